@@ -188,6 +188,95 @@ xclEnqueuePeerToPeerCopyBuffer(cl_command_queue    command_queue,
                      const cl_event *    event_wait_list,
                      cl_event *          event_parameter);
 
+/*----
+ *
+ * DOC: Command graphs
+ * ~~~~~~~~~~~~~~~~~~~
+ * A command graph records a sequence of commands enqueued on a
+ * command queue and replays the sequence with one call.  Kernel
+ * commands are encoded once when the graph is recorded, replaying a
+ * graph skips argument validation, dependency resolution, and
+ * command construction.
+ *
+ * Commands enqueued between xclBeginGraphRecording and
+ * xclEndGraphRecording are recorded but not executed.  Events
+ * returned while recording cannot be waited on, and blocking
+ * commands cannot be recorded.  Commands in a graph can depend only
+ * on other commands in the same graph.  The graph does not retain
+ * memory objects or host pointers used by the recorded commands.
+ */
+typedef struct _xcl_graph * xcl_graph;
+
+/**
+ * struct xcl_graph_arg_update - new value of a scalar kernel argument
+ *
+ * @node:      index of the recorded kernel command in the graph,
+ *             commands are numbered from 0 in the order they were
+ *             enqueued
+ * @arg_index: index of the kernel argument
+ * @arg_size:  size of the argument value
+ * @arg_value: pointer to the argument value
+ */
+typedef struct {
+  cl_uint     node;
+  cl_uint     arg_index;
+  size_t      arg_size;
+  const void* arg_value;
+} xcl_graph_arg_update;
+
+/**
+ * Start recording commands enqueued on command_queue
+ *
+ * Waits for commands already enqueued on command_queue to complete.
+ *
+ * CL_INVALID_COMMAND_QUEUE: if command_queue is not valid
+ * CL_INVALID_OPERATION    : if command_queue is already recording
+ */
+extern cl_int
+xclBeginGraphRecording(cl_command_queue command_queue);
+
+/**
+ * Stop recording and return the recorded graph
+ *
+ * CL_INVALID_COMMAND_QUEUE: if command_queue is not valid
+ * CL_INVALID_OPERATION    : if command_queue is not recording
+ */
+extern xcl_graph
+xclEndGraphRecording(cl_command_queue command_queue,
+                     cl_int*          errcode_ret);
+
+/**
+ * Enqueue all commands of a graph for execution
+ *
+ * Argument updates are applied before the replay and remain in
+ * effect for subsequent replays.  Replays of the same graph execute
+ * one at a time in the order they were enqueued.
+ *
+ * CL_INVALID_COMMAND_QUEUE: if command_queue is not valid or is not
+ *                           on the device the graph was recorded on
+ * CL_INVALID_VALUE        : if graph is nullptr, or if updates is
+ *                           nullptr and num_updates is > 0
+ * CL_INVALID_ARG_INDEX    : if an update refers to a node that is not
+ *                           a kernel or an argument that is not scalar
+ * CL_INVALID_ARG_SIZE     : if an update size does not match the argument
+ */
+extern cl_int
+xclEnqueueGraph(cl_command_queue            command_queue,
+                xcl_graph                   graph,
+                cl_uint                     num_updates,
+                const xcl_graph_arg_update* updates,
+                cl_uint                     num_events_in_wait_list,
+                const cl_event*             event_wait_list,
+                cl_event*                   event_parameter);
+
+/**
+ * Release a graph
+ *
+ * Enqueued replays complete before the graph is deleted.
+ */
+extern cl_int
+xclReleaseGraph(xcl_graph graph);
+
 /*----
  *
  * DOC: OpenCL Stream APIs
@@ -286,7 +375,46 @@ clReadStream(cl_stream             /* stream*/,
 	     cl_int*               /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
 
 
+/**
+ * clWriteStreams - post several write requests to a stream in one call
+ * @stream      : The stream
+ * @num_packets : The number of requests
+ * @ptrs        : Array of @num_packets ptrs to write from
+ * @sizes       : Array of @num_packets sizes in bytes
+ * @attributes  : Array of @num_packets write request types
+ * errcode_ret  : The return value eg CL_SUCCESS
+ * Requests are posted in order until one fails.  Non-blocking requests
+ * complete through clPollStreams as with clWriteStream.
+ * Return the number of requests posted.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clWriteStreams(cl_stream             /* stream*/,
+	cl_uint               /* num_packets */,
+	const void* const*    /* ptrs */,
+	const size_t*         /* sizes */,
+	cl_stream_xfer_req*   /* attributes */,
+	cl_int*               /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
+
+/**
+ * clReadStreams - post several read requests to a stream in one call
+ * @stream      : The stream
+ * @num_packets : The number of requests
+ * @ptrs        : Array of @num_packets ptrs to read into
+ * @sizes       : Array of @num_packets sizes in bytes
+ * @attributes  : Array of @num_packets read request types
+ * errcode_ret  : The return value eg CL_SUCCESS
+ * Return the number of requests posted, see clWriteStreams.
+ */
+extern CL_API_ENTRY cl_int CL_API_CALL
+clReadStreams(cl_stream             /* stream*/,
+	cl_uint               /* num_packets */,
+	void* const*          /* ptrs */,
+	const size_t*         /* sizes */,
+	cl_stream_xfer_req*   /* attributes */,
+	cl_int*               /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
+
 /* clCreateStreamBuffer - Alloc buffer used for read and write.
+ * Buffers released with clReleaseStreamBuffer are reused.
  * @size       : The size of the buffer
  * errcode_ret : The return value, eg CL_SUCCESS
  * Returns cl_stream_mem
@@ -296,8 +424,20 @@ clCreateStreamBuffer(cl_device_id device,
 	size_t                /* size*/,
 	cl_int *              /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
 
+/* clMapStreamBuffer - Get the host address of a stream buffer.
+ * @stream_mem  : The stream memory created by clCreateStreamBuffer
+ * errcode_ret  : The return value, eg CL_SUCCESS
+ * The address is valid until the buffer is released.
+ * Returns the host address of the buffer
+ */
+extern CL_API_ENTRY void* CL_API_CALL
+clMapStreamBuffer(cl_stream_mem         /* stream memobj */,
+	cl_int *              /* errcode_ret*/) CL_API_SUFFIX__VERSION_1_0;
+
 /* clReleaseStreamBuffer - Release the buffer created.
  * @cl_stream_mem : The stream memory to be released.
+ * The buffer is kept for reuse by clCreateStreamBuffer once requests
+ * from it have completed.
  * Return a cl_int
  */
 extern CL_API_ENTRY cl_int CL_API_CALL
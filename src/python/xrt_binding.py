@@ -746,6 +746,147 @@ def xclExecWait(handle, timeoutMilliSec):
     libc.xclExecWait.argtypes = [xclDeviceHandle, ctypes.c_int]
     return libc.xclExecWait(handle, timeoutMilliSec)
 
+# Prototypes of the calls used by the batched helpers below.  Indexing
+# libc returns a private function object so setting up the types once
+# does not interfere with the per call setup of the wrappers above.
+_xclMapBO = libc['xclMapBO']
+_xclMapBO.restype = ctypes.c_void_p
+_xclMapBO.argtypes = [xclDeviceHandle, ctypes.c_uint, ctypes.c_bool]
+_xclSyncBO = libc['xclSyncBO']
+_xclSyncBO.restype = ctypes.c_int
+_xclSyncBO.argtypes = [xclDeviceHandle, ctypes.c_uint, ctypes.c_int, ctypes.c_size_t, ctypes.c_size_t]
+_xclExecBuf = libc['xclExecBuf']
+_xclExecBuf.restype = ctypes.c_int
+_xclExecBuf.argtypes = [xclDeviceHandle, ctypes.c_uint]
+_xclExecWait = libc['xclExecWait']
+_xclExecWait.restype = ctypes.c_int
+_xclExecWait.argtypes = [xclDeviceHandle, ctypes.c_int]
+try:
+    # Only shims that cache BO mappings (zynq) export xclUnmapBO
+    _xclUnmapBO = libc['xclUnmapBO']
+    _xclUnmapBO.restype = ctypes.c_int
+    _xclUnmapBO.argtypes = [xclDeviceHandle, ctypes.c_uint, ctypes.c_void_p]
+except AttributeError:
+    _xclUnmapBO = None
+_munmap = ctypes.CDLL(None, use_errno=True)['munmap']
+_munmap.restype = ctypes.c_int
+_munmap.argtypes = [ctypes.c_void_p, ctypes.c_size_t]
+
+def xclMapBOBuffer(handle, boHandle, write, size=None):
+    """
+    xclMapBOBuffer() - Memory map BO as an object supporting the buffer protocol
+
+    :param handle: (xclDeviceHandle) device handle
+    :param boHandle: (unsigned int) BO handle
+    :param write: (boolean) READ only or READ/WRITE mapping
+    :param size: size of mapping, defaults to size of BO
+    :return: (ctypes.c_ubyte array) mapped BO memory or None on failure
+
+    The returned array aliases the BO memory, so numpy.frombuffer(), ctypes
+    from_buffer() and memoryview(buf).cast('B') give views of the BO without
+    copying.  Views must not be used after the buffer is unmapped with
+    xclUnmapBOBuffer().
+    """
+    if size is None:
+        prop = xclBOProperties()
+        if xclGetBOProperties(handle, boHandle, prop):
+            return None
+        size = prop.size
+    ptr = _xclMapBO(handle, boHandle, write)
+    if not ptr or ptr == ctypes.c_void_p(-1).value:
+        return None
+    return (ctypes.c_ubyte * size).from_address(ptr)
+
+def xclUnmapBOBuffer(handle, boHandle, buf):
+    """
+    xclUnmapBOBuffer() - Unmap a buffer returned by xclMapBOBuffer()
+
+    :param handle: (xclDeviceHandle) device handle
+    :param boHandle: (unsigned int) BO handle the buffer was mapped from
+    :param buf: buffer returned by xclMapBOBuffer()
+    :return: 0 on success or standard errno
+
+    The mapping is released through the shim when it caches BO mappings,
+    so a later xclMapBOBuffer() of the same BO never sees a stale address.
+    """
+    if _xclUnmapBO:
+        return abs(_xclUnmapBO(handle, boHandle, ctypes.addressof(buf)))
+    if _munmap(ctypes.addressof(buf), ctypes.sizeof(buf)):
+        return ctypes.get_errno()
+    return 0
+
+def xclSyncBOs(handle, bos, direction):
+    """
+    xclSyncBOs() - Synchronize contents of several buffers in requested direction
+
+    :param handle: (xclDeviceHandle) device handle
+    :param bos: iterable of (boHandle, size, offset) tuples
+    :param direction: (xclBOSyncDirection) To device or from device
+    :return: 0 on success or standard errno of first failing sync
+
+    Buffers are synchronized in order, stopping at the first failure.
+    """
+    for boHandle, size, offset in bos:
+        err = _xclSyncBO(handle, boHandle, direction, size, offset)
+        if err:
+            return err
+    return 0
+
+def xclExecBufs(handle, cmdBOs):
+    """
+    xclExecBufs() - Submit several execution requests to the scheduler
+
+    :param handle: Device handle
+    :param cmdBOs: iterable of BO handles containing command packets
+    :return: 0 or standard error number of first failing submission
+
+    Commands are submitted in order, stopping at the first failure.
+    """
+    for cmdBO in cmdBOs:
+        err = _xclExecBuf(handle, cmdBO)
+        if err:
+            return err
+    return 0
+
+# ERT_CMD_STATE_COMPLETED, ERT_CMD_STATE_ERROR and ERT_CMD_STATE_ABORT
+_cmd_done_states = (4, 5, 6)
+
+def _cmd_state(cmd):
+    # state is bits [3-0] of the first word of every command packet
+    return ctypes.c_uint32.from_address(ctypes.addressof(cmd)).value & 0xf
+
+def xclExecWaitCmds(handle, cmds, timeoutMilliSec=1000):
+    """
+    xclExecWaitCmds() - Wait until commands have finished executing
+
+    :param handle: Device handle
+    :param cmds: mapped command packets, from xclMapBOBuffer() or ert structures
+    :param timeoutMilliSec: How long each xclExecWait() call waits for
+    :return: list of final command states
+
+    A command is finished when it has completed, failed or was aborted.
+    """
+    cmds = list(cmds)
+    while any(_cmd_state(cmd) not in _cmd_done_states for cmd in cmds):
+        if _xclExecWait(handle, timeoutMilliSec) < 0:
+            break
+    return [_cmd_state(cmd) for cmd in cmds]
+
+def xclExecWaitAsync(handle, cmds, timeoutMilliSec=1000, loop=None):
+    """
+    xclExecWaitAsync() - asyncio variant of xclExecWaitCmds()
+
+    :param loop: asyncio event loop, defaults to the current event loop
+    :return: awaitable resolving to the list of final command states
+
+    The wait runs on the default executor of the event loop.  ctypes releases
+    the GIL around xclExecWait() so other coroutines keep running meanwhile.
+    """
+    import asyncio
+    if loop is None:
+        loop = asyncio.get_event_loop()
+    return loop.run_in_executor(None, xclExecWaitCmds, handle, list(cmds), timeoutMilliSec)
+
 def xclRegisterInterruptNotify(handle, userInterrupt, fd):
     """
     register *eventfdfile handle for a MSIX interrupt
@@ -283,6 +283,90 @@ get_ert_slotsize()
   return value;
 }
 
+/**
+ * Policy for sizing the number of in-flight kernel commands per
+ * execution context.  "adaptive" sizes the window from observed CU
+ * completion rate, scheduler queue depth, and number of contexts
+ * sharing the CUs.  "static" uses a fixed 2x CUs (20x for dataflow).
+ */
+inline std::string
+get_cu_window()
+{
+  static std::string value = detail::get_string_value("Runtime.cu_window","adaptive");
+  return value;
+}
+
+/**
+ * Policy used by software scheduler to select among ready CUs.
+ * One of first_fit, round_robin, least_loaded, affinity
+ */
+inline std::string
+get_sws_cu_policy()
+{
+  static std::string value = detail::get_string_value("Runtime.sws_cu_policy","least_loaded");
+  return value;
+}
+
+/**
+ * Pin per device runtime threads (DMA workers, command monitor) to
+ * the cores of the device's NUMA node.  Ignored when cpu_affinity is
+ * specified.
+ */
+inline bool
+get_numa_affinity()
+{
+  static bool value = detail::get_bool_value("Runtime.numa_affinity",true);
+  return value;
+}
+
+/**
+ * Allocate host backing of runtime owned buffer objects, e.g. the
+ * staging buffers of unaligned host pointers, on the NUMA node of the
+ * device.
+ */
+inline bool
+get_numa_alloc()
+{
+  static bool value = detail::get_bool_value("Runtime.numa_alloc",true);
+  return value;
+}
+
+/**
+ * Chunk size in bytes used when staging unaligned host pointers
+ * through the host backing of a buffer object.  Chunks are copied
+ * and transferred concurrently by the DMA workers.  0 transfers the
+ * entire range as one chunk.
+ */
+inline unsigned int
+get_staging_chunk_size()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.staging_chunk_size",0x100000);
+  return value;
+}
+
+/**
+ * Max bytes of released stream buffers kept per device for reuse by
+ * clCreateStreamBuffer.  Buffers released beyond this are returned to
+ * the driver.
+ */
+inline unsigned int
+get_stream_buf_pool_size()
+{
+  static unsigned int value = detail::get_uint_value("Runtime.stream_buf_pool_size",0x4000000);
+  return value;
+}
+
+/**
+ * Run soft kernel CUs on threads inside the soft kernel daemon instead
+ * of one forked process per CU.
+ */
+inline bool
+get_sk_in_process()
+{
+  static bool value = detail::get_bool_value("Runtime.sk_in_process",false);
+  return value;
+}
+
 inline bool
 get_cdma()
 {
@@ -0,0 +1,423 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "xclbin_compress.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+// Chunk encoding is a sequence of
+//   token, [literal length], literals, offset (16 bit LE), [match length]
+// The high nibble of token is the literal length and the low nibble is
+// the match length minus min_match.  A nibble of 15 is followed by
+// bytes that are added to the length, until a byte that is not 255.
+// The last sequence of a chunk has literals only and ends the chunk.
+
+namespace {
+
+const char compressed_magic[8] = "xclbinz";
+const uint32_t raw_chunk = 0x80000000;
+const size_t min_match = 4;
+const size_t max_offset = 0xffff;
+const unsigned int hash_bits = 16;
+
+static void
+corrupt(const std::string& what)
+{
+  throw std::runtime_error("compressed xclbin section is corrupted: " + what);
+}
+
+static uint32_t
+load32(const unsigned char* p)
+{
+  uint32_t v;
+  std::memcpy(&v,p,sizeof(v));
+  return v;
+}
+
+static uint32_t
+get_le32(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void
+put_le32(std::vector<char>& out, uint32_t v)
+{
+  out.push_back(static_cast<char>(v));
+  out.push_back(static_cast<char>(v >> 8));
+  out.push_back(static_cast<char>(v >> 16));
+  out.push_back(static_cast<char>(v >> 24));
+}
+
+static unsigned int
+hash(uint32_t v)
+{
+  return (v * 2654435761u) >> (32 - hash_bits);
+}
+
+static uint64_t
+align8(uint64_t v)
+{
+  return (v + 7) & ~static_cast<uint64_t>(7);
+}
+
+static const std::array<uint32_t,256>&
+crc_table()
+{
+  static const std::array<uint32_t,256> table = [] {
+    std::array<uint32_t,256> t;
+    for (uint32_t i=0; i<256; ++i) {
+      uint32_t c = i;
+      for (int k=0; k<8; ++k)
+        c = (c & 1) ? (0xedb88320u ^ (c >> 1)) : (c >> 1);
+      t[i] = c;
+    }
+    return t;
+  }();
+  return table;
+}
+
+static void
+put_length(std::vector<char>& out, size_t len)
+{
+  for (; len >= 255; len -= 255)
+    out.push_back(static_cast<char>(255));
+  out.push_back(static_cast<char>(len));
+}
+
+static void
+compress_chunk(const unsigned char* src, size_t size, std::vector<char>& out, std::vector<uint32_t>& table)
+{
+  // table holds position + 1 of last occurrence of a hash, 0 is empty
+  std::fill(table.begin(),table.end(),0);
+
+  size_t anchor = 0;
+  size_t pos = 0;
+
+  auto emit = [&](size_t offset, size_t len) {
+    size_t literals = pos - anchor;
+    unsigned int token = std::min<size_t>(literals,15) << 4;
+    if (len)
+      token |= std::min<size_t>(len - min_match,15);
+    out.push_back(static_cast<char>(token));
+    if (literals >= 15)
+      put_length(out,literals - 15);
+    out.insert(out.end(),src + anchor,src + pos);
+    if (!len)
+      return;
+    out.push_back(static_cast<char>(offset));
+    out.push_back(static_cast<char>(offset >> 8));
+    if (len - min_match >= 15)
+      put_length(out,len - min_match - 15);
+  };
+
+  while (pos + min_match <= size) {
+    auto value = load32(src + pos);
+    auto& entry = table[hash(value)];
+    size_t ref = entry;
+    entry = pos + 1;
+    if (ref && pos - (ref - 1) <= max_offset && load32(src + ref - 1) == value) {
+      --ref;
+      size_t len = min_match;
+      while (pos + len < size && src[ref + len] == src[pos + len])
+        ++len;
+      emit(pos - ref,len);
+      pos += len;
+      anchor = pos;
+      continue;
+    }
+
+    // Skip faster through data that does not compress
+    pos += 1 + ((pos - anchor) >> 8);
+  }
+
+  pos = size;
+  emit(0,0);
+}
+
+static void
+decompress_chunk(const unsigned char* src, size_t size, unsigned char* dst, size_t dst_size)
+{
+  size_t ip = 0;
+  size_t op = 0;
+
+  auto get_length = [&](size_t len) {
+    unsigned char byte = 255;
+    while (byte == 255) {
+      if (ip == size)
+        corrupt("truncated length");
+      byte = src[ip++];
+      len += byte;
+    }
+    return len;
+  };
+
+  while (ip < size) {
+    unsigned int token = src[ip++];
+
+    size_t literals = token >> 4;
+    if (literals == 15)
+      literals = get_length(literals);
+    if (literals > size - ip || literals > dst_size - op)
+      corrupt("literals out of range");
+    std::memcpy(dst + op,src + ip,literals);
+    ip += literals;
+    op += literals;
+
+    // Last sequence has no match
+    if (ip == size)
+      break;
+
+    if (size - ip < 2)
+      corrupt("truncated match");
+    size_t offset = src[ip] | (src[ip + 1] << 8);
+    ip += 2;
+    size_t len = token & 0xf;
+    if (len == 15)
+      len = get_length(len);
+    len += min_match;
+    if (offset == 0 || offset > op || len > dst_size - op)
+      corrupt("match out of range");
+
+    // Match may overlap the bytes it produces
+    auto out = dst + op;
+    auto ref = out - offset;
+    if (offset >= len)
+      std::memcpy(out,ref,len);
+    else
+      for (size_t i=0; i<len; ++i)
+        out[i] = ref[i];
+    op += len;
+  }
+
+  if (op != dst_size)
+    corrupt("chunk size mismatch");
+}
+
+static axlf_compressed_section
+get_header(const char* data, size_t size)
+{
+  axlf_compressed_section hdr;
+  if (size < sizeof(hdr))
+    corrupt("truncated header");
+  std::memcpy(&hdr,data,sizeof(hdr));
+  if (std::memcmp(hdr.m_magic,compressed_magic,sizeof(compressed_magic)))
+    corrupt("bad magic");
+  return hdr;
+}
+
+// m_sectionFlags occupies what used to be padding, xclbins written by
+// older tools can have garbage there.  A section is compressed only if
+// the flag is set and its data starts with the compressed magic.
+static bool
+is_compressed(const axlf* top, const axlf_section_header& sec)
+{
+  if (!(sec.m_sectionFlags & AXLF_SECTION_COMPRESSED))
+    return false;
+  uint64_t length = top->m_header.m_length;
+  if (sec.m_sectionOffset > length || sec.m_sectionSize > length - sec.m_sectionOffset)
+    return false;
+  auto data = reinterpret_cast<const char*>(top) + sec.m_sectionOffset;
+  return xrt_core::xclbin::is_compressed_section(data,sec.m_sectionSize);
+}
+
+}
+
+namespace xrt_core { namespace xclbin {
+
+uint32_t
+crc32(uint32_t crc, const char* data, size_t size)
+{
+  auto& table = crc_table();
+  auto p = reinterpret_cast<const unsigned char*>(data);
+  crc = ~crc;
+  for (size_t i=0; i<size; ++i)
+    crc = table[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+  return ~crc;
+}
+
+std::vector<char>
+compress_section(const char* data, size_t size, uint32_t chunk_size)
+{
+  if (chunk_size == 0 || (chunk_size & raw_chunk))
+    throw std::invalid_argument("bad chunk size for xclbin section compression");
+
+  axlf_compressed_section hdr;
+  std::memset(&hdr,0,sizeof(hdr));
+  std::memcpy(hdr.m_magic,compressed_magic,sizeof(compressed_magic));
+  hdr.m_uncompressedSize = size;
+  hdr.m_chunkSize = chunk_size;
+  hdr.m_checksum = crc32(0,data,size);
+
+  std::vector<char> out(reinterpret_cast<const char*>(&hdr),reinterpret_cast<const char*>(&hdr) + sizeof(hdr));
+  std::vector<uint32_t> table(1 << hash_bits);
+  std::vector<char> chunk;
+  auto src = reinterpret_cast<const unsigned char*>(data);
+  for (size_t offset=0; offset<size; offset+=chunk_size) {
+    size_t usize = std::min<size_t>(chunk_size,size - offset);
+    chunk.clear();
+    compress_chunk(src + offset,usize,chunk,table);
+
+    // Store chunks that do not compress as is
+    if (chunk.size() >= usize) {
+      put_le32(out,usize | raw_chunk);
+      out.insert(out.end(),data + offset,data + offset + usize);
+    }
+    else {
+      put_le32(out,chunk.size());
+      out.insert(out.end(),chunk.begin(),chunk.end());
+    }
+  }
+  return out;
+}
+
+uint64_t
+get_uncompressed_size(const char* data, size_t size)
+{
+  return get_header(data,size).m_uncompressedSize;
+}
+
+void
+decompress_section(const char* data, size_t size, char* dst, size_t dst_size)
+{
+  auto hdr = get_header(data,size);
+  if (hdr.m_uncompressedSize != dst_size)
+    throw std::runtime_error("bad destination size for compressed xclbin section");
+  if (hdr.m_chunkSize == 0 && dst_size)
+    corrupt("bad chunk size");
+
+  auto src = reinterpret_cast<const unsigned char*>(data);
+  auto out = reinterpret_cast<unsigned char*>(dst);
+  size_t ip = sizeof(hdr);
+  size_t op = 0;
+  uint32_t crc = 0;
+  while (op < dst_size) {
+    if (size - ip < 4)
+      corrupt("truncated chunk");
+    auto word = get_le32(src + ip);
+    ip += 4;
+
+    size_t csize = word & ~raw_chunk;
+    size_t usize = std::min<size_t>(hdr.m_chunkSize,dst_size - op);
+    if (csize > size - ip)
+      corrupt("truncated chunk");
+
+    if (word & raw_chunk) {
+      if (csize != usize)
+        corrupt("chunk size mismatch");
+      std::memcpy(out + op,src + ip,usize);
+    }
+    else {
+      decompress_chunk(src + ip,csize,out + op,usize);
+    }
+
+    // Checksum the chunk while it is still in cache
+    crc = crc32(crc,dst + op,usize);
+    ip += csize;
+    op += usize;
+  }
+
+  if (crc != hdr.m_checksum)
+    throw std::runtime_error("compressed xclbin section checksum mismatch");
+}
+
+bool
+is_compressed_section(const char* data, size_t size)
+{
+  return size >= sizeof(axlf_compressed_section)
+    && std::memcmp(data,compressed_magic,sizeof(compressed_magic)) == 0;
+}
+
+bool
+is_compressed(const axlf* top)
+{
+  // Section headers must be within the xclbin
+  uint32_t count = top->m_header.m_numSections;
+  if (count && sizeof(axlf) + (count - 1) * sizeof(axlf_section_header) > top->m_header.m_length)
+    return false;
+
+  auto begin = top->m_sections;
+  auto end = begin + top->m_header.m_numSections;
+  return std::any_of(begin,end,[top](const axlf_section_header& sec) { return ::is_compressed(top,sec); });
+}
+
+std::vector<char>
+decompress(const axlf* top)
+{
+  auto raw = reinterpret_cast<const char*>(top);
+  uint64_t length = top->m_header.m_length;
+  uint32_t count = top->m_header.m_numSections;
+  uint64_t header_size = sizeof(axlf) + (count ? count - 1 : 0) * sizeof(axlf_section_header);
+  if (header_size > length)
+    throw std::runtime_error("xclbin length is smaller than its header");
+
+  // Place the expanded sections one after the other
+  std::vector<uint64_t> offsets(count);
+  std::vector<uint64_t> sizes(count);
+  std::vector<bool> compressed(count);
+  uint64_t total = align8(header_size);
+  for (uint32_t idx=0; idx<count; ++idx) {
+    auto& sec = top->m_sections[idx];
+    if (sec.m_sectionOffset > length || sec.m_sectionSize > length - sec.m_sectionOffset)
+      throw std::runtime_error("xclbin section " + std::to_string(idx) + " is out of range");
+    compressed[idx] = ::is_compressed(top,sec);
+    sizes[idx] = compressed[idx]
+      ? get_uncompressed_size(raw + sec.m_sectionOffset,sec.m_sectionSize)
+      : sec.m_sectionSize;
+    if (!sizes[idx])
+      continue;
+    offsets[idx] = total;
+    total = align8(total + sizes[idx]);
+  }
+
+  std::vector<char> xclbin(total);
+  std::memcpy(xclbin.data(),raw,header_size);
+  auto out = reinterpret_cast<axlf*>(xclbin.data());
+  out->m_header.m_length = total;
+
+  for (uint32_t idx=0; idx<count; ++idx) {
+    auto& sec = top->m_sections[idx];
+    auto src = raw + sec.m_sectionOffset;
+    auto dst = xclbin.data() + offsets[idx];
+    if (compressed[idx])
+      decompress_section(src,sec.m_sectionSize,dst,sizes[idx]);
+    else if (sizes[idx])
+      std::memcpy(dst,src,sizes[idx]);
+
+    auto& osec = out->m_sections[idx];
+    osec.m_sectionFlags &= ~AXLF_SECTION_COMPRESSED;
+    osec.m_sectionOffset = offsets[idx];
+    osec.m_sectionSize = sizes[idx];
+  }
+
+  return xclbin;
+}
+
+const axlf*
+expand(const axlf* top, std::vector<char>& expanded)
+{
+  if (std::memcmp(top->m_magic,"xclbin2",8) || !is_compressed(top))
+    return top;
+  expanded = decompress(top);
+  return reinterpret_cast<const axlf*>(expanded.data());
+}
+
+} // xclbin
+} // xrt_core
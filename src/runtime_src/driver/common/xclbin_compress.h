@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xclbin_compress_h_
+#define xclbin_compress_h_
+
+#include "driver/include/xclbin.h"
+#include <vector>
+#include <cstddef>
+
+// Compression of xclbin sections.  The codec is a self contained LZ
+// variant, sections are compressed in independent chunks so that they
+// can be expanded in a streaming fashion.  This file is shared with
+// xclbinutil and must not depend on other parts of xrt.
+
+namespace xrt_core { namespace xclbin {
+
+/**
+ * crc32() - CRC-32 (IEEE 802.3) of a buffer
+ *
+ * @crc: CRC of preceding data, 0 for first buffer
+ */
+uint32_t
+crc32(uint32_t crc, const char* data, size_t size);
+
+/**
+ * compress_section() - Compress section data
+ *
+ * @chunk_size: Uncompressed size of each independently compressed chunk
+ * Return: axlf_compressed_section header followed by compressed chunks
+ */
+std::vector<char>
+compress_section(const char* data, size_t size, uint32_t chunk_size=0x100000);
+
+/**
+ * get_uncompressed_size() - Size of compressed section data once expanded
+ *
+ * Throws std::runtime_error if data is not a compressed section
+ */
+uint64_t
+get_uncompressed_size(const char* data, size_t size);
+
+/**
+ * decompress_section() - Expand compressed section data
+ *
+ * @dst: Buffer receiving the expanded data, it must be exactly the
+ *   size returned by get_uncompressed_size()
+ *
+ * Chunks are expanded directly into @dst.  Throws std::runtime_error
+ * if the data is corrupted or if the checksum does not match.
+ */
+void
+decompress_section(const char* data, size_t size, char* dst, size_t dst_size);
+
+/**
+ * is_compressed_section() - Check if section data starts with the
+ *   axlf_compressed_section magic
+ */
+bool
+is_compressed_section(const char* data, size_t size);
+
+/**
+ * is_compressed() - Check if any section of an xclbin is compressed
+ *
+ * A section is compressed if AXLF_SECTION_COMPRESSED is set in its
+ * flags and its data is an axlf_compressed_section.  The flags reuse
+ * header padding, the magic keeps legacy xclbins with non zero padding
+ * from being mistaken for compressed ones.
+ */
+bool
+is_compressed(const axlf* top);
+
+/**
+ * decompress() - Expand all compressed sections of an xclbin
+ *
+ * Return: Copy of xclbin with all sections uncompressed
+ *
+ * The copy contains the axlf header and the sections, each aligned
+ * to 8 bytes.  Data following the sections in the original xclbin is
+ * not preserved.
+ */
+std::vector<char>
+decompress(const axlf* top);
+
+/**
+ * expand() - Expand an xclbin that is about to be loaded
+ *
+ * @expanded: Storage for the expanded xclbin, untouched if nothing
+ *   is compressed
+ * Return: @top if it is not an axlf or has no compressed sections,
+ *   otherwise the xclbin in @expanded
+ *
+ * Used by the shims before handing an xclbin to the driver or the
+ * emulator, neither of which knows about compressed sections.  Throws
+ * std::runtime_error if a compressed section is corrupted.
+ */
+const axlf*
+expand(const axlf* top, std::vector<char>& expanded);
+
+} // xclbin
+} // xrt_core
+
+#endif
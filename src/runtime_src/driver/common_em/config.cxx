@@ -66,6 +66,7 @@ namespace xclemulation{
     mServerPort = 0;
     mKeepRunDir=false;
     mLauncherArgs = "";
+    mSharedDeviceMemory = true;
   }
 
   static bool getBoolValue(std::string& value,bool defaultValue)
@@ -180,6 +181,10 @@ namespace xclemulation{
       {
         setLauncherArgs(value);
       }
+      else if (name == "shared_device_memory")
+      {
+        setSharedDeviceMemory(getBoolValue(value,true));
+      }
       else if(name == "launch_waveform")
       {
         if (boost::iequals(value,"gui" ))
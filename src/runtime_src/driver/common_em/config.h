@@ -113,6 +113,7 @@ namespace xclemulation{
       inline void setServerPort(unsigned int serverPort)        { mServerPort       = serverPort;    }
       inline void setKeepRunDir(bool _mKeepRundir)              { mKeepRunDir = _mKeepRundir;        }    
       inline void setLauncherArgs(std::string & _mLauncherArgs) { mLauncherArgs = _mLauncherArgs;    }    
+      inline void setSharedDeviceMemory(bool shared)            { mSharedDeviceMemory = shared;      }
       
       inline bool isDiagnosticsEnabled()        const { return mDiagnostics;    }
       inline bool isUMRChecksEnabled()          const { return mUMRChecks;      }
@@ -134,6 +135,7 @@ namespace xclemulation{
       inline bool isErrorsToBePrintedOnConsole()   const { return mPrintErrorsInConsole;  }
       inline bool isWarningsToBePrintedOnConsole() const { return mPrintWarningsInConsole;}
       inline std::string getLauncherArgs() const { return mLauncherArgs;}
+      inline bool isSharedDeviceMemoryEnabled() const { return mSharedDeviceMemory;}
       
       void populateEnvironmentSetup(std::map<std::string,std::string>& mEnvironmentNameValueMap);
 
@@ -159,6 +161,7 @@ namespace xclemulation{
       unsigned int mServerPort;
       bool mKeepRunDir;
       std::string mLauncherArgs;
+      bool mSharedDeviceMemory;
       
      
       config();
@@ -19,6 +19,8 @@
  */
 
 #include <shim.h>
+#include "driver/common/message.h"
+#include "driver/common/xclbin_compress.h"
  
 xclDeviceHandle xclOpen(unsigned deviceIndex, const char *logfileName, xclVerbosityLevel level)
 {
@@ -88,6 +90,15 @@ int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
   xclcpuemhal2::CpuemShim *drv = xclcpuemhal2::CpuemShim::handleCheck(handle);
   if (!drv)
     return -1;
+  // The emulators do not know about compressed sections
+  std::vector<char> expanded;
+  try {
+    buffer = reinterpret_cast<const xclBin*>(xrt_core::xclbin::expand(reinterpret_cast<const axlf*>(buffer), expanded));
+  }
+  catch (const std::exception& ex) {
+    xrt_core::message::send(xrt_core::message::severity_level::ERROR, "XRT", ex.what());
+    return -EINVAL;
+  }
   return drv->xclLoadXclBin(buffer);
 }
 
@@ -21,11 +21,13 @@
 #include "shim.h"
 #include <errno.h>
 #include <unistd.h>
+#include <sys/syscall.h>
 namespace xclcpuemhal2 {
 
   std::map<unsigned int, CpuemShim*> devices;
-  unsigned int CpuemShim::mBufferCount = 0;
+  std::atomic<unsigned int> CpuemShim::mBufferCount(0);
   std::map<int, std::tuple<std::string,int,void*> > CpuemShim::mFdToFileNameMap;
+  std::mutex CpuemShim::mFdToFileNameMtx;
   bool CpuemShim::mFirstBinary = true;
   const unsigned CpuemShim::TAG = 0X586C0C6C; // XL OpenCL X->58(ASCII), L->6C(ASCII), O->0 C->C L->6C(ASCII);
   const unsigned CpuemShim::CONTROL_AP_START = 1;
@@ -616,6 +618,10 @@ namespace xclcpuemhal2 {
 
   void CpuemShim::launchTempProcess()
   {
+    // Several threads may find the device process missing
+    std::lock_guard<std::mutex> lk(mTempProcessMtx);
+    if(sock)
+      return;
     std::string binaryDirectory("");
     launchDeviceProcess(false,binaryDirectory);
     std::string xmlFile("");
@@ -731,7 +737,7 @@ namespace xclcpuemhal2 {
 
   size_t CpuemShim::xclWrite(xclAddressSpace space, uint64_t offset, const void *hostBuf, size_t size) 
   {
-    std::lock_guard<std::mutex> lk(mApiMtx);
+    ApiLock lk(this);
     if (mLogStream.is_open()) {
       mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << offset<<", "<<hostBuf<<", "<< size<<std::endl;
     }
@@ -759,7 +765,7 @@ namespace xclcpuemhal2 {
 
   size_t CpuemShim::xclRead(xclAddressSpace space, uint64_t offset, void *hostBuf, size_t size) 
   {
-    std::lock_guard<std::mutex> lk(mApiMtx);
+    ApiLock lk(this);
     if (mLogStream.is_open()) {
       mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << space << ", "
         << offset << ", " << hostBuf << ", " << size << std::endl;
@@ -821,7 +827,10 @@ namespace xclcpuemhal2 {
       uint64_t c_dest = dest + processed_bytes;
 #ifndef _WINDOWS
       uint32_t space =0;
-      xclCopyBufferHost2Device_RPC_CALL(xclCopyBufferHost2Device,handle,c_dest,c_src,c_size,seek,space);
+      xclCopyBufferHost2Device_call c_msg;
+      xclCopyBufferHost2Device_response r_msg;
+      xclCopyBufferHost2Device_SET_PROTOMESSAGE(xclCopyBufferHost2Device,handle,c_dest,c_src,c_size,seek,space);
+      rpcExchange(xclCopyBufferHost2Device_n,c_msg,r_msg);
 #endif
       processed_bytes += c_size;
     }
@@ -859,7 +868,11 @@ namespace xclcpuemhal2 {
       uint64_t c_src = src + processed_bytes;
 #ifndef _WINDOWS
       uint32_t space =0;
-      xclCopyBufferDevice2Host_RPC_CALL(xclCopyBufferDevice2Host,handle,c_dest,c_src,c_size,skip,space);
+      xclCopyBufferDevice2Host_call c_msg;
+      xclCopyBufferDevice2Host_response r_msg;
+      xclCopyBufferDevice2Host_SET_PROTOMESSAGE(xclCopyBufferDevice2Host,handle,c_dest,c_src,c_size,skip,space);
+      rpcExchange(xclCopyBufferDevice2Host_n,c_msg,r_msg);
+      xclCopyBufferDevice2Host_SET_PROTO_RESPONSE(c_dest);
 #endif
 
       processed_bytes += c_size;
@@ -868,6 +881,37 @@ namespace xclcpuemhal2 {
 
   }
 
+  template <typename CallMsg, typename ResponseMsg>
+  void CpuemShim::rpcExchange(unsigned api, const CallMsg& c_msg, ResponseMsg& r_msg)
+  {
+    std::vector<char> cbuf(c_msg.ByteSize());
+    if(!c_msg.SerializeToArray(cbuf.data(),cbuf.size())){std::cerr<<"FATAL ERROR:protobuf SerializeToArray failed"<<std::endl;exit(1);}
+
+    call_packet_info ci;
+    ci.set_size(cbuf.size());
+    ci.set_xcl_api(api);
+    std::vector<char> cibuf(ci.ByteSize());
+    if(!ci.SerializeToArray(cibuf.data(),cibuf.size())){std::cerr<<"FATAL ERROR:protobuf SerializeToArray failed"<<std::endl;exit(1);}
+
+    response_packet_info ri;
+    ri.set_size(0);
+    std::vector<char> ribuf(ri.ByteSize());
+    std::vector<char> rbuf;
+    {
+      std::lock_guard<std::mutex> lk(mtx);
+      sock->sk_write(cibuf.data(),cibuf.size());
+      sock->sk_write(cbuf.data(),cbuf.size());
+      sock->sk_read(ribuf.data(),ribuf.size());
+      bool rv = ri.ParseFromArray(ribuf.data(),ribuf.size());
+      assert(true == rv);
+      rbuf.resize(ri.size());
+      sock->sk_read(rbuf.data(),rbuf.size());
+    }
+    bool rv = r_msg.ParseFromArray(rbuf.data(),rbuf.size());
+    assert(true == rv);
+    (void)rv;
+  }
+
   void CpuemShim::xclOpen(const char* logfileName)
   {
     xclemulation::config::getInstance()->populateEnvironmentSetup(mEnvironmentNameValueMap);
@@ -919,15 +963,18 @@ namespace xclcpuemhal2 {
   }
   void CpuemShim::resetProgram(bool callingFromClose)
   {
-    for (auto& it: mFdToFileNameMap)
     {
-      int fd=it.first;
-      int sSize = std::get<1>(it.second);
-      void* addr = std::get<2>(it.second);
-      munmap(addr,sSize);
-      close(fd);
+      std::lock_guard<std::mutex> fdlk(mFdToFileNameMtx);
+      for (auto& it: mFdToFileNameMap)
+      {
+        int fd=it.first;
+        int sSize = std::get<1>(it.second);
+        void* addr = std::get<2>(it.second);
+        munmap(addr,sSize);
+        close(fd);
+      }
+      mFdToFileNameMap.clear();
     }
-    mFdToFileNameMap.clear();
 
     if (mLogStream.is_open()) {
       mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
@@ -947,7 +994,7 @@ namespace xclcpuemhal2 {
   
   void CpuemShim::xclClose()
   {
-    std::lock_guard<std::mutex> lk(mApiMtx);
+    std::unique_lock<std::shared_timed_mutex> lk(mApiMtx);
     if (mLogStream.is_open()) {
       mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
     }
@@ -957,15 +1004,18 @@ namespace xclcpuemhal2 {
         systemUtil::makeSystemCall(deviceDirectory, systemUtil::systemOperation::REMOVE);
       return;
     }
-    for (auto& it: mFdToFileNameMap)
     {
-      int fd=it.first;
-      int sSize = std::get<1>(it.second);
-      void* addr = std::get<2>(it.second);
-      munmap(addr,sSize);
-      close(fd);
-    }
+      std::lock_guard<std::mutex> fdlk(mFdToFileNameMtx);
+      for (auto& it: mFdToFileNameMap)
+      {
+        int fd=it.first;
+        int sSize = std::get<1>(it.second);
+        void* addr = std::get<2>(it.second);
+        munmap(addr,sSize);
+        close(fd);
+      }
       mFdToFileNameMap.clear();
+    }
     mCloseAll = true; 
     std::string socketName = sock->get_name();
     if(socketName.empty() == false)// device is active if socketName is non-empty
@@ -1023,14 +1073,14 @@ namespace xclcpuemhal2 {
 
 /*********************************** Utility ******************************************/
 
-xclemulation::drm_xocl_bo* CpuemShim::xclGetBoByHandle(unsigned int boHandle)
+std::shared_ptr<CpuemShim::BufferObject> CpuemShim::getBO(unsigned int boHandle)
 {
-  auto it = mXoclObjMap.find(boHandle);
-  if(it == mXoclObjMap.end())
+  BOTableShard& shard = getBOShard(boHandle);
+  std::shared_lock<std::shared_timed_mutex> lk(shard.mtx);
+  auto it = shard.bos.find(boHandle);
+  if(it == shard.bos.end())
     return nullptr;
-
-  xclemulation::drm_xocl_bo* bo = (*it).second;
-  return bo;
+  return (*it).second;
 }
 
 inline unsigned short CpuemShim::xocl_ddr_channel_count()
@@ -1045,12 +1095,12 @@ inline unsigned long long CpuemShim::xocl_ddr_channel_size()
 
 int CpuemShim::xclGetBOProperties(unsigned int boHandle, xclBOProperties *properties)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << std::endl;
   }
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(boHandle);
+  auto bo = getBO(boHandle);
   if (!bo) {
     PRINTENDFUNC;
     return  -1;
@@ -1081,10 +1131,10 @@ int CpuemShim::xoclCreateBo(xclemulation::xocl_create_bo* info)
     ddr = 0;
   }
   
-  struct xclemulation::drm_xocl_bo *xobj = new xclemulation::drm_xocl_bo;
+  auto xobj = std::make_shared<BufferObject>();
   xobj->flags=info->flags;
   /* check whether buffer is p2p or not*/
-  bool p2pBuffer = xocl_bo_p2p(xobj); 
+  bool p2pBuffer = xocl_bo_p2p(xobj.get()); 
   std::string sFileName("");
   xobj->base = xclAllocDeviceBuffer2(size,XCL_MEM_DEVICE_RAM,ddr,p2pBuffer,sFileName);
   xobj->filename = sFileName;
@@ -1093,20 +1143,71 @@ int CpuemShim::xoclCreateBo(xclemulation::xocl_create_bo* info)
   xobj->buf = NULL;
   xobj->fd = -1;
 
-  info->handle = mBufferCount;
-  mXoclObjMap[mBufferCount++] = xobj;
+  info->handle = mBufferCount++;
+  BOTableShard& shard = getBOShard(info->handle);
+  std::lock_guard<std::shared_timed_mutex> lk(shard.mtx);
+  shard.bos[info->handle] = std::move(xobj);
+  return 0;
+}
+
+int CpuemShim::shareBO(BufferObject* bo)
+{
+#if defined(__NR_memfd_create)
+  int fd = syscall(__NR_memfd_create, "sw_emu_bo", 0);
+#else
+  int fd = -1;
+#endif
+  if (fd == -1)
+    return -1;
+
+  if (ftruncate(fd, bo->size) == -1)
+  {
+    close(fd);
+    return -1;
+  }
+
+  void* data = mmap(0, bo->size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED)
+  {
+    close(fd);
+    return -1;
+  }
+
+  // The device process opens the memfd through procfs and uses it as
+  // the device memory of the BO
+  std::string fileName = "/proc/" + std::to_string(getpid()) + "/fd/" + std::to_string(fd);
+  bool ack = false;
+  xclImportBO_RPC_CALL(xclImportBO,fileName,bo->base,bo->size);
+
+  // The device process has opened the memfd once the call returns, and
+  // the mappings keep the memory alive.  Do not hold a descriptor per BO,
+  // applications with many buffers would run out of them.
+  close(fd);
+  if (!ack)
+  {
+    munmap(data, bo->size);
+    return -1;
+  }
+
+  bo->sharedBuf = data;
   return 0;
 }
 
 unsigned int CpuemShim::xclAllocBO(size_t size, xclBOKind domain, unsigned flags)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << size << std::dec << " , "<<domain <<" , "<< flags << std::endl;
   }
   xclemulation::xocl_create_bo info = {size, mNullBO, flags};
   int result = xoclCreateBo(&info);
+  if (!result && xclemulation::config::getInstance()->isSharedDeviceMemoryEnabled())
+  {
+    auto bo = getBO(info.handle);
+    if (bo && !xocl_bo_p2p(bo.get()) && shareBO(bo.get()) && mLogStream.is_open())
+      mLogStream << __func__ << " shared device memory unavailable, BO " << info.handle << " is synced by copy" << std::endl;
+  }
   PRINTENDFUNC;
   return result ? mNullBO : info.handle;
 }
@@ -1115,15 +1216,15 @@ unsigned int CpuemShim::xclAllocBO(size_t size, xclBOKind domain, unsigned flags
 /******************************** xclAllocUserPtrBO ************************************/
 unsigned int CpuemShim::xclAllocUserPtrBO(void *userptr, size_t size, unsigned flags)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << userptr <<", " << std::hex << size << std::dec <<" , "<< flags << std::endl;
   }
   xclemulation::xocl_create_bo info = {size, mNullBO, flags};
   int result = xoclCreateBo(&info);
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(info.handle);
-  if (bo) {
+  if (auto bo = getBO(info.handle)) {
+    std::lock_guard<std::mutex> bolk(bo->mtx);
     bo->userptr = userptr;
   }
   PRINTENDFUNC;
@@ -1138,10 +1239,11 @@ int CpuemShim::xclExportBO(unsigned int boHandle)
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << std::endl;
   }
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(boHandle);
+  auto bo = getBO(boHandle);
   if(!bo)
     return -1;
 
+  std::lock_guard<std::mutex> bolk(bo->mtx);
   std::string sFileName = bo->filename;
   if(sFileName.empty())
   {
@@ -1173,6 +1275,7 @@ int CpuemShim::xclExportBO(unsigned int boHandle)
     munmap(data,bo->size);
     return -1;
   }
+  std::lock_guard<std::mutex> fdlk(mFdToFileNameMtx);
   mFdToFileNameMap [fd] = std::make_tuple(sFileName,size,(void*)data);
   PRINTENDFUNC;
   return fd;
@@ -1180,6 +1283,11 @@ int CpuemShim::xclExportBO(unsigned int boHandle)
 /***************************************************************************************/
 
 /******************************** xclImportBO *******************************************/
+// Only fds returned by xclExportBO of a P2P BO on this device are
+// accepted.  The device process maps the file behind the fd as the
+// device memory of the new BO, so exporter and importer share device
+// memory.  The host side of the imported BO is not shared, its
+// contents move with xclSyncBO like any unshared BO.
 unsigned int CpuemShim::xclImportBO(int boGlobalHandle, unsigned flags)
 {
   //TODO
@@ -1187,48 +1295,55 @@ unsigned int CpuemShim::xclImportBO(int boGlobalHandle, unsigned flags)
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boGlobalHandle << std::endl;
   }
-  auto itr = mFdToFileNameMap.find(boGlobalHandle);
-  if(itr != mFdToFileNameMap.end())
+  std::string fileName;
+  int size = 0;
   {
-    const std::string& fileName = std::get<0>((*itr).second);
-    int size = std::get<1>((*itr).second);
-    unsigned int importedBo = xclAllocBO(size, xclBOKind::XCL_BO_DEVICE_RAM,flags);
-    xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(importedBo);
-    if(!bo)
-    {
-      std::cout<<"ERROR HERE in importBO "<<std::endl;
-      return -1;
-    }
-    bo->fd = boGlobalHandle;
-    bool ack;
-    xclImportBO_RPC_CALL(xclImportBO,fileName,bo->base,size);
-    if(!ack)
+    std::lock_guard<std::mutex> fdlk(mFdToFileNameMtx);
+    auto itr = mFdToFileNameMap.find(boGlobalHandle);
+    if(itr == mFdToFileNameMap.end())
       return -1;
-    PRINTENDFUNC;
-    return importedBo;
+    fileName = std::get<0>((*itr).second);
+    size = std::get<1>((*itr).second);
+  }
+  xclemulation::xocl_create_bo info = {static_cast<uint64_t>(size), mNullBO, flags};
+  if (xoclCreateBo(&info))
+    return -1;
+  unsigned int importedBo = info.handle;
+  auto bo = getBO(importedBo);
+  if(!bo)
+  {
+    std::cout<<"ERROR HERE in importBO "<<std::endl;
+    return -1;
   }
-  return -1;
+  std::lock_guard<std::mutex> bolk(bo->mtx);
+  bo->fd = boGlobalHandle;
+  bool ack;
+  xclImportBO_RPC_CALL(xclImportBO,fileName,bo->base,size);
+  if(!ack)
+    return -1;
+  PRINTENDFUNC;
+  return importedBo;
 }
 /***************************************************************************************/
 
 /******************************** xclCopyBO *******************************************/
 int CpuemShim::xclCopyBO(unsigned int dst_boHandle, unsigned int src_boHandle, size_t size, size_t dst_offset, size_t src_offset)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   //TODO
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << dst_boHandle 
       <<" , "<< src_boHandle << " , "<< size <<"," << dst_offset << "," <<src_offset<< std::endl;
   }
-  xclemulation::drm_xocl_bo* sBO = xclGetBoByHandle(src_boHandle);
+  auto sBO = getBO(src_boHandle);
   if(!sBO)
   {
     PRINTENDFUNC;
     return -1;
   }
 
-  xclemulation::drm_xocl_bo* dBO = xclGetBoByHandle(dst_boHandle);
+  auto dBO = getBO(dst_boHandle);
   if(!dBO)
   {
     PRINTENDFUNC;
@@ -1241,10 +1356,15 @@ int CpuemShim::xclCopyBO(unsigned int dst_boHandle, unsigned int src_boHandle, s
   }
 
   int ack = false;
-  auto fItr = mFdToFileNameMap.find(dBO->fd);
-  if(fItr != mFdToFileNameMap.end())
+  std::string sFileName;
+  {
+    std::lock_guard<std::mutex> fdlk(mFdToFileNameMtx);
+    auto fItr = mFdToFileNameMap.find(dBO->fd);
+    if(fItr != mFdToFileNameMap.end())
+      sFileName = std::get<0>((*fItr).second);
+  }
+  if(!sFileName.empty())
   {
-    const std::string& sFileName = std::get<0>((*fItr).second);
     xclCopyBO_RPC_CALL(xclCopyBO,sBO->base,sFileName,size,src_offset,dst_offset);
   }
   if(!ack)
@@ -1257,16 +1377,24 @@ int CpuemShim::xclCopyBO(unsigned int dst_boHandle, unsigned int src_boHandle, s
 /******************************** xclMapBO *********************************************/
 void *CpuemShim::xclMapBO(unsigned int boHandle, bool write)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << " , " << write << std::endl;
   }
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(boHandle);
+  auto bo = getBO(boHandle);
   if (!bo) {
     PRINTENDFUNC;
     return nullptr;
   }
+  std::lock_guard<std::mutex> bolk(bo->mtx);
+
+  if (bo->sharedBuf)
+  {
+    bo->buf = bo->sharedBuf;
+    PRINTENDFUNC;
+    return bo->buf;
+  }
 
   std::string sFileName = bo->filename;
   if(!sFileName.empty() )
@@ -1289,7 +1417,10 @@ void *CpuemShim::xclMapBO(unsigned int boHandle, bool write)
       munmap(data,bo->size);
       return nullptr;
     }
-    mFdToFileNameMap [fd] = std::make_tuple(sFileName,bo->size,(void*)data);
+    {
+      std::lock_guard<std::mutex> fdlk(mFdToFileNameMtx);
+      mFdToFileNameMap [fd] = std::make_tuple(sFileName,bo->size,(void*)data);
+    }
     bo->buf = data;
     PRINTENDFUNC;
     return data;
@@ -1311,17 +1442,25 @@ void *CpuemShim::xclMapBO(unsigned int boHandle, bool write)
 /******************************** xclSyncBO *******************************************/
 int CpuemShim::xclSyncBO(unsigned int boHandle, xclBOSyncDirection dir, size_t size, size_t offset)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << " , " << std::endl;
   }
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(boHandle);
+  auto bo = getBO(boHandle);
   if(!bo)
   {
     PRINTENDFUNC;
     return -1;
   }
+  std::lock_guard<std::mutex> bolk(bo->mtx);
+
+  // Host and device access the same pages
+  if (bo->sharedBuf && !bo->userptr)
+  {
+    PRINTENDFUNC;
+    return 0;
+  }
 
   int returnVal = 0;
   if(dir == XCL_BO_SYNC_BO_TO_DEVICE)
@@ -1346,23 +1485,28 @@ int CpuemShim::xclSyncBO(unsigned int boHandle, xclBOSyncDirection dir, size_t s
 /******************************** xclFreeBO *******************************************/
 void CpuemShim::xclFreeBO(unsigned int boHandle)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << std::endl;
   }
-  auto it = mXoclObjMap.find(boHandle);
-  if(it == mXoclObjMap.end())
-  {
-    PRINTENDFUNC;
-    return;
-  }
-  xclemulation::drm_xocl_bo* bo = (*it).second;;
-  if(bo)
+  std::shared_ptr<BufferObject> bo;
   {
-    xclFreeDeviceBuffer(bo->base);
-    mXoclObjMap.erase(it);
+    BOTableShard& shard = getBOShard(boHandle);
+    std::lock_guard<std::shared_timed_mutex> shardlk(shard.mtx);
+    auto it = shard.bos.find(boHandle);
+    if(it == shard.bos.end())
+    {
+      PRINTENDFUNC;
+      return;
+    }
+    bo = std::move((*it).second);
+    shard.bos.erase(it);
   }
+  // Wait for operations in flight on the BO, the object itself is
+  // released with the last reference
+  std::lock_guard<std::mutex> bolk(bo->mtx);
+  xclFreeDeviceBuffer(bo->base);
   PRINTENDFUNC;
 }
 /***************************************************************************************/
@@ -1370,12 +1514,12 @@ void CpuemShim::xclFreeBO(unsigned int boHandle)
 /******************************** xclWriteBO *******************************************/
 size_t CpuemShim::xclWriteBO(unsigned int boHandle, const void *src, size_t size, size_t seek)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << " , "<< src <<" , "<< size << ", " << seek << std::endl;
   }
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(boHandle);
+  auto bo = getBO(boHandle);
   if(!bo)
   {
     PRINTENDFUNC;
@@ -1393,12 +1537,12 @@ size_t CpuemShim::xclWriteBO(unsigned int boHandle, const void *src, size_t size
 /******************************** xclReadBO *******************************************/
 size_t CpuemShim::xclReadBO(unsigned int boHandle, void *dst, size_t size, size_t skip)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << std::hex << boHandle << " , "<< dst <<" , "<< size << ", " << skip << std::endl;
   }
-  xclemulation::drm_xocl_bo* bo = xclGetBoByHandle(boHandle);
+  auto bo = getBO(boHandle);
   if(!bo)
   {
     PRINTENDFUNC;
@@ -1419,7 +1563,7 @@ size_t CpuemShim::xclReadBO(unsigned int boHandle, void *dst, size_t size, size_
  */
 int CpuemShim::xclCreateWriteQueue(xclQueueContext *q_ctx, uint64_t *q_hdl)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
     mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
 
@@ -1442,7 +1586,7 @@ int CpuemShim::xclCreateWriteQueue(xclQueueContext *q_ctx, uint64_t *q_hdl)
  */
 int CpuemShim::xclCreateReadQueue(xclQueueContext *q_ctx, uint64_t *q_hdl)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
@@ -1466,7 +1610,7 @@ int CpuemShim::xclCreateReadQueue(xclQueueContext *q_ctx, uint64_t *q_hdl)
  */
 int CpuemShim::xclDestroyQueue(uint64_t q_hdl)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
@@ -1491,7 +1635,8 @@ int CpuemShim::xclDestroyQueue(uint64_t q_hdl)
  */
 ssize_t CpuemShim::xclWriteQueue(uint64_t q_hdl, xclQueueRequest *wr)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
+  std::lock_guard<std::mutex> qlk(mQueueMtx);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
@@ -1546,6 +1691,7 @@ ssize_t CpuemShim::xclReadQueue(uint64_t q_hdl, xclQueueRequest *rd)
     {
       vaLenMap[rd->bufs[i].va] = rd->bufs[i].len;
     }
+    std::lock_guard<std::mutex> qlk(mQueueMtx);
     mReqList.push_back(std::make_tuple(mReqCounter,rd->priv_data, vaLenMap));
   }
 
@@ -1562,7 +1708,10 @@ ssize_t CpuemShim::xclReadQueue(uint64_t q_hdl, xclQueueRequest *rd)
     } while (read_size == 0 && !nonBlocking);
     fullSize += read_size;
   }
-  mReqCounter++;
+  {
+    std::lock_guard<std::mutex> qlk(mQueueMtx);
+    mReqCounter++;
+  }
   PRINTENDFUNC;
   return fullSize;
 
@@ -1589,6 +1738,7 @@ int CpuemShim::xclPollCompletion(int min_compl, int max_compl, xclReqCompletion
   *actual = 0;
   while(*actual < min_compl)
   {
+    std::lock_guard<std::mutex> qlk(mQueueMtx);
     std::list<std::tuple<uint64_t ,void*, std::map<uint64_t,uint64_t> > >::iterator it = mReqList.begin();
     while ( it != mReqList.end() )
     {
@@ -1619,7 +1769,7 @@ int CpuemShim::xclPollCompletion(int min_compl, int max_compl, xclReqCompletion
  */
 void * CpuemShim::xclAllocQDMABuf(size_t size, uint64_t *buf_hdl)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
@@ -1642,7 +1792,7 @@ void * CpuemShim::xclAllocQDMABuf(size_t size, uint64_t *buf_hdl)
  */
 int CpuemShim::xclFreeQDMABuf(uint64_t buf_hdl)
 {
-  std::lock_guard<std::mutex> lk(mApiMtx);
+  ApiLock lk(this);
   if (mLogStream.is_open()) 
   {
     mLogStream << __func__ << ", " << std::this_thread::get_id() << std::endl;
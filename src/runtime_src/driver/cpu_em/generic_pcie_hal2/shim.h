@@ -35,6 +35,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
+#include <atomic>
+#include <memory>
+#include <shared_mutex>
 #include <thread>
 #include <tuple>
 #include <sys/wait.h>
@@ -80,7 +83,6 @@ namespace xclcpuemhal2 {
       static int xclLogMsg(xclDeviceHandle handle, xclLogMsgLevel level, const char* tag, const char* format, va_list args1);
       
 
-      xclemulation::drm_xocl_bo* xclGetBoByHandle(unsigned int boHandle);
       inline unsigned short xocl_ddr_channel_count();
       inline unsigned long long xocl_ddr_channel_size();
       // HAL2 RELATED member functions end 
@@ -153,6 +155,68 @@ namespace xclcpuemhal2 {
     private:
       std::mutex mMemManagerMutex;
 
+      // Buffer object with its own lock.  Map, sync, and free of one BO
+      // are serialized without blocking operations on other BOs.
+      //
+      // With shared device memory the BO is backed by a memfd that the
+      // device process maps as the BO's device memory.  Host map returns
+      // the same pages and sync has nothing to copy: xclSyncBO of such a
+      // BO returns 0 without any transfer, data written through the
+      // mapping is visible to kernels right away.  User pointer, P2P and
+      // imported BOs are not shared and are synced by copy.
+      struct BufferObject : xclemulation::drm_xocl_bo
+      {
+        std::mutex mtx;
+        void* sharedBuf = nullptr;
+
+        ~BufferObject()
+        {
+          if (sharedBuf)
+            munmap(sharedBuf, size);
+        }
+      };
+      // Back @bo with a memfd.  The device process is given the path
+      // /proc/<host pid>/fd/<fd> through the xclImportBO RPC and opens
+      // it, so it must run as the same user as the host process.  The
+      // memfd is closed once the device process has mapped it.
+      // Returns -1 if the BO must be synced by copy instead.
+      int shareBO(BufferObject* bo);
+
+      // BO table sharded on handle, each shard has a reader / writer
+      // lock so lookups from several threads do not contend
+      static const unsigned BO_TABLE_SHARDS = 16;
+      struct BOTableShard
+      {
+        std::shared_timed_mutex mtx;
+        std::map<unsigned int, std::shared_ptr<BufferObject>> bos;
+      };
+      BOTableShard mBOTable[BO_TABLE_SHARDS];
+
+      BOTableShard& getBOShard(unsigned int boHandle) { return mBOTable[boHandle % BO_TABLE_SHARDS]; }
+      std::shared_ptr<BufferObject> getBO(unsigned int boHandle);
+
+      // Entry points hold the API lock shared so they run concurrently,
+      // xclClose holds it exclusively.  The HAL log stream is not thread
+      // safe, calls are serialized when logging is enabled.
+      class ApiLock
+      {
+        std::shared_lock<std::shared_timed_mutex> mShared;
+        std::unique_lock<std::mutex> mLog;
+      public:
+        explicit ApiLock(CpuemShim* shim)
+          : mShared(shim->mApiMtx), mLog(shim->mLogMtx, std::defer_lock)
+        {
+          if (shim->mLogStream.is_open())
+            mLog.lock();
+        }
+      };
+
+      // Exchange one message with the device process.  Only the socket
+      // transfer holds the channel lock, messages are encoded and decoded
+      // in per call buffers so copies from several threads overlap.
+      template <typename CallMsg, typename ResponseMsg>
+      void rpcExchange(unsigned api, const CallMsg& c_msg, ResponseMsg& r_msg);
+
       // Performance monitoring helper functions
       bool isDSAVersion(double checkVersion, bool onlyThisVersion);
       uint64_t getHostTraceTimeNsec();
@@ -211,14 +275,17 @@ namespace xclcpuemhal2 {
       bool mCloseAll;
       
       std::mutex mProcessLaunchMtx;
-      std::mutex mApiMtx;
+      std::mutex mTempProcessMtx;
+      std::shared_timed_mutex mApiMtx;
+      std::mutex mLogMtx;
+      std::mutex mQueueMtx;
       static bool mFirstBinary;
       bool bUnified;
       bool bXPR;
       // HAL2 RELATED member variables start
-      std::map<int, xclemulation::drm_xocl_bo*> mXoclObjMap;
-      static unsigned int mBufferCount;
+      static std::atomic<unsigned int> mBufferCount;
       static std::map<int, std::tuple<std::string,int,void*> > mFdToFileNameMap;
+      static std::mutex mFdToFileNameMtx;
       // HAL2 RELATED member variables end 
       std::list<std::tuple<uint64_t ,void*, std::map<uint64_t , uint64_t> > > mReqList;
       uint64_t mReqCounter;
@@ -176,6 +176,7 @@ ZYNQShim::~ZYNQShim() {
     memcpy((char*) (ZYNQ_HW_EM::remotePortMappedPointer), &cPacketEndChar, 1);
     delete cmd;
   }
+  releaseMapCache();
   if (mKernelFD > 0) {
     close(mKernelFD);
   }
@@ -156,13 +156,32 @@ extern "C" {
         IP_MEM_HBM
     };
 
+    enum axlf_section_flags {
+        AXLF_SECTION_COMPRESSED = 0x1       /* Section data is an axlf_compressed_section */
+    };
+
     struct axlf_section_header {
         uint32_t m_sectionKind;             /* Section type */
         char m_sectionName[16];             /* Examples: "stage2", "clear1", "clear2", "ocl1", "ocl2, "ublaze", "sched" */
+        uint32_t m_sectionFlags;            /* axlf_section_flags, occupies what used to be padding */
         uint64_t m_sectionOffset;           /* File offset of section data */
         uint64_t m_sectionSize;             /* Size of section data */
     };
 
+    /*
+     * Compressed section data starts with this header and is followed
+     * by the chunks of the section.  Each chunk is a 32 bit little endian
+     * size followed by the chunk data.  If bit 31 of the size is set the
+     * chunk is stored as is, otherwise it is LZ compressed.  Each chunk
+     * expands to m_chunkSize bytes except for the last one.
+     */
+    struct axlf_compressed_section {
+        char m_magic[8];                    /* Should be "xclbinz\0" */
+        uint64_t m_uncompressedSize;        /* Size of section data once expanded */
+        uint32_t m_chunkSize;               /* Uncompressed size of each chunk */
+        uint32_t m_checksum;                /* CRC-32 of the uncompressed section data */
+    };
+
     struct axlf_header {
         uint64_t m_length;                  /* Total size of the xclbin file */
         uint64_t m_timeStamp;               /* Number of seconds since epoch when xclbin was created */
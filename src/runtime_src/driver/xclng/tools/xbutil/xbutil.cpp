@@ -168,6 +168,9 @@ int main(int argc, char *argv[])
     std::string mcsFile1, mcsFile2;
     std::string xclbin;
     size_t blockSize = 0;
+    xcldev::memxfer::options xferOptions;
+    unsigned benchThreads = 0;
+    std::string benchJsonFile;
     int c;
     dd::ddArgs_t ddArgs;
 
@@ -248,11 +251,13 @@ int main(int argc, char *argv[])
         {"monitorfifofull", no_argument, 0, xcldev::STATUS_UNSUPPORTED},
         {"accelmonitor", no_argument, 0, xcldev::STATUS_UNSUPPORTED},
         {"stream", no_argument, 0, xcldev::STREAM},
+        {"direct", no_argument, 0, xcldev::MEM_DIRECT},
+        {"bench", no_argument, 0, xcldev::DMATEST_BENCH},
         {0, 0, 0, 0}
     };
 
     int long_index;
-    const char* short_options = "a:b:c:d:e:f:g:h:i:m:n:o:p:r:s"; //don't add numbers
+    const char* short_options = "a:b:c:d:e:f:g:h:i:m:n:o:p:r:st:"; //don't add numbers
     while ((c = getopt_long(argc, argv, short_options, long_options, &long_index)) != -1)
     {
         if (cmd == xcldev::LIST) {
@@ -280,6 +285,24 @@ int main(int argc, char *argv[])
             subcmd = xcldev::MEM_WRITE;
             break;
         }
+        case xcldev::MEM_DIRECT : {
+            //--direct
+            if (cmd != xcldev::MEM || subcmd != xcldev::MEM_READ) {
+                std::cout << "ERROR: Option '" << long_options[long_index].name << "' cannot be used with command " << cmdname << "\n";
+                return -1;
+            }
+            xferOptions.m_direct = true;
+            break;
+        }
+        case xcldev::DMATEST_BENCH : {
+            //--bench
+            if (cmd != xcldev::DMATEST) {
+                std::cout << "ERROR: Option '" << long_options[long_index].name << "' cannot be used with command " << cmdname << "\n";
+                return -1;
+            }
+            subcmd = xcldev::DMATEST_BENCH;
+            break;
+        }
         case xcldev::STATUS_LAPC : {
             //--lapc
             if (cmd != xcldev::STATUS) {
@@ -354,6 +377,9 @@ int main(int argc, char *argv[])
             if (cmd == xcldev::FLASH) {
                 flashType = optarg;
                 break;
+            } else if (cmd == xcldev::DMATEST) {
+                benchJsonFile = optarg;
+                break;
             } else if (cmd != xcldev::MEM || subcmd != xcldev::MEM_READ) {
                 std::cout << "ERROR: '-o' not applicable for this command\n";
                 return -1;
@@ -479,8 +505,8 @@ int main(int argc, char *argv[])
             break;
         case 'b':
         {
-            if (cmd != xcldev::DMATEST) {
-                std::cout << "ERROR: '-b' only allowed with 'dmatest' command\n";
+            if (cmd != xcldev::DMATEST && cmd != xcldev::MEM) {
+                std::cout << "ERROR: '-b' only allowed with 'dmatest' and 'mem' commands\n";
                 return -1;
             }
             std::string tmp(optarg);
@@ -501,6 +527,22 @@ int main(int argc, char *argv[])
                 return -1;
             }
             blockSize *= 1024; // convert kilo bytes to bytes
+            if (cmd == xcldev::MEM)
+                xferOptions.m_block_size = blockSize;
+            break;
+        }
+        case 't': {
+            if (cmd != xcldev::MEM && cmd != xcldev::DMATEST) {
+                std::cout << "ERROR: '-t' only allowed with 'mem' and 'dmatest' commands\n";
+                return -1;
+            }
+            int threads = std::atoi(optarg);
+            if (threads <= 0) {
+                std::cout << "ERROR: Value supplied to -" << (char)c << " option is invalid\n";
+                return -1;
+            }
+            xferOptions.m_threads = threads;
+            benchThreads = threads;
             break;
         }
         default:
@@ -522,13 +564,20 @@ int main(int argc, char *argv[])
     case xcldev::BOOT:
     case xcldev::RUN:
     case xcldev::FAN:
-    case xcldev::DMATEST:
     case xcldev::MEM:
     case xcldev::QUERY:
     case xcldev::SCAN:
     case xcldev::STATUS:
     case xcldev::M2MTEST:
         break;
+    case xcldev::DMATEST:
+    {
+        if (!benchJsonFile.empty() && subcmd != xcldev::DMATEST_BENCH) {
+            std::cout << "ERROR: '-o' requires '--bench' for command " << cmdname << "\n";
+            return -1;
+        }
+        break;
+    }
     case xcldev::PROGRAM:
     {
         if (xclbin.size() == 0) {
@@ -647,13 +696,17 @@ int main(int argc, char *argv[])
         result = deviceVec[index]->run(regionIndex, computeIndex);
         break;
     case xcldev::DMATEST:
-        result = deviceVec[index]->dmatest(blockSize, true);
+        if (subcmd == xcldev::DMATEST_BENCH) {
+            result = deviceVec[index]->dmabench(blockSize, benchThreads, benchJsonFile);
+        } else {
+            result = deviceVec[index]->dmatest(blockSize, true);
+        }
         break;
     case xcldev::MEM:
         if (subcmd == xcldev::MEM_READ) {
-            result = deviceVec[index]->memread(outMemReadFile, startAddr, sizeInBytes);
+            result = deviceVec[index]->memread(outMemReadFile, startAddr, sizeInBytes, xferOptions);
         } else if (subcmd == xcldev::MEM_WRITE) {
-            result = deviceVec[index]->memwrite(startAddr, sizeInBytes, pattern_byte);
+            result = deviceVec[index]->memwrite(startAddr, sizeInBytes, pattern_byte, xferOptions);
         }
         break;
     case xcldev::DD:
@@ -704,12 +757,14 @@ void xcldev::printHelp(const std::string& exe)
     std::cout << "Command and option summary:\n";
     std::cout << "  clock   [-d card] [-r region] [-f clock1_freq_MHz] [-g clock2_freq_MHz] [-h clock3_freq_MHz]\n";
     std::cout << "  dmatest [-d card] [-b [0x]block_size_KB]\n";
+    std::cout << "  dmatest --bench [-d card] [-b [0x]max_size_KB] [-t max_threads] [-o json filename]\n";
     std::cout << "  dump\n";
     std::cout << "  help\n";
     std::cout << "  list\n";
     std::cout << "  m2mtest\n";
-    std::cout << "  mem --read [-d card] [-a [0x]start_addr] [-i size_bytes] [-o output filename]\n";
-    std::cout << "  mem --write [-d card] [-a [0x]start_addr] [-i size_bytes] [-e pattern_byte]\n";
+    std::cout << "  mem --read [-d card] [-a [0x]start_addr] [-i size_bytes] [-o output filename] [-b [0x]block_size_KB] [-t threads] [--direct]\n";
+    std::cout << "  mem --write [-d card] [-a [0x]start_addr] [-i size_bytes] [-e pattern_byte] [-b [0x]block_size_KB] [-t threads]\n";
+    std::cout << "  dd      [-d card] --if=file | --of=file [--bs=bytes] [--count=blocks] [--skip=blocks] [--seek=blocks] [--threads=n] [--direct]\n";
     std::cout << "  program [-d card] [-r region] -p xclbin\n";
     std::cout << "  query   [-d card [-r region]]\n";
     std::cout << "  reset   [-d card]\n";
@@ -740,9 +795,13 @@ void xcldev::printHelp(const std::string& exe)
     std::cout << "  " << exe << " program -d 2 -p a.xclbin\n";
     std::cout << "Run DMA test on card 1 with 32 KB blocks of buffer\n";
     std::cout << "  " << exe << " dmatest -d 1 -b 0x2000\n";
+    std::cout << "Sweep DMA bandwidth and latency on all banks of card 0 up to 4 threads, save results in bench.json\n";
+    std::cout << "  " << exe << " dmatest --bench -t 4 -o bench.json\n";
     std::cout << "Read 256 bytes from DDR starting at 0x1000 into file read.out\n";
     std::cout << "  " << exe << " mem --read -a 0x1000 -i 256 -o read.out\n";
     std::cout << "  " << "Default values for address is 0x0, size is DDR size and file is memread.out\n";
+    std::cout << "Read all of DDR into file ddr.out with 8 threads of 4 MB blocks, bypassing the page cache\n";
+    std::cout << "  " << exe << " mem --read -b 4096 -t 8 --direct -o ddr.out\n";
     std::cout << "Write 256 bytes to DDR starting at 0x1000 with byte 0xaa \n";
     std::cout << "  " << exe << " mem --write -a 0x1000 -i 256 -e 0xaa\n";
     std::cout << "  " << "Default values for address is 0x0, size is DDR size and pattern is 0x0\n";
@@ -29,6 +29,7 @@
 #include "driver/include/xclperf.h"
 #include "driver/include/xcl_axi_checker_codes.h"
 #include "../user_common/dmatest.h"
+#include "../user_common/dmabench.h"
 #include "../user_common/memaccess.h"
 #include "../user_common/dd.h"
 #include "../user_common/utils.h"
@@ -87,6 +88,8 @@ enum subcommand {
     STATUS_SPC,
     STREAM,
     STATUS_UNSUPPORTED,
+    MEM_DIRECT,
+    DMATEST_BENCH,
 };
 enum statusmask {
     STATUS_NONE_MASK = 0x0,
@@ -1189,7 +1192,57 @@ public:
         return result;
     }
 
-    int memread(std::string aFilename, unsigned long long aStartAddr = 0, unsigned long long aSize = 0) {
+    /*
+     * dmabench
+     *
+     * Sweep DMA bandwidth and latency over all memory banks in
+     * mem_topology.  Results are optionally written as JSON to aJsonFile.
+     */
+    int dmabench(size_t aMaxSize, unsigned aMaxThreads, const std::string& aJsonFile) {
+        std::string errmsg;
+        std::vector<char> buf;
+        pcidev::get_dev(m_idx)->user->sysfs_get("icap", "mem_topology", errmsg, buf);
+        if (!errmsg.empty()) {
+            std::cout << errmsg << std::endl;
+            return -EINVAL;
+        }
+        const mem_topology *map = (mem_topology *)buf.data();
+        if (buf.empty() || map->m_count == 0) {
+            std::cout << "WARNING: 'mem_topology' invalid, "
+                << "unable to perform DMA benchmark. Has the bitstream been loaded? "
+                << "See 'xbutil program'." << std::endl;
+            return -EINVAL;
+        }
+
+        std::vector<DMABenchmark::bank> banks;
+        for (int32_t i = 0; i < map->m_count; i++) {
+            if (map->m_mem_data[i].m_type == MEM_STREAMING || !map->m_mem_data[i].m_used)
+                continue;
+            banks.emplace_back(i, (const char*)map->m_mem_data[i].m_tag, map->m_mem_data[i].m_size * 1024);
+        }
+
+        DMABenchmark::options options;
+        if (aMaxSize)
+            options.m_max_size = aMaxSize;
+        if (aMaxThreads)
+            options.m_max_threads = aMaxThreads;
+        DMABenchmark bench(m_handle, banks, options);
+        int result = bench.run(std::cout);
+
+        if (!aJsonFile.empty()) {
+            std::ofstream ostr(aJsonFile);
+            if (!ostr) {
+                std::cout << "ERROR: Cannot open " << aJsonFile << std::endl;
+                return -EINVAL;
+            }
+            bench.writeJson(ostr, m_devinfo.mName);
+            std::cout << "INFO: Results saved in file: " << aJsonFile << std::endl;
+        }
+        return result;
+    }
+
+    int memread(std::string aFilename, unsigned long long aStartAddr = 0, unsigned long long aSize = 0,
+                const memxfer::options& aXferOptions = memxfer::options()) {
         std::ios_base::fmtflags f(std::cout.flags());
         if (strstr(m_devinfo.mName, "-xare")) {//This is ARE device
           if (aStartAddr > m_devinfo.mDDRSize) {
@@ -1204,7 +1257,7 @@ public:
         std::cout.flags(f);
 
         return memaccess(m_handle, m_devinfo.mDDRSize, m_devinfo.mDataAlignment,
-            pcidev::get_dev(m_idx)->user->sysfs_name).read(
+            pcidev::get_dev(m_idx)->user->sysfs_name, aXferOptions).read(
             aFilename, aStartAddr, aSize);
     }
 
@@ -1221,7 +1274,8 @@ public:
             aStartAddr, aSize, aPattern, checks);
     }
 
-    int memwrite(unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern = 'J') {
+    int memwrite(unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern = 'J',
+                 const memxfer::options& aXferOptions = memxfer::options()) {
         std::ios_base::fmtflags f(std::cout.flags());
         if (strstr(m_devinfo.mName, "-xare")) {//This is ARE device
             if (aStartAddr > m_devinfo.mDDRSize) {
@@ -1235,7 +1289,7 @@ public:
         }
         std::cout.flags(f);
         return memaccess(m_handle, m_devinfo.mDDRSize, m_devinfo.mDataAlignment,
-            pcidev::get_dev(m_idx)->user->sysfs_name).write(
+            pcidev::get_dev(m_idx)->user->sysfs_name, aXferOptions).write(
             aStartAddr, aSize, aPattern);
     }
 
@@ -1294,6 +1348,8 @@ public:
      *           REQUIRED for deviceToFile
      * --skip : specify the source offset (in block counts) OPTIONAL defaults to 0
      * --seek : specify the destination offset (in block counts) OPTIONAL defaults to 0
+     * --threads : specify the number of DMA threads OPTIONAL
+     * --direct : use O_DIRECT for file I/O OPTIONAL
      */
     int do_dd(dd::ddArgs_t args )
     {
@@ -1302,55 +1358,43 @@ public:
         }
         if( args.dir == dd::unset ) {
             return -1; // direction invalid
-        } else if( args.dir == dd::deviceToFile ) {
-            unsigned long long addr = args.skip; // ddr read offset
-            while( args.count-- > 0 ) { // writes all full blocks
-                memread( args.file, addr, args.blockSize ); // returns 0 on complete read.
-                // how to check for partial reads when device is empty?
-                addr += args.blockSize;
-            }
-        } else if( args.dir == dd::fileToDevice ) {
-            // write entire contents of file to device DDR at seek offset.
-            unsigned long long addr = args.seek; // ddr write offset
-            std::ifstream iStream( args.file.c_str(), std::ifstream::binary );
-            if( !iStream ) {
-                perror( "open input file" );
-                return errno;
-            }
-            // If unspecified count, calculate the count from the full file size.
-            if( args.count <= 0 ) {
-                iStream.seekg( 0, iStream.end );
-                int length = iStream.tellg();
-                args.count = length / args.blockSize + 1; // round up
-                iStream.seekg( 0, iStream.beg );
-            }
-            iStream.seekg( 0, iStream.beg );
-
-            char *buf;
-            static char *inBuf;
-            size_t inSize;
+        }
 
-            inBuf = (char*)malloc( args.blockSize );
-            if( !inBuf ) {
-                perror( "malloc block size" );
+        // Block size of dd is also the transfer block size
+        memxfer::options xferOptions;
+        unsigned long long blockSize = args.blockSize > 0 ? args.blockSize : dd::defaultBS;
+        xferOptions.m_block_size = blockSize;
+        if( args.threads > 0 )
+            xferOptions.m_threads = args.threads;
+        xferOptions.m_direct = args.direct;
+        unsigned long long skip = args.skip > 0 ? args.skip : 0; // source offset
+        unsigned long long seek = args.seek > 0 ? args.seek : 0; // destination offset
+        memaccess mem(m_handle, m_devinfo.mDDRSize, m_devinfo.mDataAlignment,
+                      pcidev::get_dev(m_idx)->user->sysfs_name, xferOptions);
+
+        if( args.dir == dd::deviceToFile ) {
+            // Like dd, drop output past the seek offset
+            if( truncate( args.file.c_str(), seek ) < 0 && errno != ENOENT ) {
+                perror( "truncate output file" );
                 return errno;
             }
+            return mem.readToFile( args.file, skip, args.count * blockSize, seek );
+        }
 
-            while( args.count-- > 0 ) { // writes all full blocks
-                buf = inBuf;
-                inSize = iStream.read( inBuf, args.blockSize ).gcount();
-                if( (int)inSize == args.blockSize ) {
-                    // full read
-                } else {
-                    // Partial read--write size specified greater than read size. Writing remainder of input file.
-                    args.count = 0; // force break
-                }
-                memwrite( addr, inSize, buf );
-                addr += inSize;
-            }
-            iStream.close();
+        // fileToDevice: If unspecified count, copy the remainder of the input file.
+        struct stat sb;
+        if( stat( args.file.c_str(), &sb ) < 0 ) {
+            perror( "open input file" );
+            return errno;
         }
-        return 0;
+        unsigned long long length = (unsigned long long)sb.st_size > skip ? sb.st_size - skip : 0;
+        if( args.count > 0 && args.count * blockSize < length ) {
+            length = args.count * blockSize;
+        }
+        if( length == 0 ) {
+            return 0;
+        }
+        return mem.writeFromFile( args.file, seek, length, skip );
     }
 
     int usageInfo(xclDeviceUsage& devstat) const {
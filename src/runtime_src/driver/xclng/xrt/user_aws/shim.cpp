@@ -58,6 +58,8 @@
 #include <poll.h>
 #include "xclbin.h"
 #include "driver/xclng/include/xocl_ioctl.h"
+#include "driver/common/message.h"
+#include "driver/common/xclbin_compress.h"
 #include "scan.h"
 #include "awssak.h"
 
@@ -1273,6 +1275,14 @@ int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
     awsbwhal::AwsXcl *drv = awsbwhal::AwsXcl::handleCheck(handle);
     if (!drv)
         return -1;
+    std::vector<char> expanded;
+    try {
+        buffer = reinterpret_cast<const xclBin*>(xrt_core::xclbin::expand(reinterpret_cast<const axlf*>(buffer), expanded));
+    }
+    catch (const std::exception& ex) {
+        xrt_core::message::send(xrt_core::message::severity_level::ERROR, "XRT", ex.what());
+        return -EINVAL;
+    }
     return drv->xclLoadXclBin(buffer);
 }
 
@@ -19,7 +19,7 @@
 #include "dd.h"
 
 namespace dd {
-const char *ddOptString = "i:o:b:c:p:e:";
+const char *ddOptString = "i:o:b:c:p:e:t:x";
 
 static const struct option longOpts[] = {
     { "if",    required_argument, NULL, 'i' },
@@ -27,7 +27,10 @@ static const struct option longOpts[] = {
     { "bs",    required_argument, 0,    'b' },
     { "count", required_argument, 0,    'c' },
     { "skip",  required_argument, 0,    'p' },
-    { "seek",  required_argument, 0,    'e' }
+    { "seek",  required_argument, 0,    'e' },
+    { "threads", required_argument, 0,  't' },
+    { "direct", no_argument,       0,   'x' },
+    { 0, 0, 0, 0 }
 };
 
 /*
@@ -65,6 +68,10 @@ ddArgs_t parse_dd_options( int argc, char *argv[] )
     args.count = -1;
     args.skip = -1;
     args.seek = -1;
+    args.threads = 0;
+    args.direct = false;
+    int skipBlocks = -1, seekBlocks = -1;
+    bool countSet = false;
     std::string tmpInFile, tmpOutFile = "";
 
     opt = getopt_long( argc, argv, ddOptString, longOpts, &longIndex );
@@ -88,17 +95,28 @@ ddArgs_t parse_dd_options( int argc, char *argv[] )
 
         case 'c':
             args.count = atoi( optarg );
+            countSet = true;
             std::cout << "count found: " << args.count << std::endl;
             break;
 
         case 'p':
-            args.skip = atoi( optarg ) * args.blockSize; // must be sure blockSize has been parsed first
-            std::cout << "skip found: " << args.skip << std::endl;
+            skipBlocks = atoi( optarg );
+            std::cout << "skip found: " << skipBlocks << std::endl;
             break;
 
         case 'e':
-            args.seek = atoi( optarg ) * args.blockSize; // must be sure blockSize has been parsed first
-            std::cout << "seek found: " << args.seek << std::endl;
+            seekBlocks = atoi( optarg );
+            std::cout << "seek found: " << seekBlocks << std::endl;
+            break;
+
+        case 't':
+            args.threads = atoi( optarg );
+            std::cout << "threads found: " << args.threads << std::endl;
+            break;
+
+        case 'x':
+            args.direct = true;
+            std::cout << "direct found" << std::endl;
             break;
 
         default:
@@ -126,18 +144,30 @@ ddArgs_t parse_dd_options( int argc, char *argv[] )
         args.isValid = false;
     }
 
-    // Test for legal combinations of skip/seek.
-    if( args.dir == deviceToFile && args.skip > 0 ) {
-        args.isValid = false;
+    // skip and seek are in blocks, convert once block size is known.
+    // skip is the source offset and seek the destination offset in
+    // both directions.
+    int blockSize = args.blockSize > 0 ? args.blockSize : defaultBS;
+    if( skipBlocks > 0 ) {
+        args.skip = (long long)skipBlocks * blockSize;
+    }
+    if( seekBlocks > 0 ) {
+        args.seek = (long long)seekBlocks * blockSize;
     }
-    if( args.dir == fileToDevice && args.seek > 0 ) {
+    if( args.threads < 0 ) {
         args.isValid = false;
     }
 
     // Test for legal count value; must be specified for dir==deviceToFile
+    // and must be positive when specified, a count of 0 would otherwise
+    // be taken as the whole bank
     if( args.dir == deviceToFile && args.count < 0 ) {
         args.isValid = false;
     }
+    if( countSet && args.count <= 0 ) {
+        std::cout << "ERROR: count must be a positive number of blocks" << std::endl;
+        args.isValid = false;
+    }
 
     return args;
 }
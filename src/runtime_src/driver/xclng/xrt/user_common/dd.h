@@ -47,8 +47,10 @@ struct ddArgs_t {
     int blockSize = defaultBS;
     e_direction dir;
     int count = -1;
-    int skip = -1;
-    int seek = -1;
+    long long skip = -1;
+    long long seek = -1;
+    int threads = 0;
+    bool direct = false;
 };
 /*
  * parse_dd_options
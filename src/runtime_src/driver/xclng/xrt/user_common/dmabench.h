@@ -0,0 +1,292 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef DMABENCH_H
+#define DMABENCH_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "driver/include/xclhal2.h"
+
+namespace xcldev {
+
+    /*
+     * DMABenchmark
+     *
+     * Sweeps DMA transfer size, thread count and direction over a set of
+     * memory banks and reports bandwidth and latency percentiles of
+     * xclSyncBO.  Only HAL APIs are used so the benchmark runs on
+     * hardware as well as on the emulation shims.
+     *
+     * Each thread syncs its own BO in the bank.  Bidirectional points run
+     * the given number of threads in each direction simultaneously.
+     * Points that don't fit in the bank or in the host footprint limit,
+     * or whose BOs cannot be allocated, are reported as skipped.
+     */
+    class DMABenchmark {
+    public:
+        enum direction {
+            TO_DEVICE,
+            FROM_DEVICE,
+            BIDIRECTIONAL
+        };
+
+        struct bank {
+            unsigned m_index;
+            std::string m_tag;
+            uint64_t m_size;
+            bank(unsigned aIndex, const std::string& aTag, uint64_t aSize) : m_index(aIndex), m_tag(aTag), m_size(aSize) {}
+        };
+
+        struct options {
+            size_t m_min_size = 0x1000;          // 4KB
+            size_t m_max_size = 0x40000000;      // 1GB
+            unsigned m_max_threads = 8;
+            uint64_t m_bytes_per_point = 0x40000000; // data moved per thread and point
+            unsigned m_min_iterations = 4;
+            unsigned m_max_iterations = 10000;
+            uint64_t m_max_footprint = 0x100000000;  // BO bytes allocated per point
+            std::vector<direction> m_directions = {TO_DEVICE, FROM_DEVICE, BIDIRECTIONAL};
+        };
+
+        struct result {
+            unsigned m_bank;
+            direction m_dir;
+            size_t m_size;
+            unsigned m_threads;
+            unsigned m_iterations;
+            bool m_skipped;
+            double m_gbps;
+            double m_p50_us;
+            double m_p99_us;
+            double m_p999_us;
+        };
+
+    private:
+        xclDeviceHandle mHandle;
+        std::vector<bank> mBanks;
+        options mOptions;
+        std::vector<result> mResults;
+
+        static const char* dirName(direction aDir) {
+            switch (aDir) {
+            case TO_DEVICE: return "write";
+            case FROM_DEVICE: return "read";
+            default: return "bidir";
+            }
+        }
+
+        // Nearest rank percentile of sorted samples in ns, returned in us
+        static double percentile(const std::vector<long long>& aSorted, double aRank) {
+            if (aSorted.empty())
+                return 0;
+            size_t idx = static_cast<size_t>(std::ceil(aRank * aSorted.size()));
+            idx = std::min(std::max<size_t>(idx, 1), aSorted.size()) - 1;
+            return aSorted[idx] / 1000.0;
+        }
+
+        result measure(const bank& aBank, direction aDir, size_t aSize, unsigned aThreads) const {
+            result res = {aBank.m_index, aDir, aSize, aThreads, 0, true, 0, 0, 0, 0};
+            unsigned streams = (aDir == BIDIRECTIONAL) ? aThreads * 2 : aThreads;
+            uint64_t footprint = (uint64_t)aSize * streams;
+            if (footprint > aBank.m_size || footprint > mOptions.m_max_footprint)
+                return res;
+
+            uint64_t iterations = mOptions.m_bytes_per_point / aSize;
+            iterations = std::max<uint64_t>(iterations, mOptions.m_min_iterations);
+            iterations = std::min<uint64_t>(iterations, mOptions.m_max_iterations);
+
+            std::vector<unsigned> bos;
+            for (unsigned s = 0; s < streams; ++s) {
+                unsigned bo = xclAllocBO(mHandle, aSize, XCL_BO_DEVICE_RAM, aBank.m_index);
+                if (bo == 0xffffffff)
+                    break;
+                bos.push_back(bo);
+            }
+            if (bos.size() != streams) {
+                for (auto bo : bos)
+                    xclFreeBO(mHandle, bo);
+                return res;
+            }
+
+            // Threads spin until all are started so that the wall clock
+            // covers concurrent transfers only
+            std::vector<std::vector<long long>> latencies(streams, std::vector<long long>(iterations));
+            std::atomic<unsigned> ready(0);
+            std::atomic<bool> go(false);
+            std::atomic<int> errors(0);
+            std::vector<std::thread> workers;
+            for (unsigned s = 0; s < streams; ++s) {
+                xclBOSyncDirection dir = (aDir == FROM_DEVICE || (aDir == BIDIRECTIONAL && (s & 1)))
+                    ? XCL_BO_SYNC_BO_FROM_DEVICE : XCL_BO_SYNC_BO_TO_DEVICE;
+                workers.emplace_back([&, s, dir] {
+                    auto& lat = latencies[s];
+                    ++ready;
+                    while (!go)
+                        std::this_thread::yield();
+                    for (auto& sample : lat) {
+                        auto start = std::chrono::steady_clock::now();
+                        if (xclSyncBO(mHandle, bos[s], dir, aSize, 0)) {
+                            ++errors;
+                            break;
+                        }
+                        sample = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+                    }
+                });
+            }
+            while (ready != streams)
+                std::this_thread::yield();
+            auto start = std::chrono::steady_clock::now();
+            go = true;
+            for (auto& w : workers)
+                w.join();
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            for (auto bo : bos)
+                xclFreeBO(mHandle, bo);
+            if (errors) {
+                std::cout << "ERROR: DMA " << dirName(aDir) << " of " << aSize << " bytes failed on bank "
+                          << aBank.m_tag << std::endl;
+                return res;
+            }
+
+            std::vector<long long> all;
+            all.reserve(streams * iterations);
+            for (const auto& lat : latencies)
+                all.insert(all.end(), lat.begin(), lat.end());
+            std::sort(all.begin(), all.end());
+
+            res.m_skipped = false;
+            res.m_iterations = iterations;
+            res.m_gbps = seconds > 0 ? (double)aSize * iterations * streams / seconds / 1e9 : 0;
+            res.m_p50_us = percentile(all, 0.50);
+            res.m_p99_us = percentile(all, 0.99);
+            res.m_p999_us = percentile(all, 0.999);
+            return res;
+        }
+
+        void print(std::ostream& aOut, const result& aRes) const {
+            std::ios_base::fmtflags f(aOut.flags());
+            aOut << std::left << std::setw(8) << aRes.m_bank << std::setw(7) << dirName(aRes.m_dir)
+                 << std::right << std::setw(12) << aRes.m_size << std::setw(8) << aRes.m_threads;
+            if (aRes.m_skipped) {
+                aOut << "  skipped\n";
+            }
+            else {
+                aOut << std::setw(8) << aRes.m_iterations << std::fixed << std::setprecision(3)
+                     << std::setw(10) << aRes.m_gbps << std::setprecision(1)
+                     << std::setw(12) << aRes.m_p50_us << std::setw(12) << aRes.m_p99_us
+                     << std::setw(12) << aRes.m_p999_us << "\n";
+            }
+            aOut.flags(f);
+        }
+
+    public:
+        DMABenchmark(xclDeviceHandle aHandle, const std::vector<bank>& aBanks, const options& aOptions)
+            : mHandle(aHandle), mBanks(aBanks), mOptions(aOptions) {}
+
+        const std::vector<result>& results() const {
+            return mResults;
+        }
+
+        /*
+         * run()
+         *
+         * Run all points, printing one line per point as it completes.
+         * Returns 0 if at least one point was measured.
+         */
+        int run(std::ostream& aOut = std::cout) {
+            mResults.clear();
+            aOut << std::left << std::setw(8) << "Bank" << std::setw(7) << "Dir" << std::right
+                 << std::setw(12) << "Size(B)" << std::setw(8) << "Threads" << std::setw(8) << "Iters"
+                 << std::setw(10) << "GB/s" << std::setw(12) << "p50(us)" << std::setw(12) << "p99(us)"
+                 << std::setw(12) << "p999(us)" << "\n";
+            bool measured = false;
+            for (const auto& b : mBanks) {
+                for (auto dir : mOptions.m_directions) {
+                    for (size_t size = mOptions.m_min_size; size <= mOptions.m_max_size; size *= 2) {
+                        for (unsigned threads = 1; threads <= mOptions.m_max_threads; threads *= 2) {
+                            mResults.push_back(measure(b, dir, size, threads));
+                            print(aOut, mResults.back());
+                            measured |= !mResults.back().m_skipped;
+                        }
+                    }
+                }
+            }
+            return measured ? 0 : -1;
+        }
+
+        /*
+         * jsonEscape()
+         *
+         * Escape a string for use as a JSON string value
+         */
+        static std::string jsonEscape(const std::string& aValue) {
+            std::string escaped;
+            for (unsigned char c : aValue) {
+                if (c == '"' || c == '\\') {
+                    escaped += '\\';
+                    escaped += c;
+                }
+                else if (c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    escaped += buf;
+                }
+                else {
+                    escaped += c;
+                }
+            }
+            return escaped;
+        }
+
+        /*
+         * writeJson()
+         */
+        void writeJson(std::ostream& aOut, const std::string& aDevice) const {
+            aOut << "{\n  \"device\": \"" << jsonEscape(aDevice) << "\",\n  \"banks\": [";
+            for (size_t i = 0; i < mBanks.size(); ++i) {
+                aOut << (i ? "," : "") << "\n    {\"index\": " << mBanks[i].m_index << ", \"tag\": \""
+                     << jsonEscape(mBanks[i].m_tag) << "\", \"size\": " << mBanks[i].m_size << "}";
+            }
+            aOut << "\n  ],\n  \"results\": [";
+            for (size_t i = 0; i < mResults.size(); ++i) {
+                const result& r = mResults[i];
+                aOut << (i ? "," : "") << "\n    {\"bank\": " << r.m_bank << ", \"direction\": \"" << dirName(r.m_dir)
+                     << "\", \"size\": " << r.m_size << ", \"threads\": " << r.m_threads;
+                if (r.m_skipped)
+                    aOut << ", \"skipped\": true}";
+                else
+                    aOut << ", \"iterations\": " << r.m_iterations << ", \"gbps\": " << r.m_gbps
+                         << ", \"p50_us\": " << r.m_p50_us << ", \"p99_us\": " << r.m_p99_us
+                         << ", \"p999_us\": " << r.m_p999_us << "}";
+            }
+            aOut << "\n  ]\n}\n";
+        }
+    };
+}
+
+#endif /* DMABENCH_H */
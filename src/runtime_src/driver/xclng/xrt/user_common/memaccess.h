@@ -30,6 +30,7 @@
 #include <numeric>
 #include <dirent.h>
 #include "dmatest.h"
+#include "memxfer.h"
 
 #include "driver/include/xclhal2.h"
 #include "driver/include/xclbin.h"
@@ -86,10 +87,16 @@ namespace xcldev {
     xclDeviceHandle mHandle;
     size_t mDDRSize, mDataAlignment;
     std::string mDevUserName;
+    memxfer::options mXferOptions;
   public:
     memaccess(xclDeviceHandle aHandle, size_t aDDRSize, size_t aDataAlignment, std::string& aDevUserName) :
               mHandle(aHandle), mDDRSize(aDDRSize), mDataAlignment (aDataAlignment), mDevUserName(aDevUserName) {}
 
+    memaccess(xclDeviceHandle aHandle, size_t aDDRSize, size_t aDataAlignment, std::string& aDevUserName,
+              const memxfer::options& aXferOptions) :
+              mHandle(aHandle), mDDRSize(aDDRSize), mDataAlignment (aDataAlignment), mDevUserName(aDevUserName),
+              mXferOptions(aXferOptions) {}
+
     struct mem_bank_t {
       uint64_t m_base_address;
       uint64_t m_size;
@@ -152,44 +159,23 @@ namespace xcldev {
     }
 
     /*
-     * readBank()
+     * getSegments()
      *
-     * Read from specified address, specified size within a bank
+     * Split aSize bytes from aStartAddr in startbank into one transfer
+     * segment per bank.  File offsets of the segments start at aFileOffset.
      * Caller's responsibility to do sanity checks. No sanity checks done here
      */
-    int readBank(std::ofstream& aOutFile, unsigned long long aStartAddr, unsigned long long aSize) {
-      char *buf = 0;
-      unsigned long long blockSize = 0x20000;
-      if (posix_memalign((void**)&buf, getpagesize(), blockSize))
-        return -1;
-      std::memset(buf, 0, blockSize);
-
-      size_t count = aSize;
-      uint64_t incr;
-      for (uint64_t phy = aStartAddr; phy < aStartAddr+aSize; phy += incr) {
-        incr = (count >= blockSize) ? blockSize : count;
-        //std::cout << "Reading from addr " << std::hex << phy << " aSize = " << std::hex << incr << std::dec << std::endl;
-        if (xclUnmgdPread(mHandle, 0, buf, incr, phy) < 0) {
-          //error
-          std::cout << "Error (" << strerror (errno) << ") reading 0x" << std::hex << incr << " bytes from DDR at offset 0x" << std::hex << phy << std::dec << "\n";
-          free(buf);
-          return -1;
-        }
-        count -= incr;
-        if (incr) {
-          aOutFile.write((const char*)buf, incr);
-          if ((aOutFile.rdstate() & std::ifstream::failbit) != 0) {
-            std::cout << "Error writing to file at offset " << aSize-count << "\n";
-          }
-        }
-        std::cout << "INFO: Read size 0x" << std::hex << incr << " B. Total Read so far 0x" << aSize-count << std::endl;
-      }
-      free(buf);
-      if (count != 0) {
-        std::cout << "Error! Read " << std::dec << aSize-count << " bytes, requested " << aSize << std::endl;
-        return -1;
+    void getSegments(std::vector<mem_bank_t>::iterator startbank, std::vector<mem_bank_t>::iterator endbank,
+                     unsigned long long aStartAddr, unsigned long long aSize, uint64_t aFileOffset,
+                     std::vector<memxfer::segment>& aSegments) {
+      for(auto it = startbank; it!=endbank && aSize!=0; ++it) {
+        unsigned long long startAddr = (it != startbank) ? it->m_base_address : aStartAddr;
+        unsigned long long available_bank_size = it->m_size - (startAddr - it->m_base_address);
+        unsigned long long accesssize = (aSize > available_bank_size) ? available_bank_size : aSize;
+        aSegments.emplace_back(startAddr, accesssize, aFileOffset);
+        aFileOffset += accesssize;
+        aSize -= accesssize;
       }
-      return count;
     }
 
     int runDMATest(size_t blocksize, unsigned int aPattern) 
@@ -322,37 +308,55 @@ namespace xcldev {
         std::cout << "INFO: Reading from single bank, " << std::dec << size << " bytes from DDR address 0x"  << std::hex << startAddr
                                     << std::dec << std::endl;
       }
-      std::ofstream outFile(aFilename, std::ofstream::out | std::ofstream::binary);
       char temp[32] = "====START of DDR Data=========\n";
-      outFile.write(temp, sizeof(temp));
-
-      size_t count = size;
-      for(auto it = startbank; it!=vec_banks.end(); ++it) {
-        unsigned long long available_bank_size;
-        if (it != startbank) {
-          startAddr = it->m_base_address;
-          available_bank_size = it->m_size;
-        }
-        else {
-          //startAddr = startAddr;
-          available_bank_size = it->m_size - (startAddr - it->m_base_address);
-        }
-        if (size != 0) {
-          unsigned long long readsize = (size > available_bank_size) ? (unsigned long long) available_bank_size : size;
-          if( readBank(outFile, startAddr, readsize) == -1) {
-            return -1;
-          }
-          size -= readsize;
-        }
-        else {
-          break;
-        }
+      std::vector<memxfer::segment> segments;
+      getSegments(startbank, vec_banks.end(), startAddr, size, sizeof(temp), segments);
+      if (memxfer(mHandle, mXferOptions).toFile(aFilename, segments) == -1) {
+        return -1;
       }
+
+      // Data is in place, add the markers around it
+      std::fstream outFile(aFilename, std::fstream::in | std::fstream::out | std::fstream::binary);
+      outFile.write(temp, sizeof(temp));
+      outFile.seekp(sizeof(temp) + size);
       strncpy(temp, "\n=====END of DDR Data=========\n", sizeof(temp));
       outFile.write(temp, sizeof(temp));
       outFile.close();
-      std::cout << "INFO: Read data saved in file: " << aFilename << "; Num of bytes: " << std::dec << count-size << " bytes " << std::endl;
-      return size;
+      std::cout << "INFO: Read data saved in file: " << aFilename << "; Num of bytes: " << std::dec << size << " bytes " << std::endl;
+      return 0;
+    }
+
+    /*
+     * readToFile()
+     *
+     * Read raw device memory into a file at the given file offset.
+     * The file is not truncated.
+     */
+    int readToFile(const std::string& aFilename, unsigned long long aStartAddr, unsigned long long aSize, uint64_t aFileOffset) {
+      std::vector<mem_bank_t> vec_banks;
+      std::vector<mem_bank_t>::iterator startbank;
+      if (readWriteHelper(aStartAddr, aSize, vec_banks, startbank) == -1) {
+        return -1;
+      }
+      std::vector<memxfer::segment> segments;
+      getSegments(startbank, vec_banks.end(), aStartAddr, aSize, aFileOffset, segments);
+      return memxfer(mHandle, mXferOptions).toFile(aFilename, segments, false);
+    }
+
+    /*
+     * writeFromFile()
+     *
+     * Write device memory from a file at the given file offset
+     */
+    int writeFromFile(const std::string& aFilename, unsigned long long aStartAddr, unsigned long long aSize, uint64_t aFileOffset) {
+      std::vector<mem_bank_t> vec_banks;
+      std::vector<mem_bank_t>::iterator startbank;
+      if (readWriteHelper(aStartAddr, aSize, vec_banks, startbank) == -1) {
+        return -1;
+      }
+      std::vector<memxfer::segment> segments;
+      getSegments(startbank, vec_banks.end(), aStartAddr, aSize, aFileOffset, segments);
+      return memxfer(mHandle, mXferOptions).fromFile(aFilename, segments);
     }
 
     /*
@@ -437,42 +441,12 @@ namespace xcldev {
      * Caller's responsibility to do sanity checks. No sanity checks done here
      */
     int writeBank(unsigned long long aStartAddr, unsigned long long aSize, unsigned int aPattern) {
-      char *buf = 0;
-      unsigned long long endAddr;
-      unsigned long long size;
-      unsigned long long blockSize = 0x20000;//128KB
-      if (posix_memalign((void**)&buf, getpagesize(), blockSize))
-        return -1;
+      std::cout << "INFO: Writing DDR with " << std::dec << aSize << " bytes of pattern: 0x"
+         << std::hex << aPattern << " from address 0x" <<std::hex << aStartAddr << std::dec << std::endl;
 
-      endAddr = aStartAddr + aSize;
-      size = endAddr-aStartAddr;
-
-      // Use plain POSIX open/pwrite/close.
-
-      std::cout << "INFO: Writing DDR with " << std::dec << size << " bytes of pattern: 0x"
-         << std::hex << aPattern << " from address 0x" <<std::hex << aStartAddr << std::endl;
-
-      unsigned long long count = size;
-      uint64_t incr = 0;
-      std::memset(buf, aPattern, blockSize);
-      for(uint64_t phy=aStartAddr; phy<endAddr; phy+=incr) {
-        incr = (count >= blockSize) ? blockSize : count;
-        //std::cout << "Writing to addr " << std::hex << phy << " size = " << std::hex << incr << std::dec << std::endl;
-        if (xclUnmgdPwrite(mHandle, 0, buf, incr, phy) < 0) {
-          //error
-          std::cout << "Error (" << strerror (errno) << ") writing 0x" << std::hex << incr << " bytes to DDR at offset 0x" << std::hex << phy << std::dec << "\n";
-          free(buf);
-          return -1;
-        }
-        count -= incr;
-      }
-
-      free(buf);
-      if (count != 0) {
-        std::cout << "Error! Written " << std::dec << size-count << " bytes, requested " << size << std::endl;
-        return -1;
-      }
-      return count;
+      std::vector<memxfer::segment> segments;
+      segments.emplace_back(aStartAddr, aSize, 0);
+      return memxfer(mHandle, mXferOptions).fill(segments, aPattern);
     }
 
     /*
@@ -498,28 +472,11 @@ namespace xcldev {
         std::cout << "INFO: Writing to single bank, " << std::dec << size << " bytes from DDR address 0x"  << std::hex << startAddr
                                     << std::dec << std::endl;
       }
-      for(auto it = startbank; it!=vec_banks.end(); ++it) {
-        unsigned long long available_bank_size;
-        if (it != startbank) {
-          startAddr = it->m_base_address;
-          available_bank_size = it->m_size;
-        }
-        else {
-          //startAddr = startAddr;
-          available_bank_size = it->m_size - (startAddr - it->m_base_address);
-        }
-        if (size != 0) {
-          unsigned long long writesize = (size > available_bank_size) ? (unsigned long long) available_bank_size : size;
-          if( writeBank(startAddr, writesize, aPattern) == -1) {
-            return -1;
-          }
-          size -= writesize;
-        }
-        else {
-          break;
-        }
-      }
-      return size;
+      std::cout << "INFO: Writing DDR with " << std::dec << size << " bytes of pattern: 0x"
+         << std::hex << aPattern << std::dec << std::endl;
+      std::vector<memxfer::segment> segments;
+      getSegments(startbank, vec_banks.end(), startAddr, size, 0, segments);
+      return memxfer(mHandle, mXferOptions).fill(segments, aPattern);
     }
 
     /*
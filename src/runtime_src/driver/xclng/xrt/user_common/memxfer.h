@@ -0,0 +1,429 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+#ifndef MEMXFER_H
+#define MEMXFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "dmatest.h"
+
+#include "driver/include/xclhal2.h"
+
+namespace xcldev {
+
+  /*
+   * memxfer
+   *
+   * Pipelined engine moving data between device memory and a file or a
+   * fill pattern.  Used by memaccess for 'mem --read/--write' and 'dd'.
+   *
+   * A transfer is a list of segments, each a contiguous device range
+   * within one bank and its offset in the file.  Segments are split in
+   * blocks of m_block_size bytes and the blocks of all segments are
+   * interleaved so that consecutive blocks go to different banks.
+   * m_threads DMA workers issue the blocks with xclUnmgdPread/Pwrite
+   * while a file thread moves completed blocks to or from the file.
+   * There are two buffers per worker so file I/O of one set of blocks
+   * overlaps DMA of the other.
+   *
+   * With m_direct the file is also opened with O_DIRECT and blocks
+   * whose file offset and size are page aligned bypass the page cache.
+   * A segment that starts at an unaligned file offset, e.g. after the
+   * header of 'mem --read', begins with a short block up to the next
+   * page boundary so the blocks that follow are aligned.  Unaligned
+   * blocks, e.g. the head and tail of a segment, use buffered I/O.
+   */
+  class memxfer {
+  public:
+    struct options {
+      size_t m_block_size = 0x200000; // 2MB
+      unsigned m_threads = 4;
+      bool m_direct = false;
+    };
+
+    struct segment {
+      uint64_t m_dev_addr;
+      uint64_t m_size;
+      uint64_t m_file_offset;
+      segment(uint64_t aAddr, uint64_t aSize, uint64_t aOffset) : m_dev_addr(aAddr), m_size(aSize), m_file_offset(aOffset) {}
+    };
+
+  private:
+    struct block {
+      uint64_t m_dev_addr;
+      uint64_t m_size;
+      uint64_t m_file_offset;
+    };
+
+    // Blocking queue of buffers tagged with their block index, pop()
+    // returns false once the queue is closed and drained
+    class bufQueue {
+      std::deque<std::pair<size_t, char*>> mItems;
+      std::mutex mMutex;
+      std::condition_variable mCond;
+      bool mClosed = false;
+    public:
+      void push(size_t aBlock, char* aBuf) {
+        std::lock_guard<std::mutex> lk(mMutex);
+        mItems.emplace_back(aBlock, aBuf);
+        mCond.notify_one();
+      }
+      bool pop(size_t& aBlock, char*& aBuf) {
+        std::unique_lock<std::mutex> lk(mMutex);
+        mCond.wait(lk, [this] { return mClosed || !mItems.empty(); });
+        if (mItems.empty())
+          return false;
+        aBlock = mItems.front().first;
+        aBuf = mItems.front().second;
+        mItems.pop_front();
+        return true;
+      }
+      void close() {
+        std::lock_guard<std::mutex> lk(mMutex);
+        mClosed = true;
+        mCond.notify_all();
+      }
+    };
+
+    xclDeviceHandle mHandle;
+    options mOptions;
+    std::vector<block> mBlocks;
+    std::vector<char*> mBuffers;
+    std::atomic<size_t> mNext;
+    std::atomic<bool> mError;
+    int mFd = -1;
+    int mDirectFd = -1;
+    size_t mAlign;
+
+    void split(const std::vector<segment>& aSegments) {
+      mBlocks.clear();
+      std::vector<uint64_t> done(aSegments.size(), 0);
+      bool more = true;
+      while (more) {
+        more = false;
+        for (size_t i = 0; i < aSegments.size(); ++i) {
+          const segment& seg = aSegments[i];
+          if (done[i] >= seg.m_size)
+            continue;
+          uint64_t incr = std::min<uint64_t>(mOptions.m_block_size, seg.m_size - done[i]);
+          uint64_t misalign = (seg.m_file_offset + done[i]) % mAlign;
+          if (mOptions.m_direct && misalign)
+            incr = std::min<uint64_t>(incr, mAlign - misalign);
+          mBlocks.push_back({seg.m_dev_addr + done[i], incr, seg.m_file_offset + done[i]});
+          done[i] += incr;
+          more = true;
+        }
+      }
+    }
+
+    int allocBuffers(size_t aCount) {
+      for (size_t i = 0; i < aCount; ++i) {
+        char *buf = 0;
+        if (posix_memalign((void**)&buf, mAlign, mOptions.m_block_size))
+          return -1;
+        mBuffers.push_back(buf);
+      }
+      return 0;
+    }
+
+    void freeBuffers() {
+      for (auto buf : mBuffers)
+        free(buf);
+      mBuffers.clear();
+    }
+
+    unsigned numThreads() const {
+      return std::max<unsigned>(1, std::min<size_t>(mOptions.m_threads, mBlocks.size()));
+    }
+
+    int openFile(const std::string& aFilename, int aFlags) {
+      mFd = open(aFilename.c_str(), aFlags, 0644);
+      if (mFd < 0) {
+        std::cout << "ERROR: (" << strerror(errno) << ") opening file " << aFilename << std::endl;
+        return -1;
+      }
+      if (mOptions.m_direct) {
+        if (std::none_of(mBlocks.begin(), mBlocks.end(), [this](const block& b) { return isAligned(b); })) {
+          std::cout << "WARNING: No page aligned blocks in transfer, O_DIRECT not used for " << aFilename
+                    << std::endl;
+          return 0;
+        }
+        mDirectFd = open(aFilename.c_str(), (aFlags & ~(O_CREAT | O_TRUNC)) | O_DIRECT);
+        if (mDirectFd < 0)
+          std::cout << "WARNING: (" << strerror(errno) << ") O_DIRECT not supported for " << aFilename
+                    << ", using buffered I/O" << std::endl;
+      }
+      return 0;
+    }
+
+    void closeFile() {
+      if (mDirectFd >= 0)
+        close(mDirectFd);
+      if (mFd >= 0)
+        close(mFd);
+      mFd = mDirectFd = -1;
+    }
+
+    bool isAligned(const block& aBlock) const {
+      return (aBlock.m_file_offset % mAlign) == 0 && (aBlock.m_size % mAlign) == 0;
+    }
+
+    int fileFd(const block& aBlock) const {
+      if (mDirectFd >= 0 && isAligned(aBlock))
+        return mDirectFd;
+      return mFd;
+    }
+
+    bool fileWrite(const block& aBlock, const char* aBuf) {
+      int fd = fileFd(aBlock);
+      uint64_t done = 0;
+      while (done < aBlock.m_size) {
+        ssize_t ret = pwrite(fd, aBuf + done, aBlock.m_size - done, aBlock.m_file_offset + done);
+        if (ret < 0) {
+          if (errno == EINTR)
+            continue;
+          std::cout << "ERROR: (" << strerror(errno) << ") writing to file at offset " << std::dec
+                    << aBlock.m_file_offset + done << std::endl;
+          return false;
+        }
+        done += ret;
+      }
+      return true;
+    }
+
+    bool fileRead(const block& aBlock, char* aBuf) {
+      int fd = fileFd(aBlock);
+      uint64_t done = 0;
+      while (done < aBlock.m_size) {
+        ssize_t ret = pread(fd, aBuf + done, aBlock.m_size - done, aBlock.m_file_offset + done);
+        if (ret < 0 && errno == EINTR)
+          continue;
+        if (ret <= 0) {
+          std::cout << "ERROR: (" << (ret ? strerror(errno) : "end of file") << ") reading from file at offset "
+                    << std::dec << aBlock.m_file_offset + done << std::endl;
+          return false;
+        }
+        done += ret;
+      }
+      return true;
+    }
+
+    bool devRead(const block& aBlock, char* aBuf) {
+      if (xclUnmgdPread(mHandle, 0, aBuf, aBlock.m_size, aBlock.m_dev_addr) < 0) {
+        std::cout << "Error (" << strerror (errno) << ") reading 0x" << std::hex << aBlock.m_size
+                  << " bytes from DDR at offset 0x" << aBlock.m_dev_addr << std::dec << "\n";
+        return false;
+      }
+      return true;
+    }
+
+    bool devWrite(const block& aBlock, const char* aBuf) {
+      if (xclUnmgdPwrite(mHandle, 0, aBuf, aBlock.m_size, aBlock.m_dev_addr) < 0) {
+        std::cout << "Error (" << strerror (errno) << ") writing 0x" << std::hex << aBlock.m_size
+                  << " bytes to DDR at offset 0x" << aBlock.m_dev_addr << std::dec << "\n";
+        return false;
+      }
+      return true;
+    }
+
+    uint64_t total() const {
+      uint64_t size = 0;
+      for (const auto& b : mBlocks)
+        size += b.m_size;
+      return size;
+    }
+
+    void report(const char* aWhat, long long aMicros) const {
+      uint64_t size = total();
+      double mbps = aMicros ? (double)size / aMicros : 0;
+      std::cout << "INFO: " << aWhat << " " << std::dec << size << " bytes in " << aMicros / 1000.0 << " ms ("
+                << mbps << " MB/s) using " << numThreads() << " thread(s) and " << mOptions.m_block_size / 1024
+                << " KB blocks" << (mDirectFd >= 0 ? ", O_DIRECT" : "") << std::endl;
+    }
+
+    int finish(const char* aWhat, Timer& aTimer) {
+      long long micros = aTimer.stop();
+      if (!mError)
+        report(aWhat, micros);
+      closeFile();
+      freeBuffers();
+      return mError ? -1 : 0;
+    }
+
+  public:
+    memxfer(xclDeviceHandle aHandle, const options& aOptions) : mHandle(aHandle), mOptions(aOptions),
+                                                                mNext(0), mError(false), mAlign(getpagesize()) {
+      // Direct I/O and the DMA engine both want page multiples
+      mOptions.m_block_size = std::max<size_t>(mAlign, (mOptions.m_block_size + mAlign - 1) / mAlign * mAlign);
+      if (!mOptions.m_threads)
+        mOptions.m_threads = 1;
+    }
+
+    ~memxfer() {
+      closeFile();
+      freeBuffers();
+    }
+
+    /*
+     * toFile()
+     *
+     * Read segments from device into file at their file offsets
+     */
+    int toFile(const std::string& aFilename, const std::vector<segment>& aSegments, bool aTruncate = true) {
+      split(aSegments);
+      unsigned threads = numThreads();
+      if (openFile(aFilename, O_WRONLY | O_CREAT | (aTruncate ? O_TRUNC : 0)) || allocBuffers(threads * 2)) {
+        closeFile();
+        freeBuffers();
+        return -1;
+      }
+
+      bufQueue idle, full;
+      for (auto buf : mBuffers)
+        idle.push(0, buf);
+
+      Timer timer;
+      mNext = 0;
+      mError = false;
+      std::thread writer([this, &idle, &full] {
+        size_t idx;
+        char *buf;
+        while (full.pop(idx, buf)) {
+          if (!mError && !fileWrite(mBlocks[idx], buf))
+            mError = true;
+          idle.push(0, buf);
+        }
+      });
+
+      std::vector<std::thread> workers;
+      for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([this, &idle, &full] {
+          size_t idx, unused;
+          char *buf;
+          while (!mError && (idx = mNext++) < mBlocks.size() && idle.pop(unused, buf)) {
+            if (!devRead(mBlocks[idx], buf)) {
+              mError = true;
+              idle.push(0, buf);
+              break;
+            }
+            full.push(idx, buf);
+          }
+        });
+      }
+      for (auto& w : workers)
+        w.join();
+      full.close();
+      writer.join();
+      return finish("Read", timer);
+    }
+
+    /*
+     * fromFile()
+     *
+     * Write segments to device from file at their file offsets
+     */
+    int fromFile(const std::string& aFilename, const std::vector<segment>& aSegments) {
+      split(aSegments);
+      unsigned threads = numThreads();
+      if (openFile(aFilename, O_RDONLY) || allocBuffers(threads * 2)) {
+        closeFile();
+        freeBuffers();
+        return -1;
+      }
+
+      bufQueue idle, full;
+      for (auto buf : mBuffers)
+        idle.push(0, buf);
+
+      Timer timer;
+      mError = false;
+      std::vector<std::thread> workers;
+      for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([this, &idle, &full] {
+          size_t idx;
+          char *buf;
+          while (full.pop(idx, buf)) {
+            if (!mError && !devWrite(mBlocks[idx], buf))
+              mError = true;
+            idle.push(0, buf);
+          }
+        });
+      }
+
+      // The file is read in order so that the read ahead of buffered
+      // I/O keeps up; buffers come back from the workers in any order
+      size_t unused;
+      char *buf;
+      for (size_t idx = 0; idx < mBlocks.size() && !mError && idle.pop(unused, buf); ++idx) {
+        if (!fileRead(mBlocks[idx], buf)) {
+          mError = true;
+          break;
+        }
+        full.push(idx, buf);
+      }
+      full.close();
+      for (auto& w : workers)
+        w.join();
+      return finish("Wrote", timer);
+    }
+
+    /*
+     * fill()
+     *
+     * Write segments of device with a byte pattern
+     */
+    int fill(const std::vector<segment>& aSegments, unsigned int aPattern) {
+      split(aSegments);
+      unsigned threads = numThreads();
+      if (allocBuffers(threads)) {
+        freeBuffers();
+        return -1;
+      }
+
+      Timer timer;
+      mNext = 0;
+      mError = false;
+      std::vector<std::thread> workers;
+      for (unsigned t = 0; t < threads; ++t) {
+        char *buf = mBuffers[t];
+        std::memset(buf, aPattern, mOptions.m_block_size);
+        workers.emplace_back([this, buf] {
+          size_t idx;
+          while (!mError && (idx = mNext++) < mBlocks.size()) {
+            if (!devWrite(mBlocks[idx], buf))
+              mError = true;
+          }
+        });
+      }
+      for (auto& w : workers)
+        w.join();
+      return finish("Wrote", timer);
+    }
+  };
+}
+
+#endif /* MEMXFER_H */
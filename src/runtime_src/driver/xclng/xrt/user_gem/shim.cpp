@@ -39,6 +39,7 @@
 #include <ert.h>
 #include "driver/common/message.h"
 #include "driver/common/scheduler.h"
+#include "driver/common/xclbin_compress.h"
 #include <cstdio>
 #include <stdarg.h>
 
@@ -957,6 +958,12 @@ int xocl::XOCLShim::xclLoadXclBinMgmt(const xclBin *buffer)
     const char *xclbininmemory = reinterpret_cast<char*> (const_cast<xclBin*> (buffer));
 
     if (!memcmp(xclbininmemory, "xclbin2", 8)) {
+        std::vector<char> expanded;
+        ret = expandXclBin(reinterpret_cast<const axlf*>(xclbininmemory), expanded);
+        if (ret)
+            return ret;
+        if (!expanded.empty())
+            xclbininmemory = expanded.data();
         ret = xclLoadAxlfMgmt(reinterpret_cast<const axlf*>(xclbininmemory));
         if (ret != 0) {
             if (ret == -EINVAL) {
@@ -994,6 +1001,28 @@ int xocl::XOCLShim::xclLoadXclBinMgmt(const xclBin *buffer)
     return ret;
 }
 
+/*
+ * expandXclBin()
+ *
+ * The driver does not know about compressed sections, expand them
+ * into @expanded.  @expanded is left empty if @buffer is not an axlf
+ * or if nothing is compressed.
+ */
+int xocl::XOCLShim::expandXclBin(const axlf *buffer, std::vector<char>& expanded)
+{
+    try {
+        xrt_core::xclbin::expand(buffer, expanded);
+    }
+    catch (const std::exception& ex) {
+        if (mLogStream.is_open()) {
+            mLogStream << __func__ << ", " << std::this_thread::get_id() << ", " << ex.what() << std::endl;
+        }
+        std::cout << __func__ << " ERROR: " << ex.what() << std::endl;
+        return -EINVAL;
+    }
+    return 0;
+}
+
 /*
  * xclLoadXclBin()
  */
@@ -1929,7 +1958,16 @@ int xclLoadXclBinMgmt(xclDeviceHandle handle, const xclBin *buffer)
 int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
 {
     xocl::XOCLShim *drv = xocl::XOCLShim::handleCheck(handle);
-    auto ret = drv ? drv->xclLoadXclBin(buffer) : -ENODEV;
+    if (!drv)
+      return -ENODEV;
+    // Expanded here so that the scheduler sees the same xclbin as the driver
+    std::vector<char> expanded;
+    auto ret = drv->expandXclBin(reinterpret_cast<const axlf*>(buffer), expanded);
+    if (ret)
+      return ret;
+    if (!expanded.empty())
+      buffer = reinterpret_cast<const xclBin*>(expanded.data());
+    ret = drv->xclLoadXclBin(buffer);
     if (!ret)
       ret = xrt_core::scheduler::init(handle, buffer);
     return ret;
@@ -311,6 +311,7 @@ private:
 
     int xclLoadAxlf(const axlf *buffer);
     int xclLoadAxlfMgmt(const axlf *buffer);
+    int expandXclBin(const axlf *buffer, std::vector<char>& expanded);
     void xclSysfsGetDeviceInfo(xclDeviceInfo2 *info);
     void xclSysfsGetUsageInfo(drm_xocl_usage_stat& stat);
     void xclSysfsGetErrorStatus(xclErrorStatus& stat);
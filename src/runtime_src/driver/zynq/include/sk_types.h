@@ -24,11 +24,14 @@
  * getHostBO : create a BO handle from given physical address.
  * mapBO     : map BO handle to process's memory space.
  * freeBO    : free BO handle.
+ * unmapBO   : release a mapping returned by mapBO.  Mappings are
+ *             shared per BO, so use this instead of munmap().
  */
 struct sk_operations {
   unsigned int (* getHostBO)(unsigned long paddr, size_t size);
   void *(* mapBO)(unsigned int boHandle, bool write);
   void (* freeBO)(unsigned int boHandle);
+  int (* unmapBO)(unsigned int boHandle, void *addr);
 };
 
 /*
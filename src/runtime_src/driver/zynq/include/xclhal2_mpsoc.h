@@ -87,6 +87,25 @@ XCL_DRIVER_DLLESPEC int xclSKCreate(xclDeviceHandle handle, unsigned int boHandl
  */
 XCL_DRIVER_DLLESPEC int xclSKReport(xclDeviceHandle handle, uint32_t cu_idx, xrt_scu_state state);
 
+/**
+ * xclUnmapBO() - Release a mapping obtained from xclMapBO
+ *
+ * @handle:        Device handle
+ * @boHandle:      BO handle
+ * @addr:          Address returned by xclMapBO for this BO
+ * Return:         0 on success or appropriate error number
+ *
+ * Mappings are cached and reference counted per BO, repeated calls to
+ * xclMapBO return the same address.  Releasing the last reference
+ * keeps the mapping cached, so that mapping and unmapping a BO for
+ * each access costs no system calls; it is unmapped by xclFreeBO or
+ * when the device is closed.  A mapping must not be unmapped with munmap()
+ * while the BO is still in use, since later xclMapBO calls would
+ * return the stale address; munmap() is only safe right before the BO
+ * is freed with xclFreeBO.
+ */
+XCL_DRIVER_DLLESPEC int xclUnmapBO(xclDeviceHandle handle, unsigned int boHandle, void *addr);
+
 #ifdef __cplusplus
 }
 #endif
@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 #include <errno.h>
+#include <signal.h>
 #include <unistd.h>
 
 #include "sk_daemon.h"
@@ -29,16 +30,25 @@
  * XRT and dispatches the commands. One typical command is configure
  * soft kernel, which is a runnable binary loaded to PS. Whenever
  * getting a configure soft kernel command, the daemon will copy
- * the binary image to file system and dispatch processes to further
- * control the life cycle of those binaries, such as create, excute
- * and exit.
+ * the binary image to an in-memory file and dispatch processes to
+ * further control the life cycle of those binaries, such as create,
+ * excute and exit.  With Runtime.sk_in_process set in xrt.ini the CUs
+ * run on threads inside the daemon instead.
  */
 
+static volatile sig_atomic_t stopDaemon = 0;
+
+static void sigStop(int sig)
+{
+  stopDaemon = 1;
+}
+
 int main(int argc, char *argv[])
 {
   pid_t pid, sid;
   xclDeviceHandle handle;
   xclSKCmd cmd;
+  struct sigaction act = {};
 
   pid = fork();
   if (pid < 0) {
@@ -75,7 +85,13 @@ int main(int argc, char *argv[])
     exit(EXIT_FAILURE);
   }
 
-  while (1) {
+  /* SIGTERM interrupts the wait for commands and stops the daemon */
+  act.sa_handler = sigStop;
+  sigemptyset(&act.sa_mask);
+  act.sa_flags = 0;
+  sigaction(SIGTERM, &act, NULL);
+
+  while (!stopDaemon) {
     /* Calling XRT interface to wait for commands */
     if (xclSKGetCmd(handle, &cmd) != 0)
       continue;
@@ -90,6 +106,7 @@ int main(int argc, char *argv[])
     }
   }
 
+  stopSoftKernelThreads();
   syslog(LOG_INFO, "Daemon stop\n");
   closelog();
 
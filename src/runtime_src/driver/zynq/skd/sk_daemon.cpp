@@ -20,10 +20,23 @@
 #include <string.h>
 #include <sys/wait.h>
 #include <sys/mman.h>
+#include <sys/syscall.h>
+#include <pthread.h>
+#include <signal.h>
+
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "sk_types.h"
 #include "sk_daemon.h"
 #include "xclhal2_mpsoc.h"
+#include "driver/common/config_reader.h"
 
 xclDeviceHandle devHdl;
 
@@ -43,6 +56,11 @@ void *mapBO(unsigned int boHandle, bool write)
   return buf;
 }
 
+int unmapBO(unsigned int boHandle, void *addr)
+{
+  return xclUnmapBO(devHdl, boHandle, addr);
+}
+
 void freeBO(unsigned int boHandle)
 {
   xclFreeBO(devHdl, boHandle);
@@ -73,7 +91,7 @@ static int destroySoftKernel(unsigned int boh, void *mapAddr)
 {
   int ret;
 
-  ret = munmap(mapAddr, SOFT_KERNEL_REG_SIZE);
+  ret = xclUnmapBO(devHdl, boh, mapAddr);
   if (ret) {
     syslog(LOG_ERR, "Cannot munmap BO %d, at %p\n", boh, mapAddr);
     return ret;
@@ -112,22 +130,62 @@ xclDeviceHandle initXRTHandle(unsigned deviceIndex)
   return(xclOpen(deviceIndex, NULL, XCL_QUIET));
 }
 
+/*
+ * Soft kernel CUs run either each in its own forked process (default)
+ * or, when Runtime.sk_in_process is set in xrt.ini, on a thread per CU
+ * inside the daemon sharing one loaded image.
+ *
+ * In-process CU threads are joinable.  They exit when the driver tells
+ * the CU to exit, or when the daemon stops them with
+ * stopSoftKernelThreads(), which sets skStop and interrupts the wait
+ * for the next command.  An image is closed once all its CU threads
+ * have been joined.
+ */
+struct skImage {
+  void *handle;
+  std::vector<std::thread> cus;
+  std::atomic<unsigned int> running{0};
+};
+
+static std::mutex skMutex;
+static std::list<std::unique_ptr<skImage>> skImages;
+static std::atomic<bool> skStop(false);
+
+/* Join CU threads and close images of soft kernels that have exited. */
+static void reapSoftKernelThreads(bool all)
+{
+  std::lock_guard<std::mutex> lk(skMutex);
+  for (auto it = skImages.begin(); it != skImages.end(); ) {
+    auto& image = *it;
+    if (!all && image->running) {
+      ++it;
+      continue;
+    }
+    for (auto& cu : image->cus)
+      cu.join();
+    dlclose(image->handle);
+    it = skImages.erase(it);
+  }
+}
+
+static void sigWake(int sig)
+{
+  /* Only interrupts the blocking wait for the next command */
+}
+
 /*
  * This is the main loop for a soft kernel CU.
- * name   : soft kernel function name to run it.
- * path   : the full path that soft kernel locates in file system.
- * cu_idx : the Compute Index.
+ * name      : soft kernel function name to run it.
+ * sk_handle : handle of the loaded soft kernel image.
+ * cu_idx    : the Compute Index.
  */
-static void softKernelLoop(char *name, char *path, uint32_t cu_idx)
+static void softKernelLoop(char *name, void *sk_handle, uint32_t cu_idx)
 {
-  void *sk_handle;
   kernel_t kernel;
   struct sk_operations ops;
   unsigned *args_from_host;
   unsigned int boh;
   int ret;
- 
-  devHdl = initXRTHandle(0);
 
   ret = createSoftKernel(&boh, cu_idx);
   if (ret) {
@@ -135,13 +193,6 @@ static void softKernelLoop(char *name, char *path, uint32_t cu_idx)
     return;
   }
 
-  /* Open and load the soft kernel. */
-  sk_handle = dlopen(path, RTLD_LAZY | RTLD_GLOBAL);
-  if (!sk_handle) {
-    syslog(LOG_ERR, "Cannot open %s\n", path);
-    return;
-  }
-
   kernel = (kernel_t)dlsym(sk_handle, name);
   if (!kernel) {
     syslog(LOG_ERR, "Cannot find kernel %s\n", name);
@@ -154,10 +205,11 @@ static void softKernelLoop(char *name, char *path, uint32_t cu_idx)
   ops.getHostBO = &getHostBO;
   ops.mapBO     = &mapBO;
   ops.freeBO    = &freeBO;
+  ops.unmapBO   = &unmapBO;
 
   args_from_host = (unsigned *)getKernelArg(boh, cu_idx);
 
-  while (1) {
+  while (!skStop) {
     ret = waitNextCmd(cu_idx);
 
     if (ret) {
@@ -174,40 +226,33 @@ static void softKernelLoop(char *name, char *path, uint32_t cu_idx)
     kernel(&args_from_host[1], &ops);
   }
 
-  dlclose(sk_handle);
   (void) destroySoftKernel(boh, args_from_host);
 }
 
-static inline void getSoftKernelPathName(uint32_t cu_idx, char *path)
+static inline void getSoftKernelFdPath(int fd, char *path)
 {
-  snprintf(path, XRT_MAX_PATH_LENGTH, "%s%s%d", SOFT_KERNEL_FILE_PATH,
-          SOFT_KERNEL_FILE_NAME, cu_idx);
-}
-
-static inline void getSoftKernelPath(char *path)
-{
-  snprintf(path, XRT_MAX_PATH_LENGTH, "%s", SOFT_KERNEL_FILE_PATH);
+  snprintf(path, XRT_MAX_PATH_LENGTH, "/proc/self/fd/%d", fd);
 }
 
 /*
- * This function create a soft kernel file.
+ * This function creates an anonymous in-memory file holding the soft
+ * kernel image, so that it can be loaded with dlopen() without writing
+ * it to the file system.
  * paddr  : The physical address of the soft kernel shared object.
  *          This image is DMAed from host to PS's memory. The XRT
  *          provides interface to create a BO handle for this
  *          memory and map it to process's memory space. So that
- *          we can create a file and copy the image to it.
+ *          we can copy the image to the memory file.
  * size   : Size of the soft kenel image.
- * cuidx  : CU index. The file will be name bease on fixed path
- *          and name plus the CU index.
+ * Return : file descriptor of the memory file or -1 on error.
  */
-static int createSoftKernelFile(uint64_t paddr, size_t size, uint32_t cuidx)
+static int createSoftKernelImage(uint64_t paddr, size_t size)
 {
   xclDeviceHandle handle;
   unsigned int boHandle;
-  FILE *fptr;
-  void *buf;
-  char path[XRT_MAX_PATH_LENGTH];
-  int len, i;
+  char *buf;
+  size_t done = 0;
+  int fd;
 
   handle = initXRTHandle(0);
   if (!handle) {
@@ -216,49 +261,37 @@ static int createSoftKernelFile(uint64_t paddr, size_t size, uint32_t cuidx)
   }
     
   boHandle = xclGetHostBO(handle, paddr, size);
-  buf = xclMapBO(handle, boHandle, false);
+  buf = (char *)xclMapBO(handle, boHandle, false);
   if (!buf) {
     syslog(LOG_ERR, "Cannot map xlcbin BO.\n");
+    xclClose(handle);
     return -1;
   }
 
-  snprintf(path, XRT_MAX_PATH_LENGTH, "%s", SOFT_KERNEL_FILE_PATH);
-  len = strlen(path);
-
-  /* If not exist, create the path one by one. */
-  for (i = 1; i < len; i++) {
-    if (path[i] == '/') {
-      path[i] = '\0';
-      if (access(path, F_OK) != 0) {
-        if (mkdir(path, 0644) != 0) {
-          syslog(LOG_ERR, "Cannot create soft kernel file.\n");
-          return -1;
-        }
-      }
-      path[i] = '/';
-    }
-  }
-
-  /* Create soft kernel file */
-  getSoftKernelPathName(cuidx, path);
-
-  fptr = fopen(path, "w+b");
-  if (fptr == NULL) {
-     syslog(LOG_ERR, "Cannot create file: %s\n", path);
-     return -1;
+  fd = syscall(SYS_memfd_create, SOFT_KERNEL_FILE_NAME, 0);
+  if (fd < 0) {
+    syslog(LOG_ERR, "Cannot create soft kernel memory file: %s\n", strerror(errno));
+    xclClose(handle);
+    return -1;
   }
 
-  /* copy the soft kernel to file */
-  if (fwrite(buf, size, 1, fptr) != 1) {
-    syslog(LOG_ERR, "Fail to write to file %s.\n", path);
-    fclose(fptr);
-    return -1;
+  /* copy the soft kernel to memory file */
+  while (done < size) {
+    ssize_t ret = write(fd, buf + done, size - done);
+    if (ret < 0) {
+      if (errno == EINTR)
+        continue;
+      syslog(LOG_ERR, "Fail to write soft kernel image: %s\n", strerror(errno));
+      close(fd);
+      xclClose(handle);
+      return -1;
+    }
+    done += ret;
   }
 
-  fclose(fptr);
   xclClose(handle);
 
-  return 0;
+  return fd;
 }
 
 /* Define a signal handler to avoid zombie process */
@@ -267,7 +300,8 @@ static void sigAct(int sig)
   wait((int *)0);
 }
 
-void configSoftKernel(xclSKCmd *cmd)
+/* Start one forked process per CU, each loading the image itself. */
+static void startSoftKernelProcesses(xclSKCmd *cmd, int fd)
 {
   pid_t pid;
   uint32_t i;
@@ -277,10 +311,6 @@ void configSoftKernel(xclSKCmd *cmd)
   sigemptyset(&act.sa_mask);
   act.sa_flags = 0;
 
-  if (createSoftKernelFile(cmd->xclbin_paddr, cmd->xclbin_size,
-          cmd->start_cuidx) != 0)
-    return;
-
   for (i = cmd->start_cuidx; i < cmd->start_cuidx + cmd->cu_nums; i++) {
     /*
      * We create a process for each Compute Unit with same soft
@@ -289,11 +319,25 @@ void configSoftKernel(xclSKCmd *cmd)
     pid = fork();
     if (pid == 0) {
       char path[XRT_MAX_PATH_LENGTH];
+      void *sk_handle;
 
-      getSoftKernelPathName(i, path);
+      /* The daemon's SIGTERM handler is not meant for CU processes */
+      signal(SIGTERM, SIG_DFL);
+
+      /* The memory file descriptor is inherited from the daemon */
+      getSoftKernelFdPath(fd, path);
+      sk_handle = dlopen(path, RTLD_LAZY | RTLD_GLOBAL);
+      if (!sk_handle) {
+        syslog(LOG_ERR, "Cannot open %s: %s\n", path, dlerror());
+        exit(EXIT_FAILURE);
+      }
+      close(fd);
+
+      devHdl = initXRTHandle(0);
 
       /* Start the soft kenel loop for each CU. */
-      softKernelLoop(cmd->krnl_name, path, i);
+      softKernelLoop(cmd->krnl_name, sk_handle, i);
+      dlclose(sk_handle);
       syslog(LOG_INFO, "Kernel %s was terminated\n", cmd->krnl_name);
       exit(EXIT_SUCCESS);
     }
@@ -305,3 +349,105 @@ void configSoftKernel(xclSKCmd *cmd)
       syslog(LOG_ERR, "Unable to create soft kernel process( %d)\n", i);
   }
 }
+
+/* Start one thread per CU in the daemon, sharing the loaded image. */
+static void startSoftKernelThreads(xclSKCmd *cmd, int fd)
+{
+  char path[XRT_MAX_PATH_LENGTH];
+  uint32_t i;
+
+  auto image = std::unique_ptr<skImage>(new skImage);
+  getSoftKernelFdPath(fd, path);
+  image->handle = dlopen(path, RTLD_LAZY | RTLD_GLOBAL);
+  if (!image->handle) {
+    syslog(LOG_ERR, "Cannot open soft kernel image: %s\n", dlerror());
+    return;
+  }
+
+  if (!devHdl)
+    devHdl = initXRTHandle(0);
+
+  /*
+   * CU threads inherit the signal mask.  SIGTERM must be handled by the
+   * main thread, which is the one waiting for daemon commands.
+   */
+  sigset_t block, old;
+  sigemptyset(&block);
+  sigaddset(&block, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &block, &old);
+
+  std::lock_guard<std::mutex> lk(skMutex);
+  auto img = image.get();
+  for (i = cmd->start_cuidx; i < cmd->start_cuidx + cmd->cu_nums; i++) {
+    std::string name(cmd->krnl_name);
+    ++img->running;
+    img->cus.emplace_back([name, img, i] {
+      std::vector<char> krnl_name(name.begin(), name.end());
+      krnl_name.push_back('\0');
+      softKernelLoop(krnl_name.data(), img->handle, i);
+      syslog(LOG_INFO, "Kernel %s_%d was terminated\n", krnl_name.data(), i);
+      --img->running;
+    });
+  }
+  skImages.push_back(std::move(image));
+  pthread_sigmask(SIG_SETMASK, &old, NULL);
+}
+
+void stopSoftKernelThreads()
+{
+  bool running = true;
+
+  skStop = true;
+  /*
+   * A thread that has checked skStop but not yet blocked in
+   * waitNextCmd() misses the signal, or may still be running the
+   * kernel.  Keep waking threads until all of them have left the loop.
+   */
+  while (running) {
+    running = false;
+    {
+      std::lock_guard<std::mutex> lk(skMutex);
+      for (auto& image : skImages) {
+        if (!image->running)
+          continue;
+        running = true;
+        for (auto& cu : image->cus)
+          pthread_kill(cu.native_handle(), SIGUSR1);
+      }
+    }
+    if (running)
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  reapSoftKernelThreads(true);
+}
+
+void configSoftKernel(xclSKCmd *cmd)
+{
+  int fd;
+
+  static bool inProcess = xrt_core::config::get_sk_in_process();
+
+  fd = createSoftKernelImage(cmd->xclbin_paddr, cmd->xclbin_size);
+  if (fd < 0)
+    return;
+
+  if (inProcess) {
+    static bool init = false;
+    if (!init) {
+      struct sigaction act = {};
+      act.sa_handler = sigWake;
+      sigemptyset(&act.sa_mask);
+      act.sa_flags = 0; /* no SA_RESTART, interrupt the wait */
+      sigaction(SIGUSR1, &act, NULL);
+      init = true;
+    }
+    reapSoftKernelThreads(false);
+    startSoftKernelThreads(cmd, fd);
+  }
+  else {
+    startSoftKernelProcesses(cmd, fd);
+  }
+
+  /* The image is loaded or the descriptor inherited, no longer needed */
+  close(fd);
+}
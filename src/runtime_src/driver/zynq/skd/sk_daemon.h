@@ -32,5 +32,6 @@
 
 xclDeviceHandle initXRTHandle(unsigned deviceIndex);
 void configSoftKernel(xclSKCmd *cmd);
+void stopSoftKernelThreads();
 
 #endif
@@ -35,6 +35,7 @@
 #include "driver/common/message.h"
 #include "driver/common/scheduler.h"
 #include "driver/common/xclbin_parser.h"
+#include "driver/common/xclbin_compress.h"
 //#include "xclbin.h"
 #include <assert.h>
 
@@ -123,6 +124,7 @@ ZYNQShim::ZYNQShim(unsigned index, const char *logfileName, xclVerbosityLevel ve
 ZYNQShim::~ZYNQShim()
 {
   if (profiling != nullptr) delete profiling;
+  releaseMapCache();
   //TODO
   if (mKernelFD > 0) {
     close(mKernelFD);
@@ -267,6 +269,15 @@ unsigned int ZYNQShim::xclGetHostBO(uint64_t paddr, size_t size) {
 
 void ZYNQShim::xclFreeBO(unsigned int boHandle)
 {
+  {
+    std::lock_guard<std::mutex> lk(mMapLock);
+    auto it = mMapCache.find(boHandle);
+    if (it != mMapCache.end()) {
+      unmapCached(it->second);
+      mMapCache.erase(it);
+    }
+  }
+
   drm_gem_close closeInfo = {boHandle, 0};
   int result = ioctl(mKernelFD, DRM_IOCTL_GEM_CLOSE, &closeInfo);
   if (mVerbosity == XCL_INFO) {
@@ -301,20 +312,84 @@ int ZYNQShim::xclReadBO(unsigned int boHandle, void *dst, size_t size, size_t sk
 
 void *ZYNQShim::xclMapBO(unsigned int boHandle, bool write)
 {
+  std::lock_guard<std::mutex> lk(mMapLock);
+  auto& mappings = mMapCache[boHandle];
+
+  // A read-write mapping satisfies read-only requests as well
+  if (mappings.rw.ptr) {
+    ++mappings.rw.refs;
+    return mappings.rw.ptr;
+  }
+  if (!write && mappings.ro.ptr) {
+    ++mappings.ro.refs;
+    return mappings.ro.ptr;
+  }
+
   drm_zocl_info_bo info = { boHandle, 0, 0 };
   int result = ioctl(mKernelFD, DRM_IOCTL_ZOCL_INFO_BO, &info);
 
   drm_zocl_map_bo mapInfo = { boHandle, 0, 0 };
   result = ioctl(mKernelFD, DRM_IOCTL_ZOCL_MAP_BO, &mapInfo);
-  if (result)
+  if (result) {
+    if (!mappings.ro.ptr)
+      mMapCache.erase(boHandle);
     return NULL;
+  }
 
   void *ptr = mmap(0, info.size, (write ?(PROT_READ|PROT_WRITE) : PROT_READ ),
           MAP_SHARED, mKernelFD, mapInfo.offset);
+  if (ptr == MAP_FAILED) {
+    if (!mappings.ro.ptr)
+      mMapCache.erase(boHandle);
+    return ptr;
+  }
 
+  auto& mapping = write ? mappings.rw : mappings.ro;
+  mapping.ptr = ptr;
+  mapping.size = info.size;
+  mapping.refs = 1;
   return ptr;
 }
 
+int ZYNQShim::xclUnmapBO(unsigned int boHandle, void *addr)
+{
+  std::lock_guard<std::mutex> lk(mMapLock);
+  auto it = mMapCache.find(boHandle);
+  if (it == mMapCache.end())
+    return -EINVAL;
+
+  auto& mappings = it->second;
+  for (auto mapping : {&mappings.rw, &mappings.ro}) {
+    if (mapping->ptr != addr || !mapping->refs)
+      continue;
+    // Last reference keeps the mapping cached for the next xclMapBO,
+    // it is unmapped by xclFreeBO
+    --mapping->refs;
+    return 0;
+  }
+  return -EINVAL;
+}
+
+// Unmap the cached mappings that are no longer referenced.  Mappings
+// still referenced belong to callers that munmap() directly before
+// freeing the BO, those are only forgotten.
+void ZYNQShim::unmapCached(BOMappings& mappings)
+{
+  for (auto mapping : {&mappings.rw, &mappings.ro}) {
+    if (mapping->ptr && !mapping->refs)
+      munmap(mapping->ptr, mapping->size);
+    *mapping = BOMapping();
+  }
+}
+
+void ZYNQShim::releaseMapCache()
+{
+  std::lock_guard<std::mutex> lk(mMapLock);
+  for (auto& entry : mMapCache)
+    unmapCached(entry.second);
+  mMapCache.clear();
+}
+
 int ZYNQShim::xclGetDeviceInfo2(xclDeviceInfo2 *info)
 {
   std::memset(info, 0, sizeof(xclDeviceInfo2));
@@ -691,6 +766,14 @@ void *xclMapBO(xclDeviceHandle handle, unsigned int boHandle, bool write)
   return drv->xclMapBO(boHandle, write);
 }
 
+int xclUnmapBO(xclDeviceHandle handle, unsigned int boHandle, void *addr)
+{
+  ZYNQ::ZYNQShim *drv = ZYNQ::ZYNQShim::handleCheck(handle);
+  if (!drv)
+    return -EINVAL;
+  return drv->xclUnmapBO(boHandle, addr);
+}
+
 int xclSyncBO(xclDeviceHandle handle, unsigned int boHandle, xclBOSyncDirection dir,
               size_t size, size_t offset) {
   //std::cout << "xclSyncBO called.. " << handle << std::endl;
@@ -719,6 +802,14 @@ unsigned int xclImportBO(xclDeviceHandle handle, int fd, unsigned flags) {
 int xclLoadXclBin(xclDeviceHandle handle, const xclBin *buffer)
 {
     ZYNQ::ZYNQShim *drv = ZYNQ::ZYNQShim::handleCheck(handle);
+    std::vector<char> expanded;
+    try {
+        buffer = reinterpret_cast<const xclBin*>(xrt_core::xclbin::expand(reinterpret_cast<const axlf*>(buffer), expanded));
+    }
+    catch (const std::exception& ex) {
+        printf("Load Xclbin Failed: %s\n", ex.what());
+        return -EINVAL;
+    }
     auto ret = drv ? drv->xclLoadXclBin(buffer) : -ENODEV;
     if (ret) {
         printf("Load Xclbin Failed\n");
@@ -1050,12 +1141,12 @@ int xclRemoveAndScanFPGA()
 ssize_t xclUnmgdPread(xclDeviceHandle handle, unsigned flags, void *buf,
                       size_t size, uint64_t offset)
 {
-  return 0;
+  return -ENOSYS;
 }
 ssize_t xclUnmgdPwrite(xclDeviceHandle handle, unsigned flags, const void *buf,
                        size_t size, uint64_t offset)
 {
-  return 0;
+  return -ENOSYS;
 }
 int xclRegisterInterruptNotify(xclDeviceHandle handle, unsigned int userInterrupt, int fd)
 {
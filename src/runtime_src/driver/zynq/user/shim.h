@@ -27,6 +27,7 @@
 #include <cstdint>
 #include <fstream>
 #include <map>
+#include <mutex>
 #include <vector>
 
 namespace ZYNQ {
@@ -62,6 +63,7 @@ public:
                  size_t seek);
   int xclReadBO(unsigned int boHandle, void *dst, size_t size, size_t skip);
   void *xclMapBO(unsigned int boHandle, bool write);
+  int xclUnmapBO(unsigned int boHandle, void *addr);
   int xclExportBO(unsigned int boHandle);
   unsigned int xclImportBO(int fd, unsigned flags);
   unsigned int xclGetBOProperties(unsigned int boHandle,
@@ -98,6 +100,25 @@ private:
   xclVerbosityLevel mVerbosity;
   int mKernelFD;
   std::map<uint64_t, uint32_t *> mKernelControl;
+
+  // Cached BO mappings.  A BO has at most one read-only and one
+  // read-write mapping, each reference counted by xclMapBO and
+  // xclUnmapBO.  A mapping whose last reference is released stays
+  // cached so that the next xclMapBO is free, it is unmapped when the
+  // BO is freed or the device is closed.
+  struct BOMapping {
+    void *ptr = nullptr;
+    size_t size = 0;
+    unsigned int refs = 0;
+  };
+  struct BOMappings {
+    BOMapping ro;
+    BOMapping rw;
+  };
+  std::mutex mMapLock;
+  std::map<unsigned int, BOMappings> mMapCache;
+  void unmapCached(BOMappings& mappings);
+  void releaseMapCache();
 };
 };
 
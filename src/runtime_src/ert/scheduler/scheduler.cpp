@@ -24,7 +24,9 @@
 #include "ert.h"
 #endif
 // includes from bsp
-#ifndef ERT_HW_EMU
+#if defined(ERT_SIM)
+#include "ert/sim/ert_sim.h"
+#elif !defined(ERT_HW_EMU)
 #include <xil_printf.h>
 #include <mb_interface.h>
 #include <xparameters.h>
@@ -46,7 +48,7 @@ ERT_UNUSED
 static void
 ert_assert(const char* file, long line, const char* function, const char* expr, const char* msg)
 {
-  xil_printf("Assert failed: %s:%d:%s:%s %s\n",file,line,function,expr,msg);
+  xil_printf("Assert failed: %s:%d:%s:%s %s\n",file,static_cast<int>(line),function,expr,msg);
   exit(1);
 }
 
@@ -239,7 +241,7 @@ struct bitset_type
 
 // If this assert fails, then ert_parameters is out of sync with
 // the board support package header files.
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 static_assert(ERT_INTC_ADDR==XPAR_INTC_SINGLE_BASEADDR,"update driver/include/ert.h");
 #endif
 
@@ -328,7 +330,7 @@ static bitset_type cu_status;
 
 // Bitmask for interrupt enabled CUs.  (0) no interrupt (1) enabled
 static bitset_type cu_interrupt_mask;
-#ifndef ERT_HW_EMU
+#if !defined(ERT_HW_EMU) && !defined(ERT_SIM)
 /**
  * Utility to read a 32 bit value from any axi-lite peripheral
  */
@@ -489,7 +491,7 @@ setup()
     auto& slot = command_slots[i];
     slot.slot_addr = ERT_CQ_BASE_ADDR + (slot_size * i);
     slot.header_value = 0x4; // free
-    slot.cus.reset(num_cus);
+    slot.cus.reset(num_cus-1);
     slot.regmap_addr = 0;
     slot.regmap_size = 0;
 
@@ -501,7 +503,7 @@ setup()
   for (size_type i=0; i<4; ++i)
     ERT_UNUSED volatile auto val = read_reg(STATUS_REGISTER_ADDR[i]);
 
-  cu_status.reset(num_cus);
+  cu_status.reset(num_cus-1);
 
   // Initialize cu_slot_usage
   for (size_type i=0; i<num_cus; ++i) {
@@ -542,7 +544,7 @@ setup()
   bool enable_master_interrupts = false;
 
   // Enable cu interupts (cu -> cu_isr -> mb interrupts)
-  cu_interrupt_mask.reset(num_cus);
+  cu_interrupt_mask.reset(num_cus-1);
   bitmask_type intc_ier_mask = 0;
   if (cu_interrupt_enabled) {
     for (size_type cu=0; cu<num_cus; ++cu) {
@@ -1078,6 +1080,10 @@ running_to_free(size_type slot_idx)
   return false;
 }
 
+#ifdef ERT_SIM
+void cu_interrupt_handler();
+#endif
+
 /**
  * Main routine executed by embedded scheduler loop
  *
@@ -1115,6 +1121,15 @@ scheduler_loop()
       }
 #endif
 
+#ifdef ERT_SIM
+      // Simulated time and host advance per slot visited, pending
+      // interrupts are taken between slots
+      if (!ert_sim::tick())
+        return;
+      if (ert_sim::interrupt_pending())
+        cu_interrupt_handler();
+#endif
+
       // In dataflow mode ERT is polling CUs for completion after
       // host has started CU or acknowleged completion.  Ctrl cmds
       // are processed in normal flow.
@@ -1174,7 +1189,9 @@ scheduler_loop()
 /**
  * CU interrupt service routine
  */
+#ifndef ERT_SIM
 void cu_interrupt_handler() __attribute__((interrupt_handler));
+#endif
 void
 cu_interrupt_handler()
 {
@@ -1226,7 +1243,15 @@ cu_interrupt_handler()
 }
 
 } // ert
-#ifndef ERT_HW_EMU
+#if defined(ERT_SIM)
+int main(int argc, char* argv[])
+{
+  if (!ert_sim::init(argc,argv))
+    return 1;
+  ert::scheduler_loop();
+  return ert_sim::report();
+}
+#elif !defined(ERT_HW_EMU)
 int main()
 {
   ert::scheduler_loop();
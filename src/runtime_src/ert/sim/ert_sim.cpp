@@ -0,0 +1,630 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Simulated peripherals and host for the embedded scheduler
+ *
+ * Every register access by the scheduler costs --reg_latency ns and
+ * every slot visited by the scheduler loop costs --loop_latency ns of
+ * simulated time.  CUs complete --cu_latency ns after they are started.
+ * The host model keeps up to --depth commands outstanding, and sees a
+ * completion --host_latency ns after the scheduler has written the
+ * command status register.
+ */
+
+#include "ert_sim.h"
+#include "driver/include/ert.h"
+
+#include <getopt.h>
+#include <algorithm>
+#include <deque>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// HLS AXI-lite control register
+const uint32_t AP_START = 0x1;
+const uint32_t AP_DONE  = 0x2;
+const uint32_t AP_IDLE  = 0x4;
+
+// Simulated CUs are placed away from the ERT address space
+const uint32_t cu_base_address = 0x1000000;
+const uint32_t cu_shift = 16;
+
+// Give up if no command completes within 1s of simulated time
+const uint64_t watchdog_ns = 1000000000;
+
+const struct option long_options[] = {
+{"cus",           required_argument, 0, 'c'},
+{"slot_size",     required_argument, 0, 's'},
+{"regmap_size",   required_argument, 0, 'm'},
+{"commands",      required_argument, 0, 'n'},
+{"depth",         required_argument, 0, 'q'},
+{"cu_latency",    required_argument, 0, 'l'},
+{"cu_jitter",     required_argument, 0, 'j'},
+{"reg_latency",   required_argument, 0, 'r'},
+{"loop_latency",  required_argument, 0, 'p'},
+{"host_latency",  required_argument, 0, 'H'},
+{"interval",      required_argument, 0, 'i'},
+{"seed",          required_argument, 0, 'S'},
+{"cu_dma",        no_argument,       0, 'D'},
+{"cu_isr",        no_argument,       0, 'I'},
+{"cq_int",        no_argument,       0, 'Q'},
+{"help",          no_argument,       0, 'h'},
+{0, 0, 0, 0}
+};
+
+void
+printHelp()
+{
+  std::cout << "usage: ert_sim [options]\n\n";
+  std::cout << "  -c <number_of_cus>          (default 4)\n";
+  std::cout << "  -s <slot_size_bytes>        (default 4096)\n";
+  std::cout << "  -m <regmap_size_words>      (default 16)\n";
+  std::cout << "  -n <number_of_commands>     (default 10000)\n";
+  std::cout << "  -q <max_outstanding>        (default all slots)\n";
+  std::cout << "  -l <cu_latency_ns>          (default 10000)\n";
+  std::cout << "  -j <cu_jitter_ns>           (default 0)\n";
+  std::cout << "  -r <reg_latency_ns>         (default 100)\n";
+  std::cout << "  -p <loop_latency_ns>        (default 20)\n";
+  std::cout << "  -H <host_latency_ns>        (default 1000)\n";
+  std::cout << "  -i <submit_interval_ns>     (default 0, closed loop)\n";
+  std::cout << "  -S <jitter_seed>\n";
+  std::cout << "  [--cu_dma] enable CU DMA\n";
+  std::cout << "  [--cu_isr] enable CU interrupts instead of polling\n";
+  std::cout << "  [--cq_int] enable command queue interrupts instead of polling\n";
+  std::cout << "  -h\n";
+}
+
+struct options
+{
+  uint32_t num_cus = 4;
+  uint32_t slot_size = 0x1000;
+  uint32_t regmap_size = 16;
+  uint64_t num_commands = 10000;
+  uint32_t depth = 0;
+  uint64_t cu_latency = 10000;
+  uint64_t cu_jitter = 0;
+  uint64_t reg_latency = 100;
+  uint64_t loop_latency = 20;
+  uint64_t host_latency = 1000;
+  uint64_t interval = 0;
+  unsigned int seed = 0;
+  bool cu_dma = false;
+  bool cu_isr = false;
+  bool cq_int = false;
+};
+
+struct cu_model
+{
+  uint32_t ctrl = AP_IDLE;
+  bool gie = false;
+  bool ier = false;
+  uint64_t start = 0;
+  uint64_t done = 0;
+  uint64_t busy_ns = 0;
+  uint64_t starts = 0;
+};
+
+struct host_model
+{
+  bool configured = false;
+  uint32_t num_slots = 0;
+  uint32_t outstanding = 0;
+  uint64_t submitted = 0;
+  uint64_t completed = 0;
+  uint64_t next_submit = 0;
+  uint64_t first_submit = 0;
+  uint64_t last_complete = 0;
+  std::vector<bool> busy;
+  std::vector<uint64_t> submit_time;
+  std::vector<uint64_t> latencies;
+
+  // (slot, time) of command status register writes by the scheduler
+  std::deque<std::pair<uint32_t,uint64_t>> notifications;
+};
+
+options opt;
+host_model host;
+std::vector<cu_model> cus;
+std::mt19937 rng;
+bool failed = false;
+
+// Simulated time in ns
+uint64_t now = 0;
+
+// Statistics of scheduler activity
+uint64_t mb_reads = 0;
+uint64_t mb_writes = 0;
+uint64_t loops = 0;
+uint64_t interrupts = 0;
+
+// Peripheral state
+std::vector<uint32_t> cq(ERT_CQ_SIZE/4);
+std::unordered_map<uint32_t,uint32_t> regs;
+uint32_t csr_status[4] = {0};
+uint32_t cu_status[4] = {0};
+uint32_t cq_status[4] = {0};
+uint32_t intc_isr = 0;
+uint32_t intc_ier = 0;
+uint32_t intc_mer = 0;
+bool mb_interrupts = false;
+
+uint32_t
+num_cu_masks()
+{
+  return ((opt.num_cus-1)>>5) + 1;
+}
+
+uint32_t
+reg(uint32_t addr)
+{
+  auto itr = regs.find(addr);
+  return itr == regs.end() ? 0 : itr->second;
+}
+
+// Index of register in a bank of 4 consecutive registers, or -1
+int
+bank_index(uint32_t addr, uint32_t bank)
+{
+  return (addr >= bank && addr < bank + 16) ? (addr - bank) >> 2 : -1;
+}
+
+// Index of CU addressed by addr, or -1
+int
+cu_index(uint32_t addr)
+{
+  if (addr < cu_base_address || addr >= cu_base_address + (cus.size() << cu_shift))
+    return -1;
+  return (addr - cu_base_address) >> cu_shift;
+}
+
+// Interrupts from cuisr and command queue status are level triggered
+void
+update_intc()
+{
+  for (int i=0; i<4; ++i) {
+    if (cu_status[i])
+      intc_isr |= 0x2;
+    if (cq_status[i])
+      intc_isr |= 0x1;
+  }
+}
+
+void
+start_cu(uint32_t cu_idx)
+{
+  auto& cu = cus[cu_idx];
+  cu.ctrl = AP_START;
+  cu.start = now;
+  cu.done = now + opt.cu_latency;
+  if (opt.cu_jitter)
+    cu.done += std::uniform_int_distribution<uint64_t>(0,opt.cu_jitter)(rng);
+  ++cu.starts;
+}
+
+// Complete CUs that are done by now
+void
+advance()
+{
+  for (uint32_t cu_idx=0; cu_idx<cus.size(); ++cu_idx) {
+    auto& cu = cus[cu_idx];
+    if (!(cu.ctrl & AP_START) || cu.done > now)
+      continue;
+    cu.ctrl = AP_DONE | AP_IDLE;
+    cu.busy_ns += cu.done - cu.start;
+    if (cu.gie && cu.ier && reg(ERT_CU_ISR_HANDLER_ENABLE_ADDR))
+      cu_status[cu_idx>>5] |= 1<<(cu_idx&31);
+  }
+  update_intc();
+}
+
+// CU DMA copies the regmap of the slot to the CU in the slot's
+// cu section and starts the CU
+void
+dma_start(uint32_t slot_idx)
+{
+  auto cu_section = (slot_idx*opt.slot_size + sizeof(uint32_t)) / 4;
+  for (uint32_t mask_idx=0; mask_idx<num_cu_masks(); ++mask_idx) {
+    auto mask = cq[cu_section + mask_idx];
+    for (uint32_t cu_idx=mask_idx<<5; mask; mask >>= 1, ++cu_idx) {
+      if (mask & 0x1) {
+        start_cu(cu_idx);
+        return;
+      }
+    }
+  }
+}
+
+uint32_t
+sim_read(uint32_t addr)
+{
+  if (addr >= ERT_CQ_BASE_ADDR && addr < ERT_CQ_BASE_ADDR + ERT_CQ_SIZE)
+    return cq[(addr - ERT_CQ_BASE_ADDR) / 4];
+
+  int idx;
+  if ((idx = bank_index(addr,ERT_STATUS_REGISTER_ADDR)) >= 0)
+    return std::exchange(csr_status[idx],0);
+  if ((idx = bank_index(addr,ERT_CU_STATUS_REGISTER_ADDR)) >= 0)
+    return std::exchange(cu_status[idx],0);
+  if ((idx = bank_index(addr,ERT_CQ_STATUS_REGISTER_ADDR)) >= 0)
+    return std::exchange(cq_status[idx],0);
+
+  if ((idx = cu_index(addr)) >= 0) {
+    auto& cu = cus[idx];
+    auto offset = addr & ((1<<cu_shift)-1);
+    if (offset == 0x0)
+      return std::exchange(cu.ctrl,cu.ctrl & ~AP_DONE); // ap_done is cleared on read
+    if (offset == 0x4)
+      return cu.gie;
+    if (offset == 0x8)
+      return cu.ier;
+    return reg(addr);
+  }
+
+  switch (addr) {
+  case ERT_INTC_IPR_ADDR:
+    return intc_isr & intc_ier;
+  case ERT_INTC_IER_ADDR:
+    return intc_ier;
+  case ERT_INTC_MER_ADDR:
+    return intc_mer;
+  case ERT_CUDMA_STATE:
+  case ERT_CUISR_STATE:
+    return ERT_HLS_MODULE_IDLE;
+  default:
+    return reg(addr);
+  }
+}
+
+void
+sim_write(uint32_t addr, uint32_t val)
+{
+  if (addr >= ERT_CQ_BASE_ADDR && addr < ERT_CQ_BASE_ADDR + ERT_CQ_SIZE) {
+    cq[(addr - ERT_CQ_BASE_ADDR) / 4] = val;
+    return;
+  }
+
+  int idx;
+  if ((idx = bank_index(addr,ERT_STATUS_REGISTER_ADDR)) >= 0) {
+    csr_status[idx] |= val;
+    for (uint32_t slot_idx=idx<<5; val; val >>= 1, ++slot_idx)
+      if (val & 0x1)
+        host.notifications.emplace_back(slot_idx,now);
+    return;
+  }
+  if ((idx = bank_index(addr,ERT_CU_DMA_REGISTER_ADDR)) >= 0) {
+    if (!reg(ERT_CU_DMA_ENABLE_ADDR))
+      return;
+    for (uint32_t slot_idx=idx<<5; val; val >>= 1, ++slot_idx)
+      if (val & 0x1)
+        dma_start(slot_idx);
+    return;
+  }
+  if ((idx = bank_index(addr,ERT_CQ_STATUS_REGISTER_ADDR)) >= 0) {
+    cq_status[idx] |= val;
+    update_intc();
+    return;
+  }
+
+  if ((idx = cu_index(addr)) >= 0) {
+    auto& cu = cus[idx];
+    auto offset = addr & ((1<<cu_shift)-1);
+    if (offset == 0x0 && (val & AP_START))
+      start_cu(idx);
+    else if (offset == 0x4)
+      cu.gie = val & 0x1;
+    else if (offset == 0x8)
+      cu.ier = val & 0x1;
+    else
+      regs[addr] = val;
+    return;
+  }
+
+  switch (addr) {
+  case ERT_INTC_IER_ADDR:
+    intc_ier = val;
+    break;
+  case ERT_INTC_MER_ADDR:
+    intc_mer = val;
+    break;
+  case ERT_INTC_IAR_ADDR:
+    intc_isr &= ~val;
+    update_intc();
+    break;
+  default:
+    regs[addr] = val;
+  }
+}
+
+void
+submit_configure()
+{
+  uint32_t features = 0x1;   // ert
+  features |= 0x2;           // host polls, mb->host interrupt is not modelled
+  if (opt.cu_dma)
+    features |= 0x4;
+  if (opt.cu_isr)
+    features |= 0x8;
+  if (opt.cq_int)
+    features |= 0x10;
+
+  // Configure command is always in first slot of default size
+  auto slot = ERT_CQ_BASE_ADDR;
+  sim_write(slot + 0x4,opt.slot_size);
+  sim_write(slot + 0x8,opt.num_cus);
+  sim_write(slot + 0xC,cu_shift);
+  sim_write(slot + 0x10,cu_base_address);
+  sim_write(slot + 0x14,features);
+  for (uint32_t cu_idx=0; cu_idx<opt.num_cus; ++cu_idx)
+    sim_write(slot + 0x18 + (cu_idx<<2),cu_base_address + (cu_idx<<cu_shift));
+  sim_write(slot,(ERT_CONFIGURE<<23) | ((5+opt.num_cus)<<12) | ERT_CMD_STATE_NEW);
+}
+
+void
+submit_start_kernel(uint32_t slot_idx)
+{
+  auto slot = ERT_CQ_BASE_ADDR + slot_idx*opt.slot_size;
+  auto masks = num_cu_masks();
+
+  // Any CU can execute the command
+  for (uint32_t mask_idx=0; mask_idx<masks; ++mask_idx) {
+    auto cus_in_mask = std::min<uint32_t>(opt.num_cus - (mask_idx<<5),32);
+    auto mask = cus_in_mask == 32 ? 0xffffffff : (1u<<cus_in_mask) - 1;
+    sim_write(slot + 0x4 + (mask_idx<<2),mask);
+  }
+  auto regmap = slot + 0x4 + (masks<<2);
+  for (uint32_t i=0; i<opt.regmap_size; ++i)
+    sim_write(regmap + (i<<2),i);
+
+  // Header is written last, the scheduler may pick up the command
+  // as soon as it sees the new state
+  auto count = masks + opt.regmap_size;
+  sim_write(slot,(ERT_START_KERNEL<<23) | (count<<12) | ((masks-1)<<10) | ERT_CMD_STATE_NEW);
+  if (opt.cq_int)
+    sim_write(ERT_CQ_STATUS_REGISTER_ADDR + ((slot_idx>>5)<<2),1<<(slot_idx&31));
+}
+
+void
+host_configured()
+{
+  host.configured = true;
+  host.num_slots = ERT_CQ_SIZE / opt.slot_size;
+  host.busy.assign(host.num_slots,false);
+  host.submit_time.assign(host.num_slots,0);
+  if (!opt.depth || opt.depth > host.num_slots)
+    opt.depth = host.num_slots;
+  host.first_submit = host.next_submit = host.last_complete = now;
+}
+
+void
+host_step()
+{
+  // Retire commands the host has been notified about
+  while (!host.notifications.empty() && host.notifications.front().second + opt.host_latency <= now) {
+    auto slot_idx = host.notifications.front().first;
+    host.notifications.pop_front();
+    csr_status[slot_idx>>5] &= ~(1<<(slot_idx&31));
+
+    if (!host.configured) {
+      if (slot_idx == 0)
+        host_configured();
+      continue;
+    }
+
+    host.busy[slot_idx] = false;
+    --host.outstanding;
+    ++host.completed;
+    host.last_complete = now;
+    host.latencies.push_back(now - host.submit_time[slot_idx]);
+  }
+
+  if (!host.configured)
+    return;
+
+  // Submit new commands to free slots
+  while (host.submitted < opt.num_commands && host.outstanding < opt.depth && host.next_submit <= now) {
+    auto itr = std::find(host.busy.begin(),host.busy.end(),false);
+    if (itr == host.busy.end())
+      break;
+    uint32_t slot_idx = itr - host.busy.begin();
+    host.busy[slot_idx] = true;
+    // In open loop latency includes time waiting for a slot
+    host.submit_time[slot_idx] = opt.interval ? host.next_submit : now;
+    host.next_submit = opt.interval ? host.next_submit + opt.interval : now;
+    ++host.outstanding;
+    ++host.submitted;
+    submit_start_kernel(slot_idx);
+  }
+}
+
+void
+charge_register_access()
+{
+  now += opt.reg_latency;
+  advance();
+}
+
+uint64_t
+to_number(const char* arg)
+{
+  return std::stoull(arg,nullptr,0);
+}
+
+} // namespace
+
+void
+microblaze_enable_interrupts()
+{
+  mb_interrupts = true;
+}
+
+void
+microblaze_disable_interrupts()
+{
+  mb_interrupts = false;
+}
+
+namespace ert {
+
+uint32_t
+read_reg(uint32_t addr)
+{
+  ++mb_reads;
+  charge_register_access();
+  return sim_read(addr);
+}
+
+void
+write_reg(uint32_t addr, uint32_t val)
+{
+  ++mb_writes;
+  charge_register_access();
+  sim_write(addr,val);
+}
+
+} // ert
+
+namespace ert_sim {
+
+bool
+init(int argc, char* argv[])
+{
+  try {
+    int c;
+    while ((c = getopt_long(argc, argv, "c:s:m:n:q:l:j:r:p:H:i:S:h", long_options, 0)) != -1) {
+      switch (c) {
+      case 'c': opt.num_cus = to_number(optarg); break;
+      case 's': opt.slot_size = to_number(optarg); break;
+      case 'm': opt.regmap_size = to_number(optarg); break;
+      case 'n': opt.num_commands = to_number(optarg); break;
+      case 'q': opt.depth = to_number(optarg); break;
+      case 'l': opt.cu_latency = to_number(optarg); break;
+      case 'j': opt.cu_jitter = to_number(optarg); break;
+      case 'r': opt.reg_latency = to_number(optarg); break;
+      case 'p': opt.loop_latency = to_number(optarg); break;
+      case 'H': opt.host_latency = to_number(optarg); break;
+      case 'i': opt.interval = to_number(optarg); break;
+      case 'S': opt.seed = to_number(optarg); break;
+      case 'D': opt.cu_dma = true; break;
+      case 'I': opt.cu_isr = true; break;
+      case 'Q': opt.cq_int = true; break;
+      case 'h':
+      default:
+        printHelp();
+        return false;
+      }
+    }
+  }
+  catch (const std::exception&) {
+    std::cout << "Invalid number in command line\n";
+    return false;
+  }
+
+  // Scheduler supports at most 128 CUs and 128 slots
+  if (opt.num_cus == 0 || opt.num_cus > 128) {
+    std::cout << "Number of CUs must be between 1 and 128\n";
+    return false;
+  }
+  if (opt.slot_size < ERT_CQ_SIZE/128 || opt.slot_size > ERT_CQ_SIZE || (opt.slot_size & (opt.slot_size-1))) {
+    std::cout << "Slot size must be a power of 2 between " << ERT_CQ_SIZE/128 << " and " << ERT_CQ_SIZE << "\n";
+    return false;
+  }
+  if (opt.regmap_size < 4 || (1 + num_cu_masks() + opt.regmap_size) * 4 > opt.slot_size) {
+    std::cout << "Register map must be at least 4 words and fit in a slot\n";
+    return false;
+  }
+  if (opt.num_commands == 0) {
+    std::cout << "Number of commands must be at least 1\n";
+    return false;
+  }
+
+  rng.seed(opt.seed);
+  cus.resize(opt.num_cus);
+  return true;
+}
+
+bool
+tick()
+{
+  // Host configures the scheduler once it has booted and cleared
+  // the command queue
+  if (!loops++)
+    submit_configure();
+
+  now += opt.loop_latency;
+  advance();
+  host_step();
+
+  if (host.configured && host.completed == opt.num_commands)
+    return false;
+
+  auto progress = host.configured ? host.last_complete : 0;
+  if (now - progress > watchdog_ns) {
+    std::cout << "No command completed in " << watchdog_ns/1000000 << "ms of simulated time, "
+              << host.completed << " of " << opt.num_commands << " commands completed\n";
+    failed = true;
+    return false;
+  }
+  return true;
+}
+
+bool
+interrupt_pending()
+{
+  if (mb_interrupts && (intc_mer & 0x1) && (intc_isr & intc_ier)) {
+    ++interrupts;
+    return true;
+  }
+  return false;
+}
+
+int
+report()
+{
+  auto elapsed = host.last_complete - host.first_submit;
+  auto& lat = host.latencies;
+  std::sort(lat.begin(),lat.end());
+
+  printf("cus=%u slots=%u depth=%u cu_dma=%d cu_isr=%d cq_int=%d\n"
+         ,opt.num_cus,host.num_slots,opt.depth,opt.cu_dma,opt.cu_isr,opt.cq_int);
+  printf("commands completed     : %llu\n",(unsigned long long)host.completed);
+  printf("simulated time (us)    : %.3f\n",elapsed/1000.0);
+  if (elapsed)
+    printf("throughput (cmds/s)    : %.0f\n",host.completed*1e9/elapsed);
+  if (!lat.empty()) {
+    uint64_t sum = 0;
+    for (auto l : lat)
+      sum += l;
+    auto pct = [&lat](double p) { return lat[std::min<size_t>(lat.size()-1,lat.size()*p)]/1000.0; };
+    printf("latency (us)           : min %.3f avg %.3f p50 %.3f p99 %.3f max %.3f\n"
+           ,lat.front()/1000.0,sum/1000.0/lat.size(),pct(0.5),pct(0.99),lat.back()/1000.0);
+  }
+  printf("scheduler loop slots   : %llu\n",(unsigned long long)loops);
+  printf("register reads/writes  : %llu/%llu\n",(unsigned long long)mb_reads,(unsigned long long)mb_writes);
+  printf("interrupts             : %llu\n",(unsigned long long)interrupts);
+  for (uint32_t cu_idx=0; cu_idx<cus.size(); ++cu_idx)
+    printf("cu(%u) starts %llu utilization %.1f%%\n",cu_idx,(unsigned long long)cus[cu_idx].starts
+           ,elapsed ? 100.0*cus[cu_idx].busy_ns/elapsed : 0.0);
+  return failed ? 1 : 0;
+}
+
+} // ert_sim
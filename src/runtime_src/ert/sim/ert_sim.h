@@ -0,0 +1,96 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef ert_sim_h_
+#define ert_sim_h_
+
+/**
+ * Host build of the embedded scheduler
+ *
+ * When scheduler.cpp is compiled with ERT_SIM it replaces the
+ * MicroBlaze board support package with the functions declared here.
+ * Register accesses go to simulated CSR, command queue, interrupt
+ * controller and CU models, and a host model submits commands the way
+ * the driver does.  Time is simulated, so runs are deterministic and
+ * independent of the speed of the host.
+ */
+
+#include <cstdint>
+#include <cstdio>
+
+#define xil_printf printf
+#define print printf
+
+using u32 = uint32_t;
+
+void microblaze_enable_interrupts();
+void microblaze_disable_interrupts();
+
+namespace ert {
+
+/**
+ * read_reg() - Read a 32 bit value from a simulated peripheral
+ */
+uint32_t
+read_reg(uint32_t addr);
+
+/**
+ * write_reg() - Write a 32 bit value to a simulated peripheral
+ */
+void
+write_reg(uint32_t addr, uint32_t val);
+
+} // ert
+
+namespace ert_sim {
+
+/**
+ * init() - Parse command line and set up the simulated CUs
+ *
+ * Return: false if the command line is invalid
+ */
+bool
+init(int argc, char* argv[]);
+
+/**
+ * tick() - Advance time for one iteration of the scheduler loop
+ *
+ * Lets the host model configure the scheduler, retire completed
+ * commands and submit new ones.
+ *
+ * Return: false when all commands have completed and the scheduler
+ *  loop should exit
+ */
+bool
+tick();
+
+/**
+ * interrupt_pending() - Check if the interrupt controller would interrupt MB
+ */
+bool
+interrupt_pending();
+
+/**
+ * report() - Print throughput and latency of the run
+ *
+ * Return: exit code for the simulator
+ */
+int
+report();
+
+} // ert_sim
+
+#endif
@@ -17,11 +17,31 @@
 #ifndef _CPU_PIPES_H_
 #define _CPU_PIPES_H_
 
+/*
+ * Pipes of software emulation kernels
+ *
+ * The pipe is a ring of packets indexed by free running packet
+ * counters.  Writers claim packets by advancing wr_claim and publish
+ * them by advancing head, readers claim by advancing rd_claim and
+ * release by advancing tail.  Claims are a single compare and swap for
+ * any number of packets, and with one writer and one reader, the common
+ * case of dataflow kernels, publishing is a single store.  The pipe
+ * mutex is taken only when work-items commit claims out of order, in
+ * which case the commit is queued until all earlier claims of the same
+ * side are committed.
+ *
+ * The _nolock builtins assume a single writer or single reader and do
+ * not claim.
+ */
+
 #include <assert.h>
 #include <pthread.h>
-#include <queue>
+#include <atomic>
 #include <cstring>
 #include <cstdlib>
+#include <initializer_list>
+#include <new>
+#include <thread>
 
 //#define PIPE_VERBOSE 1
 #ifdef PIPE_VERBOSE
@@ -40,34 +60,188 @@
 # define MAYBE_UNUSED __attribute__((unused))
 #endif
 
-
+#define CPU_PIPE_CACHE_LINE 64
+#define CPU_PIPE_MAX_PENDING 64
 
 extern "C" {
 
 typedef struct _cpu_pipe_reserve_id_t {
-  std::size_t head;
-  std::size_t tail;
-  std::size_t next;
-  unsigned size;
-  unsigned ref;
+  std::size_t start;   // first packet
+  unsigned n;          // number of packets
+  struct _cpu_pipe_reserve_id_t *next;   // free list
 } cpu_pipe_reserve_id_t;
 
+// Commit waiting for earlier claims of the same side
+typedef struct _cpu_pipe_pending_t {
+  std::size_t start;
+  std::size_t end;
+} cpu_pipe_pending_t;
+
+typedef struct _cpu_pipe_side_t {
+  // Claimed by work-items, ahead of or equal to the published index
+  alignas(CPU_PIPE_CACHE_LINE) std::atomic<std::size_t> claim;
+
+  // Published index, head for the write side, tail for the read side
+  alignas(CPU_PIPE_CACHE_LINE) std::atomic<std::size_t> index;
+
+  // Out of order commits, protected by the pipe mutex
+  alignas(CPU_PIPE_CACHE_LINE) std::atomic<unsigned> npending;
+  cpu_pipe_pending_t pending[CPU_PIPE_MAX_PENDING];
+} cpu_pipe_side_t;
+
 typedef struct _cpu_pipe_t {
-  pthread_mutex_t rd_lock;
-  pthread_mutex_t wr_lock;
+  pthread_mutex_t lock;
 
   std::size_t pkt_size;
-  std::size_t pipe_size;
-
-  std::size_t head;
-  std::size_t tail;
+  std::size_t pipe_size;   // bytes in buf
+  std::size_t capacity;    // packets in buf
 
-  std::deque<cpu_pipe_reserve_id_t*> rd_rids;
-  std::deque<cpu_pipe_reserve_id_t*> wr_rids;
+  cpu_pipe_side_t wr;
+  cpu_pipe_side_t rd;
 
-  char buf[0];
+  alignas(CPU_PIPE_CACHE_LINE) char buf[0];
 } cpu_pipe_t;
 
+/*
+ * Initialize a pipe in memory of sizeof(cpu_pipe_t) + pipe_size
+ * bytes aligned to CPU_PIPE_CACHE_LINE
+ */
+MAYBE_UNUSED
+EXPORT void
+cpu_pipe_init(void *v, std::size_t pkt_size, std::size_t pipe_size)
+{
+  cpu_pipe_t *p = new (v) cpu_pipe_t;
+  pthread_mutex_init(&p->lock, 0);
+  p->pkt_size = pkt_size;
+  p->pipe_size = pipe_size;
+  p->capacity = pipe_size / pkt_size;
+  for (cpu_pipe_side_t *side : {&p->wr, &p->rd}) {
+    side->claim = 0;
+    side->index = 0;
+    side->npending = 0;
+  }
+}
+
+static inline char*
+cpu_pipe_packet(cpu_pipe_t *p, std::size_t idx)
+{
+  return &p->buf[(idx % p->capacity) * p->pkt_size];
+}
+
+static inline void
+cpu_pipe_pause()
+{
+  std::this_thread::yield();
+}
+
+/*
+ * Claim n packets for writing, returns -1 if they don't fit.  For
+ * reading pass the read side and the write side as limit with a
+ * capacity of 0.
+ */
+static inline int
+cpu_pipe_claim(cpu_pipe_side_t *side, cpu_pipe_side_t *limit, std::size_t capacity,
+               unsigned n, std::size_t *start)
+{
+  std::size_t idx = side->claim.load(std::memory_order_relaxed);
+  do {
+    if (idx + n > limit->index.load(std::memory_order_acquire) + capacity)
+      return -1;
+  } while (!side->claim.compare_exchange_weak(idx, idx + n, std::memory_order_relaxed));
+  *start = idx;
+  return 0;
+}
+
+// Publish queued commits that are next in order
+static inline void
+cpu_pipe_drain(cpu_pipe_t *p, cpu_pipe_side_t *side)
+{
+  pthread_mutex_lock(&p->lock);
+  for (unsigned i = 0; i < side->npending;) {
+    cpu_pipe_pending_t &c = side->pending[i];
+    if (c.start != side->index.load()) {
+      ++i;
+      continue;
+    }
+    side->index.store(c.end);
+    c = side->pending[--side->npending];
+    i = 0;
+  }
+  pthread_mutex_unlock(&p->lock);
+}
+
+/*
+ * Publish claimed packets [start,start+n).  In order commits are a
+ * single compare and swap, out of order commits are queued and
+ * published by the commit that completes the order.
+ */
+static inline void
+cpu_pipe_commit(cpu_pipe_t *p, cpu_pipe_side_t *side, std::size_t start, unsigned n)
+{
+  for (;;) {
+    std::size_t expected = start;
+    if (side->index.compare_exchange_strong(expected, start + n)) {
+      if (side->npending.load())
+        cpu_pipe_drain(p, side);
+      return;
+    }
+
+    pthread_mutex_lock(&p->lock);
+    if (side->npending < CPU_PIPE_MAX_PENDING) {
+      side->pending[side->npending].start = start;
+      side->pending[side->npending].end = start + n;
+      ++side->npending;
+      pthread_mutex_unlock(&p->lock);
+      cpu_pipe_drain(p, side);
+      return;
+    }
+
+    // Queue is full, the commits ahead of this one will be published
+    // once the earliest claim is committed, which may be this one
+    pthread_mutex_unlock(&p->lock);
+    cpu_pipe_pause();
+  }
+}
+
+// Reserve ids are recycled per thread since reservations are
+// typically committed by the work-item that made them
+struct cpu_pipe_rid_cache {
+  cpu_pipe_reserve_id_t *head = 0;
+  ~cpu_pipe_rid_cache() {
+    while (head) {
+      cpu_pipe_reserve_id_t *next = head->next;
+      free(head);
+      head = next;
+    }
+  }
+};
+
+static inline cpu_pipe_rid_cache&
+cpu_pipe_rids()
+{
+  static thread_local cpu_pipe_rid_cache cache;
+  return cache;
+}
+
+static inline cpu_pipe_reserve_id_t*
+cpu_pipe_alloc_rid()
+{
+  cpu_pipe_rid_cache &cache = cpu_pipe_rids();
+  cpu_pipe_reserve_id_t *rid = cache.head;
+  if (rid) {
+    cache.head = rid->next;
+    return rid;
+  }
+  return (cpu_pipe_reserve_id_t*)malloc(sizeof(cpu_pipe_reserve_id_t));
+}
+
+static inline void
+cpu_pipe_free_rid(cpu_pipe_reserve_id_t *rid)
+{
+  cpu_pipe_rid_cache &cache = cpu_pipe_rids();
+  rid->next = cache.head;
+  cache.head = rid;
+}
 
 /*
  * 6.13.16.2 - work-item builtins, non-reservation, non-locking
@@ -83,13 +257,14 @@ cpu_write_pipe_nolock(void *v, void *e)
   printf("cpu_write_pipe_nolock %p %p\n", v, e);
 #endif
 
-  std::size_t head = p->head;
-  std::size_t next = (head + p->pkt_size) % p->pipe_size;
+  std::size_t head = p->wr.index.load(std::memory_order_relaxed);
 
-  while (next == p->tail);
+  while (head + 1 > p->rd.index.load(std::memory_order_acquire) + p->capacity)
+    cpu_pipe_pause();
 
-  std::memcpy(&p->buf[head], e, p->pkt_size);
-  p->head = next;
+  std::memcpy(cpu_pipe_packet(p, head), e, p->pkt_size);
+  p->wr.claim.store(head + 1, std::memory_order_relaxed);
+  p->wr.index.store(head + 1, std::memory_order_release);
 
   return 0;
 }
@@ -104,15 +279,15 @@ cpu_write_pipe_nb_nolock(void *v, void *e)
   printf("cpu_write_pipe_nb_nolock %p %p\n", v, e);
 #endif
 
-  std::size_t head = p->head;
-  std::size_t next = (head + p->pkt_size) % p->pipe_size;
+  std::size_t head = p->wr.index.load(std::memory_order_relaxed);
 
-  if (next == p->tail) {
+  if (head + 1 > p->rd.index.load(std::memory_order_acquire) + p->capacity) {
     return -1;
   }
 
-  std::memcpy(&p->buf[head], e, p->pkt_size);
-  p->head = next;
+  std::memcpy(cpu_pipe_packet(p, head), e, p->pkt_size);
+  p->wr.claim.store(head + 1, std::memory_order_relaxed);
+  p->wr.index.store(head + 1, std::memory_order_release);
   return 0;
 }
 
@@ -126,12 +301,14 @@ cpu_read_pipe_nolock(void *v, void *e)
   printf("cpu_read_pipe_nolock %p %p\n", v, e);
 #endif
 
-  std::size_t tail = p->tail;
+  std::size_t tail = p->rd.index.load(std::memory_order_relaxed);
 
-  while (p->head == tail);
+  while (p->wr.index.load(std::memory_order_acquire) == tail)
+    cpu_pipe_pause();
 
-  std::memcpy(e, &p->buf[tail], p->pkt_size);
-  p->tail = (tail + p->pkt_size) % p->pipe_size;
+  std::memcpy(e, cpu_pipe_packet(p, tail), p->pkt_size);
+  p->rd.claim.store(tail + 1, std::memory_order_relaxed);
+  p->rd.index.store(tail + 1, std::memory_order_release);
   return 0;
 }
 
@@ -145,14 +322,15 @@ cpu_read_pipe_nb_nolock(void *v, void *e)
   printf("cpu_read_pipe_nb_nolock %p %p\n", v, e);
 #endif
 
-  std::size_t tail = p->tail;
+  std::size_t tail = p->rd.index.load(std::memory_order_relaxed);
 
-  if (p->head == tail) {
+  if (p->wr.index.load(std::memory_order_acquire) == tail) {
     return -1;
   }
 
-  std::memcpy(e, &p->buf[tail], p->pkt_size);
-  p->tail = (tail + p->pkt_size) % p->pipe_size;
+  std::memcpy(e, cpu_pipe_packet(p, tail), p->pkt_size);
+  p->rd.claim.store(tail + 1, std::memory_order_relaxed);
+  p->rd.index.store(tail + 1, std::memory_order_release);
 
   return 0;
 }
@@ -168,18 +346,21 @@ cpu_peek_pipe_nb_nolock(void *v, void *e)
   printf("cpu_peek_pipe_nb_nolock %p %p\n", v, e);
 #endif
 
-  std::size_t tail = p->tail;
+  std::size_t tail = p->rd.index.load(std::memory_order_relaxed);
 
-  if (p->head == tail) {
+  if (p->wr.index.load(std::memory_order_acquire) == tail) {
     return -1;
   }
-  std::memcpy(e, &p->buf[tail], p->pkt_size);
+  std::memcpy(e, cpu_pipe_packet(p, tail), p->pkt_size);
   return 0;
 }
 
 
 /*
  * 6.13.16.2 - work-item builtins, non-reservation, locking
+ *
+ * Any number of work-items may write or read concurrently, each
+ * packet is claimed and committed like a reservation of one packet.
  */
 
 MAYBE_UNUSED
@@ -187,10 +368,12 @@ EXPORT int
 cpu_write_pipe(void *v, void *e)
 {
   cpu_pipe_t *p = (cpu_pipe_t*)v;
-  pthread_mutex_lock(&p->wr_lock);
-  int ret = cpu_write_pipe_nolock(v, e);
-  pthread_mutex_unlock(&p->wr_lock);
-  return ret;
+  std::size_t idx;
+  while (cpu_pipe_claim(&p->wr, &p->rd, p->capacity, 1, &idx))
+    cpu_pipe_pause();
+  std::memcpy(cpu_pipe_packet(p, idx), e, p->pkt_size);
+  cpu_pipe_commit(p, &p->wr, idx, 1);
+  return 0;
 }
 
 MAYBE_UNUSED
@@ -198,10 +381,12 @@ EXPORT int
 cpu_write_pipe_nb(void *v, void *e)
 {
   cpu_pipe_t *p = (cpu_pipe_t*)v;
-  pthread_mutex_lock(&p->wr_lock);
-  int ret = cpu_write_pipe_nb_nolock(v, e);
-  pthread_mutex_unlock(&p->wr_lock);
-  return ret;
+  std::size_t idx;
+  if (cpu_pipe_claim(&p->wr, &p->rd, p->capacity, 1, &idx))
+    return -1;
+  std::memcpy(cpu_pipe_packet(p, idx), e, p->pkt_size);
+  cpu_pipe_commit(p, &p->wr, idx, 1);
+  return 0;
 }
 
 MAYBE_UNUSED
@@ -209,10 +394,12 @@ EXPORT int
 cpu_read_pipe(void *v, void *e)
 {
   cpu_pipe_t *p = (cpu_pipe_t*)v;
-  pthread_mutex_lock(&p->rd_lock);
-  int ret = cpu_read_pipe_nolock(v, e);
-  pthread_mutex_unlock(&p->rd_lock);
-  return ret;
+  std::size_t idx;
+  while (cpu_pipe_claim(&p->rd, &p->wr, 0, 1, &idx))
+    cpu_pipe_pause();
+  std::memcpy(e, cpu_pipe_packet(p, idx), p->pkt_size);
+  cpu_pipe_commit(p, &p->rd, idx, 1);
+  return 0;
 }
 
 MAYBE_UNUSED
@@ -220,21 +407,26 @@ EXPORT int
 cpu_read_pipe_nb(void *v, void *e)
 {
   cpu_pipe_t *p = (cpu_pipe_t*)v;
-  pthread_mutex_lock(&p->rd_lock);
-  int ret = cpu_read_pipe_nb_nolock(v, e);
-  pthread_mutex_unlock(&p->rd_lock);
-  return ret;
+  std::size_t idx;
+  if (cpu_pipe_claim(&p->rd, &p->wr, 0, 1, &idx))
+    return -1;
+  std::memcpy(e, cpu_pipe_packet(p, idx), p->pkt_size);
+  cpu_pipe_commit(p, &p->rd, idx, 1);
+  return 0;
 }
 
 MAYBE_UNUSED
 EXPORT int
 cpu_peek_pipe_nb(void *v, void *e)
 {
+  // Next packet not claimed by another reader, which may claim it
+  // right after the copy
   cpu_pipe_t *p = (cpu_pipe_t*)v;
-  pthread_mutex_lock(&p->rd_lock);
-  int ret = cpu_peek_pipe_nb_nolock(v, e);
-  pthread_mutex_unlock(&p->rd_lock);
-  return ret;
+  std::size_t idx = p->rd.claim.load(std::memory_order_relaxed);
+  if (p->wr.index.load(std::memory_order_acquire) <= idx)
+    return -1;
+  std::memcpy(e, cpu_pipe_packet(p, idx), p->pkt_size);
+  return 0;
 }
 
 /*
@@ -249,37 +441,17 @@ cpu_reserve_read_pipe(void *v, unsigned n)
 #ifdef PIPE_VERBOSE
   printf("cpu_reserve_read_pipe %p %d\n", v, n);
 #endif
-  if (!v) return 0;
+  if (!v || !n) return 0;
 
-  pthread_mutex_lock(&p->rd_lock);
+  cpu_pipe_reserve_id_t *rid = cpu_pipe_alloc_rid();
+  if (!rid)
+    return 0;
 
-  std::size_t tail;
-  if (p->rd_rids.size()) {
-    cpu_pipe_reserve_id_t *id = p->rd_rids.back();
-    tail = id->tail;
+  if (cpu_pipe_claim(&p->rd, &p->wr, 0, n, &rid->start)) {
+    cpu_pipe_free_rid(rid);
+    return 0;
   }
-  else {
-    tail = p->tail;
-  }
-
-  int space = p->head - tail;
-  if (space < 0)
-    space += p->pipe_size;
-
-  cpu_pipe_reserve_id_t *rid = 0;
-  if ((int)n <= space) {
-    rid = (cpu_pipe_reserve_id_t*)malloc(sizeof(cpu_pipe_reserve_id_t));
-    if (rid) {
-      // success
-      rid->tail = tail;
-      rid->next = (tail + (p->pkt_size*n)) % p->pipe_size;
-      rid->size = n*p->pkt_size;
-      rid->ref = 1;
-      p->rd_rids.push_back(rid);
-    }
-  }
-
-  pthread_mutex_unlock(&p->rd_lock);
+  rid->n = n;
   return rid;
 }
 
@@ -292,20 +464,10 @@ cpu_commit_read_pipe(void *v, void *r)
 #ifdef PIPE_VERBOSE
   printf("cpu_commit_read_pipe %p %p\n", v, r);
 #endif
+  assert(rid && "bad commit on read pipe");
 
-  pthread_mutex_lock(&p->rd_lock);
-
-  rid->ref--;
-  assert(rid->ref == 0 && "bad commit on read pipe");
-
-  while (p->rd_rids.size() && !p->rd_rids.front()->ref) {
-    cpu_pipe_reserve_id_t *front = p->rd_rids.front();
-    p->tail = front->next;
-    p->rd_rids.pop_front();
-    free(front);
-  }
-
-  pthread_mutex_unlock(&p->rd_lock);
+  cpu_pipe_commit(p, &p->rd, rid->start, rid->n);
+  cpu_pipe_free_rid(rid);
 }
 
 MAYBE_UNUSED
@@ -317,15 +479,10 @@ cpu_read_pipe_reserve(void *v, void *r, unsigned idx, void *e)
 #ifdef PIPE_VERBOSE
   printf("cpu_read_pipe_reserve %p %p %d %p\n", v, r, idx, e);
 #endif
-  if (!p || !rid)
-    return -1;
-
-  std::size_t offset = idx*p->pkt_size;
-  if (offset > (rid->size+p->pkt_size))
+  if (!p || !rid || idx >= rid->n)
     return -1;
 
-  offset = (rid->tail + offset) % p->pipe_size;
-  std::memcpy(e, &p->buf[offset], p->pkt_size);
+  std::memcpy(e, cpu_pipe_packet(p, rid->start + idx), p->pkt_size);
 
   return 0;
 }
@@ -338,38 +495,17 @@ cpu_reserve_write_pipe(void *v, unsigned n)
 #ifdef PIPE_VERBOSE
   printf("cpu_reserve_write_pipe %p %d\n", v, n);
 #endif
-  if (!v) return 0;
+  if (!v || !n) return 0;
 
-  pthread_mutex_lock(&p->wr_lock);
-
-  std::size_t head;
-  if (p->wr_rids.size()) {
-    cpu_pipe_reserve_id_t *id = p->wr_rids.back();
-    head = id->head;
-  }
-  else {
-    head = p->head;
-  }
+  cpu_pipe_reserve_id_t *rid = cpu_pipe_alloc_rid();
+  if (!rid)
+    return 0;
 
-  int next = (head + p->pkt_size) % p->pipe_size;
-  int space = p->tail - next;
-  if (space < 0)
-    space += p->pipe_size;
-
-  cpu_pipe_reserve_id_t *rid = 0;
-  if ((int)n <= space) {
-    rid = (cpu_pipe_reserve_id_t*)malloc(sizeof(cpu_pipe_reserve_id_t));
-    if (rid) {
-      // success
-      rid->head = head;
-      rid->next = (head + (p->pkt_size*n)) % p->pipe_size;
-      rid->size = n*p->pkt_size;
-      rid->ref = 1;
-      p->wr_rids.push_back(rid);
-    }
+  if (cpu_pipe_claim(&p->wr, &p->rd, p->capacity, n, &rid->start)) {
+    cpu_pipe_free_rid(rid);
+    return 0;
   }
-
-  pthread_mutex_unlock(&p->wr_lock);
+  rid->n = n;
   return rid;
 }
 
@@ -382,19 +518,10 @@ cpu_commit_write_pipe(void *v, void *r)
 #ifdef PIPE_VERBOSE
   printf("cpu_commit_write_pipe %p %p\n", v, r);
 #endif
-  pthread_mutex_lock(&p->wr_lock);
-
-  rid->ref--;
-  assert(rid->ref == 0 && "bad commit on write pipe");
-
-  while (p->wr_rids.size() && !p->wr_rids.front()->ref) {
-    cpu_pipe_reserve_id_t *front = p->wr_rids.front();
-    p->head = front->next;
-    p->wr_rids.pop_front();
-    free(front);
-  }
+  assert(rid && "bad commit on write pipe");
 
-  pthread_mutex_unlock(&p->wr_lock);
+  cpu_pipe_commit(p, &p->wr, rid->start, rid->n);
+  cpu_pipe_free_rid(rid);
 }
 
 MAYBE_UNUSED
@@ -406,15 +533,10 @@ cpu_write_pipe_reserve(void *v, void *r, unsigned idx, void *e)
 #ifdef PIPE_VERBOSE
   printf("cpu_write_pipe_reserve %p %p %d %d\n", v, r, idx, *(int*)e);
 #endif
-  if (!p || !rid)
+  if (!p || !rid || idx >= rid->n)
     return -1;
 
-  std::size_t offset = idx*p->pkt_size;
-  if (offset > (rid->size+p->pkt_size))
-    return -1;
-
-  offset = (rid->head + offset) % p->pipe_size;
-  std::memcpy(&p->buf[offset], e, p->pkt_size);
+  std::memcpy(cpu_pipe_packet(p, rid->start + idx), e, p->pkt_size);
 
   return 0;
 }
@@ -462,23 +584,11 @@ cpu_get_pipe_num_packets(void *v)
 {
   cpu_pipe_t *p = (cpu_pipe_t*)v;
 
-  pthread_mutex_lock(&p->rd_lock);
-  std::size_t head = p->head;
-  std::size_t tail;
-  if (p->rd_rids.size()) {
-    cpu_pipe_reserve_id_t *id = p->rd_rids.back();
-    tail = id->tail;
-  }
-  else {
-    tail = p->tail;
-  }
-  pthread_mutex_unlock(&p->rd_lock);
-
-  int space = head - tail;
-  if (space < 0)
-    space += p->pipe_size;
+  // Published packets not yet reserved by a reader
+  std::size_t tail = p->rd.claim.load(std::memory_order_relaxed);
+  std::size_t head = p->wr.index.load(std::memory_order_acquire);
 
-  return (unsigned int)(space / p->pkt_size);
+  return (unsigned int)(head > tail ? head - tail : 0);
 }
 
 MAYBE_UNUSED
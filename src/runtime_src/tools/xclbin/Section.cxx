@@ -16,12 +16,16 @@
 
 #include "Section.h"
 
+#include <algorithm>
 #include <iostream>
+#include <fcntl.h>
+#include <unistd.h>
 #include <boost/algorithm/string.hpp>
 #include <boost/property_tree/json_parser.hpp>
 
 
 #include "XclBinUtilities.h"
+#include "driver/common/xclbin_compress.h"
 namespace XUtil = XclBinUtilities;
 
 // Static Variables Initialization
@@ -36,7 +40,10 @@ Section::Section()
     , m_sKindName("")
     , m_pBuffer(nullptr)
     , m_bufferSize(0)
-    , m_name("") {
+    , m_name("")
+    , m_sDeferredFile("")
+    , m_deferredOffset(0)
+    , m_bCompressed(false) {
   // Empty
 }
 
@@ -52,6 +59,7 @@ Section::purgeBuffers()
     m_pBuffer = nullptr;
   }
   m_bufferSize = 0;
+  m_sDeferredFile.clear();
 }
 
 void
@@ -207,6 +215,30 @@ Section::initXclBinSectionHeader(axlf_section_header& _sectionHeader) {
 void
 Section::writeXclBinSectionBuffer(std::fstream& _ostream) const
 {
+  // Stream a deferred payload through a bounded buffer
+  if (isPayloadDeferred()) {
+    std::fstream ifSource(m_sDeferredFile, std::ifstream::in | std::ifstream::binary);
+    if (!ifSource.is_open()) {
+      std::string errMsg = "ERROR: Unable to open the file for reading: " + m_sDeferredFile;
+      throw std::runtime_error(errMsg);
+    }
+    ifSource.seekg(m_deferredOffset);
+
+    static const unsigned int chunkSize = 0x100000;
+    std::unique_ptr<char[]> chunk(new char[chunkSize]);
+    for (unsigned int remaining = m_bufferSize; remaining != 0; ) {
+      unsigned int size = std::min(remaining, chunkSize);
+      ifSource.read(chunk.get(), size);
+      if (ifSource.gcount() != size) {
+        std::string errMsg = "ERROR: Input stream for the binary buffer is smaller then the expected size.";
+        throw std::runtime_error(errMsg);
+      }
+      _ostream.write(chunk.get(), size);
+      remaining -= size;
+    }
+    return;
+  }
+
   if ((m_pBuffer == nullptr) ||
       (m_bufferSize == 0)) {
     return;
@@ -215,6 +247,148 @@ Section::writeXclBinSectionBuffer(std::fstream& _ostream) const
   _ostream.write(m_pBuffer, m_bufferSize);
 }
 
+void
+Section::readXclBinBinaryDeferred(const std::string& _sFileName, const axlf_section_header& _sectionHeader) {
+  // Some error checking
+  if ((enum axlf_section_kind)_sectionHeader.m_sectionKind != getSectionKind()) {
+    std::string errMsg = XUtil::format("ERROR: Unexpected section kind.  Expected: %d, Read: %d", getSectionKind(), _sectionHeader.m_sectionKind);
+    throw std::runtime_error(errMsg);
+  }
+
+  if ((m_pBuffer != nullptr) || isPayloadDeferred()) {
+    std::string errMsg = "ERROR: Binary buffer already exists.";
+    throw std::runtime_error(errMsg);
+  }
+
+  // Compressed sections can't be copied as is, expand them now.  The
+  // flags used to be padding, only trust them if the magic is there too.
+  if (_sectionHeader.m_sectionFlags & AXLF_SECTION_COMPRESSED) {
+    std::fstream ifSource(_sFileName, std::ifstream::in | std::ifstream::binary);
+    if (!ifSource.is_open()) {
+      std::string errMsg = "ERROR: Unable to open the file for reading: " + _sFileName;
+      throw std::runtime_error(errMsg);
+    }
+    char magic[sizeof(axlf_compressed_section)];
+    ifSource.seekg(_sectionHeader.m_sectionOffset);
+    ifSource.read(magic, std::min<uint64_t>(sizeof(magic), _sectionHeader.m_sectionSize));
+    if (xrt_core::xclbin::is_compressed_section(magic, ifSource.gcount())) {
+      readXclBinBinary(ifSource, _sectionHeader);
+      return;
+    }
+  }
+
+  m_name = (char*)&_sectionHeader.m_sectionName;
+  m_bufferSize = _sectionHeader.m_sectionSize;
+  m_sDeferredFile = _sFileName;
+  m_deferredOffset = _sectionHeader.m_sectionOffset;
+
+  XUtil::TRACE(XUtil::format("Section: %s (%d), deferred", getSectionKindAsString().c_str(), (unsigned int)getSectionKind()));
+  XUtil::TRACE(XUtil::format("  m_name: %s", m_name.c_str()));
+  XUtil::TRACE(XUtil::format("  m_size: %ld", m_bufferSize));
+}
+
+void
+Section::setCompressed(bool _bCompressed) {
+  m_bCompressed = _bCompressed;
+}
+
+bool
+Section::isCompressed() const {
+  return m_bCompressed;
+}
+
+std::vector<char>
+Section::getCompressedPayload() const {
+  loadPayload();
+  XUtil::TRACE(XUtil::format("Compressing section: %s (%d)", getSectionKindAsString().c_str(), (unsigned int)getSectionKind()));
+  return xrt_core::xclbin::compress_section(m_pBuffer, m_bufferSize);
+}
+
+void
+Section::expandBuffer() {
+  XUtil::TRACE(XUtil::format("Expanding compressed section: %s (%d)", getSectionKindAsString().c_str(), (unsigned int)getSectionKind()));
+  try {
+    uint64_t expandedSize = xrt_core::xclbin::get_uncompressed_size(m_pBuffer, m_bufferSize);
+    std::unique_ptr<char[]> expanded(new char[expandedSize]);
+    xrt_core::xclbin::decompress_section(m_pBuffer, m_bufferSize, expanded.get(), expandedSize);
+    delete m_pBuffer;
+    m_pBuffer = expanded.release();
+    m_bufferSize = expandedSize;
+  } catch (std::exception &e) {
+    std::string errMsg = XUtil::format("ERROR: Section '%s': %s", getSectionKindAsString().c_str(), e.what());
+    throw std::runtime_error(errMsg);
+  }
+  m_bCompressed = true;
+}
+
+bool
+Section::isPayloadDeferred() const {
+  return !m_sDeferredFile.empty();
+}
+
+void
+Section::loadPayload() const {
+  if (!isPayloadDeferred()) {
+    return;
+  }
+
+  XUtil::TRACE(XUtil::format("Loading deferred section: %s (%d)", getSectionKindAsString().c_str(), (unsigned int)getSectionKind()));
+  std::fstream ifSource(m_sDeferredFile, std::ifstream::in | std::ifstream::binary);
+  if (!ifSource.is_open()) {
+    std::string errMsg = "ERROR: Unable to open the file for reading: " + m_sDeferredFile;
+    throw std::runtime_error(errMsg);
+  }
+
+  std::unique_ptr<char[]> buffer(new char[m_bufferSize]);
+  ifSource.seekg(m_deferredOffset);
+  ifSource.read(buffer.get(), m_bufferSize);
+  if (ifSource.gcount() != m_bufferSize) {
+    std::string errMsg = "ERROR: Input stream for the binary buffer is smaller then the expected size.";
+    throw std::runtime_error(errMsg);
+  }
+
+  m_pBuffer = buffer.release();
+  m_sDeferredFile.clear();
+}
+
+void
+Section::readPayloadHead(char* _pBuffer, unsigned int _size) const {
+  if (!isPayloadDeferred()) {
+    memcpy(_pBuffer, m_pBuffer, _size);
+    return;
+  }
+
+  std::fstream ifSource(m_sDeferredFile, std::ifstream::in | std::ifstream::binary);
+  ifSource.seekg(m_deferredOffset);
+  ifSource.read(_pBuffer, _size);
+  if (ifSource.gcount() != _size) {
+    std::string errMsg = "ERROR: Input stream for the binary buffer is smaller then the expected size.";
+    throw std::runtime_error(errMsg);
+  }
+}
+
+void
+Section::copyPayload(int _fdOut, uint64_t _offsetOut) const {
+  if (!isPayloadDeferred()) {
+    std::string errMsg = "ERROR: Section payload is not deferred.";
+    throw std::runtime_error(errMsg);
+  }
+
+  int fdIn = open(m_sDeferredFile.c_str(), O_RDONLY);
+  if (fdIn == -1) {
+    std::string errMsg = "ERROR: Unable to open the file for reading: " + m_sDeferredFile;
+    throw std::runtime_error(errMsg);
+  }
+
+  try {
+    XUtil::copyFileRange(fdIn, m_deferredOffset, _fdOut, _offsetOut, m_bufferSize);
+  } catch (...) {
+    close(fdIn);
+    throw;
+  }
+  close(fdIn);
+}
+
 void
 Section::readXclBinBinary(std::fstream& _istream, const axlf_section_header& _sectionHeader) {
   // Some error checking
@@ -223,7 +397,7 @@ Section::readXclBinBinary(std::fstream& _istream, const axlf_section_header& _se
     throw std::runtime_error(errMsg);
   }
 
-  if (m_pBuffer != nullptr) {
+  if ((m_pBuffer != nullptr) || isPayloadDeferred()) {
     std::string errMsg = "ERROR: Binary buffer already exists.";
     throw std::runtime_error(errMsg);
   }
@@ -241,6 +415,11 @@ Section::readXclBinBinary(std::fstream& _istream, const axlf_section_header& _se
     throw std::runtime_error(errMsg);
   }
 
+  if ((_sectionHeader.m_sectionFlags & AXLF_SECTION_COMPRESSED) &&
+      xrt_core::xclbin::is_compressed_section(m_pBuffer, m_bufferSize)) {
+    expandBuffer();
+  }
+
   XUtil::TRACE(XUtil::format("Section: %s (%d)", getSectionKindAsString().c_str(), (unsigned int)getSectionKind()));
   XUtil::TRACE(XUtil::format("  m_name: %s", m_name.c_str()));
   XUtil::TRACE(XUtil::format("  m_size: %ld", m_bufferSize));
@@ -276,7 +455,7 @@ Section::readXclBinBinary(std::fstream& _istream,
     std::string errMsg = XUtil::format("ERROR: Unexpected section kind.  Expected: %d, Read: %d", getSectionKind(), eKind);
   }
 
-  if (m_pBuffer != nullptr) {
+  if ((m_pBuffer != nullptr) || isPayloadDeferred()) {
     std::string errMsg = "ERROR: Binary buffer already exists.";
     throw std::runtime_error(errMsg);
   }
@@ -304,6 +483,12 @@ Section::readXclBinBinary(std::fstream& _istream,
       std::string errMsg = "ERROR: Input stream for the binary buffer is smaller then the expected size.";
       throw std::runtime_error(errMsg);
     }
+
+    unsigned int flags = XUtil::stringToUInt64(_ptSection.get<std::string>("Flags", "0"));
+    if ((flags & AXLF_SECTION_COMPRESSED) &&
+        xrt_core::xclbin::is_compressed_section(m_pBuffer, m_bufferSize)) {
+      expandBuffer();
+    }
   }
 
   XUtil::TRACE(XUtil::format("Adding Section: %s (%d)", getSectionKindAsString().c_str(), (unsigned int)getSectionKind()));
@@ -314,6 +499,7 @@ Section::readXclBinBinary(std::fstream& _istream,
 
 void
 Section::getPayload(boost::property_tree::ptree& _pt) const {
+  loadPayload();
   marshalToJSON(m_pBuffer, m_bufferSize, _pt);
 }
 
@@ -467,6 +653,7 @@ Section::dumpContents(std::fstream& _ostream, enum FormatType _eFormatType) cons
   case FT_JSON:
     {
       boost::property_tree::ptree pt;
+      loadPayload();
       marshalToJSON(m_pBuffer, m_bufferSize, pt);
 
       boost::property_tree::write_json(_ostream, pt, true /*Pretty print*/);
@@ -475,6 +662,7 @@ Section::dumpContents(std::fstream& _ostream, enum FormatType _eFormatType) cons
   case FT_HTML:
     {
       boost::property_tree::ptree pt;
+      loadPayload();
       marshalToJSON(m_pBuffer, m_bufferSize, pt);
 
       _ostream << XUtil::format("<!DOCTYPE html><html><body><h1>Section: %s (%d)</h1><pre>", getSectionKindAsString().c_str(), getSectionKind()) << std::endl;
@@ -551,6 +739,7 @@ Section::getSubPayload(std::ostringstream &_buf,
   }
 
   // All is good now get the data from the section
+  loadPayload();
   getSubPayload(m_pBuffer, m_bufferSize, _buf, _sSubSection, _eFormatType);
 
   if (_buf.tellp() == 0) {
@@ -582,6 +771,7 @@ Section::readSubPayload(std::fstream& _istream,
 
   // All is good now get the data from the section
   std::ostringstream buffer;
+  loadPayload();
   readSubPayload(m_pBuffer, m_bufferSize, _istream, _sSubSection, _eFormatType, buffer);
 
   // Now for some how cleaning
@@ -93,6 +93,21 @@ class Section {
   void purgeBuffers();
   void setName(const std::string &_sSectionName);
 
+ public:
+  // Deferred payload: the section is only described by its header and
+  // the payload stays in the input file until it is accessed.  Sections
+  // that are never examined are copied file to file.
+  void readXclBinBinaryDeferred(const std::string& _sFileName, const axlf_section_header& _sectionHeader);
+  bool isPayloadDeferred() const;
+  void loadPayload() const;
+  void copyPayload(int _fdOut, uint64_t _offsetOut) const;
+
+ public:
+  // Store the section compressed when written to an xclbin
+  void setCompressed(bool _bCompressed);
+  bool isCompressed() const;
+  std::vector<char> getCompressedPayload() const;
+
  protected:
   // Child class option to create an JSON metadata
   virtual void marshalToJSON(char* _pDataSection, unsigned int _sectionSize, boost::property_tree::ptree& _ptree) const;
@@ -100,6 +115,8 @@ class Section {
   virtual void getSubPayload(char* _pDataSection, unsigned int _sectionSize, std::ostringstream &_buf, const std::string &_sSubSection, enum Section::FormatType _eFormatType) const;
   virtual void readSubPayload(const char *_pOrigDataSection, unsigned int _origSectionSize,  std::fstream &_istream, const std::string &_sSubSection, enum Section::FormatType _eFormatType, std::ostringstream &_buffer) const;
   virtual void writeSubPayload(const std::string & _sSubSectionName, FormatType _eFormatType, std::fstream&  _oStream) const;
+  void readPayloadHead(char* _pBuffer, unsigned int _size) const;
+  void expandBuffer();
 
  protected:
   Section();
@@ -112,10 +129,14 @@ class Section {
   enum axlf_section_kind m_eKind;
   std::string m_sKindName;
 
-  char* m_pBuffer;
+  mutable char* m_pBuffer;
   unsigned int m_bufferSize;
   std::string m_name;
 
+  mutable std::string m_sDeferredFile;
+  uint64_t m_deferredOffset;
+  bool m_bCompressed;
+
  private:
   static std::map<enum axlf_section_kind, std::string> m_mapIdToName;
   static std::map<std::string, enum axlf_section_kind> m_mapNameToId;
@@ -52,6 +52,7 @@ SectionBMC::doesSupportAddFormatType(FormatType _eFormatType) const
 bool
 SectionBMC::subSectionExists(const std::string& _sSubSectionName) const {
   // No buffer no subsections
+  loadPayload();
   if (m_pBuffer == nullptr) {
     return false;
   }
@@ -379,6 +380,7 @@ SectionBMC::writeSubPayload(const std::string & _sSubSectionName,
                             FormatType _eFormatType, 
                             std::fstream&  _oStream) const {
   // Some basic DRC checks
+  loadPayload();
   if (m_pBuffer == nullptr) {
     std::string errMsg = "ERROR: BMC section does not exist.";
     throw std::runtime_error(errMsg);
@@ -37,29 +37,33 @@ SectionBitstream::getContentTypeAsString()
      return "Binary Image";
   }
 
-  XUtil::TRACE_BUF("BUFFER", (const char*) m_pBuffer, 8);
+  // Only the head of the payload is needed to identify it
+  char head[8];
+  readPayloadHead(head, sizeof(head));
+
+  XUtil::TRACE_BUF("BUFFER", (const char*) head, 8);
 
   // Bitstream
-  if (((unsigned char) m_pBuffer[0] == 0x00 ) &&
-      ((unsigned char) m_pBuffer[1] == 0x09 ) &&
-      ((unsigned char) m_pBuffer[2] == 0x0f ) &&
-      ((unsigned char) m_pBuffer[3] == 0xf0 ) &&
-      ((unsigned char) m_pBuffer[4] == 0x0f ) &&
-      ((unsigned char) m_pBuffer[5] == 0xf0 ) &&
-      ((unsigned char) m_pBuffer[6] == 0x0f ) &&
-      ((unsigned char) m_pBuffer[7] == 0xf0 )) {
+  if (((unsigned char) head[0] == 0x00 ) &&
+      ((unsigned char) head[1] == 0x09 ) &&
+      ((unsigned char) head[2] == 0x0f ) &&
+      ((unsigned char) head[3] == 0xf0 ) &&
+      ((unsigned char) head[4] == 0x0f ) &&
+      ((unsigned char) head[5] == 0xf0 ) &&
+      ((unsigned char) head[6] == 0x0f ) &&
+      ((unsigned char) head[7] == 0xf0 )) {
       return "Bitstream";
   }
 
   // ZIP
-  if (((unsigned char) m_pBuffer[0] == 0x50 ) &&
-      ((unsigned char) m_pBuffer[1] == 0x4B )) {
-    if ((((unsigned char) m_pBuffer[2] == 0x03 ) &&
-         ((unsigned char) m_pBuffer[3] == 0x04 )) ||
-        (((unsigned char) m_pBuffer[2] == 0x05 ) &&
-         ((unsigned char) m_pBuffer[3] == 0x06 )) ||
-        (((unsigned char) m_pBuffer[2] == 0x07 ) &&
-         ((unsigned char) m_pBuffer[3] == 0x08 ))) {
+  if (((unsigned char) head[0] == 0x50 ) &&
+      ((unsigned char) head[1] == 0x4B )) {
+    if ((((unsigned char) head[2] == 0x03 ) &&
+         ((unsigned char) head[3] == 0x04 )) ||
+        (((unsigned char) head[2] == 0x05 ) &&
+         ((unsigned char) head[3] == 0x06 )) ||
+        (((unsigned char) head[2] == 0x07 ) &&
+         ((unsigned char) head[3] == 0x08 ))) {
       if (m_name == "behav") {
         return "HW Emulation Binary";
       }
@@ -68,10 +72,10 @@ SectionBitstream::getContentTypeAsString()
   }
 
   // ELF
-  if (((unsigned char) m_pBuffer[0] == 0x7f ) &&
-      ((unsigned char) m_pBuffer[1] == 0x45 ) &&
-      ((unsigned char) m_pBuffer[2] == 0x4c ) &&
-      ((unsigned char) m_pBuffer[3] == 0x46 )) {
+  if (((unsigned char) head[0] == 0x7f ) &&
+      ((unsigned char) head[1] == 0x45 ) &&
+      ((unsigned char) head[2] == 0x4c ) &&
+      ((unsigned char) head[3] == 0x46 )) {
     return "SW Emulation Binary";
   }
 
@@ -137,6 +137,7 @@ SectionMCS::getSubPayload(char* _pDataSection,
   // Get the payload
   std::vector<mcsBufferPair> mcsBuffers;
 
+  loadPayload();
   if (m_pBuffer != nullptr) {
     extractBuffers(m_pBuffer, m_bufferSize, mcsBuffers);
   }
@@ -350,6 +351,7 @@ bool
 SectionMCS::subSectionExists(const std::string& _sSubSectionName) const {
   // Get a list of the sections
   std::vector<mcsBufferPair> mcsBuffers;
+  loadPayload();
   if (m_pBuffer != nullptr) {
     extractBuffers(m_pBuffer, m_bufferSize, mcsBuffers);
   }
@@ -410,6 +412,7 @@ SectionMCS::writeSubPayload(const std::string & _sSubSectionName,
 
   // Obtain the collection of MCS buffers
   std::vector<mcsBufferPair> mcsBuffers;
+  loadPayload();
   if (m_pBuffer != nullptr) {
     extractBuffers(m_pBuffer, m_bufferSize, mcsBuffers);
   }
@@ -19,6 +19,8 @@
 #include "Section.h"
 
 #include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
 #include <boost/property_tree/json_parser.hpp>
 #include <boost/algorithm/string.hpp>
 
@@ -131,7 +133,11 @@ XclBin::readXclBinBinaryHeader(std::fstream& _istream) {
 }
 
 void
-XclBin::readXclBinBinarySections(std::fstream& _istream) {
+XclBin::readXclBinBinarySections(std::fstream& _istream, const std::string& _binaryFileName) {
+  // Determine the file size, used to validate the section headers
+  _istream.seekg(0, _istream.end);
+  uint64_t fileSize = _istream.tellg();
+
   // Read in each section
   unsigned int numberOfSections = m_xclBinHeader.m_header.m_numSections;
 
@@ -154,9 +160,16 @@ XclBin::readXclBinBinarySections(std::fstream& _istream) {
 
     Section* pSection = Section::createSectionObjectOfKind((enum axlf_section_kind)sectionHeader.m_sectionKind);
 
+    if (sectionHeader.m_sectionOffset + sectionHeader.m_sectionSize > fileSize) {
+      std::string errMsg = XUtil::format("ERROR: Section %d (offset: 0x%lx, size: 0x%lx) extends beyond the end of the file.", 
+                                         index, sectionHeader.m_sectionOffset, sectionHeader.m_sectionSize);
+      throw std::runtime_error(errMsg);
+    }
+
     // Here for testing purposes, when all segments are supported it should be removed
+    // Only the header is read, the payload is read (or copied) on demand
     if (pSection != nullptr) {
-      pSection->readXclBinBinary(_istream, sectionHeader);
+      pSection->readXclBinBinaryDeferred(_binaryFileName, sectionHeader);
       addSection(pSection);
     }
   }
@@ -191,7 +204,8 @@ XclBin::readXclBinBinary(const std::string &_binaryFileName,
     readXclBinBinaryHeader(ifXclBin);
 
     // Read the sections
-    readXclBinBinarySections(ifXclBin);
+    readXclBinBinarySections(ifXclBin, _binaryFileName);
+    m_sInputFile = _binaryFileName;
   }
 
   ifXclBin.close();
@@ -238,7 +252,7 @@ XclBin::writeXclBinBinaryHeader(std::fstream& _ostream, boost::property_tree::pt
 
 
 void
-XclBin::writeXclBinBinarySections(std::fstream& _ostream, boost::property_tree::ptree& _mirroredData) {
+XclBin::writeXclBinBinarySections(std::fstream& _ostream, int _fdOut, boost::property_tree::ptree& _mirroredData) {
   // Nothing to write
   if (m_sections.empty()) {
     return;
@@ -248,6 +262,9 @@ XclBin::writeXclBinBinarySections(std::fstream& _ostream, boost::property_tree::
   struct axlf_section_header sectionHeader[m_sections.size()];
   memset(&sectionHeader, 0, sizeof(sectionHeader));  // Zero out memory
 
+  // Sections stored compressed, their size is only known once compressed
+  std::vector<std::vector<char>> compressedPayloads(m_sections.size());
+
 
   // Populate the array size and offsets
   unsigned int currentOffset = sizeof(axlf) - sizeof(axlf_section_header) + sizeof(sectionHeader);
@@ -257,6 +274,11 @@ XclBin::writeXclBinBinarySections(std::fstream& _ostream, boost::property_tree::
 
     // Initialize section header
     m_sections[index]->initXclBinSectionHeader(sectionHeader[index]);
+    if (m_sections[index]->isCompressed()) {
+      compressedPayloads[index] = m_sections[index]->getCompressedPayload();
+      sectionHeader[index].m_sectionSize = compressedPayloads[index].size();
+      sectionHeader[index].m_sectionFlags |= AXLF_SECTION_COMPRESSED;
+    }
     sectionHeader[index].m_sectionOffset = currentOffset;
     currentOffset += sectionHeader[index].m_sectionSize;
   }
@@ -283,8 +305,17 @@ XclBin::writeXclBinBinarySections(std::fstream& _ostream, boost::property_tree::
       throw std::runtime_error(errMsg);
     }
 
-    // Write buffer
-    m_sections[index]->writeXclBinSectionBuffer(_ostream);
+    // Write buffer, untouched sections are copied directly from the input file
+    if (m_sections[index]->isCompressed()) {
+      _ostream.write(compressedPayloads[index].data(), compressedPayloads[index].size());
+      std::vector<char>().swap(compressedPayloads[index]);
+    } else if (m_sections[index]->isPayloadDeferred()) {
+      _ostream.flush();
+      m_sections[index]->copyPayload(_fdOut, runningOffset);
+      _ostream.seekp(runningOffset + sectionHeader[index].m_sectionSize);
+    } else {
+      m_sections[index]->writeXclBinSectionBuffer(_ostream);
+    }
 
     // Write mirror data
     {
@@ -303,6 +334,9 @@ XclBin::writeXclBinBinarySections(std::fstream& _ostream, boost::property_tree::
       pt_sectionHeader.put("Name", XUtil::format("%s", sectionHeader[index].m_sectionName).c_str());
       pt_sectionHeader.put("Offset", XUtil::format("0x%lx", sectionHeader[index].m_sectionOffset).c_str());
       pt_sectionHeader.put("Size", XUtil::format("0x%lx", sectionHeader[index].m_sectionSize).c_str());
+      if (sectionHeader[index].m_sectionFlags != 0) {
+        pt_sectionHeader.put("Flags", XUtil::format("0x%x", sectionHeader[index].m_sectionFlags).c_str());
+      }
 
       boost::property_tree::ptree pt_Payload;
       if (m_sections[index]->doesSupportAddFormatType(Section::FT_JSON) && 
@@ -351,6 +385,13 @@ XclBin::writeXclBinBinary(const std::string &_binaryFileName,
     throw std::runtime_error(errMsg);
   }
 
+  // Overwriting the input file, bring in the payloads before it is truncated
+  if (!m_sInputFile.empty() && XUtil::isSameFile(m_sInputFile, _binaryFileName)) {
+    for (auto pSection : m_sections) {
+      pSection->loadPayload();
+    }
+  }
+
   // Write the xclbin file image
   XUtil::TRACE("Writing the xclbin binary file: " + _binaryFileName);
   std::fstream ofXclBin;
@@ -360,6 +401,13 @@ XclBin::writeXclBinBinary(const std::string &_binaryFileName,
     throw std::runtime_error(errMsg);
   }
 
+  // Descriptor used to copy the deferred sections
+  int fdOut = open(_binaryFileName.c_str(), O_WRONLY);
+  if (fdOut == -1) {
+    std::string errMsg = "ERROR: Unable to open the file for writing: " + _binaryFileName;
+    throw std::runtime_error(errMsg);
+  }
+
   if (_bSkipUUIDInsertion) {
     XUtil::TRACE("Skipping xclbin's UUID insertion.");
   } else {
@@ -376,7 +424,13 @@ XclBin::writeXclBinBinary(const std::string &_binaryFileName,
   writeXclBinBinaryHeader(ofXclBin, mirroredData);
 
   // Write the section array and sections
-  writeXclBinBinarySections(ofXclBin, mirroredData);
+  try {
+    writeXclBinBinarySections(ofXclBin, fdOut, mirroredData);
+  } catch (...) {
+    close(fdOut);
+    throw;
+  }
+  close(fdOut);
 
   // Write out our mirror data
   writeXclBinBinaryMirrorData(ofXclBin, mirroredData);
@@ -648,6 +702,31 @@ XclBin::removeSection(const std::string & _sSectionToRemove)
 }
 
 
+void 
+XclBin::compressSection(const std::string & _sSectionToCompress)
+{
+  XUtil::TRACE("Compressing Section: " + _sSectionToCompress);
+
+  enum axlf_section_kind _eKind;
+
+  if (Section::translateSectionKindStrToKind(_sSectionToCompress, _eKind) == false) {
+    std::string errMsg = XUtil::format("ERROR: Section '%s' isn't a valid section name.", _sSectionToCompress.c_str());
+    throw std::runtime_error(errMsg);
+  }
+
+  Section * pSection = findSection(_eKind);
+  if (pSection == nullptr) {
+    std::string errMsg = XUtil::format("ERROR: Section '%s' is not part of the xclbin archive.", _sSectionToCompress.c_str());
+    throw std::runtime_error(errMsg);
+  }
+
+  pSection->setCompressed(true);
+  std::cout << std::endl << XUtil::format("Section '%s'(%d) will be stored compressed", 
+                                          pSection->getSectionKindAsString().c_str(), 
+                                          pSection->getSectionKind()) << std::endl;
+}
+
+
 void 
 XclBin::replaceSection(ParameterSectionData &_PSD)
 {
@@ -1168,6 +1247,12 @@ XclBin::dumpSection(ParameterSectionData &_PSD)
   }
 
   std::string sDumpFileName = _PSD.getFile();
+
+  // Overwriting the input file, bring in the payload before it is truncated
+  if (!m_sInputFile.empty() && XUtil::isSameFile(m_sInputFile, sDumpFileName)) {
+    pSection->loadPayload();
+  }
+
   // Write the xclbin file image
   std::fstream oDumpFile;
   oDumpFile.open(sDumpFileName, std::ifstream::out | std::ifstream::binary);
@@ -1176,7 +1261,24 @@ XclBin::dumpSection(ParameterSectionData &_PSD)
     throw std::runtime_error(errMsg);
   }
 
-  pSection->dumpContents(oDumpFile, _PSD.getFormatType());
+  // Raw images still in the input file are copied file to file
+  if ((_PSD.getFormatType() == Section::FT_RAW) && pSection->isPayloadDeferred()) {
+    oDumpFile.close();
+    int fdOut = open(sDumpFileName.c_str(), O_WRONLY);
+    if (fdOut == -1) {
+      std::string errMsg = "ERROR: Unable to open the file for writing: " + sDumpFileName;
+      throw std::runtime_error(errMsg);
+    }
+    try {
+      pSection->copyPayload(fdOut, 0);
+    } catch (...) {
+      close(fdOut);
+      throw;
+    }
+    close(fdOut);
+  } else {
+    pSection->dumpContents(oDumpFile, _PSD.getFormatType());
+  }
   XUtil::TRACE(XUtil::format("Section '%s' (%d) dumped.", pSection->getSectionKindAsString().c_str(), pSection->getSectionKind()));
   std::cout << std::endl << XUtil::format("Section: '%s'(%d) was successfully written.\nFormat: %s\nFile  : '%s'", 
                                           pSection->getSectionKindAsString().c_str(), 
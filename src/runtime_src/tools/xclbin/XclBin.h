@@ -46,6 +46,7 @@ class XclBin {
   void readXclBinBinary(const std::string &_binaryFileName, bool _bMigrate = false);
   void writeXclBinBinary(const std::string &_binaryFileName, bool _bSkipUUIDInsertion);
   void removeSection(const std::string & _sSectionToRemove);
+  void compressSection(const std::string & _sSectionToCompress);
   void addSection(ParameterSectionData &_PSD);
   void addSections(ParameterSectionData &_PSD);
   void appendSections(ParameterSectionData &_PSD);
@@ -61,7 +62,7 @@ class XclBin {
  private:
   void updateHeaderFromSection(Section *_pSection);
   void readXclBinBinaryHeader(std::fstream& _istream);
-  void readXclBinBinarySections(std::fstream& _istream);
+  void readXclBinBinarySections(std::fstream& _istream, const std::string& _binaryFileName);
 
   void findAndReadMirrorData(std::fstream& _istream, boost::property_tree::ptree& _mirrorData) const;
   void readXclBinaryMirrorImage(std::fstream& _istream, const boost::property_tree::ptree& _mirrorData);
@@ -85,7 +86,7 @@ class XclBin {
   void readXclBinHeader(const boost::property_tree::ptree& _ptHeader, struct axlf& _axlfHeader);
   void readXclBinSection(std::fstream& _istream, const boost::property_tree::ptree& _ptSection);
   void writeXclBinBinaryHeader(std::fstream& _ostream, boost::property_tree::ptree& _mirroredData);
-  void writeXclBinBinarySections(std::fstream& _ostream, boost::property_tree::ptree& _mirroredData);
+  void writeXclBinBinarySections(std::fstream& _ostream, int _fdOut, boost::property_tree::ptree& _mirroredData);
 
 
  protected:
@@ -95,6 +96,7 @@ class XclBin {
  private:
   std::vector<Section*> m_sections;
   axlf m_xclBinHeader;
+  std::string m_sInputFile;  // Source of the deferred section payloads
 
  protected:
   SchemaVersion m_SchemaVersionMirrorWrite;
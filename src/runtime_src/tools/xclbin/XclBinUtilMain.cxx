@@ -110,6 +110,7 @@ int main_(int argc, char** argv) {
   std::vector<std::string> sectionsToRemove;
   std::vector<std::string> sectionsToDump;
   std::vector<std::string> sectionsToAppend;
+  std::vector<std::string> sectionsToCompress;
 
   std::vector<std::string> keyValuePairs;
   std::vector<std::string> keysToRemove;
@@ -132,6 +133,7 @@ int main_(int argc, char** argv) {
       ("add-section", boost::program_options::value<std::vector<std::string> >(&sectionsToAdd)->multitoken(), "Section name to add.  Format: <section>:<format>:<file>")
       ("dump-section", boost::program_options::value<std::vector<std::string> >(&sectionsToDump)->multitoken(), "Section to dump. Format: <section>:<format>:<file>")
       ("replace-section", boost::program_options::value<std::vector<std::string> >(&sectionsToReplace)->multitoken(), "Section to replace. ")
+      ("compress-section", boost::program_options::value<std::vector<std::string> >(&sectionsToCompress)->multitoken(), "Section name to store compressed in the output file.")
 
       ("key-value", boost::program_options::value<std::vector<std::string> >(&keyValuePairs)->multitoken(), "Key value pairs.  Format: [USER|SYS]:<key>:<value>")
       ("remove-key", boost::program_options::value<std::vector<std::string> >(&keysToRemove)->multitoken(), "Removes the given user key from the xclbin archive." )
@@ -390,6 +392,10 @@ int main_(int argc, char** argv) {
     }
   }
 
+  for (auto section : sectionsToCompress) {
+    xclBin.compressSection(section);
+  }
+
   for (auto section : sectionsToDump) {
     ParameterSectionData psd(section);
     if (psd.getSectionName().empty() &&
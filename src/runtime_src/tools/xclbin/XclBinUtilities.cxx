@@ -29,6 +29,12 @@
 #include <boost/uuid/uuid_io.hpp>       // for to_string
 
 #include <arpa/inet.h>
+#include <algorithm>
+#include <errno.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 namespace XUtil = XclBinUtilities;
 
@@ -559,6 +565,58 @@ XclBinUtilities::write_htonl(std::ostream & _buf, uint32_t _word32)
   _buf.write((char *) &word32, sizeof(uint32_t));
 }
 
+void
+XclBinUtilities::copyFileRange(int _fdIn, uint64_t _offsetIn, int _fdOut, uint64_t _offsetOut, uint64_t _size)
+{
+  // Let the kernel copy the data, copy_file_range can share extents on
+  // file systems that support it.  Fall back to sendfile and then to a
+  // user space copy for file systems that support neither.
+  static const size_t chunkSize = 0x100000;
+  std::unique_ptr<char[]> buf;  // User space copy, allocated on first use
+  bool bKernelCopy = true;
+  while (_size != 0) {
+    ssize_t copied = -1;
+#ifdef __NR_copy_file_range
+    if (bKernelCopy) {
+      loff_t offIn = _offsetIn;
+      loff_t offOut = _offsetOut;
+      copied = syscall(__NR_copy_file_range, _fdIn, &offIn, _fdOut, &offOut, _size, 0);
+    }
+#endif
+    if ((copied < 0) && bKernelCopy && (lseek(_fdOut, _offsetOut, SEEK_SET) != -1)) {
+      off_t offIn = _offsetIn;
+      copied = sendfile(_fdOut, _fdIn, &offIn, _size);
+    }
+    if ((copied < 0) && (errno != EINTR)) {
+      bKernelCopy = false;
+      if (!buf)
+        buf.reset(new char[chunkSize]);
+      copied = pread(_fdIn, buf.get(), std::min<uint64_t>(_size, chunkSize), _offsetIn);
+      if (copied > 0)
+        copied = pwrite(_fdOut, buf.get(), copied, _offsetOut);
+    }
+    if ((copied < 0) && (errno == EINTR))
+      continue;
+    if (copied == 0) {
+      std::string errMsg = XUtil::format("ERROR: Unexpected end of file, 0x%lx bytes from offset 0x%lx not copied", _size, _offsetIn);
+      throw std::runtime_error(errMsg);
+    }
+    if (copied < 0) {
+      std::string errMsg = XUtil::format("ERROR: Unable to copy 0x%lx bytes from offset 0x%lx: %s", _size, _offsetIn, strerror(errno));
+      throw std::runtime_error(errMsg);
+    }
+    _offsetIn += copied;
+    _offsetOut += copied;
+    _size -= copied;
+  }
+}
 
+bool
+XclBinUtilities::isSameFile(const std::string& _sFile1, const std::string& _sFile2)
+{
+  struct stat st1, st2;
+  if ((stat(_sFile1.c_str(), &st1) != 0) || (stat(_sFile2.c_str(), &st2) != 0))
+    return false;
 
-
+  return (st1.st_dev == st2.st_dev) && (st1.st_ino == st2.st_ino);
+}
@@ -71,6 +71,9 @@ void printKinds();
 std::string getUUIDAsString( const unsigned char (&_uuid)[16] );
 
 void write_htonl(std::ostream & _buf, uint32_t _word32);
+
+void copyFileRange(int _fdIn, uint64_t _offsetIn, int _fdOut, uint64_t _offsetOut, uint64_t _size);
+bool isSameFile(const std::string& _sFile1, const std::string& _sFile2);
 };
 
 #endif
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "driver/common/xclbin_compress.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+static std::vector<char> createPayload(size_t _size) {
+  // Runs of zeros with random data in between, similar to a bitstream
+  std::vector<char> payload(_size);
+  srand(0);
+  for (size_t index = 0; index < _size; ++index) {
+    payload[index] = ((index % 4096) < 3000) ? 0 : (char) rand();
+  }
+  return payload;
+}
+
+TEST(CompressSection, RoundTrip) {
+   std::vector<char> payload = createPayload(3 * 0x100000 + 123);
+
+   std::vector<char> compressed = xrt_core::xclbin::compress_section(payload.data(), payload.size());
+   ASSERT_LT(compressed.size(), payload.size()) << "Section payload did not compress.";
+
+   uint64_t size = xrt_core::xclbin::get_uncompressed_size(compressed.data(), compressed.size());
+   ASSERT_EQ(size, payload.size());
+
+   std::vector<char> expanded(size);
+   xrt_core::xclbin::decompress_section(compressed.data(), compressed.size(), expanded.data(), expanded.size());
+   ASSERT_EQ(expanded, payload) << "Expanded section does not match the original payload.";
+}
+
+TEST(CompressSection, Incompressible) {
+   std::vector<char> payload(100000);
+   srand(1);
+   for (auto & byte : payload) {
+     byte = (char) rand();
+   }
+
+   // Chunks that don't compress are stored as is
+   std::vector<char> compressed = xrt_core::xclbin::compress_section(payload.data(), payload.size(), 0x4000);
+   ASSERT_LE(compressed.size(), payload.size() + sizeof(axlf_compressed_section) + 4 * 7);
+
+   std::vector<char> expanded(payload.size());
+   xrt_core::xclbin::decompress_section(compressed.data(), compressed.size(), expanded.data(), expanded.size());
+   ASSERT_EQ(expanded, payload);
+}
+
+TEST(CompressSection, DetectCorruption) {
+   std::vector<char> payload = createPayload(0x100000);
+   std::vector<char> compressed = xrt_core::xclbin::compress_section(payload.data(), payload.size());
+
+   compressed[compressed.size() / 2] ^= 0x5a;
+
+   std::vector<char> expanded(payload.size());
+   ASSERT_THROW(xrt_core::xclbin::decompress_section(compressed.data(), compressed.size(), expanded.data(), expanded.size()), std::runtime_error);
+}
+
+// Builds an xclbin with one section holding @_data
+static std::vector<char> createXclBin(const std::vector<char> & _data, uint32_t _flags) {
+   std::vector<char> xclbin(sizeof(axlf) + _data.size());
+   axlf * top = reinterpret_cast<axlf *>(xclbin.data());
+   memcpy(top->m_magic, "xclbin2", 8);
+   top->m_header.m_length = xclbin.size();
+   top->m_header.m_numSections = 1;
+   top->m_sections[0].m_sectionKind = BITSTREAM;
+   top->m_sections[0].m_sectionFlags = _flags;
+   top->m_sections[0].m_sectionOffset = sizeof(axlf);
+   top->m_sections[0].m_sectionSize = _data.size();
+   memcpy(xclbin.data() + sizeof(axlf), _data.data(), _data.size());
+   return xclbin;
+}
+
+TEST(CompressSection, LegacyPadding) {
+   // Older tools left garbage in what is now m_sectionFlags
+   std::vector<char> payload = createPayload(0x10000);
+   std::vector<char> xclbin = createXclBin(payload, 0xdeadbeef);
+   const axlf * top = reinterpret_cast<const axlf *>(xclbin.data());
+   ASSERT_FALSE(xrt_core::xclbin::is_compressed(top)) << "Section without compressed magic reported as compressed.";
+
+   std::vector<char> expanded;
+   ASSERT_EQ(xrt_core::xclbin::expand(top, expanded), top);
+   ASSERT_TRUE(expanded.empty());
+}
+
+TEST(CompressSection, ExpandXclBin) {
+   std::vector<char> payload = createPayload(0x100000 + 7);
+   std::vector<char> compressed = xrt_core::xclbin::compress_section(payload.data(), payload.size());
+   std::vector<char> xclbin = createXclBin(compressed, AXLF_SECTION_COMPRESSED);
+   const axlf * top = reinterpret_cast<const axlf *>(xclbin.data());
+   ASSERT_TRUE(xrt_core::xclbin::is_compressed(top));
+
+   std::vector<char> expanded;
+   const axlf * out = xrt_core::xclbin::expand(top, expanded);
+   ASSERT_EQ(out, reinterpret_cast<const axlf *>(expanded.data()));
+   ASSERT_EQ(out->m_sections[0].m_sectionFlags & AXLF_SECTION_COMPRESSED, 0u);
+   ASSERT_EQ(out->m_sections[0].m_sectionSize, payload.size());
+   const char * data = expanded.data() + out->m_sections[0].m_sectionOffset;
+   ASSERT_TRUE(std::equal(payload.begin(), payload.end(), data)) << "Expanded section does not match the original payload.";
+}
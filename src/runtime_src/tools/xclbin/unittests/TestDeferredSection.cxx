@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "ParameterSectionData.h"
+#include "XclBin.h"
+#include "XclBinUtilities.h"
+namespace XUtil = XclBinUtilities;
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+
+static std::string tempFileName(const std::string & _sName) {
+  return "/tmp/xclbintest_" + std::to_string(getpid()) + "_" + _sName;
+}
+
+static std::vector<char> createPayload(size_t _size) {
+  std::vector<char> payload(_size);
+  srand(0);
+  for (auto & byte : payload) {
+    byte = (char) rand();
+  }
+  return payload;
+}
+
+static void writeFile(const std::string & _sFileName, const std::vector<char> & _data) {
+  std::ofstream ofs(_sFileName, std::ofstream::binary);
+  ofs.write(_data.data(), _data.size());
+}
+
+static std::vector<char> readFile(const std::string & _sFileName) {
+  std::ifstream ifs(_sFileName, std::ifstream::binary);
+  return std::vector<char>((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+}
+
+TEST(DeferredSection, CopyFileRange) {
+   // Larger than the user space copy buffer, odd offsets and size
+   std::vector<char> payload = createPayload(3 * 0x100000 + 123);
+   const std::string sIn = tempFileName("range_in");
+   const std::string sOut = tempFileName("range_out");
+   writeFile(sIn, payload);
+
+   int fdIn = open(sIn.c_str(), O_RDONLY);
+   int fdOut = open(sOut.c_str(), O_CREAT | O_TRUNC | O_WRONLY, 0600);
+   ASSERT_GE(fdIn, 0);
+   ASSERT_GE(fdOut, 0);
+   XUtil::copyFileRange(fdIn, 17, fdOut, 4096, payload.size() - 17);
+
+   // Copy past the end of the input file
+   ASSERT_THROW(XUtil::copyFileRange(fdIn, payload.size() - 10, fdOut, 0, 20), std::runtime_error);
+   close(fdIn);
+   close(fdOut);
+
+   std::vector<char> copy = readFile(sOut);
+   ASSERT_EQ(copy.size(), 4096 + payload.size() - 17);
+   ASSERT_TRUE(std::equal(payload.begin() + 17, payload.end(), copy.begin() + 4096)) << "Copied range does not match the input file.";
+
+   unlink(sIn.c_str());
+   unlink(sOut.c_str());
+}
+
+TEST(DeferredSection, CopyUnchangedSection) {
+   std::vector<char> payload = createPayload(2 * 0x100000 + 5);
+   const std::string sPayload = tempFileName("payload");
+   const std::string sXclBin1 = tempFileName("1.xclbin");
+   const std::string sXclBin2 = tempFileName("2.xclbin");
+   const std::string sDump = tempFileName("dump");
+   writeFile(sPayload, payload);
+
+   enum axlf_section_kind eKind;
+   Section::translateSectionKindStrToKind("BITSTREAM", eKind);
+
+   {
+     XclBin xclBin;
+     ParameterSectionData psd("BITSTREAM:RAW:" + sPayload);
+     xclBin.addSection(psd);
+     xclBin.writeXclBinBinary(sXclBin1, true /* bSkipUUIDInsertion */);
+   }
+
+   // Sections read from an xclbin stay in the file and are copied file
+   // to file when written
+   {
+     XclBin xclBin;
+     xclBin.readXclBinBinary(sXclBin1, false /* bMigrateForward */);
+     const Section * pSection = xclBin.findSection(eKind);
+     ASSERT_NE(pSection, nullptr) << "Section 'BITSTREAM' not found.";
+     ASSERT_TRUE(pSection->isPayloadDeferred()) << "Section payload was read from the file.";
+     xclBin.writeXclBinBinary(sXclBin2, true /* bSkipUUIDInsertion */);
+     ASSERT_TRUE(pSection->isPayloadDeferred()) << "Section payload was read when copied.";
+   }
+
+   {
+     XclBin xclBin;
+     xclBin.readXclBinBinary(sXclBin2, false /* bMigrateForward */);
+     const Section * pSection = xclBin.findSection(eKind);
+     ASSERT_NE(pSection, nullptr) << "Section 'BITSTREAM' not copied.";
+     std::fstream oDump(sDump, std::ios::out | std::ios::binary);
+     pSection->dumpContents(oDump, Section::FT_RAW);
+   }
+   ASSERT_EQ(readFile(sDump), payload) << "Copied section does not match the original payload.";
+
+   unlink(sPayload.c_str());
+   unlink(sXclBin1.c_str());
+   unlink(sXclBin2.c_str());
+   unlink(sDump.c_str());
+}
@@ -17,12 +17,38 @@
 #include "binary.h"
 
 #include "driver/include/xclbin.h"
+#include "driver/common/xclbin_compress.h"
 
 #include <algorithm>
 #include <iostream>
 
 namespace xclbin {
 
+// Sections stored compressed are expanded up front so that the rest
+// of xrt, including the driver, sees one contiguous plain xclbin.  The
+// compressed image is released as soon as it has been expanded.
+static std::vector<char>
+expand(std::vector<char>&& in)
+{
+  auto xb = std::move(in);
+  if (xb.size() < sizeof(axlf))
+    throw error("bad axlf file");
+
+  auto top = reinterpret_cast<const axlf*>(xb.data());
+  if (xb.size() < top->m_header.m_length)
+    throw error ("axlf length mismatch");
+
+  if (!xrt_core::xclbin::is_compressed(top))
+    return xb;
+
+  try {
+    return xrt_core::xclbin::decompress(top);
+  }
+  catch (const std::exception& ex) {
+    throw error(ex.what());
+  }
+}
+
 /**
  * class xclbin2 (axlf)
  *
@@ -38,7 +64,7 @@ struct xclbin2 : public binary::impl
 
   explicit
   xclbin2(std::vector<char>&& xb)
-    : m_xclbin(std::move(xb)), m_raw(&m_xclbin[0])
+    : m_xclbin(expand(std::move(xb))), m_raw(&m_xclbin[0])
     , m_axlf(reinterpret_cast<const axlf*>(m_raw))
     , m_header(&m_axlf->m_header)
   {
@@ -71,28 +71,14 @@ event_commandstatus_to_string(cl_int status)
   return tbl[status];
 }
 
-//Iterate all events and find all events that aEvent depends on, returns a vector
-//Note that, this function calls try_get_chain() which locks the event object
-//So any functions called while iterating on the chain should not lock the event
-//Also, note that app_debug_track->for_each locks the tracker data structure,
-//so the lambda cannot call any functions that would inturn try to lock tracker
+//Find all events that aEvent depends on, returns a vector
+//The tracker records dependencies as events are chained, so this only
+//looks up aEvent instead of walking the chain of every live event.
+//Note that, this function try locks the tracker data structure
 std::vector<xocl::event*> event_chain_to_dependencies (xocl::event* aEvent) {
   std::vector<xocl::event*> dependencies;
-
-  auto findDependencies = [aEvent, &dependencies] (cl_event aEv) {
-    xocl::event * e =  xocl::xocl(aEv);
-    //consider all events, including user events that are not in any command queue
-      xocl::range_lock<xocl::event::event_iterator_type>&& aRange = e->try_get_chain();
-      for (auto it = aRange.begin(); it!=aRange.end(); ++it) {
-        if (*it == aEvent) {
-          //Add ev to the aEvent dependent list
-          dependencies.push_back(e);
-          break;
-        }
-      }
-  };
-
-  appdebug::app_debug_track<cl_event>::getInstance()->for_each(findDependencies);
+  for (auto ev : appdebug::app_debug_track<cl_event>::getInstance()->try_get_dependencies(aEvent))
+    dependencies.push_back(xocl::xocl(ev));
   return dependencies;
 }
 
@@ -636,6 +622,7 @@ void register_xocl_appdebug_callbacks() {
   /* event */
   xocl::event::register_constructor_callbacks(appdebug::add_event);
   xocl::event::register_destructor_callbacks(appdebug::remove_event);
+  xocl::event::register_chain_callbacks(appdebug::chain_event);
   /* command queue */
   xocl::command_queue::register_constructor_callbacks(appdebug::add_command_queue);
   xocl::command_queue::register_destructor_callbacks(appdebug::remove_command_queue);
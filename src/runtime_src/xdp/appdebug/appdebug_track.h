@@ -27,14 +27,51 @@
 #include <utility>
 #include <string>
 #include <algorithm>
-#include <set>
-#include <map>
+#include <array>
+#include <unordered_set>
+#include <unordered_map>
+#include <vector>
 #include <mutex>
+#include <functional>
+#include <cstdint>
 
 namespace appdebug {
 void cb_scheduler_cmd_start (const xrt::command*,const xocl::execution_context*);
 void cb_scheduler_cmd_done (const xrt::command*,const xocl::execution_context*);
 
+//Objects are spread over shards by address, each shard with its own lock,
+//so that threads creating and releasing objects rarely contend and adding
+//or removing an object is constant time
+template <typename Container>
+class app_debug_shards {
+public:
+  static const size_t nshards = 16;
+  struct shard {
+    std::mutex m_mutex;
+    Container m_objs;
+  };
+
+  template <typename T>
+  shard& get (T aObj) {
+    auto addr = reinterpret_cast<uintptr_t>(aObj);
+    return m_shards[((addr >> 4) ^ (addr >> 12)) % m_shards.size()];
+  }
+
+  //Locks all the shards without suspending, throws if any of them is taken
+  std::vector<std::unique_lock<std::mutex>> try_lock_all () {
+    std::vector<std::unique_lock<std::mutex>> locks;
+    locks.reserve(m_shards.size());
+    for (auto& s : m_shards) {
+      locks.emplace_back(s.m_mutex, std::try_to_lock);
+      if (!locks.back().owns_lock())
+        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
+    }
+    return locks;
+  }
+
+  std::array<shard, nshards> m_shards;
+};
+
 template <typename T>
 class app_debug_track {
 public:
@@ -50,24 +87,27 @@ public:
   //these can suspend to get access to the data structure
   void add_object (T aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
-      m_objs.insert(aObj);
+      auto& s = m_objs.get(aObj);
+      std::lock_guard<std::mutex> lk (s.m_mutex);
+      s.m_objs.insert(aObj);
     }
   }
   void remove_object (T aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
-      m_objs.erase(aObj);
+      auto& s = m_objs.get(aObj);
+      std::lock_guard<std::mutex> lk (s.m_mutex);
+      s.m_objs.erase(aObj);
     }
   }
 
   //Following 2 function called during debug by user, this should never suspend
   void validate_object (T aObj) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
+      auto& s = m_objs.get(aObj);
+      std::unique_lock<std::mutex> lk(s.m_mutex, std::defer_lock);
       if (!lk.try_lock())
         throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      if (m_objs.find(aObj) == m_objs.end() )
+      if (s.m_objs.find(aObj) == s.m_objs.end() )
         throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
     }
     else {
@@ -77,10 +117,9 @@ public:
 
   void for_each(std::function<void(T aObj)>&& fn) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-      if (!lk.try_lock())
-        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      std::for_each(m_objs.begin(), m_objs.end(), fn);
+      auto locks = m_objs.try_lock_all();
+      for (auto& s : m_objs.m_shards)
+        std::for_each(s.m_objs.begin(), s.m_objs.end(), fn);
     }
     else {
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Invalid object tracker");
@@ -91,8 +130,7 @@ public:
   //disallow access to the data structure after the object is deleted
   static bool m_set;
 private:
-  std::set <T> m_objs;
-  std::mutex m_mutex;
+  app_debug_shards<std::unordered_set<T>> m_objs;
 };
 
 template <>
@@ -101,6 +139,8 @@ public:
   struct event_data_t {
     bool m_start;
     uint32_t m_ncomplete;
+    //Events that this event waits on, maintained as events are chained
+    std::vector<cl_event> m_dependencies;
   };
   static app_debug_track* getInstance() {
     static app_debug_track singleton;
@@ -118,14 +158,38 @@ public:
   //these can suspend to get access to the data structure
   void add_object (cl_event aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
-      m_objs.insert(std::pair<cl_event, event_data_t>(aObj, event_data_t()));
+      auto& s = m_objs.get(aObj);
+      std::lock_guard<std::mutex> lk (s.m_mutex);
+      s.m_objs.insert(std::pair<cl_event, event_data_t>(aObj, event_data_t()));
     }
   }
   void remove_object (cl_event aObj) {
     if (m_set) {
-      std::lock_guard<std::mutex> lk (m_mutex);
-      m_objs.erase(aObj);
+      auto& s = m_objs.get(aObj);
+      std::lock_guard<std::mutex> lk (s.m_mutex);
+      s.m_objs.erase(aObj);
+    }
+  }
+
+  //Record that aObj waits on aDep, called when aObj is chained to aDep
+  void add_dependency (cl_event aObj, cl_event aDep) {
+    if (m_set) {
+      auto& s = m_objs.get(aObj);
+      std::lock_guard<std::mutex> lk (s.m_mutex);
+      auto it = s.m_objs.find(aObj);
+      if (it != s.m_objs.end())
+        it->second.m_dependencies.push_back(aDep);
+    }
+  }
+  void remove_dependency (cl_event aObj, cl_event aDep) {
+    if (m_set) {
+      auto& s = m_objs.get(aObj);
+      std::lock_guard<std::mutex> lk (s.m_mutex);
+      auto it = s.m_objs.find(aObj);
+      if (it != s.m_objs.end()) {
+        auto& deps = it->second.m_dependencies;
+        deps.erase(std::remove(deps.begin(), deps.end(), aDep), deps.end());
+      }
     }
   }
 
@@ -134,19 +198,22 @@ public:
     if (!m_set)
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Appdebug singleton is deleted");
 
-    std::lock_guard<std::mutex> lk (m_mutex);
-    if (m_objs.find(aObj) == m_objs.end() )
+    auto& s = m_objs.get(aObj);
+    std::lock_guard<std::mutex> lk (s.m_mutex);
+    auto it = s.m_objs.find(aObj);
+    if (it == s.m_objs.end() )
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
-    return m_objs[aObj];
+    return it->second;
   }
 
   //Following 2 function called during debug by user, this should never suspend
   void validate_object (cl_event aObj) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
+      auto& s = m_objs.get(aObj);
+      std::unique_lock<std::mutex> lk(s.m_mutex, std::defer_lock);
       if (!lk.try_lock())
         throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      if (m_objs.find(aObj) == m_objs.end() )
+      if (s.m_objs.find(aObj) == s.m_objs.end() )
         throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
     }
     else {
@@ -156,12 +223,11 @@ public:
 
   void for_each(std::function<void(cl_event aObj)>&& fn) {
     if (m_set) {
-      std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
-      if (!lk.try_lock())
-        throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-      //std::for_each(m_objs.begin(), m_objs.end(), fn);
-      for (auto it = m_objs.begin(); it!=m_objs.end(); ++it) {
-        fn(it->first);
+      auto locks = m_objs.try_lock_all();
+      for (auto& s : m_objs.m_shards) {
+        for (auto it = s.m_objs.begin(); it!=s.m_objs.end(); ++it) {
+          fn(it->first);
+        }
       }
     }
     else {
@@ -173,12 +239,27 @@ public:
     if (!m_set)
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Appdebug singleton is deleted");
 
-    std::unique_lock<std::mutex> lk(m_mutex, std::defer_lock);
+    auto& s = m_objs.get(aObj);
+    std::unique_lock<std::mutex> lk(s.m_mutex, std::defer_lock);
     if (!lk.try_lock())
       throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
-    if (m_objs.find(aObj) == m_objs.end() )
+    auto it = s.m_objs.find(aObj);
+    if (it == s.m_objs.end() )
       throw xocl::error(DBG_EXCEPT_INVALID_OBJECT, "Unknown OpenCL object");
-    return m_objs[aObj];
+    return it->second;
+  }
+
+  //Returns the live events that aObj waits on, this should never suspend
+  std::vector<cl_event> try_get_dependencies (const cl_event aObj) {
+    std::vector<cl_event> deps = try_get_data(aObj).m_dependencies;
+    deps.erase(std::remove_if(deps.begin(), deps.end(), [this](cl_event aDep) {
+          auto& s = m_objs.get(aDep);
+          std::unique_lock<std::mutex> lk(s.m_mutex, std::defer_lock);
+          if (!lk.try_lock())
+            throw xocl::error(DBG_EXCEPT_LOCK_FAILED, "Failed to secure lock on data structure");
+          return s.m_objs.find(aDep) == s.m_objs.end();
+        }), deps.end());
+    return deps;
   }
 
   //When the program exits, the static singleton object could get deleted
@@ -186,8 +267,7 @@ public:
   //disallow access to the data structure after the object is deleted
   static bool m_set;
 private:
-  std::map<cl_event, event_data_t> m_objs;
-  std::mutex m_mutex;
+  app_debug_shards<std::unordered_map<cl_event, event_data_t>> m_objs;
 };
 ////////////////////////Command queue////////////////////
 inline
@@ -234,6 +314,21 @@ void remove_event (xocl::event* aEv) {
     //std::cout << "Removing event xocl " << std::hex << aEv << " cl " << clEv << std::endl;
     //app_debug_track<cl_event>::getInstance()->remove_object(static_cast<cl_event>(aEv));
     app_debug_track<cl_event>::getInstance()->remove_object(clEv);
+    //Events chained to this one no longer depend on it
+    try {
+      auto&& aRange = aEv->try_get_chain();
+      for (auto it = aRange.begin(); it!=aRange.end(); ++it)
+        app_debug_track<cl_event>::getInstance()->remove_dependency(*it, clEv);
+    }
+    catch (const xocl::error&) {
+      //Stale dependencies are filtered out by try_get_dependencies
+    }
+  }
+}
+inline
+void chain_event (xocl::event* aDep, xocl::event* aEv) {
+  if (xrt::config::get_app_debug()) {
+    app_debug_track<cl_event>::getInstance()->add_dependency(aEv, aDep);
   }
 }
 inline
@@ -393,6 +393,11 @@ namespace xdp {
     mLogger->logDependency(objKind, eventString, dependString);
   }
 
+  void RTProfile::logDevicePhase(const std::string& deviceName, const char* phase, bool start)
+  {
+    mLogger->logDevicePhase(deviceName, phase, start);
+  }
+
   void RTProfile::logDeviceTrace(std::string deviceName, std::string binaryName, xclPerfMonType type,
       xclTraceResultsVector& traceVector)
   {
@@ -141,6 +141,9 @@ namespace xdp {
     void logDependency(RTUtil::e_profile_command_kind objKind,
        const std::string eventString, const std::string dependString);
 
+    // Log start or end of a host side device phase (e.g., program load steps)
+    void logDevicePhase(const std::string& deviceName, const char* phase, bool start);
+
     // Log device trace
     void logDeviceTrace(std::string deviceName, std::string binaryName, xclPerfMonType type,
         xclTraceResultsVector& traceVector);
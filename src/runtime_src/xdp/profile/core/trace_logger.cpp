@@ -492,6 +492,15 @@ namespace xdp {
     writeTimelineTrace(traceTime, commandString, "", eventString, dependString);
   }
 
+  void TraceLogger::logDevicePhase(const std::string& deviceName, const char* phase, bool start)
+  {
+    std::string commandString = "DEVICE_PHASE|" + deviceName + "|" + phase;
+    std::lock_guard < std::mutex > lock(mLogMutex);
+
+    double traceTime = mPluginHandle->getTraceTime();
+    writeTimelineTrace(traceTime, commandString, start ? "START" : "END", "", "", 0, 0);
+  }
+
   // ***************************************************************************
   // Log device trace
   // ***************************************************************************
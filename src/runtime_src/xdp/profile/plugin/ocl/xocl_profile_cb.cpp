@@ -566,6 +566,15 @@ void cb_log_dependencies(xocl::event* event,  cl_uint num_deps, const cl_event*
   }
 }
 
+void cb_log_device_phase(const std::string& device_name, const char* phase, bool start)
+{
+  if (!xrt::config::get_timeline_trace()) {
+    return;
+  }
+
+  OCLProfiler::Instance()->getProfileManager()->logDevicePhase(device_name, phase, start);
+}
+
 void cb_add_to_active_devices(const std::string& device_name)
 {
   auto profiler = OCLProfiler::Instance();
@@ -631,6 +640,7 @@ void register_xocl_profile_callbacks() {
   xocl::profile::register_cb_log_function_start(cb_log_function_start);
   xocl::profile::register_cb_log_function_end(cb_log_function_end);
   xocl::profile::register_cb_log_dependencies(cb_log_dependencies);
+  xocl::profile::register_cb_log_device_phase(cb_log_device_phase);
   xocl::profile::register_cb_add_to_active_devices(cb_add_to_active_devices);
   xocl::profile::register_cb_set_kernel_clock_freq(cb_set_kernel_clock_freq);
   xocl::profile::register_cb_reset(cb_reset);
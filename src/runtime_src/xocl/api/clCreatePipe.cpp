@@ -106,6 +106,7 @@ clCreatePipe(cl_context                context,
   int status = posix_memalign(&user_ptr, 128, (sizeof(cpu_pipe_t)+nbytes));
   if (status)
     throw xocl::error(CL_MEM_OBJECT_ALLOCATION_FAILURE);
+  cpu_pipe_init(user_ptr,upipe->get_pipe_packet_size(),nbytes);
   upipe->set_pipe_host_ptr(user_ptr);
 
   xocl::assign(errcode_ret,CL_SUCCESS);
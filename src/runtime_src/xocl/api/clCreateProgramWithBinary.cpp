@@ -29,9 +29,13 @@
 #include "detail/context.h"
 #include "detail/device.h"
 
+#include "xrt/util/thread.h"
+
 #include <exception>
 #include <string>
 #include <algorithm>
+#include <vector>
+#include <thread>
 
 #include "plugin/xdp/profile.h"
 
@@ -43,6 +47,77 @@ loadProgramBinary(xocl::program* program, xocl::device* device)
   device->load_program(program);
 }
 
+// Load the program on all devices concurrently.  The per device load
+// is serialized by the device itself, so each device is loaded on its
+// own thread.  All loads run to completion, errors are reported per
+// device in binary_status, and the first error is rethrown.
+static void
+loadProgramBinaries(xocl::program* program, cl_uint num_devices,
+                    const cl_device_id* device_list, cl_int* binary_status)
+{
+  std::vector<std::exception_ptr> errors(num_devices);
+
+  if (num_devices == 1) {
+    try {
+      loadProgramBinary(program,xocl::xocl(device_list[0]));
+    }
+    catch (...) {
+      errors[0] = std::current_exception();
+    }
+  }
+  else {
+    std::vector<std::thread> loaders;
+    loaders.reserve(num_devices);
+    for (cl_uint idx=0; idx<num_devices; ++idx) {
+      loaders.emplace_back
+        (xrt::thread([program,device_list,idx,&errors] {
+          try {
+            loadProgramBinary(program,xocl::xocl(device_list[idx]));
+          }
+          catch (...) {
+            errors[idx] = std::current_exception();
+          }
+        }));
+    }
+    for (auto& loader : loaders)
+      loader.join();
+  }
+
+  std::exception_ptr first_error;
+  for (cl_uint idx=0; idx<num_devices; ++idx) {
+    auto& error = errors[idx];
+    if (!error) {
+      if (binary_status)
+        binary_status[idx] = CL_SUCCESS;
+      continue;
+    }
+
+    if (binary_status)
+      binary_status[idx] = CL_INVALID_BINARY;
+
+    std::string msg;
+    try {
+      std::rethrow_exception(error);
+    }
+    catch (const std::exception& ex) {
+      msg = ex.what();
+    }
+    catch (...) {
+      msg = "unknown error";
+    }
+
+    if (num_devices > 1)
+      xocl::send_exception_message
+        (("device '" + xocl::xocl(device_list[idx])->get_unique_name() + "': " + msg).c_str());
+
+    if (!first_error)
+      first_error = error;
+  }
+
+  if (first_error)
+    std::rethrow_exception(first_error);
+}
+
 } //namespace
 
 namespace xocl {
@@ -126,17 +201,7 @@ clCreateProgramWithBinary(cl_context                      context ,
   auto program = std::make_unique<xocl::program>(xocl::xocl(context),num_devices,device_list,binaries,lengths);
 
   // Assign binaries to all devices in the list
-  size_t idx = 0;
-  for (auto device : xocl::get_range(device_list,device_list+num_devices)) {
-    try {
-      loadProgramBinary(program.get(),xocl(device));
-      xocl::assign(&binary_status[idx++],CL_SUCCESS);
-    }
-    catch (const xocl::error& ex) {
-      xocl::assign(&binary_status[idx],CL_INVALID_BINARY);
-      throw;
-    }
-  }
+  loadProgramBinaries(program.get(),num_devices,device_list,binary_status);
 
   xocl::profile::start_device_profiling(1);
   // NOTE: We read from the counters to set a baseline for values and
@@ -23,6 +23,7 @@
 #include "detail/validate.h"
 
 #include "enqueue.h"
+#include "printf/rt_printf.h"
 #include <iostream>
 #include "plugin/xdp/appdebug.h"
 #include "plugin/xdp/profile.h"
@@ -64,6 +65,7 @@ clEnqueueMapBuffer(cl_command_queue command_queue,
                    cl_event *       event_parameter,
                    cl_int *         errcode_ret)
 {
+  detail::command_queue::validBlockingOrError(command_queue,blocking_map);
   validOrError(command_queue,buffer,map_flags,offset,size,num_events_in_wait_list,event_wait_list);
 
   auto uevent = create_hard_event(command_queue,CL_COMMAND_MAP_BUFFER,num_events_in_wait_list,event_wait_list);
@@ -74,8 +76,10 @@ clEnqueueMapBuffer(cl_command_queue command_queue,
   xocl::appdebug::set_event_action(uevent.get(),xocl::appdebug::action_map,buffer,map_flags);
 
   uevent->queue();
-  if (blocking_map)
+  if (blocking_map) {
     uevent->wait();
+    XCL::Printf::flushBuffers();
+  }
 
   xocl::assign(event_parameter,uevent.get());
   xocl::assign(errcode_ret,CL_SUCCESS);
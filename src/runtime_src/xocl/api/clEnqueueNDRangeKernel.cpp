@@ -476,6 +476,7 @@ clEnqueueNDRangeKernel(cl_command_queue command_queue,
 namespace {
 
 struct CallbackArgs {
+  unsigned int ticket = 0;
   xocl::ptr<xocl::kernel> kernel;
   xocl::ptr<xocl::memory> mem;
   std::vector<uint8_t> buf;
@@ -495,15 +496,16 @@ void CL_CALLBACK cb_BufferReturned(cl_event event, cl_int status, void *data)
 {
   CallbackArgs *args = reinterpret_cast<CallbackArgs*>(data);
   cl_kernel kernel = args->kernel.get();
-  XCL::Printf::PrintfManager printfManager;
-  printfManager.enqueueBuffer(kernel, args->buf);
-  delete args;
   if ( XCL::Printf::isPrintfDebugMode() ) {
     std::cout << "clEnqueueNDRangeKernel - printf buffer returned callback\n";
-    printfManager.dbgDump();
   }
-  printfManager.print();
-  printfManager.clear();
+  // Decoding is deferred to the printf decoder thread, the buffer
+  // is moved so no copy is made here
+  if (status == CL_COMPLETE)
+    XCL::Printf::postBuffer(args->ticket, kernel, std::move(args->buf));
+  else
+    XCL::Printf::cancelBuffer(args->ticket);
+  delete args;
 
   xocl::api::clReleaseEvent(event);
 }
@@ -574,18 +576,26 @@ cl_int enqueueReadPrintfBuffer(cl_kernel kernel, cl_command_queue queue,
     args->mem = xocl::xocl(mem);
     args->buf.resize(bufSize);
     uint8_t *hostBuf = &args->buf[0];
-    err = xocl::api::clEnqueueReadBuffer
-      (queue, mem,
-       /*blocking_read*/CL_FALSE,
-       /*offset*/0, bufSize, hostBuf,
-       /*num_events_in_wait_list*/1, /*event_wait_list*/&waitEvent,
-       /*return event*/&event);
-    if (err != CL_SUCCESS)
-      throw xocl::error(err,"enqueueReadPrintfBuffer");
-    err = xocl::api::clSetEventCallback(event, CL_COMPLETE, cb_BufferReturned, args.get());
-    if (err == CL_SUCCESS) {
-      args.release();
+    args->ticket = XCL::Printf::reserveBuffer(waitEvent);
+    try {
+      err = xocl::api::clEnqueueReadBuffer
+        (queue, mem,
+         /*blocking_read*/CL_FALSE,
+         /*offset*/0, bufSize, hostBuf,
+         /*num_events_in_wait_list*/1, /*event_wait_list*/&waitEvent,
+         /*return event*/&event);
+      if (err != CL_SUCCESS)
+        throw xocl::error(err,"enqueueReadPrintfBuffer");
+      err = xocl::api::clSetEventCallback(event, CL_COMPLETE, cb_BufferReturned, args.get());
+    }
+    catch (...) {
+      XCL::Printf::cancelBuffer(args->ticket);
+      throw;
     }
+    if (err == CL_SUCCESS)
+      args.release();
+    else
+      XCL::Printf::cancelBuffer(args->ticket);
   }
   return err;
 }
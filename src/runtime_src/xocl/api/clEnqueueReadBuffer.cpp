@@ -27,6 +27,7 @@
 #include "detail/memory.h"
 #include "detail/event.h"
 #include "detail/context.h"
+#include "printf/rt_printf.h"
 #include "plugin/xdp/appdebug.h"
 #include "plugin/xdp/profile.h"
 
@@ -43,6 +44,9 @@ validOrError(cl_command_queue   command_queue,
              const cl_event *   event_wait_list , 
              cl_event *         event_parameter)
 {
+  // Not an api check, a recorded command cannot be waited on
+  detail::command_queue::validBlockingOrError(command_queue,blocking);
+
   if (!config::api_checks())
     return;
 
@@ -105,8 +109,10 @@ clEnqueueReadBuffer(cl_command_queue   command_queue,
   xocl::appdebug::set_event_action(uevent.get(),xocl::appdebug::action_readwrite,buffer,offset,size,ptr);
  
   uevent->queue();
-  if (blocking)
+  if (blocking) {
     uevent->wait();
+    XCL::Printf::flushBuffers();
+  }
 
   xocl::assign(event_parameter,uevent.get());
   return CL_SUCCESS;
@@ -72,6 +72,7 @@ clEnqueueSVMMap(cl_command_queue command_queue,
                 const cl_event * event_wait_list,
                 cl_event       * event)
 {
+  detail::command_queue::validBlockingOrError(command_queue,blocking_map);
   validOrError(command_queue,map_flags,svm_ptr,size,num_events_in_wait_list,event_wait_list);
 
   auto uevent = create_hard_event(command_queue,CL_COMMAND_SVM_MAP,num_events_in_wait_list,event_wait_list);
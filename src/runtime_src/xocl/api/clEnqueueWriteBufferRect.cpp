@@ -47,6 +47,9 @@ validOrError(cl_command_queue     command_queue ,
              const cl_event *     event_wait_list ,
              cl_event *           event )
 {
+  // Not an api check, a recorded command cannot be waited on
+  detail::command_queue::validBlockingOrError(command_queue,blocking);
+
   if (!config::api_checks())
     return;
 
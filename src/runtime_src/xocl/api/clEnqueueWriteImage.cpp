@@ -21,6 +21,7 @@
 #include "xocl/core/memory.h"
 #include "xocl/core/event.h"
 
+#include "detail/command_queue.h"
 #include "detail/memory.h"
 #include "detail/event.h"
 
@@ -43,6 +44,9 @@ validOrError(cl_command_queue      command_queue,
              const cl_event *      event_wait_list,
              cl_event *            event)
 {
+  // Not an api check, a recorded command cannot be waited on
+  detail::command_queue::validBlockingOrError(command_queue,blocking_write);
+
   if (!config::api_checks())
     return;
 
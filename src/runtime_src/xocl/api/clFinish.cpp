@@ -19,6 +19,7 @@
 #include "xocl/core/object.h"
 #include "xocl/core/command_queue.h"
 #include "detail/command_queue.h"
+#include "printf/rt_printf.h"
 
 #include <iostream>
 
@@ -40,6 +41,9 @@ clFinish(cl_command_queue command_queue)
 {
   validOrError(command_queue);
   xocl(command_queue)->wait();
+  // Kernel printf output is decoded asynchronously, make sure
+  // it is visible before returning to host code
+  XCL::Printf::flushBuffers();
   return CL_SUCCESS;
 }
 
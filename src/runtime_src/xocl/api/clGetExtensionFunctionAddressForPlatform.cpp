@@ -28,11 +28,18 @@ static const std::map<const std::string, void *> extensionFunctionTable = {
   std::pair<const std::string, void *>("clReleaseStream", (void *)clReleaseStream),
   std::pair<const std::string, void *>("clWriteStream", (void *)clWriteStream),
   std::pair<const std::string, void *>("clReadStream", (void *)clReadStream),
+  std::pair<const std::string, void *>("clWriteStreams", (void *)clWriteStreams),
+  std::pair<const std::string, void *>("clReadStreams", (void *)clReadStreams),
   std::pair<const std::string, void *>("clCreateStreamBuffer", (void *)clCreateStreamBuffer),
+  std::pair<const std::string, void *>("clMapStreamBuffer", (void *)clMapStreamBuffer),
   std::pair<const std::string, void *>("clReleaseStreamBuffer", (void *)clReleaseStreamBuffer),
   std::pair<const std::string, void *>("clPollStreams", (void *)clPollStreams),
   std::pair<const std::string, void *>("xclGetMemObjectFd", (void *)xclGetMemObjectFd),
   std::pair<const std::string, void *>("xclGetMemObjectFromFd", (void *)xclGetMemObjectFromFd),
+  std::pair<const std::string, void *>("xclBeginGraphRecording", (void *)xclBeginGraphRecording),
+  std::pair<const std::string, void *>("xclEndGraphRecording", (void *)xclEndGraphRecording),
+  std::pair<const std::string, void *>("xclEnqueueGraph", (void *)xclEnqueueGraph),
+  std::pair<const std::string, void *>("xclReleaseGraph", (void *)xclReleaseGraph),
   std::pair<const std::string, void *>("clIcdGetPlatformIDsKHR", (void *)clIcdGetPlatformIDsKHR),
 };
 
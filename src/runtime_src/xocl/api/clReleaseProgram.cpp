@@ -19,6 +19,7 @@
 #include "xocl/core/object.h"
 #include "xocl/core/program.h"
 #include "detail/program.h"
+#include "printf/rt_printf.h"
 
 #include "plugin/xdp/profile.h"
 
@@ -37,8 +38,10 @@ clReleaseProgram(cl_program program)
 {
   validOrError(program);
 
-  if (xocl::xocl(program)->release())
+  if (xocl::xocl(program)->release()) {
+    XCL::Printf::releaseProgram(program);
     delete xocl::xocl(program);
+  }
 
   return CL_SUCCESS;
 }
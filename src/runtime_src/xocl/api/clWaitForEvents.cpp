@@ -19,6 +19,7 @@
 #include "xocl/core/object.h"
 #include "xocl/core/range.h"
 #include "detail/event.h"
+#include "printf/rt_printf.h"
 
 #include <iostream>
 
@@ -41,7 +42,8 @@ clWaitForEvents(cl_uint num_events, const cl_event* event_list)
 {
   validOrError(num_events, event_list);
   for (auto event : get_range(event_list,event_list+num_events))
-    xocl(event)->wait();  
+    xocl(event)->wait();
+  XCL::Printf::flushBuffers();
   return CL_SUCCESS;
 }
 
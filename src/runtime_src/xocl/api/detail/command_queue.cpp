@@ -53,6 +53,13 @@ validOrError(const cl_device_id device, cl_command_queue_properties properties)
     throw error(CL_INVALID_QUEUE_PROPERTIES);
 }
 
+void
+validBlockingOrError(const cl_command_queue command_queue, cl_bool blocking)
+{
+  if (blocking && command_queue && xocl(command_queue)->is_recording())
+    throw error(CL_INVALID_OPERATION,"blocking command cannot be recorded in a graph");
+}
+
 }
 
 }} // detail,xocl
@@ -29,6 +29,15 @@ validOrError(const cl_command_queue command_queue);
 void
 validOrError(const cl_device_id, cl_command_queue_properties properties);
 
+/**
+ * Blocking commands cannot be enqueued while the queue is recording a
+ * graph, the recorded command does not execute until the graph is
+ * enqueued.  Checked before the command is recorded so that a
+ * rejected command is not added to the graph.
+ */
+void
+validBlockingOrError(const cl_command_queue command_queue, cl_bool blocking);
+
 }
 
 }} // detail,xocl
@@ -30,6 +30,8 @@
 #include "xocl/core/device.h"
 #include "xocl/core/kernel.h"
 
+#include <map>
+
 
 namespace {
 
@@ -265,6 +267,43 @@ migrate_buffer(shared_event_completer sec,xocl::device* device
   }
 }
 
+static void
+migrate_buffers(shared_event_completer sec,xocl::device* device
+                ,const std::vector<xocl::memory*>& buffers,cl_mem_migration_flags flags)
+{
+  try {
+    sec->set_status(CL_RUNNING);
+    device->migrate_buffers(buffers,flags);
+  }
+  catch (const std::exception& ex) {
+    handle_device_exception(sec.get(),ex);
+  }
+}
+
+// Schedule migration of buffers with one DMA task per memory bank.
+// The event completes when the last task completes.
+static void
+schedule_migrate_buffers(const shared_event_completer& sec,xocl::device* device
+                         ,const std::vector<xocl::memory*>& buffers,cl_mem_migration_flags flags)
+{
+  if (buffers.empty())
+    return;
+
+  auto xdevice = device->get_xrt_device();
+  auto at = (flags & CL_MIGRATE_MEM_OBJECT_HOST) ? async_type::read : async_type::write;
+
+  if (buffers.size()==1) {
+    xdevice->schedule(migrate_buffer,at,sec,device,buffers.front(),flags);
+    return;
+  }
+
+  std::map<int,std::vector<xocl::memory*>> banks;
+  for (auto mem : buffers)
+    banks[mem->get_memidx()].push_back(mem);
+  for (auto& bank : banks)
+    xdevice->schedule(migrate_buffers,at,sec,device,std::move(bank.second),flags);
+}
+
 static void
 read_image(xocl::event* event,xocl::device* device,cl_mem image,
 	const size_t* origin,const size_t* region, size_t row_pitch,size_t slice_pitch,
@@ -363,9 +402,10 @@ action_ndrange_migrate(cl_event event,cl_kernel kernel)
     XOCL_DEBUG(std::cout,"launching ndrange migrate DMA event(",ev->get_uid(),")\n");
     auto command_queue = ev->get_command_queue();
     auto device = command_queue->get_device();
-    auto xdevice = device->get_xrt_device();
     auto ec = make_shared_event_completer(ev);
 
+    std::vector<xocl::memory*> migrate;
+    migrate.reserve(kernel_args.size());
     for (auto mem : kernel_args) {
       // do not migrate if argument is write only, but trick the code
       // into assuming that the argument is resident
@@ -375,10 +415,11 @@ action_ndrange_migrate(cl_event event,cl_kernel kernel)
       }
 
       // only migrate if not already resident on device
-      if (!mem->is_resident(device)) {
-        xdevice->schedule(migrate_buffer,async_type::write,ec,device,mem,0);
-      }
+      if (!mem->is_resident(device))
+        migrate.push_back(mem);
     }
+
+    schedule_migrate_buffers(ec,device,migrate,0);
   };
 }
 
@@ -521,8 +562,9 @@ action_migrate_memobjects(size_t num, const cl_mem* memobjs, cl_mem_migration_fl
     XOCL_DEBUG(std::cout,"launching migrate DMA event(",ev->get_uid(),")\n");
     auto command_queue = ev->get_command_queue();
     auto device = command_queue->get_device();
-    auto xdevice = device->get_xrt_device();
     auto ec = make_shared_event_completer(ev);
+    std::vector<xocl::memory*> migrate;
+    migrate.reserve(mo.size());
     for (auto mem : mo) {
       // do not migrate if argument is CL_MIGRATE_MEM_OBJECT_CONTENT_UNDERFINED
       // but trick code into assuming that the argument is resident
@@ -533,9 +575,10 @@ action_migrate_memobjects(size_t num, const cl_mem* memobjs, cl_mem_migration_fl
         continue;
       }
 
-      auto at = (flags & CL_MIGRATE_MEM_OBJECT_HOST) ? async_type::read : async_type::write;
-      xdevice->schedule(migrate_buffer,at,ec,device,mem,flags);
+      migrate.push_back(xocl::xocl(mem));
     }
+
+    schedule_migrate_buffers(ec,device,migrate,flags);
   };
 }
 
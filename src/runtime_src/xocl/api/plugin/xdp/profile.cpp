@@ -73,6 +73,7 @@ cb_action_copy_type cb_action_copy;
 cb_log_function_start_type cb_log_function_start;
 cb_log_function_end_type cb_log_function_end;
 cb_log_dependencies_type cb_log_dependencies;
+cb_log_device_phase_type cb_log_device_phase;
 cb_add_to_active_devices_type cb_add_to_active_devices;
 cb_set_kernel_clock_freq_type cb_set_kernel_clock_freq;
 cb_reset_type cb_reset;
@@ -139,6 +140,11 @@ void register_cb_log_dependencies(cb_log_dependencies_type&& cb)
   cb_log_dependencies = std::move(cb);
 }
 
+void register_cb_log_device_phase(cb_log_device_phase_type&& cb)
+{
+  cb_log_device_phase = std::move(cb);
+}
+
 void register_cb_add_to_active_devices(cb_add_to_active_devices_type&& cb)
 {
   cb_add_to_active_devices = std::move(cb);
@@ -466,6 +472,21 @@ function_call_logger::
 
 std::atomic <unsigned int>  function_call_logger::m_funcid_global(0);
 
+device_phase_logger::
+device_phase_logger(const std::string& device_name, const char* phase)
+  : m_device_name(device_name), m_phase(phase)
+{
+  if (cb_log_device_phase)
+    cb_log_device_phase(m_device_name, m_phase, true);
+}
+
+device_phase_logger::
+~device_phase_logger()
+{
+  if (cb_log_device_phase)
+    cb_log_device_phase(m_device_name, m_phase, false);
+}
+
 void add_to_active_devices(const std::string& device_name)
 {
   if (cb_add_to_active_devices)
@@ -66,6 +66,7 @@ using cb_action_copy_type = std::function< void (xocl::event* event, cl_int stat
 using cb_log_function_start_type = std::function<void(const char* functionName, long long queueAddress, unsigned int functionID)>;
 using cb_log_function_end_type = std::function<void(const char* functionName, long long queueAddress, unsigned int functionID)>;
 using cb_log_dependencies_type = std::function<void(xocl::event* event,  cl_uint num_deps, const cl_event* deps)>;
+using cb_log_device_phase_type = std::function<void(const std::string& device_name, const char* phase, bool start)>;
 using cb_add_to_active_devices_type = std::function<void (const std::string& device_name)>;
 using cb_set_kernel_clock_freq_type = std::function<void(const std::string& device_name, unsigned int freq)>;
 using cb_reset_type = std::function<void(const xocl::xclbin&)>;
@@ -95,6 +96,7 @@ void register_cb_action_copy (cb_action_copy_type&& cb);
 void register_cb_log_function_start (cb_log_function_start_type&& cb);
 void register_cb_log_function_end (cb_log_function_end_type&& cb);
 void register_cb_log_dependencies(cb_log_dependencies_type && cb);
+void register_cb_log_device_phase(cb_log_device_phase_type && cb);
 void register_cb_add_to_active_devices(cb_add_to_active_devices_type&& cb);
 void register_cb_set_kernel_clock_freq (cb_set_kernel_clock_freq_type&& cb);
 void register_cb_reset(cb_reset_type && cb);
@@ -150,6 +152,11 @@ set_event_action(xocl::event* event, F&& f, Args&&... args)
     return;
 #endif
 
+  // The event keeps the action only when profiling is configured, so
+  // avoid creating it otherwise
+  if (!xrt::config::get_profile())
+    return;
+
   event->set_profile_action(f(std::forward<Args>(args)...));
 }
 
@@ -174,6 +181,20 @@ struct function_call_logger
   long long m_address = 0;
 };
 
+/**
+ * Log start and end of a host side device phase, such as the steps
+ * of loading a program, to the timeline trace.  Unlike
+ * function_call_logger this is not counted as an API call.
+ */
+struct device_phase_logger
+{
+  device_phase_logger(const std::string& device_name, const char* phase);
+  ~device_phase_logger();
+
+  std::string m_device_name;
+  const char* m_phase;
+};
+
 void
 add_to_active_devices(const std::string& device_name);
 
@@ -18,6 +18,128 @@
 
 #include "rt_printf.h"
 #include "xocl/core/kernel.h"
+#include "xocl/core/program.h"
+#include "xocl/core/event.h"
+#include "xocl/core/error.h"
+#include "xrt/util/thread.h"
+
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace {
+
+/////////////////////////////////////////////////////////////////////////
+// Background printf decoder.  The decoder thread is started on first
+// posted buffer and drains all pending buffers before exiting.
+//
+// A ticket is reserved when the printf buffer read is enqueued, and is
+// retired when the buffer has been decoded and printed, or when the read
+// failed.  Each ticket remembers the kernel event that produced it so
+// that a flush only waits for output of kernels that have completed.
+struct printf_job
+{
+  unsigned int ticket;
+  xocl::ptr<xocl::kernel> kernel;
+  std::vector<uint8_t> buf;
+};
+
+static std::mutex s_mutex;
+static std::condition_variable s_work;
+static std::condition_variable s_done;
+static std::queue<printf_job> s_jobs;
+static std::map<unsigned int,xocl::ptr<xocl::event>> s_tickets;
+static unsigned int s_next_ticket = 0;
+static bool s_stop = false;
+static std::thread s_decoder;
+
+// Parsed format strings per program (uid) per kernel (uid).  Bounded by
+// the total number of format strings cached for a program, and dropped
+// when the program is released.
+static const size_t s_max_cached_formats = 4096;
+static std::mutex s_cache_mutex;
+static std::map<unsigned int,std::map<unsigned int,XCL::Printf::FormatStringCache>> s_format_cache;
+
+static XCL::Printf::FormatStringCache&
+get_format_cache(const xocl::kernel* kernel)
+{
+  auto& program_cache = s_format_cache[kernel->get_program()->get_uid()];
+  size_t formats = 0;
+  for (auto& entry : program_cache)
+    formats += entry.second.size();
+  if (formats > s_max_cached_formats)
+    program_cache.clear();
+  return program_cache[kernel->get_uid()];
+}
+
+static void
+decode(printf_job& job)
+{
+  try {
+    std::lock_guard<std::mutex> lk(s_cache_mutex);
+    auto& cache = get_format_cache(job.kernel.get());
+    XCL::Printf::BufferPrintf bp(std::move(job.buf), job.kernel->get_stringtable());
+    if (XCL::Printf::isPrintfDebugMode()) {
+      std::cout << "printf decoder - kernel(" << job.kernel->get_uid() << ") buffer\n";
+      bp.dbgDump();
+    }
+    bp.print(std::cout, cache);
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+  }
+}
+
+// Caller must hold s_mutex
+static void
+retire(unsigned int ticket)
+{
+  s_tickets.erase(ticket);
+  s_done.notify_all();
+}
+
+static void
+decoder_loop()
+{
+  while (true) {
+    printf_job job;
+    {
+      std::unique_lock<std::mutex> lk(s_mutex);
+      while (!s_stop && s_jobs.empty())
+        s_work.wait(lk);
+      if (s_jobs.empty())
+        return; // stopped and drained
+      job = std::move(s_jobs.front());
+      s_jobs.pop();
+    }
+
+    decode(job);
+    job.kernel = nullptr;
+
+    std::lock_guard<std::mutex> lk(s_mutex);
+    retire(job.ticket);
+  }
+}
+
+struct decoder_stopper
+{
+  ~decoder_stopper()
+  {
+    {
+      std::lock_guard<std::mutex> lk(s_mutex);
+      if (!s_decoder.joinable())
+        return;
+      s_stop = true;
+    }
+    s_work.notify_all();
+    s_decoder.join();
+  }
+};
+
+static decoder_stopper s_decoder_stopper;
+
+} // namespace
 
 namespace XCL {
 namespace Printf {
@@ -59,6 +181,59 @@ void PrintfManager::dbgDump(std::ostream& os)
 
 /////////////////////////////////////////////////////////////////////////
 
+unsigned int reserveBuffer(cl_event kernel_event)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  auto ticket = s_next_ticket++;
+  s_tickets.emplace(ticket,xocl::xocl(kernel_event));
+  return ticket;
+}
+
+void postBuffer(unsigned int ticket, cl_kernel kernel, std::vector<uint8_t>&& buf)
+{
+  {
+    std::lock_guard<std::mutex> lk(s_mutex);
+    if (!s_decoder.joinable())
+      s_decoder = xrt::thread(decoder_loop);
+    s_jobs.push(printf_job{ticket, xocl::xocl(kernel), std::move(buf)});
+  }
+  s_work.notify_one();
+}
+
+void cancelBuffer(unsigned int ticket)
+{
+  std::lock_guard<std::mutex> lk(s_mutex);
+  retire(ticket);
+}
+
+void flushBuffers()
+{
+  std::unique_lock<std::mutex> lk(s_mutex);
+
+  // Wait for the tickets of kernels that have completed.  The printf
+  // buffer read of such a kernel depends only on the kernel event, so
+  // it is guaranteed to finish.  Kernels still running or waiting on
+  // other events are not waited for.
+  std::vector<unsigned int> tickets;
+  for (auto& entry : s_tickets)
+    if (entry.second->get_status() == CL_COMPLETE)
+      tickets.push_back(entry.first);
+
+  for (auto ticket : tickets)
+    while (s_tickets.count(ticket))
+      s_done.wait(lk);
+
+  std::cout.flush();
+}
+
+void releaseProgram(cl_program program)
+{
+  std::lock_guard<std::mutex> lk(s_cache_mutex);
+  s_format_cache.erase(xocl::xocl(program)->get_uid());
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 bool kernelHasPrintf(cl_kernel kernel)
 {
   bool retval = (kernel && xocl::xocl(kernel)->has_printf() && (xocl::xocl(kernel)->get_stringtable().size() > 0) );
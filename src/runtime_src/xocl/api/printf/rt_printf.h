@@ -56,6 +56,38 @@ private:
 
 };
 
+/////////////////////////////////////////////////////////////////////////
+// ASYNCHRONOUS DECODING
+//
+// Printf buffers returned from the device are handed off to a background
+// decoder thread so that the completion of the buffer read (and anything
+// chained to it) is not held up by format string parsing and printing.
+// Buffers are decoded one at a time in the order they are posted, so the
+// output of one kernel event is never interleaved with that of another.
+// Parsed format strings are cached per program and kernel by string
+// table index.
+//
+// Host synchronization points (clFinish, clWaitForEvents, blocking reads
+// and maps) call flushBuffers() so that output of completed kernels is
+// visible when the host observes the completion.
+
+// Reserve a ticket for the printf buffer of kernel_event, must be
+// followed by exactly one postBuffer() or cancelBuffer() of the ticket
+unsigned int reserveBuffer(cl_event kernel_event);
+
+// Post a buffer for decoding, the decoder takes ownership of buf
+void postBuffer(unsigned int ticket, cl_kernel kernel, std::vector<uint8_t>&& buf);
+
+// Retire a ticket whose buffer could not be read
+void cancelBuffer(unsigned int ticket);
+
+// Block until all reserved buffers of completed kernels have been
+// decoded and printed
+void flushBuffers();
+
+// Drop cached format strings of a program that is being deleted
+void releaseProgram(cl_program program);
+
 /////////////////////////////////////////////////////////////////////////
 // UTILITY FUNCTIONS
 
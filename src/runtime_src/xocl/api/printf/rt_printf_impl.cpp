@@ -670,6 +670,17 @@ void FormatString::dbgDump(std::ostream& str) const
 
 /////////////////////////////////////////////////////////////////////////
 
+const FormatString& FormatStringCache::get(uint32_t id, const std::string& format)
+{
+  auto& entry = m_cache[id];
+  if ( !entry ) {
+    entry.reset(new FormatString(format));
+  }
+  return *entry;
+}
+
+/////////////////////////////////////////////////////////////////////////
+
 BufferPrintf::BufferPrintf()
   : m_currentOffset(0)
 {
@@ -696,6 +707,13 @@ BufferPrintf::BufferPrintf(const uint8_t* buf, size_t bufLen, const StringTable&
   setStringTable(table);
 }
 
+BufferPrintf::BufferPrintf(MemBuffer&& buf, const StringTable& table)
+  : m_currentOffset(0)
+{
+  setBuffer(std::move(buf));
+  setStringTable(table);
+}
+
 void BufferPrintf::setBuffer(const uint8_t* buf, size_t bufLen)
 {
   m_buf.resize(bufLen);
@@ -713,6 +731,15 @@ void BufferPrintf::setBuffer(const MemBuffer& buf)
   std::copy(buf.begin(), buf.end(), m_buf.begin());
 }
 
+void BufferPrintf::setBuffer(MemBuffer&& buf)
+{
+  // Currently bufLen must be 64-bit aligned
+  if ( (buf.size() % 8) != 0 ) {
+    throwError("setBuffer - bufLen is not a multiple of 8 bytes");
+  }
+  m_buf = std::move(buf);
+}
+
 void BufferPrintf::setStringTable(const StringTable& table)
 {
   m_stringTable = table;
@@ -720,18 +747,28 @@ void BufferPrintf::setStringTable(const StringTable& table)
 
 void BufferPrintf::print(std::ostream& os)
 {
+  FormatStringCache cache;
+  print(os, cache);
+}
+
+void BufferPrintf::print(std::ostream& os, FormatStringCache& cache)
+{
+  std::vector<PrintfArg> argVec;
   moveToFirstRecord();
   while ( hasNextRecord() ) {
-    std::string formatStr = getFormat();
-    FormatString format(formatStr);
+    uint32_t id = getFormatID();
+    auto itr = m_stringTable.find(id);
+    if ( itr == m_stringTable.end() ) {
+      std::ostringstream oss;
+      oss << "BufferPrintf lookup() - id " << id << " does not exist in the string table";
+      throwError(oss.str());
+    }
+    const FormatString& format = cache.get(id, itr->second);
     if ( format.isValid() ) {
-      std::vector<XCL::Printf::ConversionSpec> conversionVec;
-      format.getSpecifiers(conversionVec);
-      std::vector<PrintfArg> argVec;
+      argVec.clear();
       int argOffset = getFormatByteCount();
-      for ( auto conversion : conversionVec ) {
-        PrintfArg arg = buildArg(m_currentOffset + argOffset, conversion);
-        argVec.push_back(arg);
+      for ( auto& conversion : format.getSpecifiers() ) {
+        argVec.push_back(buildArg(m_currentOffset + argOffset, conversion));
         argOffset += getElementByteCount(conversion) * conversion.m_vectorSize;
         // HACK: Special handling for vec3 packed strangely from compiler
         //    float3 += 32 bits
@@ -745,8 +782,7 @@ void BufferPrintf::print(std::ostream& os)
           }
         }
       }
-      std::string result = string_printf(formatStr, argVec);
-      os << result;
+      os << string_printf(format, argVec);
     }
     nextRecord();
   }
@@ -943,7 +979,7 @@ uint64_t BufferPrintf::extractField(int idx, int byteCount) const
   return val;
 }
 
-PrintfArg BufferPrintf::buildArg(int bufIdx, ConversionSpec& conversion) const
+PrintfArg BufferPrintf::buildArg(int bufIdx, const ConversionSpec& conversion) const
 {
   int elementBytes = getElementByteCount(conversion);
   if ( conversion.isIntClass() ) {
@@ -1003,7 +1039,7 @@ PrintfArg BufferPrintf::buildArg(int bufIdx, ConversionSpec& conversion) const
 
 /////////////////////////////////////////////////////////////////////////
 
-std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
+std::string convertArg(PrintfArg& arg, const ConversionSpec& conversion)
 {
   std::string retval = "";
   char formatStr[32];
@@ -1122,17 +1158,20 @@ std::string convertArg(PrintfArg& arg, ConversionSpec& conversion)
 
 std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> args)
 {
-  std::vector<ConversionSpec> specVec;
-  std::vector<std::string> splitVec;
   FormatString formatString(formatStr);
-  if ( formatString.isValid() == false ) {
+  return string_printf(formatString, args);
+}
+
+std::string string_printf(const FormatString& format, std::vector<PrintfArg>& args)
+{
+  if ( format.isValid() == false ) {
     std::ostringstream oss;
-    oss << "Error - invalid format string '" << formatStr;
+    oss << "Error - invalid format string '" << format.getFormat();
     throwError(oss.str());
     return "";
   }
-  formatString.getSplitFormatString(splitVec);
-  formatString.getSpecifiers(specVec);
+  auto& splitVec = format.getSplitFormatString();
+  auto& specVec = format.getSpecifiers();
 
   if ( args.size() != specVec.size() ) {
     std::ostringstream oss;
@@ -1146,13 +1185,10 @@ std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> a
     oss << splitVec[0];
   }
   for ( size_t idx = 1; idx < splitVec.size(); ++idx ) {
-    PrintfArg& arg = args[idx-1];
-    ConversionSpec& conversion = specVec[idx-1];
-    oss << convertArg(arg, conversion);
+    oss << convertArg(args[idx-1], specVec[idx-1]);
     oss << splitVec[idx];
   }
-  std::string retval = oss.str();
-  return retval;
+  return oss.str();
 }
 
 void throwError(const std::string& errorMsg)
@@ -23,6 +23,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <memory>
 #include <stdint.h>
 
 
@@ -143,6 +144,11 @@ public:
    //    splitStr.size() == specVec.size() + 1
    void getSplitFormatString(std::vector<std::string>& splitStr) const;
 
+   // Non-copying accessors of the above
+   const std::vector<ConversionSpec>& getSpecifiers() const { return m_specVec; }
+   const std::vector<std::string>& getSplitFormatString() const { return m_splitFormatString; }
+   const std::string& getFormat() const { return m_format; }
+
    bool isValid() const { return m_valid; }
    void dbgDump(std::ostream& str = std::cout) const;
 
@@ -160,6 +166,29 @@ private:
 
 };
 
+/////////////////////////////////////////////////////////////////////////
+// FormatStringCache -
+//
+// Parsed format strings keyed by string table index. A kernel typically
+// executes the same handful of printf statements in every work item, so
+// the format string for a given index is parsed once and reused for all
+// records that reference it, across all buffers returned by the kernel.
+//
+// Not thread safe, callers must serialize access.
+class FormatStringCache {
+
+public:
+   // Return the parsed format string for string table entry 'id', parsing
+   // and caching 'format' if this is the first lookup of 'id'.
+   const FormatString& get(uint32_t id, const std::string& format);
+
+   void clear() { m_cache.clear(); }
+   size_t size() const { return m_cache.size(); }
+
+private:
+   std::map<uint32_t,std::unique_ptr<FormatString>> m_cache;
+};
+
 /////////////////////////////////////////////////////////////////////////
 // A decoded printf argument. This is just a convenient way to quickly 
 // store anything that a printf argument is allowed to be. Arguments are 
@@ -245,17 +274,23 @@ public:
     BufferPrintf();
     BufferPrintf(const MemBuffer& buf, const StringTable& table);
     BufferPrintf(const uint8_t* buf, size_t bufSize, const StringTable& table);
+    BufferPrintf(MemBuffer&& buf, const StringTable& table);
 
     ~BufferPrintf();
 
     void setBuffer(const uint8_t* buf, size_t bufLen);
     void setBuffer(const MemBuffer& buf);
+    void setBuffer(MemBuffer&& buf);
 
     void setStringTable(const StringTable& table);
     
     // Print buffer contents to the outputstream
     void print(std::ostream& os = std::cout);
 
+    // Print buffer contents to the outputstream using (and populating)
+    // a cache of parsed format strings for this buffer's string table
+    void print(std::ostream& os, FormatStringCache& cache);
+
     void dbgDump(std::ostream& os = std::cout) const;
 
 public:
@@ -297,7 +332,7 @@ private:
 
     // Build up a printf argument given the conversion specifier
     // and memory buffer and string table
-    PrintfArg buildArg(int bufIdx, ConversionSpec& conversion) const;
+    PrintfArg buildArg(int bufIdx, const ConversionSpec& conversion) const;
     
     // Convert escape sequences \n, \r, \t, \ to text representation
     // Newline replaced by string: "\n"
@@ -319,13 +354,16 @@ private:
 // Perform a conversion given a single printf argument and return the string 
 // representation of the result. This is called repeatedly for each arg
 // during string_printf to build the complete output string.
-std::string convertArg(PrintfArg& arg, ConversionSpec& conversion);
+std::string convertArg(PrintfArg& arg, const ConversionSpec& conversion);
 
 // Given format string and args, create and return a string (similar to sprintf). 
 // This exercises the round trip internal printf and is used to test breaking down
 // a format and printing arguments.
 std::string string_printf(const std::string& formatStr, std::vector<PrintfArg> args);
 
+// Same as above, but with an already parsed format string.
+std::string string_printf(const FormatString& format, std::vector<PrintfArg>& args);
+
 // Throws an exception with the given error message. Put as a utility function 
 // because I am not sure on the exception throwing and error reporting standards
 // so for now I simply throw a std::runtime_exception.
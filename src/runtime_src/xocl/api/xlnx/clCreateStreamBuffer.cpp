@@ -22,8 +22,6 @@
 #include "xocl/core/device.h"
 #include "plugin/xdp/profile.h"
 
-//To access make_unique<>. TODO
-
 namespace xocl {
 static void
 validOrError(cl_device_id device,
@@ -39,10 +37,9 @@ clCreateStreamBuffer(cl_device_id device,
 	             cl_int*      errcode_ret) 
 {
   validOrError(device,size,errcode_ret);
-  auto buf = std::make_unique<xocl::stream_mem>(size);
-  buf->get(xocl::xocl(device));
+  auto buf = xocl::xocl(device)->create_stream_buf(size);
   xocl::assign(errcode_ret,CL_SUCCESS);
-  return buf.release();
+  return buf;
 }
 
 } //xocl
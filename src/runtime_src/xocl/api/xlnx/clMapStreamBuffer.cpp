@@ -0,0 +1,64 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/stream.h"
+#include "xocl/core/error.h"
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_stream_mem stream_obj,
+	     cl_int*       errcode_ret)
+{
+  if (!config::api_checks())
+    return;
+
+  if (!stream_obj)
+    throw error(CL_INVALID_VALUE,"stream_obj is nullptr");
+}
+
+static void*
+clMapStreamBuffer(cl_stream_mem stream_obj,
+		  cl_int*       errcode_ret)
+{
+  validOrError(stream_obj,errcode_ret);
+  xocl::assign(errcode_ret,CL_SUCCESS);
+  return xocl::xocl(stream_obj)->map();
+}
+
+} //xocl
+
+CL_API_ENTRY void* CL_API_CALL
+clMapStreamBuffer(cl_stream_mem stream_obj,
+		  cl_int*       errcode_ret) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clMapStreamBuffer(stream_obj,errcode_ret);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,ex.get_code());
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,CL_INVALID_VALUE);
+  }
+  return nullptr;
+}
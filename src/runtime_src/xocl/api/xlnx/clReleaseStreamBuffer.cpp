@@ -17,21 +17,32 @@
 // Copyright 2018 Xilinx, Inc. All rights reserved.
 
 #include <CL/opencl.h>
+#include "xocl/config.h"
 #include "xocl/core/stream.h"
 #include "xocl/core/error.h"
+#include "xocl/core/device.h"
 #include "plugin/xdp/profile.h"
 
 namespace xocl {
 static void
 validOrError(cl_stream_mem stream_obj)
 {
+  if (!config::api_checks())
+    return;
+
+  if (!stream_obj)
+    throw error(CL_INVALID_MEM_OBJECT,"stream buffer is nullptr");
+  if (!xocl::xocl(stream_obj)->m_device)
+    throw error(CL_INVALID_MEM_OBJECT,"stream buffer has no device");
 }
 
 cl_int 
 clReleaseStreamBuffer(cl_stream_mem stream_obj)
 {
   validOrError(stream_obj);
-  return CL_INVALID_VALUE;
+  auto mem = xocl::xocl(stream_obj);
+  mem->m_device->release_stream_buf(mem);
+  return CL_SUCCESS;
 }
 
 } //xocl
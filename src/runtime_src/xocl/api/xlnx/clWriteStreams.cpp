@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/stream.h"
+#include "xocl/core/error.h"
+#include "plugin/xdp/profile.h"
+#include "xocl/core/device.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_stream           stream,
+	     cl_uint             num_packets,
+	     const void* const*  ptrs,
+	     const size_t*       sizes,
+	     cl_stream_xfer_req* attributes,
+	     cl_int*             errcode_ret)
+{
+  if (!config::api_checks())
+    return;
+
+  if (!stream)
+    throw error(CL_INVALID_VALUE,"stream is nullptr");
+  if (num_packets && (!ptrs || !sizes || !attributes))
+    throw error(CL_INVALID_VALUE,"ptrs, sizes or attributes is nullptr");
+}
+
+static cl_int
+clWriteStreams(cl_stream           stream,
+	      cl_uint             num_packets,
+	      const void* const*  ptrs,
+	      const size_t*       sizes,
+	      cl_stream_xfer_req* attributes,
+	      cl_int*             errcode_ret)
+{
+  validOrError(stream,num_packets,ptrs,sizes,attributes,errcode_ret);
+  auto posted = xocl::xocl(stream)->write(num_packets,ptrs,sizes,attributes);
+  xocl::assign(errcode_ret,posted == num_packets ? CL_SUCCESS : CL_INVALID_OPERATION);
+  return posted;
+}
+
+} //xocl
+
+CL_API_ENTRY cl_int CL_API_CALL
+clWriteStreams(cl_stream           stream,
+	      cl_uint             num_packets,
+	      const void* const*  ptrs,
+	      const size_t*       sizes,
+	      cl_stream_xfer_req* attributes,
+	      cl_int*             errcode_ret) CL_API_SUFFIX__VERSION_1_0
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL;
+    return xocl::clWriteStreams
+      (stream,num_packets,ptrs,sizes,attributes,errcode_ret);
+  }
+  catch (const xrt::error& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,ex.get_code());
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,CL_INVALID_VALUE);
+  }
+  return 0;
+}
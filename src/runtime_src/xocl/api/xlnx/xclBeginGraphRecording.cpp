@@ -0,0 +1,67 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/error.h"
+#include "detail/command_queue.h"
+
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_command_queue command_queue)
+{
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_COMMAND_QUEUE if command_queue is not a valid
+  // command-queue
+  detail::command_queue::validOrError(command_queue);
+
+  // CL_INVALID_OPERATION if command_queue is already recording
+  if (xocl(command_queue)->is_recording())
+    throw error(CL_INVALID_OPERATION,"command queue is already recording");
+}
+
+static cl_int
+xclBeginGraphRecording(cl_command_queue command_queue)
+{
+  validOrError(command_queue);
+  xocl(command_queue)->begin_recording();
+  return CL_SUCCESS;
+}
+
+} // xocl
+
+cl_int
+xclBeginGraphRecording(cl_command_queue command_queue)
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL_WITH_QUEUE(command_queue);
+    return xocl::xclBeginGraphRecording(command_queue);
+  }
+  catch (const xocl::error& ex) {
+    xocl::send_exception_message(ex.what());
+    return ex.get_code();
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    return CL_OUT_OF_HOST_MEMORY;
+  }
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/graph.h"
+#include "xocl/core/error.h"
+#include "detail/command_queue.h"
+
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_command_queue command_queue)
+{
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_COMMAND_QUEUE if command_queue is not a valid
+  // command-queue
+  detail::command_queue::validOrError(command_queue);
+
+  // CL_INVALID_OPERATION if command_queue is not recording
+  if (!xocl(command_queue)->is_recording())
+    throw error(CL_INVALID_OPERATION,"command queue is not recording");
+}
+
+static xcl_graph
+xclEndGraphRecording(cl_command_queue command_queue, cl_int* errcode_ret)
+{
+  validOrError(command_queue);
+  auto graph = xocl(command_queue)->end_recording();
+  xocl::assign(errcode_ret,CL_SUCCESS);
+  return retobj(graph.get());
+}
+
+} // xocl
+
+xcl_graph
+xclEndGraphRecording(cl_command_queue command_queue, cl_int* errcode_ret)
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL_WITH_QUEUE(command_queue);
+    return xocl::xclEndGraphRecording(command_queue,errcode_ret);
+  }
+  catch (const xocl::error& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,ex.get_code());
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    xocl::assign(errcode_ret,CL_OUT_OF_HOST_MEMORY);
+  }
+  return nullptr;
+}
@@ -0,0 +1,120 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <CL/opencl.h>
+#include "xocl/config.h"
+#include "xocl/core/command_queue.h"
+#include "xocl/core/event.h"
+#include "xocl/core/graph.h"
+#include "xocl/core/error.h"
+#include "detail/command_queue.h"
+#include "detail/event.h"
+
+#include "plugin/xdp/profile.h"
+
+namespace xocl {
+
+static void
+validOrError(cl_command_queue            command_queue,
+             xcl_graph                   graph,
+             cl_uint                     num_updates,
+             const xcl_graph_arg_update* updates,
+             cl_uint                     num_events_in_wait_list,
+             const cl_event*             event_wait_list)
+{
+  if (!config::api_checks())
+    return;
+
+  // CL_INVALID_COMMAND_QUEUE if command_queue is not a valid
+  // command-queue or is not on the graph device
+  detail::command_queue::validOrError(command_queue);
+
+  // CL_INVALID_VALUE if graph is nullptr or updates is nullptr and
+  // num_updates > 0
+  if (!graph)
+    throw error(CL_INVALID_VALUE,"graph is nullptr");
+  if (num_updates && !updates)
+    throw error(CL_INVALID_VALUE,"updates is nullptr");
+
+  if (xocl(command_queue)->get_device()!=xocl(graph)->get_device())
+    throw error(CL_INVALID_COMMAND_QUEUE,"command queue device is not the graph device");
+
+  // CL_INVALID_OPERATION if command_queue is recording
+  if (xocl(command_queue)->is_recording())
+    throw error(CL_INVALID_OPERATION,"command queue is recording");
+
+  // CL_INVALID_CONTEXT if context associated with command_queue and
+  // events in event_wait_list are not the same.
+  // CL_INVALID_EVENT_WAIT_LIST if event_wait_list is NULL and
+  // num_events_in_wait_list > 0, or event_wait_list is not NULL and
+  // num_events_in_wait_list is 0, or if event objects in
+  // event_wait_list are not valid events.
+  detail::event::validOrError(command_queue,num_events_in_wait_list,event_wait_list);
+}
+
+static cl_int
+xclEnqueueGraph(cl_command_queue            command_queue,
+                xcl_graph                   graph,
+                cl_uint                     num_updates,
+                const xcl_graph_arg_update* updates,
+                cl_uint                     num_events_in_wait_list,
+                const cl_event*             event_wait_list,
+                cl_event*                   event_parameter)
+{
+  validOrError(command_queue,graph,num_updates,updates,num_events_in_wait_list,event_wait_list);
+
+  // Argument updates are validated here so that errors are reported
+  // by this call rather than when the graph executes
+  std::vector<graph::arg_update> arg_updates;
+  arg_updates.reserve(num_updates);
+  for (auto& u : get_range(updates,updates+num_updates)) {
+    auto value = static_cast<const char*>(u.arg_value);
+    arg_updates.push_back({u.node,u.arg_index,std::vector<char>(value,value+u.arg_size)});
+    xocl(graph)->validate(arg_updates.back());
+  }
+
+  auto uevent = xocl(graph)->enqueue
+    (xocl(command_queue),std::move(arg_updates),num_events_in_wait_list,event_wait_list);
+  xocl::assign(event_parameter,uevent.get());
+  return CL_SUCCESS;
+}
+
+} // xocl
+
+cl_int
+xclEnqueueGraph(cl_command_queue            command_queue,
+                xcl_graph                   graph,
+                cl_uint                     num_updates,
+                const xcl_graph_arg_update* updates,
+                cl_uint                     num_events_in_wait_list,
+                const cl_event*             event_wait_list,
+                cl_event*                   event_parameter)
+{
+  try {
+    PROFILE_LOG_FUNCTION_CALL_WITH_QUEUE(command_queue);
+    return xocl::xclEnqueueGraph
+      (command_queue,graph,num_updates,updates,
+       num_events_in_wait_list,event_wait_list,event_parameter);
+  }
+  catch (const xocl::error& ex) {
+    xocl::send_exception_message(ex.what());
+    return ex.get_code();
+  }
+  catch (const std::exception& ex) {
+    xocl::send_exception_message(ex.what());
+    return CL_OUT_OF_HOST_MEMORY;
+  }
+}
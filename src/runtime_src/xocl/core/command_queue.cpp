@@ -18,6 +18,7 @@
 #include "context.h"
 #include "device.h"
 #include "event.h"
+#include "graph.h"
 
 #include "xocl/api/plugin/xdp/profile.h"
 
@@ -201,6 +202,47 @@ wait_and_lock() const
     m_has_events.wait(lk);
   return queue_lock(std::move(lk));
 }
+
+void
+command_queue::
+begin_recording()
+{
+  XOCL_DEBUG(std::cout,"xocl::command_queue::begin_recording(",m_uid,")\n");
+  std::unique_lock<std::mutex> lk(m_events_mutex);
+  if (m_graph.get())
+    throw xocl::error(CL_INVALID_OPERATION,"command queue " + std::to_string(m_uid) + " is already recording");
+  while (m_events.size())
+    m_has_events.wait(lk);
+  m_graph = new graph(this);
+  m_graph->release(); // ptr<graph> retains
+  m_recording = true;
+}
+
+ptr<graph>
+command_queue::
+end_recording()
+{
+  XOCL_DEBUG(std::cout,"xocl::command_queue::end_recording(",m_uid,")\n");
+  std::lock_guard<std::mutex> lk(m_events_mutex);
+  if (!m_graph.get())
+    throw xocl::error(CL_INVALID_OPERATION,"command queue " + std::to_string(m_uid) + " is not recording");
+  m_recording = false;
+  return std::move(m_graph);
+}
+
+bool
+command_queue::
+record(event* ev)
+{
+  if (!m_recording)
+    return false;
+  std::lock_guard<std::mutex> lk(m_events_mutex);
+  if (!m_graph.get())
+    return false;
+  m_graph->record(ev);
+  return true;
+}
+
 void
 command_queue::
 register_constructor_callbacks(commandqueue_callback_type&& aCallback)
@@ -20,11 +20,13 @@
 #include "xocl/core/object.h"
 #include "xocl/core/refcount.h"
 #include "xocl/core/property.h"
+#include "xocl/core/pool.h"
 
 #include <vector>
 #include <set>
 #include <unordered_set>
 #include <mutex>
+#include <atomic>
 #include <condition_variable>
 #include <functional>
 
@@ -39,7 +41,7 @@ class command_queue : public refcount, public _cl_command_queue
   // it retains the event upon queuing and releases it when the
   // event is removed.
 public:
-  using event_queue_type = std::unordered_set<event*>;
+  using event_queue_type = std::unordered_set<event*,std::hash<event*>,std::equal_to<event*>,pool_allocator<event*>>;
   using event_iterator_type = event_queue_type::iterator;
 
   using commandqueue_callback_type = std::function<void(command_queue*)>;
@@ -176,6 +178,47 @@ public:
   queue_lock
   wait_and_lock() const;
 
+  /**
+   * Start recording events queued on this command queue
+   *
+   * Waits for all events to complete, then creates a graph to which
+   * subsequently queued events are added rather than executed.
+   *
+   * @throws
+   *   xocl::error CL_INVALID_OPERATION if already recording
+   */
+  void
+  begin_recording();
+
+  /**
+   * Stop recording
+   *
+   * @return
+   *   The recorded graph
+   * @throws
+   *   xocl::error CL_INVALID_OPERATION if not recording
+   */
+  ptr<graph>
+  end_recording();
+
+  /**
+   * Check if command queue is recording events
+   */
+  bool
+  is_recording() const
+  {
+    return m_recording;
+  }
+
+  /**
+   * Record event in graph if command queue is recording
+   *
+   * @return
+   *   true if the event was recorded, false if the command queue is
+   *   not recording
+   */
+  bool
+  record(event* ev);
 
   /**
    * Register callback function for command queue construction
@@ -204,6 +247,11 @@ private:
   std::vector<event*> m_barriers;
   ptr<event> m_last_queued_event;
   property_type m_props;
+
+  // Graph being recorded, guarded by m_events_mutex.  The flag
+  // avoids locking when queuing events on a queue not recording.
+  ptr<graph> m_graph;
+  std::atomic<bool> m_recording {false};
 };
 
 } // xocl
@@ -84,6 +84,36 @@ get_memidx_union() const
   return xclbin.cu_address_to_memidx(m_address);
 }
 
+void
+cu_occupancy::
+record_completion(unsigned long latency_ns, unsigned long now_ns)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+
+  // Minimum latency approximates the unloaded service time of the CU
+  // excluding queueing.  Allow it to creep up so the estimate follows
+  // a CU that is now given more work per command.
+  m_min_latency = m_min_latency
+    ? std::min(latency_ns, m_min_latency + m_min_latency/16)
+    : latency_ns;
+
+  // Only sample the completion interval if this command was in flight
+  // when the previous one completed, otherwise the gap is idle time
+  // rather than throughput of the CU.
+  auto submitted = now_ns - latency_ns;
+  if (m_last_done && submitted < m_last_done) {
+    auto interval = now_ns - m_last_done;
+    m_interval = m_interval
+      ? (7*m_interval + interval)/8
+      : interval;
+  }
+  m_last_done = now_ns;
+
+  // Little's law: commands in flight = latency * completion rate
+  if (m_interval)
+    m_depth = (m_min_latency + m_interval - 1) / m_interval + 1;
+}
+
 std::unique_ptr<compute_unit>
 compute_unit::
 create(const xclbin::symbol* symbol, const xclbin::symbol::instance& inst,
@@ -18,12 +18,96 @@
 #define xocl_core_compute_unit_h_
 
 #include "xocl/xclbin/xclbin.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <string>
 
 namespace xocl {
 
 class device;
 
+// Pipeline occupancy of a compute unit
+//
+// Statistics are updated once per completed command and read by
+// execution contexts sizing their window of commands in flight.
+// Readers never lock; the pipeline depth is recomputed and published
+// by the completing thread.
+class cu_occupancy
+{
+public:
+  /**
+   * Record completion of a command that executed on the CU
+   *
+   * @latency_ns: Time from command submission to completion
+   * @now_ns: Time of completion
+   *
+   * Updates running estimates of the CU's minimum latency and of
+   * the interval between completions, used to compute the pipeline
+   * depth of the CU.
+   */
+  void
+  record_completion(unsigned long latency_ns, unsigned long now_ns);
+
+  /**
+   * Number of commands that keep the CU busy
+   *
+   * Computed from observed latency and completion interval using
+   * Little's law, plus one command queued behind those in flight.
+   *
+   * @default_depth: Value returned until completions have been observed
+   * @max_depth: Upper bound on returned depth
+   * @return Estimated pipeline depth in range [2,max_depth]
+   */
+  size_t
+  get_pipeline_depth(size_t default_depth, size_t max_depth) const
+  {
+    size_t depth = m_depth;
+    if (!depth)
+      return std::min(default_depth,max_depth);
+    return std::max<size_t>(2,std::min(depth,max_depth));
+  }
+
+  /**
+   * Pipeline depth shared fairly among the contexts using the CU
+   *
+   * @return At least one command
+   */
+  size_t
+  get_pipeline_share(size_t default_depth, size_t max_depth) const
+  {
+    auto depth = get_pipeline_depth(default_depth,max_depth);
+    size_t share = std::max(1u,get_num_contexts());
+    return std::max<size_t>(1,(depth+share-1)/share);
+  }
+
+  void
+  add_context()
+  {
+    ++m_contexts;
+  }
+
+  void
+  remove_context()
+  {
+    --m_contexts;
+  }
+
+  unsigned int
+  get_num_contexts() const
+  {
+    return m_contexts;
+  }
+
+private:
+  std::atomic<unsigned int> m_contexts {0};
+  std::atomic<size_t> m_depth {0};
+  std::mutex m_mutex;
+  unsigned long m_min_latency = 0;
+  unsigned long m_interval = 0;
+  unsigned long m_last_done = 0;
+};
+
 // Compute unit
 //
 // Ownership of cus is shared between program and device with
@@ -132,6 +216,60 @@ public:
     return m_device;
   }
 
+  /**
+   * Record completion of a command that executed on this CU
+   *
+   * @latency_ns: Time from command submission to completion
+   * @now_ns: Time of completion
+   */
+  void
+  record_completion(unsigned long latency_ns, unsigned long now_ns) const
+  {
+    m_occupancy.record_completion(latency_ns,now_ns);
+  }
+
+  /**
+   * Number of commands that keep this CU busy (see cu_occupancy)
+   */
+  size_t
+  get_pipeline_depth(size_t default_depth, size_t max_depth) const
+  {
+    return m_occupancy.get_pipeline_depth(default_depth,max_depth);
+  }
+
+  /**
+   * Share of pipeline depth of one of the contexts using this CU
+   */
+  size_t
+  get_pipeline_share(size_t default_depth, size_t max_depth) const
+  {
+    return m_occupancy.get_pipeline_share(default_depth,max_depth);
+  }
+
+  /**
+   * Track execution contexts scheduling work on this CU
+   *
+   * Execution contexts competing for the same CU share its pipeline
+   * depth.
+   */
+  void
+  add_context() const
+  {
+    m_occupancy.add_context();
+  }
+
+  void
+  remove_context() const
+  {
+    m_occupancy.remove_context();
+  }
+
+  unsigned int
+  get_num_contexts() const
+  {
+    return m_occupancy.get_num_contexts();
+  }
+
   /**
    * Static constructor for compute units.
    *
@@ -179,6 +317,9 @@ private:
   // Intersection of all argument masks
   mutable bool cached = false;
   mutable xclbin::memidx_bitmask_type m_memidx;
+
+  // Occupancy statistics shared by all execution contexts using this CU
+  mutable cu_occupancy m_occupancy;
 };
 
 } // xocl
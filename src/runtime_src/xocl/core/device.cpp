@@ -18,6 +18,7 @@
 #include "memory.h"
 #include "program.h"
 #include "compute_unit.h"
+#include "stream.h"
 
 #include "xocl/api/plugin/xdp/profile.h"
 #include "xocl/api/plugin/xdp/debug.h"
@@ -31,11 +32,17 @@
 #include <fstream>
 #include <sstream>
 #include <cstring>
+#include <mutex>
 
 namespace {
 
 static unsigned int uid_count = 0;
 
+// Programs may be loaded on multiple devices concurrently, but the
+// xdp plugin callbacks and scheduler initialization operate on
+// process wide state and are serialized through this mutex
+static std::mutex s_load_mutex;
+
 static
 std::string
 to_hex(void* addr)
@@ -109,29 +116,26 @@ buffer_resident_or_error(const xocl::memory* buffer, const xocl::device* device)
                              + std::to_string(device->get_uid()) + ")");
 }
 
-// Copy hbuf to ubuf if necessary
-static void
-sync_to_ubuf(xocl::memory* buffer, size_t offset, size_t size,
-             xrt::device* xdevice, const xrt::device::BufferObjectHandle& boh)
+// User buffer that is staged through the host backing of boh, or
+// nullptr if boh maps the user buffer
+static void*
+get_staged_ubuf(xocl::memory* buffer, xrt::device* xdevice, const xrt::device::BufferObjectHandle& boh)
 {
   if (buffer->is_aligned())
-    return;
+    return nullptr;
 
   auto ubuf = buffer->get_host_ptr();
-  if (ubuf) {
-    auto hbuf = xdevice->map(boh);
-    xdevice->unmap(boh);
-    if (ubuf!=hbuf) {
-      ubuf = static_cast<char*>(ubuf) + offset;
-      hbuf = static_cast<char*>(hbuf) + offset;
-      std::memcpy(ubuf,hbuf,size);
-    }
-  }
+  if (!ubuf)
+    return nullptr;
+
+  auto hbuf = xdevice->map(boh);
+  xdevice->unmap(boh);
+  return ubuf!=hbuf ? ubuf : nullptr;
 }
 
-// Copy ubuf to hbuf if necessary
+// Copy hbuf to ubuf if necessary
 static void
-sync_to_hbuf(xocl::memory* buffer, size_t offset, size_t size,
+sync_to_ubuf(xocl::memory* buffer, size_t offset, size_t size,
              xrt::device* xdevice, const xrt::device::BufferObjectHandle& boh)
 {
   if (buffer->is_aligned())
@@ -144,7 +148,7 @@ sync_to_hbuf(xocl::memory* buffer, size_t offset, size_t size,
     if (ubuf!=hbuf) {
       ubuf = static_cast<char*>(ubuf) + offset;
       hbuf = static_cast<char*>(hbuf) + offset;
-      std::memcpy(hbuf,ubuf,size);
+      std::memcpy(ubuf,hbuf,size);
     }
   }
 }
@@ -356,18 +360,83 @@ close_stream(xrt::device::stream_handle stream, int connidx)
   return m_xdevice->closeStream(stream);
 }
 
+namespace {
+
+// Non-blocking requests with a completion are tracked by the stream
+// pool of the device
+inline bool
+is_tracked(const xrt::device::stream_xfer_req* req)
+{
+  return (req->flags & CL_STREAM_NONBLOCKING) && !(req->flags & CL_STREAM_SILENT);
+}
+
+template <typename PtrType, typename XferType>
+ssize_t
+xfer_stream(xocl::stream_pool* pool, PtrType ptr, xrt::device::stream_xfer_req* req, XferType&& xfer)
+{
+  if (!is_tracked(req))
+    return xfer(ptr,req);
+
+  auto hreq = *req;
+  hreq.priv_data = pool->track(ptr,req->priv_data);
+  auto ret = xfer(ptr,&hreq);
+  if (ret < 0)
+    pool->untrack(hreq.priv_data);
+  return ret;
+}
+
+}
+
 ssize_t
 device::
 write_stream(xrt::device::stream_handle stream, const void* ptr, size_t size, xrt::device::stream_xfer_req* req)
 {
-  return m_xdevice->writeStream(stream, ptr, size, req);
+  return xfer_stream(get_stream_pool(),ptr,req,[this,stream,size](const void* p,xrt::device::stream_xfer_req* r) {
+      return m_xdevice->writeStream(stream,p,size,r);
+    });
 }
 
 ssize_t
 device::
 read_stream(xrt::device::stream_handle stream, void* ptr, size_t size, xrt::device::stream_xfer_req* req)
 {
-  return m_xdevice->readStream(stream, ptr, size, req);
+  return xfer_stream(get_stream_pool(),ptr,req,[this,stream,size](void* p,xrt::device::stream_xfer_req* r) {
+      return m_xdevice->readStream(stream,p,size,r);
+    });
+}
+
+size_t
+device::
+write_streams(xrt::device::stream_handle stream, size_t num, const void* const* ptrs, const size_t* sizes, xrt::device::stream_xfer_req* reqs)
+{
+  auto pool = get_stream_pool();
+  size_t posted = 0;
+  for (; posted < num; ++posted) {
+    auto size = sizes[posted];
+    auto ret = xfer_stream(pool,ptrs[posted],&reqs[posted],[this,stream,size](const void* p,xrt::device::stream_xfer_req* r) {
+        return m_xdevice->writeStream(stream,p,size,r);
+      });
+    if (ret < 0)
+      break;
+  }
+  return posted;
+}
+
+size_t
+device::
+read_streams(xrt::device::stream_handle stream, size_t num, void* const* ptrs, const size_t* sizes, xrt::device::stream_xfer_req* reqs)
+{
+  auto pool = get_stream_pool();
+  size_t posted = 0;
+  for (; posted < num; ++posted) {
+    auto size = sizes[posted];
+    auto ret = xfer_stream(pool,ptrs[posted],&reqs[posted],[this,stream,size](void* p,xrt::device::stream_xfer_req* r) {
+        return m_xdevice->readStream(stream,p,size,r);
+      });
+    if (ret < 0)
+      break;
+  }
+  return posted;
 }
 
 xrt::device::stream_buf
@@ -388,12 +457,32 @@ int
 device::
 poll_streams(xrt::device::stream_xfer_completions* comps, int min, int max, int* actual, int timeout)
 {
-  return m_xdevice->pollStreams(comps, min,max,actual,timeout);
+  int num = 0;
+  auto ret = m_xdevice->pollStreams(comps, min,max,&num,timeout);
+  get_stream_pool()->complete(comps,num);
+  if (actual)
+    *actual = num;
+  return ret;
+}
+
+stream_mem*
+device::
+create_stream_buf(size_t size)
+{
+  return get_stream_pool()->alloc(size);
+}
+
+void
+device::
+release_stream_buf(stream_mem* mem)
+{
+  get_stream_pool()->release(mem);
 }
 
 device::
 device(platform* pltf, xrt::device* xdevice)
   : m_uid(uid_count++), m_platform(pltf), m_xdevice(xdevice)
+  , m_stream_pool(std::make_shared<stream_pool>(this))
 {
   XOCL_DEBUG(std::cout,"xocl::device::device(",m_uid,")\n");
 }
@@ -402,6 +491,7 @@ device::
 device(platform* pltf, xrt::device* hw_device, xrt::device* swem_device, xrt::device* hwem_device)
   : m_uid(uid_count++), m_platform(pltf), m_xdevice(nullptr)
   , m_hw_device(hw_device), m_swem_device(swem_device), m_hwem_device(hwem_device)
+  , m_stream_pool(std::make_shared<stream_pool>(this))
 {
   XOCL_DEBUG(std::cout,"xocl::device::device(",m_uid,")\n");
 
@@ -462,6 +552,7 @@ device(device* parent, const compute_unit_vector_type& cus)
   , m_hwem_device(parent->m_hwem_device)
   , m_parent(parent)
   , m_computeunits(std::move(cus))
+  , m_stream_pool(parent->m_stream_pool)
 {
   XOCL_DEBUG(std::cout,"xocl::device::device(",m_uid,")\n");
 
@@ -477,6 +568,11 @@ device::
 ~device()
 {
   XOCL_DEBUG(std::cout,"xocl::device::~device(",m_uid,")\n");
+  if (m_xdevice && !m_parent.get())
+    XOCL_DEBUG(std::cout,"xocl::device(",m_uid,") unaligned host pointer bytes staged to device: "
+               ,m_xdevice->getStagedBytes(xrt::hal::device::direction::HOST2DEVICE)
+               ,", from device: "
+               ,m_xdevice->getStagedBytes(xrt::hal::device::direction::DEVICE2HOST),"\n");
 }
 
 void
@@ -839,6 +935,60 @@ unmap_buffer(memory* buffer, void* mapped_ptr)
   }
 }
 
+void
+device::
+migrate_buffers(const std::vector<memory*>& buffers,cl_mem_migration_flags flags)
+{
+  auto xdevice = get_xrt_device();
+  std::vector<xrt::device::BufferObjectHandle> bos;
+  std::vector<memory*> synced;
+  bos.reserve(buffers.size());
+  synced.reserve(buffers.size());
+
+  // Buffers with unaligned user pointers are staged individually,
+  // all other buffers are synced in one submission
+  auto sync_all = [&](xrt::hal::device::direction dir) {
+    std::vector<xrt::device::BufferObjectHandle> direct;
+    direct.reserve(bos.size());
+    for (size_t idx=0; idx<synced.size(); ++idx) {
+      if (auto ubuf = get_staged_ubuf(synced[idx],xdevice,bos[idx]))
+        xdevice->syncStaged(bos[idx],ubuf,synced[idx]->get_size(),0,dir);
+      else
+        direct.push_back(bos[idx]);
+    }
+    if (!direct.empty())
+      xdevice->sync(direct,dir,false);
+  };
+
+  // Support clEnqueueMigrateMemObjects device->host
+  if (flags & CL_MIGRATE_MEM_OBJECT_HOST) {
+    for (auto buffer : buffers) {
+      buffer_resident_or_error(buffer,this);
+      auto boh = buffer->get_buffer_object_or_error(this);
+      if (!buffer->is_p2p_memory()) {
+        bos.push_back(boh);
+        synced.push_back(buffer);
+      }
+    }
+    sync_all(xrt::hal::device::direction::DEVICE2HOST);
+    return;
+  }
+
+  // Host to device for kernel args and clEnqueueMigrateMemObjects
+  for (auto buffer : buffers) {
+    auto boh = buffer->get_buffer_object(this);
+    if (!buffer->is_p2p_memory()) {
+      bos.push_back(boh);
+      synced.push_back(buffer);
+    }
+  }
+  sync_all(xrt::hal::device::direction::HOST2DEVICE);
+
+  // Now buffers are resident on this device and migrate is complete
+  for (auto buffer : buffers)
+    buffer->set_resident(this);
+}
+
 void
 device::
 migrate_buffer(memory* buffer,cl_mem_migration_flags flags)
@@ -849,8 +999,10 @@ migrate_buffer(memory* buffer,cl_mem_migration_flags flags)
     auto boh = buffer->get_buffer_object_or_error(this);
     auto xdevice = get_xrt_device();
     if(!buffer->is_p2p_memory()){
-      xdevice->sync(boh,buffer->get_size(),0,xrt::hal::device::direction::DEVICE2HOST,false);
-      sync_to_ubuf(buffer,0,buffer->get_size(),xdevice,boh);
+      if (auto ubuf = get_staged_ubuf(buffer,xdevice,boh))
+        xdevice->syncStaged(boh,ubuf,buffer->get_size(),0,xrt::hal::device::direction::DEVICE2HOST);
+      else
+        xdevice->sync(boh,buffer->get_size(),0,xrt::hal::device::direction::DEVICE2HOST,false);
     }
     return;
   }
@@ -862,8 +1014,10 @@ migrate_buffer(memory* buffer,cl_mem_migration_flags flags)
 
   if(!buffer->is_p2p_memory()){
     // Sync from host to device to make make buffer resident of this device
-    sync_to_hbuf(buffer,0,buffer->get_size(),xdevice,boh);
-    xdevice->sync(boh,buffer->get_size(), 0, xrt::hal::device::direction::HOST2DEVICE,false);
+    if (auto ubuf = get_staged_ubuf(buffer,xdevice,boh))
+      xdevice->syncStaged(boh,ubuf,buffer->get_size(),0,xrt::hal::device::direction::HOST2DEVICE);
+    else
+      xdevice->sync(boh,buffer->get_size(), 0, xrt::hal::device::direction::HOST2DEVICE,false);
   }
   // Now buffer is resident on this device and migrate is complete
   buffer->set_resident(this);
@@ -1119,17 +1273,26 @@ load_program(program* program)
   if (m_active && !std::getenv("XCL_CONFORMANCE"))
     throw xocl::error(CL_OUT_OF_RESOURCES,"program already loaded on device");
 
+  // Phases of program load are logged to the timeline per device so
+  // that concurrent loads on multiple devices can be told apart
+  auto device_name = get_unique_name();
+  profile::device_phase_logger load_logger(device_name,"load_program");
+
   m_xclbin = program->get_xclbin(this);
   auto binary = m_xclbin.binary(); // ::xclbin::binary
 
-  // Kernel debug is enabled based on if there is debug_data in the
-  // binary it does not have sdaccel.ini attribute. If there is
-  // debug_data then make sure xdp is loaded
-  if (binary.debug_data().first)
-    xrt::hal::load_xdp();
+  {
+    std::lock_guard<std::mutex> lk(s_load_mutex);
+
+    // Kernel debug is enabled based on if there is debug_data in the
+    // binary it does not have sdaccel.ini attribute. If there is
+    // debug_data then make sure xdp is loaded
+    if (binary.debug_data().first)
+      xrt::hal::load_xdp();
 
-  xocl::debug::reset(m_xclbin);
-  xocl::profile::reset(m_xclbin);
+    xocl::debug::reset(m_xclbin);
+    xocl::profile::reset(m_xclbin);
+  }
 
   // validatate target binary for target device and set the xrt device
   // according to target binary this is likely temp code that is
@@ -1149,6 +1312,7 @@ load_program(program* program)
   // reclocking - old
   // This is obsolete and will be removed soon (pending verify.xclbin updates)
   if (xrt::config::get_frequency_scaling()) {
+    profile::device_phase_logger reclock_logger(device_name,"reclock");
     const clock_freq_topology* freqs = m_xclbin.get_clk_freq_topology();
     if(!freqs) {
       if (!is_sw_emulation())
@@ -1160,7 +1324,7 @@ load_program(program* program)
         throw xocl::error(CL_INVALID_PROGRAM,"Too many kernel clocks");
       for (auto& clock : kclocks) {
         if (idx == 0) {
-          std::string device_name = get_unique_name();
+          std::lock_guard<std::mutex> lk(s_load_mutex);
           profile::set_kernel_clock_freq(device_name, clock.frequency);
         }
         target_freqs[idx++] = clock.frequency;
@@ -1183,6 +1347,7 @@ load_program(program* program)
 
   // programmming
   if (xrt::config::get_xclbin_programing()) {
+    profile::device_phase_logger xclbin_logger(device_name,"loadXclBin");
     auto header = reinterpret_cast<const xclBin *>(binary_data.first);
     auto xbrv = xdevice->loadXclBin(header);
     if (xbrv.valid() && xbrv.get()){
@@ -1218,11 +1383,16 @@ load_program(program* program)
   }
 
   m_active = program;
-  profile::add_to_active_devices(get_unique_name());
 
   // In order to use virtual CUs (KDMA) we must open a virtual context
-  m_xdevice->acquire_cu_context(-1,true);
+  {
+    profile::device_phase_logger context_logger(device_name,"acquire_cu_context");
+    m_xdevice->acquire_cu_context(-1,true);
+  }
 
+  std::lock_guard<std::mutex> lk(s_load_mutex);
+  profile::add_to_active_devices(get_unique_name());
+  profile::device_phase_logger scheduler_logger(device_name,"init_scheduler");
   init_scheduler(this);
 }
 
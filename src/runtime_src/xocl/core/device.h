@@ -33,6 +33,8 @@ namespace xrt { class device; }
 
 namespace xocl {
 
+class stream_pool;
+
 class device : public refcount, public _cl_device_id
 {
 public:
@@ -405,6 +407,16 @@ public:
   void
   migrate_buffer(memory* buffer,cl_mem_migration_flags flags);
 
+  /**
+   * Migrate multiple buffers to or from this device
+   *
+   * Same as migrate_buffer() for each buffer, but all buffers are
+   * transferred with one DMA submission.  The buffers should be in
+   * the same memory bank.
+   */
+  void
+  migrate_buffers(const std::vector<memory*>& buffers,cl_mem_migration_flags flags);
+
   /**
    * Write data size bytes to buffer at specified offset
    *
@@ -500,12 +512,41 @@ public:
   ssize_t
   read_stream(xrt::device::stream_handle stream, void* ptr, size_t size, xrt::device::stream_xfer_req* req);
 
+  /**
+   * Post @num write requests to a stream
+   *
+   * Requests are posted in order until one fails.
+   *
+   * @return
+   *   Number of requests posted
+   */
+  size_t
+  write_streams(xrt::device::stream_handle stream, size_t num, const void* const* ptrs, const size_t* sizes, xrt::device::stream_xfer_req* reqs);
+
+  /**
+   * Post @num read requests to a stream, see write_streams()
+   */
+  size_t
+  read_streams(xrt::device::stream_handle stream, size_t num, void* const* ptrs, const size_t* sizes, xrt::device::stream_xfer_req* reqs);
+
   xrt::device::stream_buf
   alloc_stream_buf(size_t size, xrt::device::stream_buf_handle* handle);
 
   int
   free_stream_buf(xrt::device::stream_buf_handle handle);
 
+  /**
+   * Get a stream buffer from the stream buffer pool of this device
+   */
+  stream_mem*
+  create_stream_buf(size_t size);
+
+  /**
+   * Return a stream buffer to the pool, see stream_pool::release()
+   */
+  void
+  release_stream_buf(stream_mem* mem);
+
   int
   poll_streams(xrt::device::stream_xfer_completions* comps, int min, int max, int* actual, int timeout);
 
@@ -745,6 +786,12 @@ private:
   void
   track(const memory* mem);
 
+  stream_pool*
+  get_stream_pool() const
+  {
+    return m_stream_pool.get();
+  }
+
   /**
    * Allocate device side buffer buffer object on specified bank
    *
@@ -806,6 +853,10 @@ private:
   // CUs populated during load_program or by sub device contructor.
   compute_unit_vector_type m_computeunits;
 
+  // Stream buffers and non-blocking stream requests of the physical
+  // device, created with the device and shared with sub devices
+  std::shared_ptr<stream_pool> m_stream_pool;
+
   // Caching.  Purely implementation detail (-2 => not initialized)
   mutable memidx_type m_cu_memidx = -2;
 };
@@ -49,6 +49,7 @@ to_string(cl_int status)
 
 static xocl::event::event_callback_list sg_constructor_callbacks;
 static xocl::event::event_callback_list sg_destructor_callbacks;
+static xocl::event::chain_callback_list sg_chain_callbacks;
 } // namespace
 
 namespace xocl {
@@ -146,6 +147,14 @@ bool
 event::
 queue(bool blocking_submit)
 {
+  // Events queued while the command queue is recording are added to
+  // the graph and never submitted
+  if (is_hard() && m_command_queue->record(this)) {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_recorded = true;
+    return true;
+  }
+
   bool queued = false;
   {
     std::lock_guard<std::mutex> lk(m_mutex);
@@ -249,6 +258,8 @@ wait() const
 {
   XOCL_DEBUG(std::cout,"xocl::event::wait(",m_uid,")\n");
   std::unique_lock<std::mutex> lk(m_mutex);
+  if (m_recorded)
+    throw xocl::error(CL_INVALID_OPERATION,"event(" + get_suid() + ") is recorded in a graph and cannot be waited on");
   while (m_status>0)  // (<0 => aborted) (==0 => CL_COMPLETE)
     m_event_complete.wait(lk);
 }
@@ -314,6 +325,13 @@ register_destructor_callbacks(event_callback_type&& aCallback)
   sg_destructor_callbacks.emplace_back(std::move(aCallback));
 }
 
+void
+event::
+register_chain_callbacks(chain_callback_type&& aCallback)
+{
+  sg_chain_callbacks.emplace_back(std::move(aCallback));
+}
+
 
 void
 event::
@@ -322,11 +340,16 @@ chain(event* ev)
   // assert(ev is locked because it is being enqueued || called from "ev" event ctor);
   assert(ev->m_status == -1); // ev is being enq'ed or ctored
 
-  std::lock_guard<std::mutex> lk(m_mutex);
-  if (m_status == CL_COMPLETE)
-    return;
-  m_chain.push_back(ev);
-  ++ev->m_wait_count;
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    if (m_status == CL_COMPLETE)
+      return;
+    m_chain.push_back(ev);
+    ++ev->m_wait_count;
+  }
+
+  for (auto& cb : sg_chain_callbacks)
+    cb(this,ev);
 }
 
 bool
@@ -24,6 +24,8 @@
 #include "xocl/core/debug.h"
 #include "xocl/core/error.h"
 #include "xocl/core/execution_context.h"
+#include "xocl/core/pool.h"
+#include "xocl/core/small_function.h"
 
 #include "xrt/config.h"
 
@@ -42,23 +44,26 @@ namespace xocl {
  * execution.  An event is triggered by an event scheduler
  * after all its dependencies have been resolved.
  */
-class event : public refcount, public _cl_event
+class event : public refcount, public _cl_event, public pooled
 {
   using callback_function_type = std::function<void(cl_int)>;
   using callback_list = std::vector<callback_function_type>;
 
   friend class command_queue;
+  friend class graph;
 
 public:
-  using event_vector_type = std::vector<ptr<event>>;
+  using event_vector_type = std::vector<ptr<event>,pool_allocator<ptr<event>>>;
   using event_iterator_type = ptr_iterator<event_vector_type::iterator>;
 
   using event_callback_type = std::function<void(event*)>;
   using event_callback_list = std::vector<event_callback_type>;
+  using chain_callback_type = std::function<void(event*,event*)>;
+  using chain_callback_list = std::vector<chain_callback_type>;
 
-  using action_enqueue_type = std::function<void (event*)>;
-  using action_profile_type = std::function<void (event*, cl_int, const std::string&)>;
-  using action_debug_type = std::function<void (event*)>;
+  using action_enqueue_type = small_function<void (event*)>;
+  using action_profile_type = small_function<void (event*, cl_int, const std::string&)>;
+  using action_debug_type = small_function<void (event*)>;
 
   event(command_queue* cq, context* ctx, cl_command_type cmd);
   event(command_queue* cq, context* ctx, cl_command_type cmd, cl_uint num_deps, const cl_event* deps);
@@ -296,6 +301,10 @@ public:
 
   /**
    * Wait for this event to complete
+   *
+   * @throws
+   *   xocl::error CL_INVALID_OPERATION if the event was recorded
+   *   in a graph, recorded events never complete
    */
   void
   wait() const;
@@ -390,6 +399,14 @@ public:
    */
   static void register_destructor_callbacks(event_callback_type&& aCallback);
 
+  /**
+   * Register callback function for chaining of events
+   *
+   * Callbacks are called with the event and the event that waits on
+   * it, after the latter has been added to the chain
+   */
+  static void register_chain_callbacks(chain_callback_type&& aCallback);
+
 protected:
   /**
    * Add argument event to event chain
@@ -508,6 +525,7 @@ private:
 
   cl_int m_status = -1;
   cl_command_type m_command_type = 0;
+  bool m_recorded = false;
   mutable std::mutex m_mutex;
   mutable std::condition_variable m_event_complete;
   mutable std::condition_variable m_event_submitted;
@@ -20,10 +20,12 @@
 
 #include "xrt/scheduler/command.h"
 #include "xrt/scheduler/scheduler.h"
+#include "xrt/util/time.h"
 
 #include "driver/common/xclbin_parser.h"
 
 #include "impl/spir.h"
+#include "xrt/config.h"
 
 #include <iostream>
 #include <fstream>
@@ -156,7 +158,7 @@ struct execution_context::start_kernel : xrt::command
 {
 public:
   start_kernel(xrt::device* xdevice, xocl::execution_context* ec)
-    : xrt::command(xdevice,ERT_START_KERNEL), m_ec(ec)
+    : xrt::command(xdevice,ERT_START_KERNEL), m_ec(ec), m_submit_ns(xrt::time_ns())
   {}
   virtual void start() const
   {
@@ -168,6 +170,7 @@ public:
     m_ec->done(this);
   }
   mutable xocl::execution_context* m_ec;
+  unsigned long m_submit_ns;
 };
 
 struct execution_context::start_kernel_conformance : start_kernel
@@ -182,8 +185,9 @@ struct execution_context::start_kernel_conformance : start_kernel
   }
 };
 
+template <typename RegmapType>
 static int
-fill_regmap(execution_context::regmap_type& regmap, size_t offset,
+fill_regmap(RegmapType& regmap, size_t offset,
             const void* data, const size_t size,
             const xocl::kernel::argument::arginfo_range_type& arginforange)
 {
@@ -192,7 +196,7 @@ fill_regmap(execution_context::regmap_type& regmap, size_t offset,
   // size is less than sizeof(uint32_t). Fill host_data
   // conservative with an additional sizeof(uint32_t) bytes.
   const char* cdata = reinterpret_cast<const char*>(data);
-  std::vector<char> host_data(cdata,cdata+size);
+  std::vector<char,pool_allocator<char>> host_data(cdata,cdata+size);
   host_data.resize(size+sizeof(uint32_t));
 
   // For each component of the argument
@@ -246,6 +250,15 @@ execution_context(device* device
   XOCL_DEBUGF("execution_context(%d) has dataflow(%d)\n",m_uid,m_dataflow);
 }
 
+execution_context::
+~execution_context()
+{
+  // A context that is released before all its work completed, e.g.
+  // when its event is aborted, must not hold on to its share of the
+  // CUs' pipeline depth
+  unregister_compute_units();
+}
+
 void
 execution_context::
 add_compute_units(device* device)
@@ -282,20 +295,6 @@ execution_context::
 write(const command_type& cmd)
 {
   auto& packet = cmd->get_packet();
-  auto data_size = packet.size() - 1; // subtract header
-
-  // Construct command header
-  auto epacket = xrt::command_cast<ert_packet*>(cmd.get());
-  epacket->count = data_size;
-
-  // Max number size is 4KB
-  auto size = packet.bytes();
-  if (size > 0x1000) {
-    throw xrt::error(CL_OUT_OF_RESOURCES
-                     , std::string("control buffer size '")
-                     + std::to_string(size/static_cast<double>(0x400))
-                     + std::string("KB' exceeds maximum value of 4KB"));
-  }
 
   static std::string debug_fnm = value_or_empty(std::getenv("MBS_PRINT_REGMAP"));
   if (!debug_fnm.empty()) {
@@ -340,6 +339,40 @@ encode_compute_units(packet_type& packet)
   epacket->extra_cu_masks = no_of_masks-1;
 }
 
+void
+execution_context::
+init_cu_affinity()
+{
+  if (m_cu_affinity_init)
+    return;
+  m_cu_affinity_init = true;
+
+  size_t preferred = 0;
+  xrt::command::cu_mask_type mask {{0}};
+  for (auto cu : m_cus) {
+    bool match = true;
+    for (auto& arg : m_kernel_args) {
+      auto mem = arg->get_memory_object();
+      if (!mem || arg->is_printf())
+        continue;
+      auto memidx = mem->get_memidx();
+      if (memidx>=0 && !cu->get_memidx(arg->get_argidx()).test(memidx)) {
+        match = false;
+        break;
+      }
+    }
+    if (match) {
+      auto cu_idx = cu->get_index();
+      mask[cu_idx/32] |= 1 << (cu_idx%32);
+      ++preferred;
+    }
+  }
+
+  // No hint unless affinity narrows the CUs
+  if (preferred && preferred < m_cus.size())
+    m_cu_affinity = mask;
+}
+
 const compute_unit*
 execution_context::
 get_compute_unit(unsigned int cu_idx) const
@@ -385,10 +418,23 @@ start()
 
   // Construct command packet and send to hardware
   auto cmd = conformance::on()
-    ? std::make_shared<start_kernel_conformance>(xdevice,this)
-    : std::make_shared<start_kernel>(xdevice,this);
+    ? std::allocate_shared<start_kernel_conformance>(pool_allocator<start_kernel_conformance>(),xdevice,this)
+    : std::allocate_shared<start_kernel>(pool_allocator<start_kernel>(),xdevice,this);
   ++m_active;
-  auto& packet = cmd->get_packet();
+
+  encode(cmd->get_packet());
+  init_cu_affinity();
+  cmd->set_cu_affinity(m_cu_affinity);
+
+  // send command to mbs
+  write(cmd);
+}
+
+void
+execution_context::
+encode(packet_type& packet)
+{
+  auto xdevice = m_device->get_xrt_device();
 
   // Encode CUs in cu bitmasks with bits in position according to the
   // CUs that can be used
@@ -499,14 +545,159 @@ start()
       fill_regmap(regmap,offset,&printf_buffer_addr,sizeof(printf_buffer_addr),arg->get_arginfo_range());
   }
 
-  // send command to mbs
-  write(cmd);
+  // Construct command header
+  auto epacket = reinterpret_cast<ert_packet*>(packet.data());
+  epacket->count = packet.size() - 1; // subtract header
+
+  // Max number size is 4KB
+  auto size = packet.bytes();
+  if (size > 0x1000) {
+    throw xrt::error(CL_OUT_OF_RESOURCES
+                     , std::string("control buffer size '")
+                     + std::to_string(size/static_cast<double>(0x400))
+                     + std::string("KB' exceeds maximum value of 4KB"));
+  }
+}
+
+std::vector<execution_context::command_type>
+execution_context::
+encode_commands(const std::function<command_type()>& create)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (m_active || m_done)
+    throw xocl::error(CL_INVALID_OPERATION,"execution context " + std::to_string(m_uid) + " already started");
+
+  init_cu_affinity();
+  std::vector<command_type> commands;
+  commands.reserve(get_num_work_groups());
+  while (!m_done) {
+    auto cmd = create();
+    encode(cmd->get_packet());
+    cmd->set_cu_affinity(m_cu_affinity);
+    commands.push_back(std::move(cmd));
+    update_work();
+  }
+  return commands;
+}
+
+const xocl::kernel::argument*
+execution_context::
+find_argument(unsigned long argidx) const
+{
+  for (auto& arg : m_kernel_args)
+    if (arg->is_indexed() && arg->get_argidx()==argidx)
+      return arg.get();
+  return nullptr;
+}
+
+void
+execution_context::
+validate_argument(unsigned long argidx, size_t size) const
+{
+  auto arg = find_argument(argidx);
+  if (!arg || arg->get_address_space()!=SPIR_ADDRSPACE_PRIVATE)
+    throw xocl::error(CL_INVALID_ARG_INDEX,"argument " + std::to_string(argidx)
+                      + " of kernel '" + m_kernel->get_name() + "' is not a scalar argument");
+  if (arg->get_size()!=size)
+    throw xocl::error(CL_INVALID_ARG_SIZE,"argument " + std::to_string(argidx)
+                      + " of kernel '" + m_kernel->get_name() + "' has size " + std::to_string(arg->get_size()));
+}
+
+void
+execution_context::
+encode_argument(word_type* packet, unsigned long argidx, const void* value) const
+{
+  auto arg = find_argument(argidx);
+  assert(arg);
+
+  // Register map starts past header and cu masks
+  auto epacket = reinterpret_cast<ert_start_kernel_cmd*>(packet);
+  size_t offset = 2 + epacket->extra_cu_masks;
+  fill_regmap(packet,offset,value,arg->get_size(),arg->get_arginfo_range());
+}
+
+void
+execution_context::
+register_compute_units()
+{
+  if (m_cu_registered)
+    return;
+  for (auto cu : m_cus)
+    cu->add_context();
+  m_cu_registered = true;
+}
+
+void
+execution_context::
+unregister_compute_units()
+{
+  if (!m_cu_registered)
+    return;
+  for (auto cu : m_cus)
+    cu->remove_context();
+  m_cu_registered = false;
+}
+
+size_t
+execution_context::
+get_window(size_t active) const
+{
+  static bool adaptive = xrt::config::get_cu_window() != "static";
+  size_t default_depth = m_dataflow ? 20 : 2;
+  if (!adaptive)
+    return default_depth*m_cus.size();
+
+  // A regular CU runs one command at a time, so beyond one running and
+  // one queued command, extra depth only helps hide host turnaround.
+  // Dataflow CUs overlap invocations and can absorb more.
+  size_t max_depth = m_dataflow ? 20 : 4;
+
+  // Each CU's pipeline depth is shared fairly among the contexts that
+  // compete for it, but every CU gets at least one command
+  size_t window = 0;
+  for (auto cu : m_cus)
+    window += cu->get_pipeline_share(default_depth,max_depth);
+
+  // Don't grow the window if the scheduler already has more commands
+  // than all device CUs together can keep busy; commands beyond that
+  // only wait in the command queue and block other kernels.  The
+  // capacity is at least the window, so only compute it when the
+  // scheduler is that busy.
+  auto outstanding = m_device->get_xrt_device()->get_num_outstanding();
+  if (outstanding < window)
+    return window;
+
+  size_t capacity = 0;
+  for (auto& cu : m_device->get_cus())
+    capacity += cu->get_pipeline_depth(default_depth,max_depth);
+  if (outstanding >= capacity)
+    window = std::min(window,std::max<size_t>(1,active));
+
+  return window;
 }
 
 bool
 execution_context::
-done(const xrt::command*)
+done(const xrt::command* cmd)
 {
+  // The scheduler leaves only the bit of the CU that executed the
+  // command in the cu mask.  Use it to update the CU's statistics.
+  auto skcmd = static_cast<const start_kernel*>(cmd);
+  auto epacket = xrt::command_cast<ert_start_kernel_cmd*>(const_cast<xrt::command*>(cmd));
+  for (unsigned int mask_idx=0; mask_idx<=epacket->extra_cu_masks; ++mask_idx) {
+    auto mask = (*cmd)[1+mask_idx];
+    if (!mask)
+      continue;
+    if (mask & (mask-1))
+      break; // more than one bit set, cu is unknown
+    auto cu_idx = mask_idx*32 + __builtin_ctz(mask);
+    if (auto cu = get_compute_unit(cu_idx)) {
+      auto now = xrt::time_ns();
+      cu->record_completion(now - skcmd->m_submit_ns, now);
+    }
+    break;
+  }
+
   // Care must be taken not to mark event complete and later reference
   // any data members of context which is owned (and deleted) with event
   bool ctx_done = false;
@@ -519,6 +710,7 @@ done(const xrt::command*)
   // Only one thread will be able to set local ctx_done to true, so it's
   // safe to proceed without exclusive lock (mutex is a data member)
   if (ctx_done) {
+    unregister_compute_units();
     m_event->set_status(CL_COMPLETE);
     return true;
   }
@@ -544,15 +736,17 @@ execute()
   if (m_done)
     return true;
 
+  register_compute_units();
+
   // Schedule workgroups.  But don't blindly schedule all workgroups
   // because that would fill the command queue with commands that
   // compete for same CUs and block (CQ full) other kernel calls that
   // may want to use other CUs.
   //
   // In order to keep scheduler busy, we need more than just one
-  // workgroup at a time, so here we try to ensure that the scheduled
-  // commands at any given time is twice the number of available CUs.
-  auto limit = m_dataflow ? 20*m_cus.size() : 2*m_cus.size();
+  // workgroup at a time, so here we try to keep a window of commands
+  // in flight sized by the occupancy of the CUs (see get_window).
+  auto limit = get_window(m_active);
   for (size_t i=m_active; !m_done && i<limit; ++i) {
     start();
     update_work();
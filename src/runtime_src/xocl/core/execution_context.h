@@ -20,10 +20,12 @@
 #include "xocl/config.h"
 #include "xocl/core/kernel.h"
 #include "xocl/core/compute_unit.h"
+#include "xocl/core/pool.h"
 
 #include "xrt/scheduler/command.h"
 #include <mutex>
 #include <array>
+#include <functional>
 #include <algorithm>
 #include <iostream>
 #include <cassert>
@@ -49,7 +51,7 @@ class event;
  *
  * Command ownership is managed by execution context.
  */
-class execution_context
+class execution_context : public pooled
 {
   struct start_kernel;
   struct start_kernel_conformance;
@@ -91,18 +93,28 @@ private:
   // Kernel state
   using argument_vector_type = std::vector<std::unique_ptr<xocl::kernel::argument>>;
   using argument_iterator_type = argument_vector_type::const_iterator;
-  argument_vector_type m_kernel_args;
+  std::vector<std::unique_ptr<xocl::kernel::argument>,pool_allocator<std::unique_ptr<xocl::kernel::argument>>> m_kernel_args;
 
   bool m_dataflow = false;
 
   // The context maintains a list of kernel compute units represented
   // by xcl::cu.  These cus (their base addresses) are used in the command
   // that starts the mbs.
-  std::vector<const compute_unit*> m_cus;
+  std::vector<const compute_unit*,pool_allocator<const compute_unit*>> m_cus;
+
+  // CUs whose memory connectivity matches the banks of the buffer
+  // arguments, passed as a hint to the scheduler.  Computed on first
+  // start since buffers are assigned banks at enqueue.
+  xrt::command::cu_mask_type m_cu_affinity {{0}};
+  bool m_cu_affinity_init = false;
 
   // Number of active start_kernel commands in this context
   size_t m_active = 0;
 
+  // Set when this context has registered itself with its CUs as
+  // competing for their pipeline depth
+  bool m_cu_registered = false;
+
   // Flag to indicate the execution context has no more work
   // to be scheduled
   bool m_done = false;
@@ -118,9 +130,24 @@ private:
   bool
   write(const command_type& cmd);
 
+  /**
+   * Encode the current workgroup into a command packet
+   */
+  void
+  encode(packet_type& packet);
+
+  /**
+   * Find bound indexed argument
+   */
+  const xocl::kernel::argument*
+  find_argument(unsigned long argidx) const;
+
   void
   encode_compute_units(packet_type& pkt);
 
+  void
+  init_cu_affinity();
+
   /**
    * Update workgroup accounting.
    */
@@ -130,6 +157,15 @@ private:
   void
   start();
 
+  /**
+   * Register or unregister this context with its CUs
+   */
+  void
+  register_compute_units();
+
+  void
+  unregister_compute_units();
+
   /**
    * Callback to indicate a start_kernel command is done.
    *
@@ -158,6 +194,8 @@ public:
                     ,const size_t* global_work_size
                     ,const size_t* local_work_size);
 
+  ~execution_context();
+
   unsigned long
   get_uid() const
   {
@@ -250,6 +288,50 @@ public:
   bool
   execute();
 
+  /**
+   * Encode commands for all workgroups without scheduling them
+   *
+   * Used by xocl::graph to build the commands of a recorded kernel
+   * once.  The context is done upon return and cannot be executed.
+   *
+   * @param create
+   *   Function that creates the command for a workgroup
+   * @return
+   *   The encoded commands in workgroup order
+   */
+  std::vector<command_type>
+  encode_commands(const std::function<command_type()>& create);
+
+  /**
+   * Max number of start_kernel commands this context should have
+   * in flight
+   *
+   * Also used by xocl::graph to window the replayed commands of a
+   * recorded context.
+   *
+   * @param active
+   *   Number of commands of this context currently in flight
+   */
+  size_t
+  get_window(size_t active) const;
+
+  /**
+   * Check that an argument can be encoded by encode_argument
+   *
+   * @throws
+   *   xocl::error CL_INVALID_ARG_INDEX if argidx is not a scalar
+   *   argument, CL_INVALID_ARG_SIZE if size doesn't match argument
+   */
+  void
+  validate_argument(unsigned long argidx, size_t size) const;
+
+  /**
+   * Encode a new value of a scalar argument into a packet encoded
+   * by this context.  The argument must have been validated.
+   */
+  void
+  encode_argument(word_type* packet, unsigned long argidx, const void* value) const;
+
 private:
   // Call back for start_kernel_conformance comands
   bool
@@ -0,0 +1,358 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "graph.h"
+#include "event.h"
+#include "command_queue.h"
+#include "device.h"
+#include "execution_context.h"
+#include "error.h"
+
+#include <algorithm>
+#include <iostream>
+
+namespace xocl {
+
+struct graph::node
+{
+  ptr<event> m_event;
+  cl_command_type m_command_type = 0;
+
+  // Indices of nodes this node depends on
+  std::vector<size_t> m_preds;
+
+  // Set if no other node depends on this node
+  bool m_sink = true;
+
+  // Enqueue action of recorded event, shared by all replays
+  std::shared_ptr<event::action_enqueue_type> m_action;
+
+  // Commands of a recorded kernel, nullptr for other nodes
+  std::shared_ptr<kernel_node> m_kernel;
+
+  node(event* ev)
+    : m_event(ev), m_command_type(ev->get_command_type())
+  {}
+};
+
+// Kernel command owned by a graph.  Completion is reported to the
+// kernel node rather than to the execution context that encoded it.
+struct graph::kernel_command : xrt::command
+{
+  kernel_command(xrt::device* xdevice, kernel_node* kn)
+    : xrt::command(xdevice,ERT_START_KERNEL), m_node(kn)
+  {}
+
+  virtual void
+  done() const;
+
+  kernel_node* m_node;
+};
+
+struct graph::kernel_node
+{
+  using word_type = execution_context::word_type;
+  using command_type = execution_context::command_type;
+
+  // Recorded execution context that encoded the commands
+  execution_context* m_ec;
+
+  // Commands, one per workgroup, and their packets as encoded.  The
+  // scheduler updates a packet as it executes the command, so the
+  // packets are restored before every replay.
+  std::vector<command_type> m_commands;
+  std::vector<std::vector<word_type>> m_packets;
+
+  // Replay event of the current replay, number of its commands that
+  // have yet to complete, index of next command to submit, and number
+  // of submitted commands that have yet to complete
+  event* m_replay = nullptr;
+  size_t m_pending = 0;
+  size_t m_next = 0;
+  size_t m_inflight = 0;
+  std::mutex m_mutex;
+
+  kernel_node(device* device, execution_context* ec)
+    : m_ec(ec)
+  {
+    auto xdevice = device->get_xrt_device();
+    m_commands = ec->encode_commands
+      ([xdevice,this]() { return std::make_shared<kernel_command>(xdevice,this); });
+    for (auto& cmd : m_commands) {
+      auto& packet = cmd->get_packet();
+      m_packets.emplace_back(packet.data(),packet.data()+packet.size());
+    }
+  }
+
+  // Submit commands to the scheduler until the window of the recorded
+  // context is full, the same window that limits commands in flight
+  // when the context itself executes
+  void
+  submit()
+  {
+    while (true) {
+      size_t idx = 0;
+      {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (m_next==m_commands.size() || m_inflight>=m_ec->get_window(m_inflight))
+          return;
+        idx = m_next++;
+        ++m_inflight;
+      }
+
+      auto& cmd = m_commands[idx];
+      auto& packet = m_packets[idx];
+      std::copy(packet.begin(),packet.end(),cmd->get_packet().data());
+      cmd->execute();
+    }
+  }
+
+  void
+  launch(event* ev, const std::vector<arg_update>& updates)
+  {
+    ev->set_status(CL_RUNNING);
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+
+      // Updates are applied to the recorded packets so that they
+      // remain in effect for subsequent replays
+      for (auto& update : updates)
+        for (auto& packet : m_packets)
+          m_ec->encode_argument(packet.data(),update.argidx,update.value.data());
+
+      m_replay = ev;
+      m_pending = m_commands.size();
+      m_next = 0;
+      m_inflight = 0;
+    }
+
+    if (m_commands.empty()) {
+      ev->set_status(CL_COMPLETE);
+      return;
+    }
+
+    submit();
+  }
+
+  void
+  done()
+  {
+    event* ev = nullptr;
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      --m_inflight;
+      if (--m_pending==0)
+        std::swap(ev,m_replay);
+    }
+
+    if (!ev) {
+      submit();
+      return;
+    }
+
+    // This node may be deleted when the replay event completes
+    ev->set_status(CL_COMPLETE);
+  }
+};
+
+void
+graph::kernel_command::
+done() const
+{
+  m_node->done();
+}
+
+graph::
+graph(command_queue* cq)
+  : m_device(cq->get_device())
+{
+  XOCL_DEBUG(std::cout,"xocl::graph::graph() on queue(",cq->get_uid(),")\n");
+}
+
+graph::
+~graph()
+{
+  XOCL_DEBUG(std::cout,"xocl::graph::~graph()\n");
+}
+
+void
+graph::
+record(event* ev)
+{
+  auto n = std::make_shared<node>(ev);
+
+  // Recorded events are never submitted, so the chain of each
+  // recorded event identifies the nodes that depend on it.  The wait
+  // count of the event includes one for itself.
+  size_t deps = 0;
+  for (size_t idx=0; idx<m_nodes.size(); ++idx) {
+    auto& pred = m_nodes[idx];
+    std::lock_guard<std::mutex> lk(pred->m_event->m_mutex);
+    if (pred->m_event->chains_nolock(ev)) {
+      n->m_preds.push_back(idx);
+      ++deps;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lk(ev->m_mutex);
+    if (ev->m_wait_count != deps+1)
+      throw xocl::error(CL_INVALID_EVENT_WAIT_LIST,"recorded event("
+                        + ev->get_suid() + ") depends on event not in graph");
+  }
+
+  auto cq = ev->get_command_queue();
+  bool ooo = cq->get_properties().test(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+  if (!ooo && !m_nodes.empty()) {
+    // In order queue, depend on previous node
+    if (n->m_preds.empty() || n->m_preds.back()!=m_nodes.size()-1)
+      n->m_preds.push_back(m_nodes.size()-1);
+  }
+  else if (ooo) {
+    // Out of order queue, barriers order all nodes recorded before
+    // them with all nodes recorded after them
+    size_t barrier = m_nodes.size();
+    for (size_t idx=m_nodes.size(); idx-- > 0;) {
+      if (m_nodes[idx]->m_command_type==CL_COMMAND_BARRIER) {
+        barrier = idx;
+        break;
+      }
+    }
+
+    // A marker without explicit dependencies waits on all prior nodes
+    auto ct = ev->get_command_type();
+    if (ct==CL_COMMAND_BARRIER || (ct==CL_COMMAND_MARKER && !deps)) {
+      for (size_t idx=(barrier==m_nodes.size() ? 0 : barrier); idx<m_nodes.size(); ++idx)
+        n->m_preds.push_back(idx);
+    }
+    else if (barrier!=m_nodes.size()) {
+      n->m_preds.push_back(barrier);
+    }
+
+    std::sort(n->m_preds.begin(),n->m_preds.end());
+    n->m_preds.erase(std::unique(n->m_preds.begin(),n->m_preds.end()),n->m_preds.end());
+  }
+
+  if (auto ec = ev->get_execution_context()) {
+    n->m_kernel = std::make_shared<kernel_node>(m_device,ec);
+  }
+  else {
+    std::lock_guard<std::mutex> lk(ev->m_mutex);
+    if (ev->m_enqueue_action)
+      n->m_action = std::make_shared<event::action_enqueue_type>(std::move(ev->m_enqueue_action));
+  }
+
+  for (auto idx : n->m_preds)
+    m_nodes[idx]->m_sink = false;
+
+  XOCL_DEBUG(std::cout,"graph records event(",ev->get_uid(),") as node(",m_nodes.size(),")\n");
+  m_nodes.push_back(std::move(n));
+}
+
+void
+graph::
+validate(const arg_update& update) const
+{
+  if (update.node >= m_nodes.size() || !m_nodes[update.node]->m_kernel)
+    throw xocl::error(CL_INVALID_ARG_INDEX,"graph node " + std::to_string(update.node) + " is not a kernel");
+  m_nodes[update.node]->m_kernel->m_ec->validate_argument(update.argidx,update.value.size());
+}
+
+ptr<event>
+graph::
+enqueue(command_queue* cq, std::vector<arg_update> updates, cl_uint num_deps, const cl_event* deps)
+{
+  // Group updates per kernel node, shared by the actions of the replay
+  std::vector<std::shared_ptr<std::vector<arg_update>>> node_updates(m_nodes.size());
+  for (auto& update : updates) {
+    auto& nu = node_updates[update.node];
+    if (!nu)
+      nu = std::make_shared<std::vector<arg_update>>();
+    nu->push_back(std::move(update));
+  }
+
+  std::lock_guard<std::recursive_mutex> lk(m_mutex);
+
+  // Roots wait on the caller's events and on the previous replay
+  std::vector<cl_event> root_deps(deps,deps+num_deps);
+  if (m_last.get())
+    root_deps.push_back(m_last.get());
+
+  std::vector<ptr<event>> replay;
+  replay.reserve(m_nodes.size());
+  std::vector<cl_event> wait_list;
+  for (size_t idx=0; idx<m_nodes.size(); ++idx) {
+    auto& n = m_nodes[idx];
+
+    wait_list.clear();
+    for (auto pred : n->m_preds)
+      wait_list.push_back(replay[pred].get());
+    if (n->m_preds.empty())
+      wait_list.insert(wait_list.end(),root_deps.begin(),root_deps.end());
+
+    auto rev = create_event(cq,cq->get_context(),n->m_command_type,wait_list.size(),wait_list.data());
+    if (auto kn = n->m_kernel) {
+      auto nu = node_updates[idx];
+      rev->set_enqueue_action([kn,nu](event* ev) {
+          static const std::vector<arg_update> no_updates;
+          try {
+            kn->launch(ev,nu ? *nu : no_updates);
+          }
+          catch (const std::exception& ex) {
+            send_exception_message(ex.what());
+            ev->abort(-1,true/*fatal*/);
+          }
+        });
+    }
+    else if (auto action = n->m_action) {
+      rev->set_enqueue_action([action](event* ev) { (*action)(ev); });
+    }
+    replay.push_back(std::move(rev));
+  }
+
+  // Marker completes when all sinks complete
+  wait_list.clear();
+  for (size_t idx=0; idx<m_nodes.size(); ++idx)
+    if (m_nodes[idx]->m_sink)
+      wait_list.push_back(replay[idx].get());
+  if (m_nodes.empty())
+    wait_list = root_deps;
+
+  auto marker = create_event(cq,cq->get_context(),CL_COMMAND_MARKER,wait_list.size(),wait_list.data());
+  ptr<graph> self(this);
+  marker->set_enqueue_action([self](event* ev) {
+      self->retire(ev);
+      ev->set_status(CL_COMPLETE);
+    });
+  m_last = marker;
+
+  for (auto& ev : replay)
+    ev->queue();
+  marker->queue();
+
+  return marker;
+}
+
+void
+graph::
+retire(const event* ev)
+{
+  std::lock_guard<std::recursive_mutex> lk(m_mutex);
+  if (m_last.get()==ev)
+    m_last = nullptr;
+}
+
+} // xocl
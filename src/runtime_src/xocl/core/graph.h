@@ -0,0 +1,141 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_graph_h_
+#define xocl_core_graph_h_
+
+#include "xocl/core/object.h"
+#include "xocl/core/refcount.h"
+
+#include <CL/cl_ext_xilinx.h>
+
+#include <vector>
+#include <memory>
+#include <mutex>
+
+struct _xcl_graph : public xocl::object<xocl::graph,_xcl_graph> {};
+
+namespace xocl {
+
+/**
+ * Recorded sequence of commands that can be replayed
+ *
+ * A graph is recorded by a command queue between
+ * command_queue::begin_recording() and command_queue::end_recording().
+ * Hard events queued on the command queue during recording are
+ * added to the graph as nodes in the order they are queued, which is
+ * also a topological order of the nodes.  Node dependencies are
+ * resolved once when the node is recorded.
+ *
+ * Kernel nodes encode the command packets of all their workgroups
+ * when recorded.  The commands and their exec buffers are owned by
+ * the graph and reused by every replay.  Other nodes replay the
+ * enqueue action of the recorded event.
+ *
+ * A replay creates one event per node with the recorded
+ * dependencies, plus a marker event that completes when all sink
+ * nodes complete.  Replays of a graph are serialized.
+ */
+class graph : public refcount, public _xcl_graph
+{
+  struct node;
+  struct kernel_node;
+  struct kernel_command;
+
+public:
+  struct arg_update
+  {
+    unsigned int node;
+    unsigned long argidx;
+    std::vector<char> value;
+  };
+
+  explicit
+  graph(command_queue* cq);
+
+  virtual ~graph();
+
+  device*
+  get_device() const
+  {
+    return m_device;
+  }
+
+  size_t
+  get_num_nodes() const
+  {
+    return m_nodes.size();
+  }
+
+  /**
+   * Record an event as a node in this graph
+   *
+   * Called by command queue when a hard event is queued while the
+   * command queue is recording.  The event must depend only on events
+   * already recorded in this graph.
+   *
+   * @param ev
+   *   Event to record.  The graph retains the event.
+   */
+  void
+  record(event* ev);
+
+  /**
+   * Check that an argument update can be applied
+   *
+   * @throws
+   *   xocl::error CL_INVALID_ARG_INDEX if node is not a kernel node or
+   *   argument is not a scalar argument of the kernel,
+   *   CL_INVALID_ARG_SIZE if value size doesn't match the argument
+   */
+  void
+  validate(const arg_update& update) const;
+
+  /**
+   * Enqueue a replay of this graph
+   *
+   * @param cq
+   *   Command queue on which to enqueue the replay, must be on the
+   *   same device as the graph was recorded on
+   * @param updates
+   *   Scalar argument updates to apply before replay, must have been
+   *   validated
+   * @param num_deps
+   *   Number of events in deps
+   * @param deps
+   *   Events that must complete before the replay starts
+   * @return
+   *   Event that completes when the replay completes
+   */
+  ptr<event>
+  enqueue(command_queue* cq, std::vector<arg_update> updates, cl_uint num_deps, const cl_event* deps);
+
+private:
+  void
+  retire(const event* ev);
+
+  device* m_device;
+  std::vector<std::shared_ptr<node>> m_nodes;
+
+  // Completion marker of last replay, roots of the next replay wait
+  // on this event.  Cleared when the marker completes.
+  ptr<event> m_last;
+  std::recursive_mutex m_mutex;
+};
+
+} // xocl
+
+#endif
@@ -20,6 +20,7 @@
 #include "xocl/core/object.h"
 #include "xocl/core/refcount.h"
 #include "xocl/core/memory.h"
+#include "xocl/core/pool.h"
 #include "xocl/xclbin/xclbin.h"
 
 #include "xrt/util/td.h"
@@ -42,7 +43,7 @@ public:
    * The class is in flux, and will change much as upstream cu_ffa
    * and execution context are adapated.
    */
-  class argument
+  class argument : public pooled
   {
   public:
     using argtype = xclbin::symbol::arg::argtype;
@@ -250,13 +251,13 @@ public:
     virtual const void* get_value() const { return m_value.data(); }
     virtual const std::string get_string_value() const;
     virtual arginfo_range_type get_arginfo_range() const
-    { return arginfo_range_type(m_components.begin(),m_components.end()); }
+    { return arginfo_range_type(m_components.data(),m_components.data()+m_components.size()); }
   private:
     size_t m_sz;
-    std::vector<uint8_t> m_value;
+    std::vector<uint8_t,pool_allocator<uint8_t>> m_value;
 
     // components of the argument (long2, int4, etc)
-    arginfo_vector_type m_components;
+    std::vector<arginfo_type,pool_allocator<arginfo_type>> m_components;
   };
 
   class global_argument : public argument
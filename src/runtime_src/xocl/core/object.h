@@ -40,6 +40,7 @@ class sampler;
 class memory;
 class stream;
 class stream_mem;
+class graph;
 
 /**
  * Base class for all CL API object types
@@ -0,0 +1,112 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "pool.h"
+
+#include <atomic>
+#include <mutex>
+
+namespace {
+
+using namespace xocl::pool;
+
+constexpr size_t num_classes = max_size/granularity;
+
+// Number of blocks carved from one system allocation
+constexpr size_t blocks_per_chunk = 32;
+
+struct block
+{
+  block* next;
+};
+
+// Free list for one size class.  Blocks in a free list are never
+// released, which also makes it safe to free blocks during static
+// destruction.
+struct freelist
+{
+  std::mutex mutex;
+  block* head = nullptr;
+};
+
+static freelist s_freelist[num_classes];
+static std::atomic<size_t> s_system_allocations {0};
+
+inline size_t
+size_class(size_t sz)
+{
+  return sz ? (sz-1)/granularity : 0;
+}
+
+static void
+refill(freelist& fl, size_t block_size)
+{
+  ++s_system_allocations;
+  auto chunk = static_cast<char*>(::operator new(block_size*blocks_per_chunk));
+  for (size_t idx=0; idx<blocks_per_chunk; ++idx) {
+    auto blk = reinterpret_cast<block*>(chunk + idx*block_size);
+    blk->next = fl.head;
+    fl.head = blk;
+  }
+}
+
+} // namespace
+
+namespace xocl { namespace pool {
+
+void*
+allocate(size_t sz)
+{
+  if (sz > max_size) {
+    ++s_system_allocations;
+    return ::operator new(sz);
+  }
+
+  auto cls = size_class(sz);
+  auto& fl = s_freelist[cls];
+  std::lock_guard<std::mutex> lk(fl.mutex);
+  if (!fl.head)
+    refill(fl,(cls+1)*granularity);
+  auto blk = fl.head;
+  fl.head = blk->next;
+  return blk;
+}
+
+void
+deallocate(void* ptr, size_t sz)
+{
+  if (!ptr)
+    return;
+
+  if (sz > max_size) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  auto& fl = s_freelist[size_class(sz)];
+  auto blk = static_cast<block*>(ptr);
+  std::lock_guard<std::mutex> lk(fl.mutex);
+  blk->next = fl.head;
+  fl.head = blk;
+}
+
+size_t
+get_num_system_allocations()
+{
+  return s_system_allocations;
+}
+
+}} // pool,xocl
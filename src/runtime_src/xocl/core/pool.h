@@ -0,0 +1,119 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_pool_h_
+#define xocl_core_pool_h_
+
+#include <cstddef>
+#include <memory>
+#include <new>
+
+namespace xocl {
+
+/**
+ * Memory pool for objects created on the enqueue hot path
+ *
+ * Events, execution contexts, kernel argument clones and their
+ * containers are allocated and freed at the rate of enqueued
+ * commands.  The pool recycles blocks through free lists per size
+ * class so that steady state enqueue does not go to the system
+ * allocator.  Blocks are never returned to the system.
+ *
+ * Requests larger than max_size are forwarded to ::operator new.
+ */
+namespace pool {
+
+constexpr size_t granularity = 32;
+constexpr size_t max_size = 1024;
+
+void*
+allocate(size_t sz);
+
+void
+deallocate(void* ptr, size_t sz);
+
+/**
+ * Number of times the pool has gone to the system allocator.
+ *
+ * In steady state this number should not change.
+ */
+size_t
+get_num_system_allocations();
+
+} // pool
+
+/**
+ * Standard allocator adaptor for pool, for use with std containers
+ */
+template <typename T>
+struct pool_allocator
+{
+  using value_type = T;
+
+  pool_allocator() = default;
+
+  template <typename U>
+  pool_allocator(const pool_allocator<U>&) {}
+
+  T*
+  allocate(size_t n)
+  {
+    return static_cast<T*>(pool::allocate(n*sizeof(T)));
+  }
+
+  void
+  deallocate(T* p, size_t n)
+  {
+    pool::deallocate(p,n*sizeof(T));
+  }
+
+  template <typename U>
+  bool
+  operator==(const pool_allocator<U>&) const
+  { return true; }
+
+  template <typename U>
+  bool
+  operator!=(const pool_allocator<U>&) const
+  { return false; }
+};
+
+/**
+ * Base class for objects allocated from the pool.
+ *
+ * Derived classes are allocated from the pool with plain new and
+ * delete.  With a virtual destructor, delete passes the size of the
+ * most derived object.
+ */
+class pooled
+{
+public:
+  static void*
+  operator new(size_t sz)
+  {
+    return pool::allocate(sz);
+  }
+
+  static void
+  operator delete(void* ptr, size_t sz)
+  {
+    pool::deallocate(ptr,sz);
+  }
+};
+
+} // xocl
+
+#endif
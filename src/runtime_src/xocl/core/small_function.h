@@ -0,0 +1,213 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xocl_core_small_function_h_
+#define xocl_core_small_function_h_
+
+#include "xocl/core/pool.h"
+
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace xocl {
+
+template <typename Signature, size_t Size = 64>
+class small_function;
+
+/**
+ * Move only replacement of std::function with small buffer storage
+ *
+ * Callables that fit in Size bytes are stored in place, larger ones
+ * are allocated from xocl::pool.  Used for event actions which are
+ * constructed per enqueued command and typically capture a handful
+ * of arguments, more than the std::function small buffer holds.
+ */
+template <typename R, typename... Args, size_t Size>
+class small_function<R(Args...),Size>
+{
+  using storage_type = typename std::aligned_storage<Size,alignof(std::max_align_t)>::type;
+
+  struct operations
+  {
+    R    (*invoke)(void*, Args&&...);
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void*);
+  };
+
+  template <typename F>
+  struct inplace
+  {
+    static F*
+    get(void* s)
+    {
+      return static_cast<F*>(s);
+    }
+
+    static R
+    invoke(void* s, Args&&... args)
+    {
+      return (*get(s))(std::forward<Args>(args)...);
+    }
+
+    static void
+    move(void* dst, void* src)
+    {
+      new (dst) F(std::move(*get(src)));
+      get(src)->~F();
+    }
+
+    static void
+    destroy(void* s)
+    {
+      get(s)->~F();
+    }
+
+    static void
+    create(void* s, F&& f)
+    {
+      new (s) F(std::move(f));
+    }
+  };
+
+  template <typename F>
+  struct pooled
+  {
+    static F*&
+    get(void* s)
+    {
+      return *static_cast<F**>(s);
+    }
+
+    static R
+    invoke(void* s, Args&&... args)
+    {
+      return (*get(s))(std::forward<Args>(args)...);
+    }
+
+    static void
+    move(void* dst, void* src)
+    {
+      *static_cast<F**>(dst) = get(src);
+    }
+
+    static void
+    destroy(void* s)
+    {
+      auto f = get(s);
+      f->~F();
+      pool::deallocate(f,sizeof(F));
+    }
+
+    static void
+    create(void* s, F&& f)
+    {
+      auto mem = pool::allocate(sizeof(F));
+      get(s) = new (mem) F(std::move(f));
+    }
+  };
+
+  template <typename F>
+  using holder = typename std::conditional<
+    (sizeof(F) <= Size
+     && alignof(F) <= alignof(std::max_align_t)
+     && std::is_nothrow_move_constructible<F>::value)
+    ,inplace<F>
+    ,pooled<F>>::type;
+
+  template <typename F>
+  static const operations*
+  get_operations()
+  {
+    static const operations ops = { &holder<F>::invoke, &holder<F>::move, &holder<F>::destroy };
+    return &ops;
+  }
+
+  void
+  reset()
+  {
+    if (m_ops)
+      m_ops->destroy(&m_storage);
+    m_ops = nullptr;
+  }
+
+  storage_type m_storage;
+  const operations* m_ops = nullptr;
+
+public:
+  small_function() {}
+
+  small_function(std::nullptr_t) {}
+
+  template <typename F
+            ,typename = typename std::enable_if<
+               !std::is_same<typename std::decay<F>::type,small_function>::value>::type>
+  small_function(F&& f)
+  {
+    using ftype = typename std::decay<F>::type;
+    ftype tmp(std::forward<F>(f));
+    holder<ftype>::create(&m_storage,std::move(tmp));
+    m_ops = get_operations<ftype>();
+  }
+
+  small_function(small_function&& rhs) noexcept
+    : m_ops(rhs.m_ops)
+  {
+    if (m_ops)
+      m_ops->move(&m_storage,&rhs.m_storage);
+    rhs.m_ops = nullptr;
+  }
+
+  small_function&
+  operator=(small_function&& rhs) noexcept
+  {
+    if (this != &rhs) {
+      reset();
+      m_ops = rhs.m_ops;
+      if (m_ops)
+        m_ops->move(&m_storage,&rhs.m_storage);
+      rhs.m_ops = nullptr;
+    }
+    return *this;
+  }
+
+  small_function(const small_function&) = delete;
+  small_function& operator=(const small_function&) = delete;
+
+  ~small_function()
+  {
+    reset();
+  }
+
+  explicit
+  operator bool() const
+  {
+    return m_ops != nullptr;
+  }
+
+  R
+  operator()(Args... args) const
+  {
+    if (!m_ops)
+      throw std::bad_function_call();
+    return m_ops->invoke(const_cast<storage_type*>(&m_storage),std::forward<Args>(args)...);
+  }
+};
+
+} // xocl
+
+#endif
@@ -16,6 +16,14 @@
 
 #include "stream.h"
 #include "device.h"
+#include "error.h"
+
+#include "xrt/util/config_reader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <tuple>
+#include <unistd.h>
 
 namespace xocl { 
 
@@ -51,6 +59,20 @@ stream
   return m_device->write_stream(m_handle, ptr, size, req);
 }
 
+size_t
+stream::
+read(size_t num, void* const* ptrs, const size_t* sizes, stream_xfer_req* reqs)
+{
+  return m_device->read_streams(m_handle, num, ptrs, sizes, reqs);
+}
+
+size_t
+stream::
+write(size_t num, const void* const* ptrs, const size_t* sizes, stream_xfer_req* reqs)
+{
+  return m_device->write_streams(m_handle, num, ptrs, sizes, reqs);
+}
+
 int
 stream::
 stream::close()
@@ -60,12 +82,146 @@ stream::close()
 }
 
 
-int 
-stream_mem::
-stream_mem::get(device* device)
+stream_pool::
+stream_pool(device* device)
+  : m_device(device)
+{}
+
+stream_pool::
+~stream_pool()
+{
+  for (auto& cap : m_free)
+    for (auto& buf : cap.second)
+      m_device->free_stream_buf(buf.second);
+}
+
+stream_mem*
+stream_pool::
+lookup(const void* ptr)
+{
+  // Requests of a stream typically come from the same buffer
+  auto addr = static_cast<const char*>(ptr);
+  auto contains = [addr](const stream_mem* mem) {
+    auto buf = static_cast<const char*>(mem->m_buf);
+    return addr >= buf && addr < buf + mem->m_capacity;
+  };
+  if (m_last && contains(m_last))
+    return m_last;
+
+  auto itr = m_allocated.upper_bound(addr);
+  if (itr == m_allocated.begin())
+    return nullptr;
+  auto mem = (--itr)->second;
+  if (!contains(mem))
+    return nullptr;
+  return (m_last = mem);
+}
+
+void
+stream_pool::
+recycle(stream_mem* mem)
+{
+  if (m_free_bytes + mem->m_capacity <= xrt::config::get_stream_buf_pool_size()) {
+    m_free[mem->m_capacity].emplace_back(mem->m_buf,mem->m_handle);
+    m_free_bytes += mem->m_capacity;
+  }
+  else {
+    m_device->free_stream_buf(mem->m_handle);
+  }
+  delete mem;
+}
+
+void
+stream_pool::
+reap(request* req)
+{
+  if (req->mem && --req->mem->m_inflight == 0 && req->mem->m_released)
+    recycle(req->mem);
+  req->next = m_requests;
+  m_requests = req;
+}
+
+stream_mem*
+stream_pool::
+alloc(size_t size)
+{
+  const size_t page = getpagesize();
+  auto capacity = (std::max<size_t>(size,1) + page - 1) & ~(page - 1);
+  auto mem = std::make_unique<stream_mem>(size);
+  mem->m_capacity = capacity;
+  mem->m_device = m_device;
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  auto itr = m_free.find(capacity);
+  if (itr != m_free.end() && !itr->second.empty()) {
+    std::tie(mem->m_buf,mem->m_handle) = itr->second.back();
+    itr->second.pop_back();
+    m_free_bytes -= capacity;
+  }
+  else {
+    mem->m_buf = m_device->alloc_stream_buf(capacity,&mem->m_handle);
+    if (!mem->m_buf)
+      throw xocl::error(CL_MEM_OBJECT_ALLOCATION_FAILURE,"Failed to allocate stream buffer");
+  }
+  m_allocated.emplace(static_cast<const char*>(mem->m_buf),mem.get());
+  return mem.release();
+}
+
+void
+stream_pool::
+release(stream_mem* mem)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  m_allocated.erase(static_cast<const char*>(mem->m_buf));
+  if (m_last == mem)
+    m_last = nullptr;
+  if (mem->m_inflight)
+    mem->m_released = true;
+  else
+    recycle(mem);
+}
+
+void*
+stream_pool::
+track(const void* ptr, void* priv_data)
+{
+  // Trackers are allocated in chunks and never freed before the pool
+  static const size_t chunk_size = 256;
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (!m_requests) {
+    m_chunks.emplace_back(new request[chunk_size]);
+    auto chunk = m_chunks.back().get();
+    for (size_t i = 0; i < chunk_size; ++i)
+      chunk[i].next = (i + 1 < chunk_size) ? &chunk[i + 1] : nullptr;
+    m_requests = chunk;
+  }
+  auto req = m_requests;
+  m_requests = req->next;
+  req->priv_data = priv_data;
+  req->mem = lookup(ptr);
+  if (req->mem)
+    ++req->mem->m_inflight;
+  return req;
+}
+
+void
+stream_pool::
+untrack(void* tracker)
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  reap(static_cast<request*>(tracker));
+}
+
+void
+stream_pool::
+complete(stream_xfer_completions* comps, int num)
 {
-  m_buf = device->alloc_stream_buf(m_size,&m_handle);
-  return 0;
+  std::lock_guard<std::mutex> lk(m_mutex);
+  for (int i = 0; i < num; ++i) {
+    auto req = static_cast<request*>(comps[i].priv_data);
+    comps[i].priv_data = req->priv_data;
+    reap(req);
+  }
 }
 
 } //xocl
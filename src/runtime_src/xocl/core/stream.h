@@ -23,6 +23,11 @@
 
 #include "xrt/device/device.h"
 
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
 namespace xocl {
 //class stream for qdma and other streaming purposes.
 class stream : public _cl_stream // TODO: public refcount
@@ -47,6 +52,8 @@ public:
   int get_stream(device* device); 
   ssize_t read(void* ptr, size_t size, stream_xfer_req* req );
   ssize_t write(const void* ptr, size_t size, stream_xfer_req* req);
+  size_t read(size_t num, void* const* ptrs, const size_t* sizes, stream_xfer_req* reqs);
+  size_t write(size_t num, const void* const* ptrs, const size_t* sizes, stream_xfer_req* reqs);
   int close();
 };
 
@@ -57,16 +64,112 @@ class stream_mem : public _cl_stream_mem //TODO: public refcount
   using stream_buf = xrt::hal::StreamBuf;
 public:
   size_t m_size {0};
+  size_t m_capacity {0};            // allocated size, rounded to page
   stream_buf_handle m_handle {0};
   stream_buf m_buf {nullptr};
+  device* m_device {nullptr};
+  unsigned int m_inflight {0};      // non-blocking requests not yet reaped
+  bool m_released {false};
 public:
   stream_mem(size_t size):m_size(size){};
 public:
-  int get(device* device);
   stream_buf map() {return m_buf;};
   void unmap() { /*do nothing*/ };
 };
 
+/**
+ * Stream buffers and non-blocking stream requests of one device
+ *
+ * Released stream buffers are kept by size for reuse instead of being
+ * returned to the driver.  A buffer released while non-blocking
+ * requests from it are in flight is recycled when poll reaps the last
+ * of them.
+ *
+ * Non-blocking requests are tracked by passing a tracker from a free
+ * list as the request priv_data to the driver.  The caller's priv_data
+ * is restored in the completion, so polling many streams does not
+ * allocate.  Silent requests generate no completion and are not
+ * tracked.
+ */
+class stream_pool
+{
+  using stream_buf = xrt::hal::StreamBuf;
+  using stream_buf_handle = xrt::hal::StreamBufHandle;
+  using stream_xfer_completions = xrt::hal::StreamXferCompletions;
+
+  struct request
+  {
+    void* priv_data = nullptr;
+    stream_mem* mem = nullptr;
+    request* next = nullptr;
+  };
+
+  device* m_device;
+  std::mutex m_mutex;
+
+  // Free buffers by capacity
+  std::map<size_t,std::vector<std::pair<stream_buf,stream_buf_handle>>> m_free;
+  size_t m_free_bytes = 0;
+
+  // Allocated buffers by address, to find the buffer of a request
+  std::map<const char*,stream_mem*> m_allocated;
+  stream_mem* m_last = nullptr;     // last buffer found, checked first
+
+  std::vector<std::unique_ptr<request[]>> m_chunks;
+  request* m_requests = nullptr;
+
+  stream_mem*
+  lookup(const void* ptr);
+
+  void
+  recycle(stream_mem* mem);
+
+  void
+  reap(request* req);
+
+public:
+  explicit
+  stream_pool(device* device);
+
+  ~stream_pool();
+
+  /**
+   * Get a buffer of at least @size bytes, reusing a released one
+   * of same capacity if any
+   */
+  stream_mem*
+  alloc(size_t size);
+
+  /**
+   * Release a buffer obtained from alloc().  The buffer is recycled
+   * once no requests from it are in flight.
+   */
+  void
+  release(stream_mem* mem);
+
+  /**
+   * Track a non-blocking request of @ptr
+   *
+   * @return
+   *   The priv_data to pass to the driver in place of @priv_data
+   */
+  void*
+  track(const void* ptr, void* priv_data);
+
+  /**
+   * Stop tracking a request that was not accepted by the driver
+   */
+  void
+  untrack(void* tracker);
+
+  /**
+   * Restore caller priv_data of @num completions and recycle buffers
+   * released while their requests were in flight
+   */
+  void
+  complete(stream_xfer_completions* comps, int num);
+};
+
 } //xocl
 
 #endif
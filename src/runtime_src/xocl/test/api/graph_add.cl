@@ -0,0 +1,27 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Kernel used by the kernel replay tests in tGraph.cpp.  Build for
+// software emulation and point XOCL_TEST_GRAPH_XCLBIN at the result:
+//  % xocc -t sw_emu --platform <platform> -k graph_add -o graph_add.xclbin graph_add.cl
+
+__kernel __attribute__ ((reqd_work_group_size(16, 1, 1)))
+void
+graph_add(__global int* data, int value)
+{
+  int id = get_global_id(0);
+  data[id] += value;
+}
@@ -16,6 +16,11 @@
 
 #include "CL/cl.h"
 
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
 struct ocl_sw_emulation
 {
   cl_platform_id platform = nullptr;
@@ -39,4 +44,38 @@ struct ocl_sw_emulation
 
 };
 
+// Program and graph_add kernel of XOCL_TEST_GRAPH_XCLBIN
+struct graph_add_kernel
+{
+  cl_program program = nullptr;
+  cl_kernel kernel = nullptr;
+
+  explicit
+  graph_add_kernel(const ocl_sw_emulation& ocl)
+  {
+    auto path = std::getenv("XOCL_TEST_GRAPH_XCLBIN");
+    if (!path)
+      return;
 
+    std::ifstream istr(path,std::ios::binary);
+    BOOST_REQUIRE(istr);
+    std::vector<unsigned char> binary{std::istreambuf_iterator<char>(istr),std::istreambuf_iterator<char>()};
+
+    cl_int err = CL_SUCCESS;
+    const unsigned char* data = binary.data();
+    auto size = binary.size();
+    program = clCreateProgramWithBinary(ocl.context,1,&ocl.device,&size,&data,nullptr,&err);
+    BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+    BOOST_REQUIRE_EQUAL(clBuildProgram(program,1,&ocl.device,nullptr,nullptr,nullptr),CL_SUCCESS);
+    kernel = clCreateKernel(program,"graph_add",&err);
+    BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+  }
+
+  ~graph_add_kernel()
+  {
+    if (kernel)
+      clReleaseKernel(kernel);
+    if (program)
+      clReleaseProgram(program);
+  }
+};
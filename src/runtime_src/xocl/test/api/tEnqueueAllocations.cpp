@@ -0,0 +1,229 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "setup.h"
+
+#include <CL/opencl.h>
+#include "xocl/core/event.h"
+#include "xocl/core/pool.h"
+#include "xocl/core/time.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+// To run all tests in this suite use
+//  % em -env opt txocl --run_test=test_EnqueueAllocations
+
+// Count calls to global operator new while counting is enabled.  The
+// replacement applies to the entire test executable, but only counts
+// inside the measured loop.
+namespace {
+
+static std::atomic<bool> s_counting {false};
+static std::atomic<size_t> s_allocations {0};
+
+struct count_guard
+{
+  count_guard()  { s_allocations = 0; s_counting = true; }
+  ~count_guard() { s_counting = false; }
+};
+
+}
+
+void*
+operator new(size_t sz)
+{
+  if (s_counting)
+    ++s_allocations;
+  if (auto ptr = std::malloc(sz ? sz : 1))
+    return ptr;
+  throw std::bad_alloc();
+}
+
+void
+operator delete(void* ptr) noexcept
+{
+  std::free(ptr);
+}
+
+void
+operator delete(void* ptr, size_t) noexcept
+{
+  std::free(ptr);
+}
+
+BOOST_AUTO_TEST_SUITE ( test_EnqueueAllocations )
+
+// Steady state enqueue of events must not go to the system
+// allocator.  Events and their containers come from xocl::pool
+// which is populated during warm up.
+//
+// Measured with the default configuration where profiling and
+// application debug are off.  With either on, the xdp loggers called
+// by the event actions allocate; the actions themselves do not (see
+// test_EnqueueAllocations2).
+BOOST_AUTO_TEST_CASE( test_EnqueueAllocations1 )
+{
+  ocl_sw_emulation ocl;
+  cl_int err = CL_SUCCESS;
+
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+
+  auto enqueue = [cq](size_t iterations) {
+    for (size_t i=0; i<iterations; ++i) {
+      cl_event ev = nullptr;
+      clEnqueueMarkerWithWaitList(cq,0,nullptr,&ev);
+      clReleaseEvent(ev);
+      clFinish(cq);
+    }
+  };
+
+  // warm up
+  enqueue(1000);
+
+  const size_t iterations = 100000;
+  auto pool_allocations = xocl::pool::get_num_system_allocations();
+  auto start = xocl::time_ns();
+  size_t allocations = 0;
+  {
+    count_guard guard;
+    enqueue(iterations);
+    allocations = s_allocations;
+  }
+  auto end = xocl::time_ns();
+
+  std::cout << "enqueue: " << iterations << " iterations in "
+            << (end-start)*1e-6 << "ms, "
+            << static_cast<double>(allocations)/iterations << " allocations per enqueue\n";
+
+  BOOST_CHECK_EQUAL(allocations,0);
+  BOOST_CHECK_EQUAL(xocl::pool::get_num_system_allocations(),pool_allocations);
+
+  clReleaseCommandQueue(cq);
+}
+
+// Profile and debug actions that are stored on events use in place
+// or pooled storage rather than the system allocator
+BOOST_AUTO_TEST_CASE( test_EnqueueAllocations2 )
+{
+  struct small { void* p[4]; };
+  struct large { void* p[16]; };
+  size_t calls = 0;
+
+  auto make = [&calls]() {
+    small s = {};
+    large l = {};
+    xocl::event::action_profile_type profile_small
+      = [&calls,s](xocl::event*,cl_int,const std::string&) { calls += (s.p[0]==nullptr); };
+    xocl::event::action_profile_type profile_large
+      = [&calls,l](xocl::event*,cl_int,const std::string&) { calls += (l.p[0]==nullptr); };
+    xocl::event::action_debug_type debug_small
+      = [&calls,s](xocl::event*) { calls += (s.p[0]==nullptr); };
+    xocl::event::action_debug_type debug_large
+      = [&calls,l](xocl::event*) { calls += (l.p[0]==nullptr); };
+
+    // Actions move into the event
+    auto profile = std::move(profile_large);
+    auto debug = std::move(debug_large);
+    profile_small(nullptr,CL_COMPLETE,"");
+    profile(nullptr,CL_COMPLETE,"");
+    debug_small(nullptr);
+    debug(nullptr);
+  };
+
+  // warm up
+  for (int i=0; i<10; ++i)
+    make();
+
+  size_t allocations = 0;
+  {
+    count_guard guard;
+    for (int i=0; i<1000; ++i)
+      make();
+    allocations = s_allocations;
+  }
+
+  BOOST_CHECK_EQUAL(calls,4*1010);
+  BOOST_CHECK_EQUAL(allocations,0);
+}
+
+// Steady state enqueue of a kernel with a buffer and a scalar
+// argument must not go to the system allocator either.  Kernel
+// arguments, the execution context, and its commands are pooled.
+//
+// Needs an xclbin built from graph_add.cl, skipped unless
+// XOCL_TEST_GRAPH_XCLBIN names the xclbin (see test_Graph).
+BOOST_AUTO_TEST_CASE( test_EnqueueAllocations3 )
+{
+  ocl_sw_emulation ocl;
+  graph_add_kernel gak(ocl);
+  if (!gak.kernel) {
+    BOOST_TEST_MESSAGE("XOCL_TEST_GRAPH_XCLBIN not set, skipping kernel enqueue");
+    return;
+  }
+
+  cl_int err = CL_SUCCESS;
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+
+  const size_t global_size = 256;
+  const size_t local_size = 16;
+  auto buffer = clCreateBuffer(ocl.context,CL_MEM_READ_WRITE,global_size*sizeof(int),nullptr,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+  BOOST_REQUIRE_EQUAL(clSetKernelArg(gak.kernel,0,sizeof(cl_mem),&buffer),CL_SUCCESS);
+
+  auto kernel = gak.kernel;
+  auto enqueue = [cq,kernel,global_size,local_size](size_t iterations) {
+    for (size_t i=0; i<iterations; ++i) {
+      int value = static_cast<int>(i);
+      clSetKernelArg(kernel,1,sizeof(int),&value);
+      cl_event ev = nullptr;
+      clEnqueueNDRangeKernel(cq,kernel,1,nullptr,&global_size,&local_size,0,nullptr,&ev);
+      clReleaseEvent(ev);
+      clFinish(cq);
+    }
+  };
+
+  // warm up
+  enqueue(100);
+
+  const size_t iterations = 10000;
+  auto pool_allocations = xocl::pool::get_num_system_allocations();
+  auto start = xocl::time_ns();
+  size_t allocations = 0;
+  {
+    count_guard guard;
+    enqueue(iterations);
+    allocations = s_allocations;
+  }
+  auto end = xocl::time_ns();
+
+  std::cout << "ndrange: " << iterations << " iterations in "
+            << (end-start)*1e-6 << "ms, "
+            << static_cast<double>(allocations)/iterations << " allocations per enqueue\n";
+
+  BOOST_CHECK_EQUAL(allocations,0);
+  BOOST_CHECK_EQUAL(xocl::pool::get_num_system_allocations(),pool_allocations);
+
+  clReleaseMemObject(buffer);
+  clReleaseCommandQueue(cq);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
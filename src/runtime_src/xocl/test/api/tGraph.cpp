@@ -0,0 +1,259 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "setup.h"
+
+#include <CL/opencl.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+// To run all tests in this suite use
+//  % em -env opt txocl --run_test=test_Graph
+//
+// Kernel replay tests need an xclbin built from graph_add.cl, they
+// are skipped unless XOCL_TEST_GRAPH_XCLBIN names the xclbin.
+
+namespace {
+
+const size_t global_size = 256;
+const size_t local_size = 16;
+
+// Record write, graph_add(value) and read of host data as nodes 0-2
+static xcl_graph
+record_graph_add(cl_command_queue cq, cl_kernel kernel, cl_mem buffer,
+                 const std::vector<int>& input, std::vector<int>& output, int value)
+{
+  cl_int err = CL_SUCCESS;
+  auto bytes = input.size()*sizeof(int);
+
+  BOOST_REQUIRE_EQUAL(clSetKernelArg(kernel,0,sizeof(cl_mem),&buffer),CL_SUCCESS);
+  BOOST_REQUIRE_EQUAL(clSetKernelArg(kernel,1,sizeof(int),&value),CL_SUCCESS);
+
+  BOOST_REQUIRE_EQUAL(xclBeginGraphRecording(cq),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clEnqueueWriteBuffer(cq,buffer,CL_FALSE,0,bytes,input.data(),0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clEnqueueNDRangeKernel(cq,kernel,1,nullptr,&global_size,&local_size,0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clEnqueueReadBuffer(cq,buffer,CL_FALSE,0,bytes,output.data(),0,nullptr,nullptr),CL_SUCCESS);
+  auto graph = xclEndGraphRecording(cq,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+  return graph;
+}
+
+static bool
+all_equal(const std::vector<int>& data, int value)
+{
+  for (auto v : data)
+    if (v!=value)
+      return false;
+  return true;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_Graph )
+
+// Record markers, check they are not executed while recording, and
+// replay the graph multiple times
+BOOST_AUTO_TEST_CASE( test_Graph1 )
+{
+  ocl_sw_emulation ocl;
+  cl_int err = CL_SUCCESS;
+
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+
+  err = xclBeginGraphRecording(cq);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+  BOOST_CHECK_EQUAL(xclBeginGraphRecording(cq),CL_INVALID_OPERATION);
+
+  cl_event recorded = nullptr;
+  for (int i=0; i<4; ++i)
+    clEnqueueMarkerWithWaitList(cq,0,nullptr,nullptr);
+  clEnqueueMarkerWithWaitList(cq,0,nullptr,&recorded);
+
+  // Recorded events cannot be waited on
+  BOOST_CHECK(clWaitForEvents(1,&recorded)!=CL_SUCCESS);
+  clReleaseEvent(recorded);
+
+  auto graph = xclEndGraphRecording(cq,&err);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+  BOOST_CHECK(graph!=nullptr);
+
+  // Only kernel nodes can be updated
+  int value = 0;
+  xcl_graph_arg_update update = {0,0,sizeof(int),&value};
+  BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,1,&update,0,nullptr,nullptr),CL_INVALID_ARG_INDEX);
+
+  for (int i=0; i<10; ++i) {
+    cl_event ev = nullptr;
+    err = xclEnqueueGraph(cq,graph,0,nullptr,0,nullptr,&ev);
+    BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+    BOOST_CHECK_EQUAL(clWaitForEvents(1,&ev),CL_SUCCESS);
+    clReleaseEvent(ev);
+  }
+
+  // Replays without waiting are serialized
+  for (int i=0; i<10; ++i)
+    xclEnqueueGraph(cq,graph,0,nullptr,0,nullptr,nullptr);
+  BOOST_CHECK_EQUAL(clFinish(cq),CL_SUCCESS);
+
+  BOOST_CHECK_EQUAL(xclReleaseGraph(graph),CL_SUCCESS);
+  clReleaseCommandQueue(cq);
+}
+
+// Record a kernel with its data movement and replay it.  Nothing
+// runs while recording, and every replay runs all workgroups.
+BOOST_AUTO_TEST_CASE( test_Graph2 )
+{
+  ocl_sw_emulation ocl;
+  graph_add_kernel gak(ocl);
+  if (!gak.kernel) {
+    BOOST_TEST_MESSAGE("XOCL_TEST_GRAPH_XCLBIN not set, skipping kernel replay");
+    return;
+  }
+
+  cl_int err = CL_SUCCESS;
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+  auto buffer = clCreateBuffer(ocl.context,CL_MEM_READ_WRITE,global_size*sizeof(int),nullptr,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+
+  std::vector<int> input(global_size,10);
+  std::vector<int> output(global_size,-1);
+  auto graph = record_graph_add(cq,gak.kernel,buffer,input,output,5);
+  BOOST_CHECK_EQUAL(clFinish(cq),CL_SUCCESS);
+  BOOST_CHECK(all_equal(output,-1));
+
+  for (int i=0; i<5; ++i) {
+    std::fill(output.begin(),output.end(),-1);
+    cl_event ev = nullptr;
+    BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,0,nullptr,0,nullptr,&ev),CL_SUCCESS);
+    BOOST_CHECK_EQUAL(clWaitForEvents(1,&ev),CL_SUCCESS);
+    clReleaseEvent(ev);
+    BOOST_CHECK(all_equal(output,15));
+  }
+
+  // Back to back replays restore the recorded input each time
+  for (int i=0; i<5; ++i)
+    xclEnqueueGraph(cq,graph,0,nullptr,0,nullptr,nullptr);
+  BOOST_CHECK_EQUAL(clFinish(cq),CL_SUCCESS);
+  BOOST_CHECK(all_equal(output,15));
+
+  BOOST_CHECK_EQUAL(xclReleaseGraph(graph),CL_SUCCESS);
+  clReleaseMemObject(buffer);
+  clReleaseCommandQueue(cq);
+}
+
+// Update the scalar argument of the recorded kernel between replays.
+// An update stays in effect for later replays without updates.
+BOOST_AUTO_TEST_CASE( test_Graph3 )
+{
+  ocl_sw_emulation ocl;
+  graph_add_kernel gak(ocl);
+  if (!gak.kernel) {
+    BOOST_TEST_MESSAGE("XOCL_TEST_GRAPH_XCLBIN not set, skipping kernel replay");
+    return;
+  }
+
+  cl_int err = CL_SUCCESS;
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+  auto buffer = clCreateBuffer(ocl.context,CL_MEM_READ_WRITE,global_size*sizeof(int),nullptr,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+
+  std::vector<int> input(global_size,0);
+  std::vector<int> output(global_size,-1);
+  auto graph = record_graph_add(cq,gak.kernel,buffer,input,output,1);
+
+  // Invalid updates are rejected: node 0 is the write, argument 0
+  // is a buffer, and the size must match the argument
+  int value = 0;
+  xcl_graph_arg_update bad_node = {0,1,sizeof(int),&value};
+  xcl_graph_arg_update bad_arg = {1,0,sizeof(int),&value};
+  xcl_graph_arg_update bad_size = {1,1,sizeof(char),&value};
+  BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,1,&bad_node,0,nullptr,nullptr),CL_INVALID_ARG_INDEX);
+  BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,1,&bad_arg,0,nullptr,nullptr),CL_INVALID_ARG_INDEX);
+  BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,1,&bad_size,0,nullptr,nullptr),CL_INVALID_ARG_SIZE);
+
+  for (value=2; value<8; ++value) {
+    xcl_graph_arg_update update = {1,1,sizeof(int),&value};
+    cl_event ev = nullptr;
+    BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,1,&update,0,nullptr,&ev),CL_SUCCESS);
+    BOOST_CHECK_EQUAL(clWaitForEvents(1,&ev),CL_SUCCESS);
+    clReleaseEvent(ev);
+    BOOST_CHECK(all_equal(output,value));
+  }
+
+  std::fill(output.begin(),output.end(),-1);
+  BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,0,nullptr,0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clFinish(cq),CL_SUCCESS);
+  BOOST_CHECK(all_equal(output,7));
+
+  // The kernel object itself is not affected by graph updates
+  std::fill(output.begin(),output.end(),-1);
+  BOOST_CHECK_EQUAL(clEnqueueWriteBuffer(cq,buffer,CL_TRUE,0,global_size*sizeof(int),input.data(),0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clEnqueueNDRangeKernel(cq,gak.kernel,1,nullptr,&global_size,&local_size,0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clEnqueueReadBuffer(cq,buffer,CL_TRUE,0,global_size*sizeof(int),output.data(),0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK(all_equal(output,1));
+
+  BOOST_CHECK_EQUAL(xclReleaseGraph(graph),CL_SUCCESS);
+  clReleaseMemObject(buffer);
+  clReleaseCommandQueue(cq);
+}
+
+// Blocking commands are rejected while recording and are not added
+// to the graph, replays leave the buffer alone
+BOOST_AUTO_TEST_CASE( test_Graph4 )
+{
+  ocl_sw_emulation ocl;
+  cl_int err = CL_SUCCESS;
+
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+  const size_t bytes = global_size*sizeof(int);
+  auto buffer = clCreateBuffer(ocl.context,CL_MEM_READ_WRITE,bytes,nullptr,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+
+  std::vector<int> recorded(global_size,7);
+  std::vector<int> output(global_size,-1);
+  BOOST_REQUIRE_EQUAL(xclBeginGraphRecording(cq),CL_SUCCESS);
+  clEnqueueMarkerWithWaitList(cq,0,nullptr,nullptr);
+  BOOST_CHECK_EQUAL(clEnqueueWriteBuffer(cq,buffer,CL_TRUE,0,bytes,recorded.data(),0,nullptr,nullptr),CL_INVALID_OPERATION);
+  BOOST_CHECK_EQUAL(clEnqueueReadBuffer(cq,buffer,CL_TRUE,0,bytes,output.data(),0,nullptr,nullptr),CL_INVALID_OPERATION);
+  clEnqueueMapBuffer(cq,buffer,CL_TRUE,CL_MAP_READ,0,bytes,0,nullptr,nullptr,&err);
+  BOOST_CHECK_EQUAL(err,CL_INVALID_OPERATION);
+  auto graph = xclEndGraphRecording(cq,&err);
+  BOOST_REQUIRE_EQUAL(err,CL_SUCCESS);
+
+  std::vector<int> input(global_size,1);
+  BOOST_CHECK_EQUAL(clEnqueueWriteBuffer(cq,buffer,CL_TRUE,0,bytes,input.data(),0,nullptr,nullptr),CL_SUCCESS);
+  for (int i=0; i<3; ++i)
+    BOOST_CHECK_EQUAL(xclEnqueueGraph(cq,graph,0,nullptr,0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clFinish(cq),CL_SUCCESS);
+  BOOST_CHECK(all_equal(output,-1));
+
+  BOOST_CHECK_EQUAL(clEnqueueReadBuffer(cq,buffer,CL_TRUE,0,bytes,output.data(),0,nullptr,nullptr),CL_SUCCESS);
+  BOOST_CHECK(all_equal(output,1));
+
+  BOOST_CHECK_EQUAL(xclReleaseGraph(graph),CL_SUCCESS);
+  clReleaseMemObject(buffer);
+  clReleaseCommandQueue(cq);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
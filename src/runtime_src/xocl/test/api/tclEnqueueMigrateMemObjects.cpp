@@ -0,0 +1,76 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "setup.h"
+
+#include <CL/opencl.h>
+#include <vector>
+#include <memory>
+#include <cstring>
+
+// To run all tests in this suite use
+//  % em -env opt txocl --run_test=test_clEnqueueMigrateMemObjects
+
+BOOST_AUTO_TEST_SUITE ( test_clEnqueueMigrateMemObjects )
+
+// Migrate many small buffers in one call to the device and back.  The
+// buffers are in the same bank and transferred as one DMA submission.
+// Unaligned user buffers force separate host buffers so that the
+// round trip is visible in the user buffers.
+BOOST_AUTO_TEST_CASE( test_clEnqueueMigrateMemObjects1 )
+{
+  ocl_sw_emulation ocl;
+  cl_int err = CL_SUCCESS;
+
+  auto cq = clCreateCommandQueue(ocl.context,ocl.device,0,&err);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+
+  const size_t num = 30;
+  const size_t sz = 100;
+  std::unique_ptr<char[]> storage(new char[num*sz+1]);
+  auto ubuf = storage.get()+1;
+  for (size_t i=0; i<num*sz; ++i)
+    ubuf[i] = static_cast<char>(i);
+
+  std::vector<cl_mem> mems;
+  for (size_t i=0; i<num; ++i) {
+    mems.push_back(clCreateBuffer(ocl.context,CL_MEM_READ_WRITE|CL_MEM_USE_HOST_PTR,sz,ubuf+i*sz,&err));
+    BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+  }
+
+  cl_event ev = nullptr;
+  err = clEnqueueMigrateMemObjects(cq,num,mems.data(),0,0,nullptr,&ev);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clWaitForEvents(1,&ev),CL_SUCCESS);
+  clReleaseEvent(ev);
+
+  std::memset(ubuf,0,num*sz);
+
+  err = clEnqueueMigrateMemObjects(cq,num,mems.data(),CL_MIGRATE_MEM_OBJECT_HOST,0,nullptr,&ev);
+  BOOST_CHECK_EQUAL(err,CL_SUCCESS);
+  BOOST_CHECK_EQUAL(clWaitForEvents(1,&ev),CL_SUCCESS);
+  clReleaseEvent(ev);
+
+  for (size_t i=0; i<num*sz; ++i)
+    BOOST_CHECK_EQUAL(ubuf[i],static_cast<char>(i));
+
+  for (auto mem : mems)
+    clReleaseMemObject(mem);
+  clReleaseCommandQueue(cq);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
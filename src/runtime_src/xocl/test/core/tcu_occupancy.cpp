@@ -0,0 +1,81 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+#include "../xcl_test_helpers.h"
+
+#include "xocl/core/compute_unit.h"
+
+// To run all tests in this suite use
+//  % em -env opt txocl --run_test=test_cu_occupancy
+
+BOOST_AUTO_TEST_SUITE ( test_cu_occupancy )
+
+// Default depth is used until overlapping completions are observed
+BOOST_AUTO_TEST_CASE( test_cu_occupancy_default )
+{
+  xocl::cu_occupancy occ;
+  BOOST_CHECK_EQUAL(occ.get_pipeline_depth(2,4),2);
+  BOOST_CHECK_EQUAL(occ.get_pipeline_depth(20,4),4);
+
+  // Commands that did not overlap are idle time, not throughput
+  occ.record_completion(100,100);
+  occ.record_completion(100,1100);
+  occ.record_completion(100,2100);
+  BOOST_CHECK_EQUAL(occ.get_pipeline_depth(2,20),2);
+}
+
+// Little's law from latency and completion interval of pipelined commands
+BOOST_AUTO_TEST_CASE( test_cu_occupancy_depth )
+{
+  xocl::cu_occupancy occ;
+
+  // Latency 1000ns, one completion every 250ns: 4 in flight plus one queued
+  for (unsigned long now=1000; now<=5000; now+=250)
+    occ.record_completion(1000,now);
+  BOOST_CHECK_EQUAL(occ.get_pipeline_depth(2,20),5);
+  BOOST_CHECK_EQUAL(occ.get_pipeline_depth(2,4),4);
+
+  // Slower completions shrink the depth
+  for (unsigned long now=5500; now<=20000; now+=500)
+    occ.record_completion(1000,now);
+  BOOST_CHECK_EQUAL(occ.get_pipeline_depth(2,20),4);
+}
+
+// Pipeline depth is shared among contexts, at least one command each
+BOOST_AUTO_TEST_CASE( test_cu_occupancy_share )
+{
+  xocl::cu_occupancy occ;
+  for (unsigned long now=1000; now<=5000; now+=250)
+    occ.record_completion(1000,now);
+
+  BOOST_CHECK_EQUAL(occ.get_pipeline_share(2,20),5);
+  occ.add_context();
+  BOOST_CHECK_EQUAL(occ.get_pipeline_share(2,20),5);
+  occ.add_context();
+  BOOST_CHECK_EQUAL(occ.get_pipeline_share(2,20),3);
+  for (int i=0; i<8; ++i)
+    occ.add_context();
+  BOOST_CHECK_EQUAL(occ.get_num_contexts(),10);
+  BOOST_CHECK_EQUAL(occ.get_pipeline_share(2,20),1);
+
+  // Contexts that go away give back their share
+  for (int i=0; i<9; ++i)
+    occ.remove_context();
+  BOOST_CHECK_EQUAL(occ.get_pipeline_share(2,20),5);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
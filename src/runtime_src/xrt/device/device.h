@@ -27,6 +27,7 @@
 #include <thread>
 #include <mutex>
 #include <algorithm>
+#include <atomic>
 
 // Opaque handle to xrt::device
 // The handle can be static_cast to xrt::device
@@ -68,6 +69,7 @@ public:
 
   device(device&& rhs)
     : m_hal(std::move(rhs.m_hal)), m_setup_done(rhs.m_setup_done)
+    , m_outstanding(rhs.m_outstanding.load())
   {}
 
   ~device()
@@ -290,6 +292,50 @@ public:
   sync(const BufferObjectHandle& bo, size_t sz, size_t offset, direction dir, bool async=true)
   { return m_hal->sync(bo,sz,offset,dir,async); }
 
+  /**
+   * Sync multiple buffer objects in their entirety to/from device
+   *
+   * All buffer objects are transferred by one submission with one
+   * completion.  Sub-buffers of the same buffer object that are
+   * adjacent or overlap are transferred as a single range.
+   *
+   * @return
+   *   Event with int value, 0 on success or first error of the
+   *   transfers
+   */
+  event
+  sync(const std::vector<BufferObjectHandle>& bos, direction dir, bool async=true)
+  { return m_hal->sync(bos,dir,async); }
+
+  /**
+   * Sync sz bytes at offset to/from device through the host backing
+   * of the buffer object
+   *
+   * Used for user buffers that cannot be mapped directly by the
+   * buffer object, e.g. unaligned host pointers.  The range is split
+   * into chunks that are copied between ubuf and the host backing
+   * and transferred to/from device by the DMA worker threads, so that
+   * the copy of one chunk overlaps the DMA of other chunks.  The
+   * function returns when all chunks are done.
+   *
+   * @param ubuf
+   *   User buffer corresponding to offset 0 of the buffer object
+   * @return
+   *   Event with int value, 0 on success or first error of the
+   *   transfers
+   */
+  event
+  syncStaged(const BufferObjectHandle& bo, void* ubuf, size_t sz, size_t offset, direction dir)
+  { return m_hal->syncStaged(bo,ubuf,sz,offset,dir); }
+
+  /**
+   * @return
+   *   Number of bytes transferred in direction dir by syncStaged()
+   */
+  uint64_t
+  getStagedBytes(direction dir) const
+  { return m_hal->getStagedBytes(dir); }
+
   /**
    * Copy sz bytes at offset from device to device/host
    *
@@ -853,6 +899,38 @@ public:
     return m_hal->getSysfsPath(subdev, entry);
   }
 
+  /**
+   * @return
+   *   NUMA node of the device, or -1 if unknown
+   */
+  int
+  getNumaNode() const
+  {
+    return m_hal->getNumaNode();
+  }
+
+  /**
+   * Account for commands scheduled on this device that have
+   * yet to complete (see xrt::scheduler::schedule)
+   */
+  void
+  add_outstanding() const
+  {
+    ++m_outstanding;
+  }
+
+  void
+  remove_outstanding() const
+  {
+    --m_outstanding;
+  }
+
+  size_t
+  get_num_outstanding() const
+  {
+    return m_outstanding;
+  }
+
   /**
    * Explicitly schedule an arbitrary function on the device's
    * task queue.
@@ -892,6 +970,7 @@ private:
   mutable std::mutex m_buffers_mutex;
   xrt::uuid m_uuid;
   bool m_setup_done;
+  mutable std::atomic<size_t> m_outstanding {0};
 };
 
 /**
@@ -240,6 +240,22 @@ public:
   virtual event
   sync(const BufferObjectHandle& bo, size_t sz, size_t offset, direction dir, bool async) = 0;
 
+  virtual event
+  sync(const std::vector<BufferObjectHandle>& bos, direction dir, bool async) = 0;
+
+  virtual event
+  syncStaged(const BufferObjectHandle& bo, void* ubuf, size_t sz, size_t offset, direction dir) = 0;
+
+  /**
+   * @return
+   *   Number of bytes transferred in direction dir by syncStaged()
+   */
+  virtual uint64_t
+  getStagedBytes(direction dir) const
+  {
+    return 0;
+  }
+
   virtual event
   copy(const BufferObjectHandle& dst_bo, const BufferObjectHandle& src_bo, size_t sz,
        size_t dst_offset, size_t src_offset) = 0;
@@ -628,6 +644,16 @@ public:
     return operations_result<std::string>();
   }
 
+  /**
+   * @return
+   *   NUMA node of the device, or -1 if unknown
+   */
+  virtual int
+  getNumaNode() const
+  {
+    return -1;
+  }
+
   virtual task::queue*
   getQueue(hal::queue_type qt) {return nullptr; }
 
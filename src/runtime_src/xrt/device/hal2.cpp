@@ -16,12 +16,16 @@
 
 #include "hal2.h"
 #include "xrt/util/thread.h"
+#include "xrt/util/numa.h"
 #include "driver/include/ert.h"
 
+#include <algorithm>
 #include <cstring> // for std::memcpy
 #include <iostream>
 #include <cerrno>
+#include <cstdlib>
 #include <sys/mman.h> // for POSIX munmap
+#include <unistd.h> // for getpagesize
 
 namespace xrt { namespace hal2 {
 
@@ -37,6 +41,7 @@ device::
   close();
   for (auto& q : m_queue)
     q.stop();
+  m_staging_queue.stop();
   for (auto& t : m_workers)
     t.join();
 }
@@ -88,14 +93,23 @@ setup()
   if (!threads) // Guard against drivers who do not set m_devinfo.mDMAThreads
     threads = 2;
 
-  XRT_DEBUG(std::cout,"Creating ",2*threads," DMA worker threads\n");
+  auto numa_path = getSysfsPath("","numa_node");
+  if (numa_path.valid())
+    m_numa_node = xrt::numa::get_node(numa_path.get());
+
+  XRT_DEBUG(std::cout,"Creating ",3*threads," DMA worker threads\n");
   for (unsigned int i=0; i<threads; ++i) {
-    // read and write queue workers
+    // read, write, and staging queue workers
     m_workers.emplace_back(xrt::thread(task::worker2,std::ref(m_queue[static_cast<qtype>(hal::queue_type::read)]),"read"));
     m_workers.emplace_back(xrt::thread(task::worker2,std::ref(m_queue[static_cast<qtype>(hal::queue_type::write)]),"write"));
+    m_workers.emplace_back(xrt::thread(task::worker2,std::ref(m_staging_queue),"staging"));
   }
   // single misc queue worker
   m_workers.emplace_back(xrt::thread(task::worker2,std::ref(m_queue[static_cast<qtype>(hal::queue_type::misc)]),"misc"));
+
+  // keep DMA workers on the cores local to the device
+  for (auto& t : m_workers)
+    xrt::numa::set_affinity(t,m_numa_node);
 #endif
 }
 
@@ -147,6 +161,18 @@ release_cu_context(const uuid& uuid,size_t cuidx)
   }
 }
 
+void
+device::
+unmapBO(unsigned int handle, void* addr, size_t size) const
+{
+  // Shims that cache mappings per BO must be told when a mapping is
+  // released, other shims hand out plain mmap'ed memory
+  if (m_ops->mUnmapBO)
+    m_ops->mUnmapBO(m_handle, handle, addr);
+  else
+    munmap(addr, size);
+}
+
 ExecBufferObjectHandle
 device::
 allocExecBuffer(size_t sz)
@@ -154,7 +180,7 @@ allocExecBuffer(size_t sz)
   auto delBufferObject = [this](ExecBufferObjectHandle::element_type* ebo) {
     ExecBufferObject* bo = static_cast<ExecBufferObject*>(ebo);
     XRT_DEBUG(std::cout,"deleted exec buffer object\n");
-    munmap(bo->data, bo->size);
+    unmapBO(bo->handle, bo->data, bo->size);
     m_ops->mFreeBO(m_handle, bo->handle);
     delete bo;
   };
@@ -180,7 +206,7 @@ alloc(size_t sz)
   auto delBufferObject = [this](BufferObjectHandle::element_type* vbo) {
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUGF("deleted buffer object device address(%p,%d)\n",bo->deviceAddr,bo->size);
-    munmap(bo->hostAddr, bo->size);
+    unmapBO(bo->handle, bo->hostAddr, bo->size);
     m_ops->mFreeBO(m_handle, bo->handle);
     delete bo;
   };
@@ -188,6 +214,7 @@ alloc(size_t sz)
   xclBOKind kind = XCL_BO_DEVICE_RAM; //TODO: check default
   uint64_t flags = 0xFFFFFF; //TODO: check default, any bank.
   auto ubo = std::make_unique<BufferObject>();
+  xrt::numa::scoped_preferred_node numa(m_numa_node);
   ubo->handle = m_ops->mAllocBO(m_handle, sz, kind, flags);
   if (ubo->handle == 0xffffffff)
     throw std::bad_alloc();
@@ -239,7 +266,7 @@ alloc(size_t sz, Domain domain, uint64_t memory_index, void* userptr)
     XRT_DEBUGF("deleted buffer object device address(%p,%d)\n",bo->deviceAddr,bo->size);
     if (bo->kind != XCL_BO_DEVICE_PREALLOCATED_BRAM) {
       if (mmapRequired)
-        munmap(bo->hostAddr, bo->size);
+        unmapBO(bo->handle, bo->hostAddr, bo->size);
       m_ops->mFreeBO(m_handle, bo->handle);
     }
     delete bo;
@@ -253,6 +280,8 @@ alloc(size_t sz, Domain domain, uint64_t memory_index, void* userptr)
     ubo->hostAddr = nullptr;
   }
   else {
+    // host backing of buffer objects owned by runtime goes on local node
+    xrt::numa::scoped_preferred_node numa(userptr ? -1 : m_numa_node);
     //uint64_t flags = (1<<memory_index);
     uint64_t flags = memory_index;
     xclBOKind kind = XCL_BO_DEVICE_RAM; //TODO: check default
@@ -381,6 +410,186 @@ device::sync(const BufferObjectHandle& boh, size_t sz, size_t offset, direction
   return event(typed_event<int>(m_ops->mSyncBO(m_handle, bo->handle, dir, sz, offset+bo->offset)));
 }
 
+bool
+sync_staged_transfer(const operations* ops, xclDeviceHandle handle,
+                     const std::vector<sync_range>& xfer, char* staging, xclBOSyncDirection dir)
+{
+  auto addr = xfer.front().device_addr + xfer.front().begin;
+  size_t total = 0;
+  for (auto& r : xfer)
+    total += r.end - r.begin;
+
+  // Shims return the ioctl() status, not the number of bytes moved
+  if (dir==XCL_BO_SYNC_BO_TO_DEVICE) {
+    size_t off = 0;
+    for (auto& r : xfer) {
+      std::memcpy(staging+off,r.host_addr+r.begin,r.end-r.begin);
+      off += r.end - r.begin;
+    }
+    return ops->mUnmgdPwrite(handle,0,staging,total,addr) >= 0;
+  }
+
+  if (ops->mUnmgdPread(handle,0,staging,total,addr) < 0)
+    return false;
+  size_t off = 0;
+  for (auto& r : xfer) {
+    std::memcpy(r.host_addr+r.begin,staging+off,r.end-r.begin);
+    off += r.end - r.begin;
+  }
+  return true;
+}
+
+std::vector<std::vector<sync_range>>
+plan_sync(std::vector<sync_range> ranges, size_t max_merge)
+{
+  // Sub buffers share the handle of their parent, transfer adjacent
+  // or overlapping regions of the same handle as one range
+  std::sort(ranges.begin(),ranges.end(),[](const sync_range& r1, const sync_range& r2) {
+      return r1.handle==r2.handle ? r1.begin<r2.begin : r1.handle<r2.handle;
+    });
+  size_t last = 0;
+  for (size_t idx=1; idx<ranges.size(); ++idx) {
+    auto& r = ranges[idx];
+    if (r.handle==ranges[last].handle && r.begin<=ranges[last].end)
+      ranges[last].end = std::max(ranges[last].end,r.end);
+    else
+      ranges[++last] = r;
+  }
+  if (!ranges.empty())
+    ranges.resize(last+1);
+
+  // Group ranges that follow each other in device memory
+  std::sort(ranges.begin(),ranges.end(),[](const sync_range& r1, const sync_range& r2) {
+      return r1.device_addr+r1.begin < r2.device_addr+r2.begin;
+    });
+  std::vector<std::vector<sync_range>> transfers;
+  size_t bytes = 0;
+  auto mergeable = [max_merge](const sync_range& rng) {
+    return rng.host_addr && rng.end-rng.begin<=max_merge;
+  };
+  for (auto& r : ranges) {
+    auto sz = r.end - r.begin;
+    if (!transfers.empty() && mergeable(r) && bytes+sz<=max_merge) {
+      auto& prev = transfers.back().back();
+      if (mergeable(prev) && prev.device_addr+prev.end==r.device_addr+r.begin) {
+        transfers.back().push_back(r);
+        bytes += sz;
+        continue;
+      }
+    }
+    transfers.push_back({r});
+    bytes = sz;
+  }
+  return transfers;
+}
+
+event
+device::
+sync(const std::vector<BufferObjectHandle>& bohs, direction dir1, bool async)
+{
+  xclBOSyncDirection dir = XCL_BO_SYNC_BO_TO_DEVICE;
+  if(dir1 == direction::DEVICE2HOST)
+    dir = XCL_BO_SYNC_BO_FROM_DEVICE;
+
+  std::vector<sync_range> ranges;
+  ranges.reserve(bohs.size());
+  for (auto& boh : bohs) {
+    BufferObject* bo = getBufferObject(boh);
+    auto host = bo->hostAddr ? static_cast<char*>(bo->hostAddr) - bo->offset : nullptr;
+    ranges.push_back({bo->handle,bo->offset,bo->offset+bo->size,bo->deviceAddr-bo->offset,host});
+  }
+
+  // Small buffer objects are combined into one transfer through a
+  // staging buffer when the shim supports unmanaged DMA
+  const size_t max_merge = (m_ops->mUnmgdPread && m_ops->mUnmgdPwrite) ? 256*1024 : 0;
+  auto transfers = plan_sync(std::move(ranges),max_merge);
+
+  // One submission for all transfers, returns first error if any
+  auto sync_transfers = [this,dir,max_merge](const std::vector<std::vector<sync_range>>& xfers) {
+    std::unique_ptr<char,decltype(&std::free)> staging(nullptr,&std::free);
+    int err = 0;
+    for (auto& xfer : xfers) {
+      if (xfer.size() > 1) {
+        if (!staging) {
+          void* ptr = nullptr;
+          if (!posix_memalign(&ptr,getpagesize(),max_merge))
+            staging.reset(static_cast<char*>(ptr));
+        }
+        if (staging && sync_staged_transfer(m_ops.get(),m_handle,xfer,staging.get(),dir))
+          continue;
+      }
+      // Single buffer object, or merged transfer failed
+      for (auto& r : xfer) {
+        auto ret = m_ops->mSyncBO(m_handle,r.handle,dir,r.end-r.begin,r.begin);
+        if (ret && !err)
+          err = ret;
+      }
+    }
+    return err;
+  };
+
+  if (async) {
+    auto qt = (dir==XCL_BO_SYNC_BO_FROM_DEVICE) ? hal::queue_type::read : hal::queue_type::write;
+    return event(addTaskF(sync_transfers,qt,std::move(transfers)));
+  }
+  return event(typed_event<int>(sync_transfers(transfers)));
+}
+
+event
+device::
+syncStaged(const BufferObjectHandle& boh, void* ubuf, size_t sz, size_t offset, direction dir1)
+{
+  xclBOSyncDirection dir = XCL_BO_SYNC_BO_TO_DEVICE;
+  if(dir1 == direction::DEVICE2HOST)
+    dir = XCL_BO_SYNC_BO_FROM_DEVICE;
+
+  BufferObject* bo = getBufferObject(boh);
+  auto hbuf = static_cast<char*>(bo->hostAddr);
+  auto user = static_cast<char*>(ubuf);
+
+  // Copy and DMA of one chunk, to device copies before DMA, from
+  // device copies after DMA
+  auto stage = [this,bo,hbuf,user,dir](size_t off, size_t n) {
+    if (dir==XCL_BO_SYNC_BO_TO_DEVICE)
+      std::memcpy(hbuf+off,user+off,n);
+    auto ret = m_ops->mSyncBO(m_handle,bo->handle,dir,n,bo->offset+off);
+    if (!ret && dir==XCL_BO_SYNC_BO_FROM_DEVICE)
+      std::memcpy(user+off,hbuf+off,n);
+    return ret;
+  };
+
+  // Chunks are aligned within the buffer object so that only first
+  // and last chunk can be partial.  Each chunk is a separate task on
+  // the staging queue, whose workers process chunks concurrently.
+  // The read and write queues cannot be used, the caller may be one
+  // of their workers and would wait for itself.
+  size_t chunk = config::get_staging_chunk_size();
+  std::vector<std::pair<decltype(task::createF(m_staging_queue,stage,offset,sz)),size_t>> chunks;
+  int err = 0;
+  uint64_t bytes = 0; // staged without error
+  auto done = [&err,&bytes](int ret, size_t n) {
+    if (!ret)
+      bytes += n;
+    else if (!err)
+      err = ret;
+  };
+
+  for (size_t off=offset, end=offset+sz; off<end; ) {
+    auto n = chunk ? std::min(end-off,chunk-(off%chunk)) : end-off;
+    if (m_workers.empty())
+      done(stage(off,n),n); // no workers started, stage on this thread
+    else
+      chunks.emplace_back(task::createF(m_staging_queue,stage,off,n),n);
+    off += n;
+  }
+
+  for (auto& c : chunks)
+    done(c.first.get(),c.second);
+
+  m_staged_bytes[dir==XCL_BO_SYNC_BO_TO_DEVICE ? 0 : 1] += bytes;
+  return event(typed_event<int>(std::move(err)));
+}
+
 event
 device::
 copy(const BufferObjectHandle& dst_boh, const BufferObjectHandle& src_boh, size_t sz, size_t dst_offset, size_t src_offset)
@@ -518,7 +727,7 @@ getBufferFromFd(const int fd, size_t& size, unsigned flags)
   auto delBufferObject = [this](BufferObjectHandle::element_type* vbo) {
     BufferObject* bo = static_cast<BufferObject*>(vbo);
     XRT_DEBUGF("deleted buffer object device address(%p,%d)\n",bo->deviceAddr,bo->size);
-    munmap(bo->hostAddr, bo->size);
+    unmapBO(bo->handle, bo->hostAddr, bo->size);
     m_ops->mFreeBO(m_handle, bo->handle);
     delete bo;
   };
@@ -23,6 +23,8 @@
 
 #include "driver/include/ert.h"
 
+#include <array>
+#include <atomic>
 #include <cassert>
 
 #include <functional>
@@ -30,6 +32,7 @@
 #include <cstring>
 #include <memory>
 #include <map>
+#include <vector>
 
 namespace xrt { namespace hal2 {
 
@@ -41,6 +44,55 @@ using svmbomap_type = std::map<void *, BufferObjectHandle>;
 using svmbomap_value_type = svmbomap_type::value_type;
 using svmbomap_iterator_type = svmbomap_type::iterator;
 
+/**
+ * Region of a buffer object to be synced as part of a batch
+ *
+ * @handle: shim handle of the buffer object
+ * @begin: start offset of the region within the buffer object
+ * @end: end offset (exclusive) of the region
+ * @device_addr: device address of offset 0 of the buffer object
+ * @host_addr: host address of offset 0, nullptr if the BO has no host backing
+ */
+struct sync_range
+{
+  unsigned int handle;
+  size_t begin;
+  size_t end;
+  uint64_t device_addr;
+  char* host_addr;
+};
+
+/**
+ * plan_sync() - Group the ranges of a batched sync into DMA transfers
+ *
+ * @ranges: regions to sync, in any order
+ * @max_merge: largest transfer that may combine several buffer objects,
+ *  0 disables merging across buffer objects
+ * Return: list of transfers, each a list of ranges in device address order
+ *
+ * Adjacent or overlapping regions of the same handle (sub-buffers) are
+ * always combined.  Regions of different buffer objects that are
+ * contiguous in device memory, hence in the same bank, are combined
+ * into one transfer as long as the transfer stays within @max_merge
+ * and every region is backed by host memory.
+ */
+std::vector<std::vector<sync_range>>
+plan_sync(std::vector<sync_range> ranges, size_t max_merge);
+
+/**
+ * sync_staged_transfer() - Sync one merged transfer with a single unmanaged DMA
+ *
+ * @xfer: ranges of the transfer, contiguous in device memory
+ * @staging: buffer large enough for all ranges of @xfer
+ * Return: true on success, false if the ranges must be synced one by one
+ *
+ * The ranges are packed into (or unpacked from) @staging around one
+ * xclUnmgdPwrite or xclUnmgdPread.
+ */
+bool
+sync_staged_transfer(const operations* ops, xclDeviceHandle handle,
+                     const std::vector<sync_range>& xfer, char* staging, xclBOSyncDirection dir);
+
 /**
  * HAL device for hal 2.0.
  *
@@ -60,6 +112,9 @@ class device : public xrt::hal::device
   // by a worker simultaneously
   using qtype = std::underlying_type<hal::queue_type>::type;
   std::array<task::queue,static_cast<qtype>(hal::queue_type::max)> m_queue;
+  // chunks of syncStaged have their own workers, syncStaged itself is
+  // called from tasks on the read and write queues
+  task::queue m_staging_queue;
   std::vector<std::thread> m_workers;
   svmbomap_type m_svmbomap;
 
@@ -68,6 +123,10 @@ class device : public xrt::hal::device
 
   hal2::device_handle m_handle;
   hal2::device_info m_devinfo;
+  int m_numa_node = -1;
+
+  // Bytes successfully transferred by syncStaged, to and from device
+  std::array<std::atomic<uint64_t>,2> m_staged_bytes {{{0},{0}}};
 
   struct BufferObject : hal::buffer_object
   {
@@ -97,6 +156,10 @@ class device : public xrt::hal::device
   ExecBufferObject*
   getExecBufferObject(const ExecBufferObjectHandle& boh) const;
 
+  // Release a mapping obtained from the shim's xclMapBO
+  void
+  unmapBO(unsigned int handle, void* addr, size_t size) const;
+
   void
   openOrError() const
   {
@@ -303,6 +366,18 @@ public:
   virtual event
   sync(const BufferObjectHandle& bo, size_t sz, size_t offset, direction dir, bool async);
 
+  virtual event
+  sync(const std::vector<BufferObjectHandle>& bos, direction dir, bool async);
+
+  virtual event
+  syncStaged(const BufferObjectHandle& bo, void* ubuf, size_t sz, size_t offset, direction dir);
+
+  virtual uint64_t
+  getStagedBytes(direction dir) const
+  {
+    return m_staged_bytes[dir==direction::HOST2DEVICE ? 0 : 1];
+  }
+
   virtual event
   copy(const BufferObjectHandle& dst_bo, const BufferObjectHandle& src_bo, size_t sz, size_t dst_offset, size_t src_offset);
 
@@ -599,6 +674,12 @@ public:
     return m_handle;
   }
 
+  virtual int
+  getNumaNode() const
+  {
+    return m_numa_node;
+  }
+
   virtual hal::operations_result<std::string>
   getSysfsPath(const std::string& subdev, const std::string& entry)
   {
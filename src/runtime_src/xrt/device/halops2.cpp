@@ -43,6 +43,9 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   ,mSyncBO(0)
   ,mCopyBO(0)
   ,mMapBO(0)
+  ,mUnmapBO(0)
+  ,mUnmgdPread(0)
+  ,mUnmgdPwrite(0)
   ,mWrite(0)
   ,mRead(0)
   ,mReClock2(0)
@@ -121,6 +124,9 @@ operations(const std::string &fileName, void *fileHandle, unsigned int count)
   mSyncBO   = (syncBOFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclSyncBO");
   mCopyBO   = (copyBOFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclCopyBO");
   mMapBO    = (mapBOFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclMapBO");
+  mUnmapBO  = (unmapBOFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclUnmapBO");
+  mUnmgdPread  = (unmgdPreadFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclUnmgdPread");
+  mUnmgdPwrite = (unmgdPwriteFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclUnmgdPwrite");
 
   mWrite    = (writeFuncType)dlsym(const_cast<void *>(mDriverHandle), "xclWrite");
   if(!mWrite)
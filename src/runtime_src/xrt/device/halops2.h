@@ -73,6 +73,7 @@ private:
                                  size_t size, size_t dst_offset, size_t src_offset);
 
   typedef void* (* mapBOFuncType)(xclDeviceHandle handle, unsigned int boHandle, bool write);
+  typedef int (* unmapBOFuncType)(xclDeviceHandle handle, unsigned int boHandle, void* addr);
 
   typedef int (* reClock2FuncType)(xclDeviceHandle handle, unsigned short region,
                                    const unsigned short *targetFreqMHz);
@@ -117,6 +118,9 @@ private:
                                       bool shared);
   typedef int (* closeContextFuncType)(xclDeviceHandle handle, const uuid_t xclbinId, unsigned ipIndex);
 
+  typedef ssize_t (* unmgdPreadFuncType)(xclDeviceHandle handle, unsigned flags, void *buf, size_t size, uint64_t offset);
+  typedef ssize_t (* unmgdPwriteFuncType)(xclDeviceHandle handle, unsigned flags, const void *buf, size_t size, uint64_t offset);
+
   //Streaming
   typedef int     (*createWriteQueueFuncType)(xclDeviceHandle handle,xclQueueContext *q_ctx, uint64_t *q_hdl);
   typedef int     (*createReadQueueFuncType)(xclDeviceHandle handle,xclQueueContext *q_ctx, uint64_t *q_hdl);
@@ -179,6 +183,9 @@ public:
   syncBOFuncType mSyncBO;
   copyBOFuncType mCopyBO;
   mapBOFuncType mMapBO;
+  unmapBOFuncType mUnmapBO; // optional, shims that cache mappings
+  unmgdPreadFuncType mUnmgdPread;   // optional, batched syncs
+  unmgdPwriteFuncType mUnmgdPwrite; // optional, batched syncs
   writeFuncType mWrite;
   readFuncType mRead;
   reClock2FuncType mReClock2;
@@ -112,6 +112,7 @@ command(command&& rhs)
   : m_uid(rhs.m_uid), m_device(rhs.m_device)
   , m_exec_bo(std::move(rhs.m_exec_bo))
   , m_packet(std::move(rhs.m_packet))
+  , m_cu_affinity(rhs.m_cu_affinity)
 {
   rhs.m_exec_bo = 0;
 }
@@ -126,6 +127,22 @@ command::
   }
 }
 
+void
+command::
+notify(ert_cmd_state s)
+{
+  if (s==ERT_CMD_STATE_COMPLETED) {
+    xrt::scheduler::retire(this);
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_done = true;
+    m_cmd_done.notify_all();
+    done();
+  }
+  else if (s==ERT_CMD_STATE_RUNNING) {
+    start();
+  }
+}
+
 int
 command::
 execute()
@@ -40,6 +40,7 @@ public:
   using packet_type = xrt::regmap_placed<uint32_t,regmap_size>;
   using value_type = packet_type::word_type;
   using buffer_type = xrt::device::ExecBufferObjectHandle;
+  using cu_mask_type = std::array<value_type,4>;
 
   /**
    * Construct a command object to be schedule on device
@@ -176,6 +177,25 @@ public:
     return reinterpret_cast<ERT_COMMAND_TYPE>(m_packet.data());
   }
 
+  /**
+   * Set preferred CUs for a start kernel command
+   *
+   * The mask has the same layout as the command cu masks.  This is a
+   * hint used by the software scheduler affinity policy, a preferred
+   * CU must also be set in the command cu mask to be used.
+   */
+  void
+  set_cu_affinity(const cu_mask_type& mask)
+  {
+    m_cu_affinity = mask;
+  }
+
+  const cu_mask_type&
+  get_cu_affinity() const
+  {
+    return m_cu_affinity;
+  }
+
   /**
    * Execute this command
    */
@@ -229,24 +249,14 @@ public:
    * implementation.  Should be private and befriended.
    */
   void
-  notify(ert_cmd_state s)
-  {
-    if (s==ERT_CMD_STATE_COMPLETED) {
-      std::lock_guard<std::mutex> lk(m_mutex);
-      m_done = true;
-      m_cmd_done.notify_all();
-      done();
-    }
-    else if (s==ERT_CMD_STATE_RUNNING) {
-      start();
-    }
-  }
+  notify(ert_cmd_state s);
 
 private:
   unsigned int m_uid;
   xrt::device* m_device;
   buffer_type m_exec_bo;
   mutable packet_type m_packet;
+  cu_mask_type m_cu_affinity {{0}};
 
   // synchronization
   bool m_done = false;
@@ -26,6 +26,7 @@
 #include "xrt/config.h"
 #include "xrt/util/error.h"
 #include "xrt/util/thread.h"
+#include "xrt/util/numa.h"
 #include "xrt/util/debug.h"
 #include "xrt/util/time.h"
 #include "xrt/util/task.h"
@@ -239,7 +240,8 @@ init(xrt::device* device, const axlf*)
   if (itr==s_device_monitor_threads.end()) {
     XRT_DEBUG(std::cout,"creating monitor thread and queue for device '",device->getName(),"'\n");
     s_device_cmds.emplace(device,command_queue_type());
-    s_device_monitor_threads.emplace(device,xrt::thread(::monitor,device));
+    auto ret = s_device_monitor_threads.emplace(device,xrt::thread(::monitor,device));
+    xrt::numa::set_affinity((*ret.first).second,device->getNumaNode());
   }
 }
 
@@ -104,10 +104,30 @@ stop()
 int
 schedule(const command_type& cmd)
 {
-  if (kds_enabled())
-    return kds::schedule(cmd);
-  else
-    return sws::schedule(cmd);
+  auto device = cmd->get_device();
+  device->add_outstanding();
+  try {
+    if (kds_enabled())
+      return kds::schedule(cmd);
+    else
+      return sws::schedule(cmd);
+  }
+  catch (...) {
+    device->remove_outstanding();
+    throw;
+  }
+}
+
+void
+retire(const command* cmd)
+{
+  cmd->get_device()->remove_outstanding();
+}
+
+size_t
+get_num_outstanding(const xrt::device* device)
+{
+  return device->get_num_outstanding();
 }
 
 void
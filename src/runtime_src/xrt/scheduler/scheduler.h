@@ -18,6 +18,7 @@
 #define xrt_scheduler_h_
 
 #include "xrt/scheduler/command.h"
+#include <string>
 #include <vector>
 
 namespace xrt {
@@ -44,6 +45,25 @@ init(xrt::device* device, const axlf* top);
 void
 init(xrt::device* device, const std::vector<uint64_t>& cu_addr_map);
 
+/**
+ * Select CU selection policy for commands scheduled on device
+ *
+ * @policy: one of "first_fit", "round_robin", "least_loaded", "affinity"
+ *
+ * The default policy is taken from Runtime.sws_cu_policy.  Must be
+ * called after the scheduler has been initialized for the device.
+ */
+void
+set_cu_policy(const xrt::device* device, const std::string& policy);
+
+/**
+ * Number of commands started on each CU of device
+ *
+ * @return Vector indexed by CU index, empty if no scheduler for device
+ */
+std::vector<size_t>
+get_cu_usage(const xrt::device* device);
+
 } // sws
 
 /**
@@ -72,6 +92,23 @@ namespace scheduler {
 int
 schedule(const command_type& cmd);
 
+/**
+ * Account for completion of a scheduled command.
+ *
+ * Called by xrt::command when the scheduler notifies completion.
+ */
+void
+retire(const command* cmd);
+
+/**
+ * Number of commands scheduled on a device that have yet to complete
+ *
+ * This is the current scheduler queue depth for the device, including
+ * commands that are running on a CU.
+ */
+size_t
+get_num_outstanding(const xrt::device* device);
+
 void
 start();
 
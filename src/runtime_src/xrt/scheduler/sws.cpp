@@ -28,9 +28,11 @@
 #include "driver/include/ert.h"
 #include "driver/include/xclbin.h"
 #include "driver/common/xclbin_parser.h"
+#include "xrt/util/message.h"
 #include "command.h"
+#include "sws_policy.h"
 #include <limits>
-#include <bitset>
+#include <atomic>
 #include <vector>
 #include <list>
 #include <map>
@@ -66,13 +68,16 @@ using cmd_ptr     = std::shared_ptr<xrt::command>;
 ////////////////////////////////////////////////////////////////
 // Constants
 ////////////////////////////////////////////////////////////////
-const size_type MAX_CUS = 128;
-using cu_bitset_type = std::bitset<MAX_CUS>;
-
-const size_type no_index = std::numeric_limits<size_type>::max();
-
+using xrt::sws::MAX_CUS;
+using xrt::sws::no_index;
 const size_type MAX_SLOTS = 128;
 
+using xrt::sws::bitmap;
+using xrt::sws::cu_bitmap_type;
+using xrt::sws::cu_load;
+using xrt::sws::cu_policy;
+using slot_bitmap_type = bitmap<MAX_SLOTS>;
+
 // FFA  handling
 const value_type AP_START    = 0x1;
 const value_type AP_DONE     = 0x2;
@@ -110,7 +115,8 @@ class exec_core;
 // @m_ecmd: xrt command packet data
 // @m_kcmd: xrt command packet data cast to start kernel cmd
 // @m_exec: execution core on which this command executes
-// @m_cus: bitset representing the CUs ths cmd can execute on
+// @m_cus: bitmap representing the CUs ths cmd can execute on
+// @m_affinity: bitmap representing the CUs preferred by this cmd
 // @m_state: current state of this command
 // @slotidx: command queue slot when command is submitted
 // @cuidx: index of CU executing this command
@@ -124,7 +130,8 @@ private:
     ert_start_kernel_cmd* m_kcmd;
   };
   exec_core* m_exec;
-  cu_bitset_type m_cus;
+  cu_bitmap_type m_cus;
+  cu_bitmap_type m_affinity;
   ert_cmd_state m_state;
 
   size_type m_uid;
@@ -139,11 +146,12 @@ public:
     static size_type count = 0;
     m_uid = count++;
     if (m_ecmd->opcode==ERT_START_KERNEL) {
-      m_cus |= m_kcmd->cu_mask;
-      for (size_type i=0; i<m_kcmd->extra_cu_masks; ++i) {
-        cu_bitset_type mask(m_kcmd->data[i]);
-        m_cus |= (mask<<sizeof(value_type)*8*i);
-      }
+      m_cus.set_word32(0,m_kcmd->cu_mask);
+      for (size_type i=0; i<m_kcmd->extra_cu_masks; ++i)
+        m_cus.set_word32(i+1,m_kcmd->data[i]);
+      auto& affinity = m_cmd->get_cu_affinity();
+      for (size_type i=0; i<affinity.size(); ++i)
+        m_affinity.set_word32(i,affinity[i]);
     }
   }
 
@@ -178,16 +186,16 @@ public:
   void
   notify_start(value_type cuidx)
   {
-    if (!cu_trace_enabled)
-      return;
-
     // Update command packet cumasks to reflect running cu before
-    // invoking call back
+    // invoking call back.  The host also uses the updated mask upon
+    // command completion.
     auto mask = cuidx >> 5;
     auto num_masks = cumasks();
     for (size_type midx=0; midx<num_masks; ++midx)
       m_ecmd->data[midx] = mask==midx ? 1 << (cuidx - (midx<<5)) : 0;
-    m_cmd->notify(ERT_CMD_STATE_RUNNING);
+
+    if (cu_trace_enabled)
+      m_cmd->notify(ERT_CMD_STATE_RUNNING);
   }
 
   // @return current state of the command object
@@ -278,6 +286,20 @@ public:
     return m_cus.test(cu_idx);
   }
 
+  // CUs this command can execute on
+  const cu_bitmap_type&
+  get_cus() const
+  {
+    return m_cus;
+  }
+
+  // CUs preferred by this command, empty if no preference
+  const cu_bitmap_type&
+  get_affinity() const
+  {
+    return m_affinity;
+  }
+
   // Get the execution core for this command object
   exec_core*
   get_exec() const
@@ -316,6 +338,7 @@ static std::atomic<unsigned int> s_num_pending {0};
 // @addr: base address of this CU
 // @ctrlreg: state of the CU (value of AXI-lite control register)
 // @done_counter: number of command that have completed (<=running_queue.size())
+// @start_cnt: number of commands started on this CU, can be read by host
 //
 // The CU supports HLS data flow model where running_queue represents
 // all the commands that have been started on this CU. The CU is polled
@@ -338,6 +361,8 @@ private:
   mutable size_type done_cnt = 0;
   mutable size_type run_cnt = 0;
 
+  std::atomic<size_t> start_cnt {0};
+
   void
   poll() const
   {
@@ -380,6 +405,20 @@ public:
       : !(ctrlreg & AP_START);
   }
 
+  // Number of commands started on this CU that have not been popped
+  size_type
+  outstanding() const
+  {
+    return running_queue.size();
+  }
+
+  // Number of commands started on this CU
+  size_t
+  started() const
+  {
+    return start_cnt;
+  }
+
   // Get the first completed command from the running queue
   //
   // @return
@@ -438,6 +477,7 @@ public:
 
     running_queue.push(xcmd);
     ++run_cnt;
+    ++start_cnt;
     XRT_DEBUGF("started cu(%d) xcmd(%d) done(%d) run(%d)\n",idx,xcmd->get_uid(),done_cnt,run_cnt);
   }
 };
@@ -449,8 +489,10 @@ public:
 // @xdev: the xrt device on which to execute
 // @scheduler: scheduler that manages this execution core
 // @submit_queue: queue holding command that have been submitted by scheduler
-// @slot_status: bitset representing free/busy slots in submit_queue
+// @slot_status: bitmap representing free/busy slots in submit_queue
 // @cu_usage: list of CUs managed by this execution core (device)
+// @cu_ready: bitmap of CUs known to be ready to start a command
+// @policy: CU selection policy (see sws_policy.h)
 // @num_slots: number of slots in submit queue
 // @num_cus: number of CUs on device
 //
@@ -466,7 +508,7 @@ public:
 // started, so scheduler will revisit the command and check for its
 // completion.
 ////////////////////////////////////////////////////////////////
-class exec_core
+class exec_core : public cu_load
 {
   // device
   xrt::device* m_xdev = nullptr;
@@ -477,11 +519,17 @@ class exec_core
   // Commands submitted to this device, the queue is slot based
   // and a slot becomes free when its command is started on a CU
   xocl_cmd* submit_queue[MAX_SLOTS] = {nullptr}; // reflects ERT CQ # slots
-  std::bitset<MAX_SLOTS> slot_status;
+  slot_bitmap_type slot_status;
 
   // Compute units on this device
   std::vector<std::unique_ptr<xocl_cu>> cu_usage;
 
+  // A CU is marked busy when started and marked ready again when
+  // a poll shows that it can accept another command
+  cu_bitmap_type cu_ready;
+
+  std::atomic<const cu_policy*> policy {nullptr};
+
   size_type num_slots = 0;
   size_type num_cus = 0;
 
@@ -490,8 +538,19 @@ public:
     : m_xdev(xdev), m_scheduler(xs), num_slots(slots), num_cus(cu_amap.size())
   {
     cu_usage.reserve(cu_amap.size());
-    for (size_type idx=0; idx<cu_amap.size(); ++idx)
+    for (size_type idx=0; idx<cu_amap.size(); ++idx) {
       cu_usage.push_back(std::make_unique<xocl_cu>(xdev,idx,cu_amap[idx]));
+      cu_ready.set(idx);
+    }
+
+    auto name = xrt::config::get_sws_cu_policy();
+    policy = cu_policy::get(name);
+    if (!policy) {
+      xrt::message::send(xrt::message::severity_level::WARNING,
+                         "Unknown Runtime.sws_cu_policy '" + name + "', using "
+                         + cu_policy::default_name());
+      policy = cu_policy::get(cu_policy::default_name());
+    }
   }
 
   // Scheduler mananging this execution core
@@ -501,6 +560,37 @@ public:
     return m_scheduler;
   }
 
+  // Select CU selection policy
+  void
+  set_policy(const cu_policy* p)
+  {
+    policy = p;
+  }
+
+  // Load of CU as seen by the CU selection policy
+  virtual size_type
+  outstanding(size_type cuidx) const
+  {
+    return cu_usage[cuidx]->outstanding();
+  }
+
+  virtual size_t
+  started(size_type cuidx) const
+  {
+    return cu_usage[cuidx]->started();
+  }
+
+  // Number of commands started on each CU
+  std::vector<size_t>
+  get_cu_usage() const
+  {
+    std::vector<size_t> usage;
+    usage.reserve(num_cus);
+    for (auto& cu : cu_usage)
+      usage.push_back(cu->started());
+    return usage;
+  }
+
   // Get a free slot index into submit queue
   //
   // @return
@@ -508,14 +598,10 @@ public:
   size_type
   acquire_slot_idx()
   {
-    // ffz
-    for (size_type idx=0; idx<num_slots; ++idx) {
-      if (!slot_status.test(idx)) {
-        slot_status.set(idx);
-        return idx;
-      }
-    }
-    return no_index;
+    auto idx = slot_status.find_first_zero(num_slots);
+    if (idx!=no_index)
+      slot_status.set(idx);
+    return idx;
   }
 
   // Release a slot index
@@ -535,9 +621,6 @@ public:
   bool
   submit(xocl_cmd* xcmd)
   {
-    if (slot_status.all())
-      return false;
-
     auto slot_idx = acquire_slot_idx();
     if (slot_idx==no_index)
       return false;
@@ -548,23 +631,33 @@ public:
     return true;
   }
 
-  // Start a command on first available ready CU
+  // Start a command on a ready CU selected by policy
+  //
+  // CUs that are not known to be ready are polled only if none
+  // of the CUs usable by the command are known to be ready.
   //
   // @return
   //  True if started successfully, false otherwise
   bool
   penguin_start(xocl_cmd* xcmd)
   {
-    // Find a ready CU
-    for (size_type cuidx=0; cuidx<num_cus; ++cuidx) {
-      auto& cu = cu_usage[cuidx];
-      if (xcmd->has_cu(cuidx) && cu->ready()) {
-        xcmd->cuidx = cuidx;
-        cu->start(xcmd);
-        return true;
-      }
+    auto& cus = xcmd->get_cus();
+    auto ready = cus & cu_ready;
+    if (ready.none()) {
+      (cus & ~cu_ready).for_each([this](size_type cuidx) {
+        if (cuidx<num_cus && cu_usage[cuidx]->ready())
+          cu_ready.set(cuidx);
+      });
+      ready = cus & cu_ready;
+      if (ready.none())
+        return false;
     }
-    return false;
+
+    auto cuidx = policy.load()->select(*this,xcmd->get_affinity(),ready);
+    cu_ready.reset(cuidx);
+    xcmd->cuidx = cuidx;
+    cu_usage[cuidx]->start(xcmd);
+    return true;
   }
 
   // Start a command on first available ready CU
@@ -792,8 +885,18 @@ static xocl_scheduler s_global_scheduler;
 static std::thread s_scheduler_thread;
 static bool s_running=false;
 
-// Each device has a execution core
+// Each device has a execution core.  The map is accessed from host
+// threads scheduling commands and querying or changing the CU policy.
 static std::map<const xrt::device*, std::unique_ptr<exec_core>> s_device_exec_core;
+static std::mutex s_device_exec_core_mutex;
+
+static exec_core*
+get_exec_core(const xrt::device* device)
+{
+  std::lock_guard<std::mutex> lk(s_device_exec_core_mutex);
+  auto itr = s_device_exec_core.find(device);
+  return itr!=s_device_exec_core.end() ? (*itr).second.get() : nullptr;
+}
 
 // Thread routine for scheduler loop
 static void
@@ -809,10 +912,10 @@ namespace xrt { namespace sws {
 int
 schedule(const cmd_ptr& cmd)
 {
-  auto device = cmd->get_device();
-
-  auto& exec = s_device_exec_core[device];
-  auto xcmd = xocl_cmd::create(exec.get(),cmd);
+  auto exec = get_exec_core(cmd->get_device());
+  if (!exec)
+    throw std::runtime_error("no software scheduler for device");
+  auto xcmd = xocl_cmd::create(exec,cmd);
   auto scheduler = exec->get_scheduler();
 
   std::lock_guard<std::mutex> lk(s_pending_mutex);
@@ -822,6 +925,30 @@ schedule(const cmd_ptr& cmd)
   return 0;
 }
 
+void
+set_cu_policy(const xrt::device* device, const std::string& policy)
+{
+  auto p = cu_policy::get(policy);
+  if (!p)
+    throw std::runtime_error("unknown sws cu policy '" + policy + "'");
+
+  std::lock_guard<std::mutex> lk(s_device_exec_core_mutex);
+  auto itr = s_device_exec_core.find(device);
+  if (itr==s_device_exec_core.end())
+    throw std::runtime_error("no software scheduler for device");
+  (*itr).second->set_policy(p);
+}
+
+std::vector<size_t>
+get_cu_usage(const xrt::device* device)
+{
+  std::lock_guard<std::mutex> lk(s_device_exec_core_mutex);
+  auto itr = s_device_exec_core.find(device);
+  if (itr==s_device_exec_core.end())
+    return {};
+  return (*itr).second->get_cu_usage();
+}
+
 void
 start()
 {
@@ -866,10 +993,9 @@ init(xrt::device* xdev, const std::vector<uint64_t>& cu_addr_map)
   std::copy(cu_addr_map.begin(),cu_addr_map.end(),std::back_inserter(amap));
   auto slots = ERT_CQ_SIZE / xrt::config::get_ert_slotsize();
   cu_trace_enabled = xrt::config::get_profile();
-  s_device_exec_core.erase(xdev);
-  s_device_exec_core.insert
-    (std::make_pair
-     (xdev,std::make_unique<exec_core>(xdev,&s_global_scheduler,slots,amap)));
+  auto exec = std::make_unique<exec_core>(xdev,&s_global_scheduler,slots,amap);
+  std::lock_guard<std::mutex> lk(s_device_exec_core_mutex);
+  s_device_exec_core[xdev] = std::move(exec);
 }
 
 void
@@ -878,10 +1004,9 @@ init(xrt::device* xdev, const axlf* top)
   // create execution core for this device
   auto slots = ERT_CQ_SIZE / xrt::config::get_ert_slotsize();
   cu_trace_enabled = xrt::config::get_profile();
-  s_device_exec_core.erase(xdev);
-  s_device_exec_core.insert
-    (std::make_pair
-     (xdev,std::make_unique<exec_core>(xdev,&s_global_scheduler,slots,xrt_core::xclbin::get_cus(top))));
+  auto exec = std::make_unique<exec_core>(xdev,&s_global_scheduler,slots,xrt_core::xclbin::get_cus(top));
+  std::lock_guard<std::mutex> lk(s_device_exec_core_mutex);
+  s_device_exec_core[xdev] = std::move(exec);
 }
 
 }} // sws,xrt
@@ -0,0 +1,104 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include "sws_policy.h"
+
+namespace {
+
+using namespace xrt::sws;
+
+class first_fit_policy : public cu_policy
+{
+public:
+  virtual size_type
+  select(cu_load&, const cu_bitmap_type&, const cu_bitmap_type& ready) const
+  {
+    return ready.find_first();
+  }
+};
+
+class round_robin_policy : public cu_policy
+{
+public:
+  virtual size_type
+  select(cu_load& load, const cu_bitmap_type&, const cu_bitmap_type& ready) const
+  {
+    auto cuidx = ready.find_next(load.rr_next);
+    if (cuidx==no_index)
+      cuidx = ready.find_first();
+    load.rr_next = cuidx + 1;
+    return cuidx;
+  }
+};
+
+class least_loaded_policy : public cu_policy
+{
+public:
+  virtual size_type
+  select(cu_load& load, const cu_bitmap_type&, const cu_bitmap_type& ready) const
+  {
+    size_type selected = no_index;
+    size_type min_outstanding = no_index;
+    size_t min_started = 0;
+    ready.for_each([&](size_type cuidx) {
+      auto outstanding = load.outstanding(cuidx);
+      auto started = load.started(cuidx);
+      if (outstanding<min_outstanding || (outstanding==min_outstanding && started<min_started)) {
+        selected = cuidx;
+        min_outstanding = outstanding;
+        min_started = started;
+      }
+    });
+    return selected;
+  }
+};
+
+class affinity_policy : public least_loaded_policy
+{
+public:
+  virtual size_type
+  select(cu_load& load, const cu_bitmap_type& preferred, const cu_bitmap_type& ready) const
+  {
+    auto candidates = ready & preferred;
+    return least_loaded_policy::select(load,preferred,candidates.none() ? ready : candidates);
+  }
+};
+
+} // namespace
+
+namespace xrt { namespace sws {
+
+const cu_policy*
+cu_policy::
+get(const std::string& name)
+{
+  static const first_fit_policy first_fit;
+  static const round_robin_policy round_robin;
+  static const least_loaded_policy least_loaded;
+  static const affinity_policy affinity;
+
+  if (name=="first_fit")
+    return &first_fit;
+  if (name=="round_robin")
+    return &round_robin;
+  if (name=="least_loaded")
+    return &least_loaded;
+  if (name=="affinity")
+    return &affinity;
+  return nullptr;
+}
+
+}} // sws,xrt
@@ -0,0 +1,217 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef xrt_sws_policy_h_
+#define xrt_sws_policy_h_
+
+/**
+ * CU selection policies of the software scheduler (sws.cpp)
+ *
+ * Kept separate from the scheduler so that policies can be used and
+ * tested without a device.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+
+namespace xrt { namespace sws {
+
+using size_type = uint32_t;
+
+const size_type MAX_CUS = 128;
+const size_type no_index = std::numeric_limits<size_type>::max();
+
+////////////////////////////////////////////////////////////////
+// Fixed size bitmap with word level scans
+//
+// Searches use find first set on 64-bit words so that cost is
+// proportional to number of words rather than number of bits.
+////////////////////////////////////////////////////////////////
+template <size_type bits>
+class bitmap
+{
+  static constexpr size_type word_bits = 64;
+  static constexpr size_type num_words = (bits + word_bits - 1) / word_bits;
+  uint64_t m_words[num_words] = {0};
+
+public:
+  void
+  set(size_type idx)
+  {
+    m_words[idx/word_bits] |= (1ULL << (idx%word_bits));
+  }
+
+  void
+  reset(size_type idx)
+  {
+    m_words[idx/word_bits] &= ~(1ULL << (idx%word_bits));
+  }
+
+  bool
+  test(size_type idx) const
+  {
+    return m_words[idx/word_bits] & (1ULL << (idx%word_bits));
+  }
+
+  // Set 32-bit word number @widx, e.g. an ERT cu mask
+  void
+  set_word32(size_type widx, uint32_t value)
+  {
+    auto shift = (widx%2)*32;
+    auto& word = m_words[widx/2];
+    word = (word & ~(0xFFFFFFFFULL << shift)) | (static_cast<uint64_t>(value) << shift);
+  }
+
+  bool
+  none() const
+  {
+    for (auto word : m_words)
+      if (word)
+        return false;
+    return true;
+  }
+
+  // @return first set bit at or after @idx, or no_index if none
+  size_type
+  find_next(size_type idx) const
+  {
+    for (auto widx=idx/word_bits; widx<num_words; ++widx) {
+      auto word = m_words[widx];
+      if (widx==idx/word_bits)
+        word &= (~0ULL << (idx%word_bits));
+      if (word)
+        return widx*word_bits + __builtin_ctzll(word);
+    }
+    return no_index;
+  }
+
+  // @return first set bit, or no_index if none
+  size_type
+  find_first() const
+  {
+    return find_next(0);
+  }
+
+  // @return first clear bit less than @limit, or no_index if none
+  size_type
+  find_first_zero(size_type limit) const
+  {
+    for (size_type widx=0; widx*word_bits<limit; ++widx) {
+      auto word = ~m_words[widx];
+      if (!word)
+        continue;
+      auto idx = widx*word_bits + __builtin_ctzll(word);
+      return idx<limit ? idx : no_index;
+    }
+    return no_index;
+  }
+
+  bitmap
+  operator&(const bitmap& rhs) const
+  {
+    bitmap result;
+    for (size_type widx=0; widx<num_words; ++widx)
+      result.m_words[widx] = m_words[widx] & rhs.m_words[widx];
+    return result;
+  }
+
+  bitmap
+  operator~() const
+  {
+    bitmap result;
+    for (size_type widx=0; widx<num_words; ++widx)
+      result.m_words[widx] = ~m_words[widx];
+    return result;
+  }
+
+  // Invoke @f on index of each set bit in increasing order
+  template <typename F>
+  void
+  for_each(F&& f) const
+  {
+    for (size_type widx=0; widx<num_words; ++widx) {
+      for (auto word=m_words[widx]; word; word&=(word-1))
+        f(widx*word_bits + __builtin_ctzll(word));
+    }
+  }
+};
+
+using cu_bitmap_type = bitmap<MAX_CUS>;
+
+////////////////////////////////////////////////////////////////
+// Load of the CUs of a device as seen by a CU selection policy
+//
+// Implemented by the scheduler's execution core.  The round robin
+// position is per device and updated by the round robin policy.
+////////////////////////////////////////////////////////////////
+class cu_load
+{
+public:
+  virtual ~cu_load() {}
+
+  // Number of commands started on CU that have not been retired
+  virtual size_type
+  outstanding(size_type cuidx) const = 0;
+
+  // Number of commands started on CU
+  virtual size_t
+  started(size_type cuidx) const = 0;
+
+  size_type rr_next = 0;
+};
+
+////////////////////////////////////////////////////////////////
+// CU selection policy
+//
+// A policy selects which of the ready CUs a command is started on.
+// The policy is selectable per device and is invoked only by the
+// scheduler thread.
+//
+// first_fit: lowest indexed ready CU
+// round_robin: next ready CU after the previously selected CU
+// least_loaded: ready CU with fewest outstanding commands, ties broken
+//   by fewest commands started
+// affinity: least loaded among ready CUs preferred by the command (the
+//   host sets preferred CUs from memory bank connectivity), or least
+//   loaded among all ready CUs if none is preferred
+////////////////////////////////////////////////////////////////
+class cu_policy
+{
+public:
+  virtual ~cu_policy() {}
+
+  // Select a CU from @ready, which is not empty.  @preferred are
+  // the CUs preferred by the command, empty if no preference.
+  virtual size_type
+  select(cu_load& load, const cu_bitmap_type& preferred, const cu_bitmap_type& ready) const = 0;
+
+  // Get policy object by name, nullptr if no such policy
+  static const cu_policy*
+  get(const std::string& name);
+
+  // Name of policy used when none is configured
+  static const char*
+  default_name()
+  {
+    return "least_loaded";
+  }
+};
+
+}} // sws,xrt
+
+#endif
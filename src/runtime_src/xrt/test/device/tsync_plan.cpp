@@ -0,0 +1,213 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "xrt/device/hal2.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <dlfcn.h>
+
+namespace {
+
+using xrt::hal2::sync_range;
+using xrt::hal2::plan_sync;
+using xrt::hal2::sync_staged_transfer;
+
+const size_t max_merge = 256*1024;
+char host[1024*1024];
+
+// Buffer objects of @sz bytes allocated back to back in one bank
+std::vector<sync_range>
+adjacent_bos(unsigned int count, size_t sz, uint64_t base = 0x1000000)
+{
+  std::vector<sync_range> ranges;
+  for (unsigned int idx=0; idx<count; ++idx)
+    ranges.push_back({idx,0,sz,base+idx*sz,host+idx*sz});
+  return ranges;
+}
+
+// Number of DMA operations needed for a plan
+size_t
+dma_calls(const std::vector<std::vector<sync_range>>& plan)
+{
+  return plan.size();
+}
+
+// Device memory behind the unmanaged DMA of the fake shim below
+char device[1024*1024];
+const uint64_t device_base = 0x1000000;
+int unmgd_calls = 0;
+ssize_t unmgd_status = 0;
+
+// Like the PCIe shims, return the ioctl() status rather than a byte count
+ssize_t
+unmgd_pwrite(xclDeviceHandle, unsigned, const void* buf, size_t size, uint64_t offset)
+{
+  ++unmgd_calls;
+  if (unmgd_status >= 0)
+    std::memcpy(device+(offset-device_base),buf,size);
+  return unmgd_status;
+}
+
+ssize_t
+unmgd_pread(xclDeviceHandle, unsigned, void* buf, size_t size, uint64_t offset)
+{
+  ++unmgd_calls;
+  if (unmgd_status >= 0)
+    std::memcpy(buf,device+(offset-device_base),size);
+  return unmgd_status;
+}
+
+// Operations of the test program itself, which is not a shim, with
+// the unmanaged DMA functions filled in
+struct unmgd_ops : xrt::hal2::operations
+{
+  unmgd_ops() : xrt::hal2::operations("",dlopen(nullptr,RTLD_LAZY),0)
+  {
+    mUnmgdPwrite = unmgd_pwrite;
+    mUnmgdPread = unmgd_pread;
+  }
+};
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_sync_plan )
+
+BOOST_AUTO_TEST_CASE( test_adjacent_merge )
+{
+  auto ranges = adjacent_bos(16,4096);
+  std::reverse(ranges.begin(),ranges.end());
+  auto plan = plan_sync(ranges,max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),1);
+  BOOST_CHECK_EQUAL(plan[0].size(),16);
+  for (unsigned int idx=0; idx<16; ++idx)
+    BOOST_CHECK_EQUAL(plan[0][idx].handle,idx);
+}
+
+BOOST_AUTO_TEST_CASE( test_no_merge_without_unmanaged_dma )
+{
+  auto plan = plan_sync(adjacent_bos(16,4096),0);
+  BOOST_CHECK_EQUAL(dma_calls(plan),16);
+}
+
+BOOST_AUTO_TEST_CASE( test_gap_splits )
+{
+  auto ranges = adjacent_bos(8,4096);
+  ranges[4].device_addr += 4096; // hole in front of 5th bo
+  ranges[5].device_addr += 4096;
+  ranges[6].device_addr += 4096;
+  ranges[7].device_addr += 4096;
+  auto plan = plan_sync(ranges,max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),2);
+  BOOST_CHECK_EQUAL(plan[0].size(),4);
+  BOOST_CHECK_EQUAL(plan[1].size(),4);
+}
+
+BOOST_AUTO_TEST_CASE( test_banks_split )
+{
+  auto ranges = adjacent_bos(4,4096,0x1000000);
+  auto bank1 = adjacent_bos(4,4096,0x4000000);
+  for (auto& r : bank1) {
+    r.handle += 4;
+    ranges.push_back(r);
+  }
+  auto plan = plan_sync(ranges,max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),2);
+}
+
+BOOST_AUTO_TEST_CASE( test_max_merge )
+{
+  // 64KB bos, 4 fit in one transfer
+  auto plan = plan_sync(adjacent_bos(10,64*1024),max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),3);
+
+  // bos larger than a merged transfer are synced by themselves
+  plan = plan_sync(adjacent_bos(2,512*1024),max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),2);
+}
+
+BOOST_AUTO_TEST_CASE( test_sub_buffers )
+{
+  // Sub buffers of one parent share the handle and are combined
+  // into one range of the parent
+  std::vector<sync_range> ranges;
+  for (size_t off=0; off<16*1024; off+=1024)
+    ranges.push_back({7,off,off+1024,0x1000000,host});
+  ranges.push_back({7,512,1536,0x1000000,host}); // overlapping
+  auto plan = plan_sync(ranges,0);
+  BOOST_CHECK_EQUAL(dma_calls(plan),1);
+  BOOST_CHECK_EQUAL(plan[0][0].begin,0);
+  BOOST_CHECK_EQUAL(plan[0][0].end,16*1024);
+}
+
+BOOST_AUTO_TEST_CASE( test_no_host_backing )
+{
+  // Buffer objects without host memory cannot be staged
+  auto ranges = adjacent_bos(4,4096);
+  ranges[1].host_addr = nullptr;
+  auto plan = plan_sync(ranges,max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),3);
+}
+
+BOOST_AUTO_TEST_CASE( test_staged_write )
+{
+  unmgd_ops ops;
+  std::vector<char> staging(max_merge);
+  auto plan = plan_sync(adjacent_bos(16,4096,device_base),max_merge);
+  BOOST_CHECK_EQUAL(dma_calls(plan),1);
+
+  for (size_t idx=0; idx<16*4096; ++idx)
+    host[idx] = static_cast<char>(idx*7);
+  std::memset(device,0,16*4096);
+  unmgd_calls = 0;
+  unmgd_status = 0;
+  BOOST_CHECK(sync_staged_transfer(&ops,nullptr,plan[0],staging.data(),XCL_BO_SYNC_BO_TO_DEVICE));
+  BOOST_CHECK_EQUAL(unmgd_calls,1);
+  BOOST_CHECK(std::memcmp(device,host,16*4096)==0);
+}
+
+BOOST_AUTO_TEST_CASE( test_staged_read )
+{
+  unmgd_ops ops;
+  std::vector<char> staging(max_merge);
+  auto plan = plan_sync(adjacent_bos(16,4096,device_base),max_merge);
+
+  for (size_t idx=0; idx<16*4096; ++idx)
+    device[idx] = static_cast<char>(idx*3);
+  std::memset(host,0,16*4096);
+  unmgd_calls = 0;
+  unmgd_status = 0;
+  BOOST_CHECK(sync_staged_transfer(&ops,nullptr,plan[0],staging.data(),XCL_BO_SYNC_BO_FROM_DEVICE));
+  BOOST_CHECK_EQUAL(unmgd_calls,1);
+  BOOST_CHECK(std::memcmp(device,host,16*4096)==0);
+}
+
+BOOST_AUTO_TEST_CASE( test_staged_error )
+{
+  // A failed merged transfer is reported so the caller syncs each bo
+  unmgd_ops ops;
+  std::vector<char> staging(max_merge);
+  auto plan = plan_sync(adjacent_bos(4,4096,device_base),max_merge);
+  unmgd_status = -EIO;
+  BOOST_CHECK(!sync_staged_transfer(&ops,nullptr,plan[0],staging.data(),XCL_BO_SYNC_BO_TO_DEVICE));
+  BOOST_CHECK(!sync_staged_transfer(&ops,nullptr,plan[0],staging.data(),XCL_BO_SYNC_BO_FROM_DEVICE));
+  unmgd_status = 0;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,177 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <boost/test/unit_test.hpp>
+
+#include "xrt/scheduler/sws_policy.h"
+#include "xrt/scheduler/scheduler.h"
+#include <vector>
+
+namespace {
+
+using namespace xrt::sws;
+
+// CU load model where a started command stays outstanding until
+// explicitly retired
+struct test_load : cu_load
+{
+  std::vector<size_type> m_outstanding;
+  std::vector<size_t> m_started;
+
+  explicit
+  test_load(size_type num_cus)
+    : m_outstanding(num_cus,0), m_started(num_cus,0)
+  {}
+
+  virtual size_type
+  outstanding(size_type cuidx) const
+  {
+    return m_outstanding[cuidx];
+  }
+
+  virtual size_t
+  started(size_type cuidx) const
+  {
+    return m_started[cuidx];
+  }
+
+  size_type
+  start(const cu_policy* policy, const cu_bitmap_type& preferred, const cu_bitmap_type& ready)
+  {
+    auto cuidx = policy->select(*this,preferred,ready);
+    ++m_outstanding[cuidx];
+    ++m_started[cuidx];
+    return cuidx;
+  }
+
+  void
+  retire(size_type cuidx)
+  {
+    --m_outstanding[cuidx];
+  }
+};
+
+static cu_bitmap_type
+make_bitmap(std::initializer_list<size_type> bits)
+{
+  cu_bitmap_type bm;
+  for (auto bit : bits)
+    bm.set(bit);
+  return bm;
+}
+
+}
+
+BOOST_AUTO_TEST_SUITE ( test_sws_policy )
+
+BOOST_AUTO_TEST_CASE( test_policy_names )
+{
+  for (auto name : {"first_fit","round_robin","least_loaded","affinity"})
+    BOOST_CHECK(cu_policy::get(name)!=nullptr);
+  BOOST_CHECK(cu_policy::get("bogus")==nullptr);
+  BOOST_CHECK(cu_policy::get(cu_policy::default_name())!=nullptr);
+}
+
+BOOST_AUTO_TEST_CASE( test_first_fit )
+{
+  auto policy = cu_policy::get("first_fit");
+  test_load load(4);
+  auto ready = make_bitmap({1,2,3});
+  for (int i=0; i<8; ++i) {
+    auto cuidx = load.start(policy,cu_bitmap_type(),ready);
+    BOOST_CHECK_EQUAL(cuidx,1);
+    load.retire(cuidx);
+  }
+  BOOST_CHECK_EQUAL(load.started(1),8);
+  BOOST_CHECK_EQUAL(load.started(2),0);
+}
+
+BOOST_AUTO_TEST_CASE( test_round_robin )
+{
+  auto policy = cu_policy::get("round_robin");
+  test_load load(4);
+  auto ready = make_bitmap({0,1,2,3});
+  std::vector<size_type> order;
+  for (int i=0; i<8; ++i)
+    order.push_back(load.start(policy,cu_bitmap_type(),ready));
+  BOOST_CHECK((order==std::vector<size_type>{0,1,2,3,0,1,2,3}));
+
+  // Skips CUs that are not ready and wraps around
+  load.rr_next = 2;
+  BOOST_CHECK_EQUAL(load.start(policy,cu_bitmap_type(),make_bitmap({0,1})),0);
+  BOOST_CHECK_EQUAL(load.start(policy,cu_bitmap_type(),make_bitmap({0,1})),1);
+  BOOST_CHECK_EQUAL(load.start(policy,cu_bitmap_type(),make_bitmap({0,1})),0);
+}
+
+BOOST_AUTO_TEST_CASE( test_least_loaded )
+{
+  auto policy = cu_policy::get("least_loaded");
+  test_load load(4);
+  auto ready = make_bitmap({0,1,2,3});
+
+  // Without retiring, commands spread over all CUs
+  for (int i=0; i<4; ++i)
+    load.start(policy,cu_bitmap_type(),ready);
+  for (size_type cuidx=0; cuidx<4; ++cuidx)
+    BOOST_CHECK_EQUAL(load.outstanding(cuidx),1);
+
+  // CU with fewest outstanding commands wins
+  load.retire(2);
+  BOOST_CHECK_EQUAL(load.start(policy,cu_bitmap_type(),ready),2);
+
+  // Ties are broken by fewest started, so usage is balanced even
+  // when commands complete before the next is started
+  for (size_type cuidx=0; cuidx<4; ++cuidx)
+    while (load.outstanding(cuidx))
+      load.retire(cuidx);
+  for (int i=0; i<7; ++i)
+    load.retire(load.start(policy,cu_bitmap_type(),ready));
+  for (size_type cuidx=0; cuidx<4; ++cuidx)
+    BOOST_CHECK_EQUAL(load.started(cuidx),3);
+}
+
+BOOST_AUTO_TEST_CASE( test_affinity )
+{
+  auto policy = cu_policy::get("affinity");
+  test_load load(4);
+  auto ready = make_bitmap({0,1,2,3});
+  auto preferred = make_bitmap({2,3});
+
+  // Least loaded among preferred CUs, even if others are less loaded
+  for (int i=0; i<4; ++i) {
+    auto cuidx = load.start(policy,preferred,ready);
+    BOOST_CHECK(cuidx==2 || cuidx==3);
+  }
+  BOOST_CHECK_EQUAL(load.outstanding(2),2);
+  BOOST_CHECK_EQUAL(load.outstanding(3),2);
+
+  // Falls back to all ready CUs when no preferred CU is ready
+  auto cuidx = load.start(policy,preferred,make_bitmap({0,1}));
+  BOOST_CHECK(cuidx==0 || cuidx==1);
+
+  // No preference is least loaded
+  BOOST_CHECK_EQUAL(load.start(policy,cu_bitmap_type(),ready),cuidx==0 ? 1 : 0);
+}
+
+// Usage and policy of a device without a software scheduler
+BOOST_AUTO_TEST_CASE( test_cu_usage_no_device )
+{
+  BOOST_CHECK(xrt::sws::get_cu_usage(nullptr).empty());
+  BOOST_CHECK_THROW(xrt::sws::set_cu_policy(nullptr,"first_fit"),std::runtime_error);
+  BOOST_CHECK_THROW(xrt::sws::set_cu_policy(nullptr,"bogus"),std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
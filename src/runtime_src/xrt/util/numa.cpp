@@ -0,0 +1,176 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#include "numa.h"
+#include "debug.h"
+#include "message.h"
+#include "config_reader.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#include <boost/tokenizer.hpp>
+
+#ifdef __GNUC__
+# include <pthread.h>
+# include <sched.h>
+# include <unistd.h>
+# include <sys/syscall.h>
+#endif
+
+namespace {
+
+// From <numaif.h>, which is part of libnuma
+const int mpol_default = 0;
+const int mpol_preferred = 1;
+
+const unsigned long bits_per_long = 8*sizeof(unsigned long);
+
+static bool
+cpu_affinity_specified()
+{
+  static bool value = xrt::config::detail::get_string_value("Runtime.cpu_affinity","default")!="default";
+  return value;
+}
+
+// Parse cpulist format, e.g. "0-7,16-23"
+static std::vector<unsigned int>
+get_node_cpus(int node)
+{
+  std::vector<unsigned int> cpus;
+  std::ifstream istr("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+  std::string list;
+  if (!std::getline(istr,list))
+    return cpus;
+
+  using tokenizer=boost::tokenizer<boost::char_separator<char> >;
+  boost::char_separator<char> sep(",\n ");
+  for (auto& tok : tokenizer(list,sep)) {
+    auto dash = tok.find('-');
+    auto first = std::stoul(tok.substr(0,dash));
+    auto last = (dash==std::string::npos) ? first : std::stoul(tok.substr(dash+1));
+    for (auto cpu=first; cpu<=last; ++cpu)
+      cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+} // namespace
+
+namespace xrt { namespace numa {
+
+int
+get_node(const std::string& path)
+{
+  std::ifstream istr(path);
+  int node = -1;
+  if (!(istr >> node) || node < 0)
+    return -1;
+  return node;
+}
+
+#ifdef __GNUC__
+
+void
+set_affinity(std::thread& thread, int node)
+{
+  if (node < 0 || !config::get_numa_affinity() || cpu_affinity_specified())
+    return;
+
+  static std::mutex mutex;
+  static std::vector<std::pair<int,cpu_set_t>> node_cpusets;
+
+  cpu_set_t cpuset;
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    auto itr = std::find_if(node_cpusets.begin(),node_cpusets.end(),
+                            [node](const std::pair<int,cpu_set_t>& e) { return e.first==node; });
+    if (itr==node_cpusets.end()) {
+      CPU_ZERO(&cpuset);
+      for (auto cpu : get_node_cpus(node))
+        if (cpu < CPU_SETSIZE)
+          CPU_SET(cpu,&cpuset);
+      node_cpusets.emplace_back(node,cpuset);
+    }
+    else {
+      cpuset = (*itr).second;
+    }
+  }
+
+  if (!CPU_COUNT(&cpuset))
+    return;
+
+  XRT_DEBUG(std::cout,"pinning thread to ",CPU_COUNT(&cpuset)," cpus of numa node ",node,"\n");
+  if (pthread_setaffinity_np(thread.native_handle(),sizeof(cpu_set_t),&cpuset))
+    xrt::message::send(xrt::message::severity_level::WARNING,
+                       "Failed to pin thread to cpus of NUMA node " + std::to_string(node));
+}
+
+scoped_preferred_node::
+scoped_preferred_node(int node)
+{
+  if (node < 0 || static_cast<unsigned long>(node) >= sizeof(m_mask)*8 || !config::get_numa_alloc())
+    return;
+
+  const unsigned long maxnode = sizeof(m_mask)*8;
+  if (syscall(SYS_get_mempolicy,&m_mode,m_mask,maxnode,nullptr,0))
+    return;
+
+  unsigned long mask[sizeof(m_mask)/sizeof(m_mask[0])] = {0};
+  mask[node/bits_per_long] = 1UL << (node%bits_per_long);
+  if (syscall(SYS_set_mempolicy,mpol_preferred,mask,maxnode))
+    return;
+
+  m_restore = true;
+}
+
+scoped_preferred_node::
+~scoped_preferred_node()
+{
+  if (!m_restore)
+    return;
+
+  const unsigned long maxnode = sizeof(m_mask)*8;
+  if (m_mode==mpol_default)
+    syscall(SYS_set_mempolicy,mpol_default,nullptr,0);
+  else
+    syscall(SYS_set_mempolicy,m_mode,m_mask,maxnode);
+}
+
+#else
+
+void
+set_affinity(std::thread&, int)
+{
+}
+
+scoped_preferred_node::
+scoped_preferred_node(int)
+{
+}
+
+scoped_preferred_node::
+~scoped_preferred_node()
+{
+}
+
+#endif
+
+}} // numa,xrt
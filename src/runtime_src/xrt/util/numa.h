@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+
+#ifndef xrt_util_numa_h_
+#define xrt_util_numa_h_
+
+#include <string>
+#include <thread>
+
+namespace xrt { namespace numa {
+
+/**
+ * Get NUMA node of a device
+ *
+ * @param path
+ *   Full sysfs path of the device's numa_node entry
+ * @return
+ *   NUMA node of the device, or -1 if unknown
+ */
+int
+get_node(const std::string& path);
+
+/**
+ * Pin a thread to the cpus of a NUMA node
+ *
+ * No-op if node is -1, if NUMA affinity is disabled per sdaccel.ini,
+ * or if cpu_affinity is specified in sdaccel.ini.
+ */
+void
+set_affinity(std::thread& thread, int node);
+
+/**
+ * Prefer a NUMA node for memory allocated by calling thread
+ *
+ * Sets the memory policy of calling thread to prefer node for the
+ * lifetime of this object, restores the previous policy on
+ * destruction.  Pages allocated by the driver on behalf of the
+ * thread, or first touched by the thread, are placed accordingly.
+ * No-op if node is -1 or if NUMA allocation is disabled per
+ * sdaccel.ini.
+ */
+class scoped_preferred_node
+{
+  bool m_restore = false;
+  int m_mode = 0;
+  unsigned long m_mask[16] = {0};
+
+public:
+  explicit
+  scoped_preferred_node(int node);
+
+  ~scoped_preferred_node();
+
+  scoped_preferred_node(const scoped_preferred_node&) = delete;
+  scoped_preferred_node& operator=(const scoped_preferred_node&) = delete;
+};
+
+}} // numa,xrt
+
+#endif
@@ -55,6 +55,7 @@ typedef struct XmaImageCfg
 {
     char         xclbin[NAME_MAX];
     bool         zerocopy;
+    bool         zerocopy_shared;
     int32_t      num_devices;
     int32_t      device_id_map[MAX_XILINX_DEVICES];
     int32_t      num_kernelcfg_entries;
@@ -74,6 +74,14 @@ extern "C" {
  *  results will occur since hardware buffers cannot be used by non-XMA components.
  *  If there is any doubt as to whether or not non-XMA components are in a pipeline,
  *  then the safest strategy is to disable "zerocopy" in the configuration file.
+ *
+ *  By default the connection table is local to a process.  When "zerocopy" is
+ *  set to "shared" in the configuration file, connections are kept in the XMA
+ *  shared memory database instead so that the components of a pipeline can be
+ *  created in different processes.  A receiver in another process cannot be
+ *  queried for its device buffer, so the receiver publishes the device address
+ *  of its next input buffer with @ref xma_connect_set_dev_addr() and the sender
+ *  picks it up with @ref xma_connect_get_dev_addr().
  *  @subsection Connection Management API details
  *
  *  The internal interface to the Connection Management API is comprised of the
@@ -81,6 +89,9 @@ extern "C" {
  *
  *  @li @ref xma_connect_alloc()
  *  @li @ref xma_connect_free()
+ *  @li @ref xma_connect_get_dev_addr()
+ *  @li @ref xma_connect_set_dev_addr()
+ *  @li @ref xma_connect_is_shared()
  *
  */
 
@@ -147,6 +158,10 @@ typedef struct XmaConnect
  *  by the underlying connection (such as an ABR Scaler), then this function
  *  must be called for each output.
  *
+ *  The connection table takes ownership of the endpoint, which is released
+ *  by xma_connect_free() or right away if no connection entry is created.
+ *  This function is thread safe.
+ *
  *  @param session Pointer to a XmaEndpoint
  *
  *  @param type    Type of connection to allocate sender or receiver
@@ -175,6 +190,58 @@ xma_connect_alloc(XmaEndpoint *endpt, XmaConnectType type);
 int32_t
 xma_connect_free(int32_t c_handle, XmaConnectType type);
 
+/**
+ *  @brief Get the device address of the receiver input buffer
+ *
+ *  This function is called by a sender before it sends a frame in order to
+ *  find the device buffer into which the frame should be written.  For a
+ *  process local connection the receiver plugin is queried directly, for a
+ *  shared connection the address last published by the receiver is returned.
+ *  A published address is returned only once, the sender must not write to
+ *  the buffer again until the receiver has published its next input buffer.
+ *
+ *  @param c_handle Sender connection handle created with
+ *                  xma_connect_alloc function
+ *
+ *  @param dev_addr Device address of the receiver input buffer
+ *
+ *  @return         0 on success
+ *                 -1 if there is no receiver, if the receiver does not
+ *                    support zerocopy or if it has not published a new
+ *                    input buffer
+*/
+int32_t
+xma_connect_get_dev_addr(int32_t c_handle, uint64_t *dev_addr);
+
+/**
+ *  @brief Publish the device address of the receiver input buffer
+ *
+ *  This function is called by the receiver of a shared connection to make
+ *  the device buffer for the next frame known to the sender.  It does
+ *  nothing for a process local connection.
+ *
+ *  @param c_handle Receiver connection handle created with
+ *                  xma_connect_alloc function
+ *
+ *  @param dev_addr Device address of the receiver input buffer
+ *
+ *  @return         0 on success
+ *                 -1 on failure.
+*/
+int32_t
+xma_connect_set_dev_addr(int32_t c_handle, uint64_t dev_addr);
+
+/**
+ *  @brief Check if a connection is kept in shared memory
+ *
+ *  @param c_handle Connection handle created with
+ *                  xma_connect_alloc function
+ *
+ *  @return         true if the connection is shared across processes
+*/
+bool
+xma_connect_is_shared(int32_t c_handle);
+
 /**
  * @}
  */
@@ -22,9 +22,9 @@
 #include <stdbool.h>
 #include <pthread.h>
 #include <limits.h>
-#include <queue>
 #include <condition_variable>
 #include <atomic>
+#include <mutex>
 #include <thread>
 
 
@@ -33,7 +33,10 @@
 #endif
 
 #define XMA_MAX_LOGMSG_SIZE          255
-#define XMA_MAX_LOGMSG_Q_ENTRIES     128
+#define XMA_MAX_LOGMSG_Q_ENTRIES     128  /* per logging thread */
+#define XMA_LOG_RECORD_SIZE          512  /* unformatted message in queue */
+#define XMA_LOG_RATE_LIMIT           2000 /* INFO/DEBUG messages/s per thread */
+#define XMA_MAX_LOGFILE_SIZE         (64 * 1024 * 1024) /* rotate log file */
 
 //#ifdef __cplusplus
 //extern "C" {
@@ -87,41 +90,29 @@ int32_t xma_msgq_dequeue(XmaMsgQ *msgq, void *msg, size_t size);
 */
 struct XmaActor;
 
-/* Data structure for XmaActor */
+/* Data structure for XmaActor
+ *
+ * Threads calling xma_logmsg() capture the message arguments into a
+ * per thread ring and the actor thread formats and writes them.  The
+ * rings are lock free, the mutex is only used by the actor to sleep
+ * while all rings are empty.
+ */
 typedef struct XmaActor
 {
-    XmaThread          *thread;
-    /*
-    Sarab: Remove this and use C++ std::queue
-    XmaMsgQ            *msg_q;
-    pthread_mutex_t     lock;
-    pthread_cond_t      queued_cond;
-    pthread_cond_t      dequeued_cond;
-    */
-
-    std::unique_ptr<std::mutex> logger_queue_mutex;//Using only for waiting for queue to be not empty
-    std::unique_ptr<std::condition_variable> logger_queue_cv;
-    std::unique_ptr<std::atomic<bool>> logger_queue_locked;
-    std::unique_ptr<std::queue<std::string>> logger_queue;
-
-  XmaActor(): logger_queue_mutex(new std::mutex), logger_queue_cv(new std::condition_variable), 
-		logger_queue_locked(new std::atomic<bool>), logger_queue(new std::queue<std::string>) {
-    *logger_queue_locked = false;
-    thread = NULL;
-  }
+    XmaThread              *thread;
+    std::mutex              wait_mutex;
+    std::condition_variable wait_cv;
+    std::atomic<bool>       sleeping;
+    std::atomic<bool>       shutdown;
+    int64_t                 realtime_offset; /* CLOCK_MONOTONIC to wall time (ns) */
+
+  XmaActor(): thread(NULL), sleeping(false), shutdown(false), realtime_offset(0) {}
 } XmaActor;
 
 /* XmaActor APIs */
-/*
-XmaActor *xma_actor_create(XmaThreadFunc      func,
-                           size_t             msg_size,
-                           size_t             max_msg_entries);
-*/
 XmaActor *xma_actor_create();
 void xma_actor_start(XmaActor *actor);
 void xma_actor_destroy(XmaActor *actor);
-int xma_actor_sendmsg(XmaActor *actor, void *msg, size_t msg_size);
-int xma_actor_recvmsg(XmaActor *actor, void *msg, size_t msg_size);
 
 /* Data structure for XmaLogger */
 typedef struct XmaLogger
@@ -26,6 +26,7 @@
 
 #include "xma.h"
 #include "lib/xmacfg.h"
+#include "lib/xmaconnect.h"
 
 #ifndef XMA_RES_TEST
 #define XMA_SHM_FILE "/tmp/xma_shm_db"
@@ -252,6 +253,60 @@ void xma_res_mark_xma_ready(XmaResources shm_cfg);
 */
 bool xma_res_xma_init_completed(XmaResources shm_cfg);
 
+/**
+ * @brief allocates a zerocopy connection entry in shared memory
+ *
+ * A sender takes an unused entry, a receiver takes the oldest pending
+ * entry with a compatible sender.
+ *
+ * @param shm_cfg shared memory pointer
+ * @param endpt endpoint describing the frames sent or received
+ * @param type sender or receiver
+ *
+ * @returns connection index or -1 on error
+*/
+int32_t xma_res_connect_alloc(XmaResources shm_cfg, XmaEndpoint *endpt,
+                              XmaConnectType type);
+
+/**
+ * @brief releases the sender or receiver side of a shared connection
+ *
+ * @param shm_cfg shared memory pointer
+ * @param c_idx connection index returned by xma_res_connect_alloc()
+ * @param type sender or receiver
+ *
+ * @returns 0 or -1 on error
+*/
+int32_t xma_res_connect_free(XmaResources shm_cfg, int32_t c_idx,
+                             XmaConnectType type);
+
+/**
+ * @brief take the device address published by the receiver
+ *
+ * The address is handed out once, the sender owns the buffer until the
+ * receiver publishes its next input buffer.
+ *
+ * @param shm_cfg shared memory pointer
+ * @param c_idx connection index returned by xma_res_connect_alloc()
+ * @param dev_addr receives the device address
+ *
+ * @returns 0 or -1 if no address has been published since the last call
+*/
+int32_t xma_res_connect_get_dev_addr(XmaResources shm_cfg, int32_t c_idx,
+                                     uint64_t *dev_addr);
+
+/**
+ * @brief publish the device address of the receiver input buffer
+ *
+ * @param shm_cfg shared memory pointer
+ * @param c_idx connection index returned by xma_res_connect_alloc()
+ * @param dev_addr device address of the next input buffer
+ *
+ * @returns 0 or -1 if the caller is not the receiver
+*/
+int32_t xma_res_connect_set_dev_addr(XmaResources shm_cfg, int32_t c_idx,
+                                     uint64_t dev_addr);
+
 /**
  *
 */
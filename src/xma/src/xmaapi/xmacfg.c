@@ -197,10 +197,16 @@ int set_zerocopy(XmaData *data)
     int          i = data->imagecfg_idx;
 
     next_node = get_next_scalar_node(data->document, &data->node_idx);
+    data->systemcfg->imagecfg[i].zerocopy = false;
+    data->systemcfg->imagecfg[i].zerocopy_shared = false;
     if (strcmp((const char*)next_node->data.scalar.value, "enable") == 0)
         data->systemcfg->imagecfg[i].zerocopy = true;
-    else
-        data->systemcfg->imagecfg[i].zerocopy = false;
+    /* 'shared' connects sessions across processes through the shm db */
+    if (strcmp((const char*)next_node->data.scalar.value, "shared") == 0)
+    {
+        data->systemcfg->imagecfg[i].zerocopy = true;
+        data->systemcfg->imagecfg[i].zerocopy_shared = true;
+    }
     data->state_idx++;
 
     return XMA_SUCCESS;
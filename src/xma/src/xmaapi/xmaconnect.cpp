@@ -17,12 +17,23 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
 #include "app/xmabuffers.h"
 #include "app/xmaerror.h"
 #include "lib/xmaapi.h"
 #include "lib/xmacfg.h"
 #include "lib/xmaconnect.h"
 #include "lib/xmahw.h"
+#include "lib/xmares.h"
+#include "xmaplugin.h"
+
+#define XMA_CONNECT_MOD "xmaconnect"
+
+// Handles of connections kept in the shm db have this bit set
+#define XMA_CONNECT_SHARED_HANDLE 0x10000
 
 extern XmaSingleton *g_xma_singleton;
 
@@ -31,64 +42,163 @@ bool
 is_zerocopy_enabled(int32_t dev_id);
 
 bool
-is_connect_compatible(XmaEndpoint *endpt1,
-                      XmaEndpoint *endpt2);
+is_zerocopy_shared(int32_t dev_id);
+
+namespace {
+
+// Properties that must match between a sender and a receiver.
+// Can't check format because of scaler plugin BUG
+struct ConnectKey
+{
+    int32_t dev_id;
+    int32_t ddr_bank;
+    int32_t bits_per_pixel;
+    int32_t width;
+    int32_t height;
+
+    explicit
+    ConnectKey(XmaEndpoint *endpt)
+      : dev_id(endpt->dev_id)
+      , ddr_bank(endpt->session->hw_session.ddr_bank)
+      , bits_per_pixel(endpt->bits_per_pixel)
+      , width(endpt->width)
+      , height(endpt->height)
+    {}
+
+    bool
+    operator==(const ConnectKey& rhs) const
+    {
+        return (dev_id         == rhs.dev_id         &&
+                ddr_bank       == rhs.ddr_bank       &&
+                bits_per_pixel == rhs.bits_per_pixel &&
+                width          == rhs.width          &&
+                height         == rhs.height);
+    }
+};
+
+struct ConnectKeyHash
+{
+    size_t
+    operator()(const ConnectKey& key) const
+    {
+        size_t h = key.dev_id;
+        h = h * 31 + key.ddr_bank;
+        h = h * 31 + key.bits_per_pixel;
+        h = h * 31 + key.width;
+        h = h * 31 + key.height;
+        return h;
+    }
+};
+
+// Index over g_xma_singleton->connections.  The mutex protects both
+// the index and the connection table entries.
+struct ConnectIndex
+{
+    std::mutex mutex;
+    // Unused entries, lowest handle at the back
+    std::vector<int32_t> free_list;
+    // Pending senders waiting for a receiver, oldest first
+    std::unordered_map<ConnectKey, std::deque<int32_t>, ConnectKeyHash> pending;
+
+    ConnectIndex()
+    {
+        for (int32_t i = MAX_CONNECTION_ENTRIES - 1; i >= 0; i--)
+            free_list.push_back(i);
+    }
+
+    void
+    remove_pending(XmaEndpoint *sender, int32_t c_handle)
+    {
+        auto itr = pending.find(ConnectKey(sender));
+        if (itr == pending.end())
+            return;
+        auto& senders = itr->second;
+        for (auto sitr = senders.begin(); sitr != senders.end(); ++sitr)
+        {
+            if (*sitr == c_handle)
+            {
+                senders.erase(sitr);
+                break;
+            }
+        }
+        if (senders.empty())
+            pending.erase(itr);
+    }
+};
+
+ConnectIndex&
+get_index()
+{
+    static ConnectIndex index;
+    return index;
+}
+
+bool
+is_valid_handle(int32_t c_handle)
+{
+    return c_handle >= 0 && c_handle < MAX_CONNECTION_ENTRIES;
+}
+
+}
 
 int32_t
 xma_connect_alloc(XmaEndpoint *endpt, XmaConnectType type)
 {
-    int32_t i;
     int32_t c_handle = -1;
     XmaConnect *conntbl = g_xma_singleton->connections;
 
     // Don't add an entry if zerocopy is disabled
     if (!is_zerocopy_enabled(endpt->dev_id))
+    {
+        free(endpt);
         return c_handle;
+    }
+
+    // Connections between processes live in the shm db and only
+    // carry the endpoint properties, the endpoint itself is not needed
+    if (is_zerocopy_shared(endpt->dev_id))
+    {
+        c_handle = xma_res_connect_alloc(g_xma_singleton->shm_res_cfg,
+                                         endpt, type);
+        free(endpt);
+        if (c_handle == -1)
+            return c_handle;
+        return c_handle | XMA_CONNECT_SHARED_HANDLE;
+    }
 
     // An endpoint is added based on the direction provided
-    // If this is a sender, find the first unused connection
-    // entry and set the state to pending.
-    // NOTE: The connection table is only local to a process
-    //       and not kept in shared system memory
-    // TODO: It may be necessary to obtain a lock on the connection
-    //       table; however, assume for now that connections are
-    //       established during initialization and initialization
-    //       is all performed from a single thread.  This assumption
-    //       may not be true and could create a problem.
-
-    // Find an unused entry for a sender
-    if (type == XMA_CONNECT_SENDER)
+    // If this is a sender, take an unused connection entry and
+    // set the state to pending.  A receiver is connected to the
+    // oldest pending sender with matching properties.
+    auto& index = get_index();
+    std::lock_guard<std::mutex> lk(index.mutex);
+
+    if (type == XMA_CONNECT_SENDER && !index.free_list.empty())
     {
-        for (i = 0; i < MAX_CONNECTION_ENTRIES; i++)
-        {
-            if (conntbl[i].state == XMA_CONNECT_UNUSED)
-            {
-                c_handle = i;
-                conntbl[i].sender = endpt;
-                conntbl[i].state = XMA_CONNECT_PENDING_ACTIVE;
-                break;
-            }
-        }
+        c_handle = index.free_list.back();
+        index.free_list.pop_back();
+        conntbl[c_handle].sender = endpt;
+        conntbl[c_handle].state = XMA_CONNECT_PENDING_ACTIVE;
+        index.pending[ConnectKey(endpt)].push_back(c_handle);
     }
-    // Find a compatible pending entry for a receiver
+
     if (type == XMA_CONNECT_RECEIVER)
     {
-        for (i = 0; i < MAX_CONNECTION_ENTRIES; i++)
+        auto itr = index.pending.find(ConnectKey(endpt));
+        if (itr != index.pending.end())
         {
-            if (conntbl[i].state == XMA_CONNECT_PENDING_ACTIVE)
-            {
-                XmaEndpoint *cmp_endpt = conntbl[i].sender;
-                if (is_connect_compatible(endpt, cmp_endpt))
-                {
-                    printf("xmaconnect: compatible connection found\n");
-                    c_handle = i;
-                    conntbl[i].receiver = endpt;
-                    conntbl[i].state = XMA_CONNECT_ACTIVE;
-                    break;
-                }
-            }
+            c_handle = itr->second.front();
+            itr->second.pop_front();
+            if (itr->second.empty())
+                index.pending.erase(itr);
+            printf("xmaconnect: compatible connection found\n");
+            conntbl[c_handle].receiver = endpt;
+            conntbl[c_handle].state = XMA_CONNECT_ACTIVE;
         }
     }
+
+    if (c_handle == -1)
+        free(endpt);
     return c_handle;
 }
 
@@ -100,31 +210,98 @@ xma_connect_free(int32_t c_handle, XmaConnectType type)
     if (c_handle == -1)
         return XMA_SUCCESS;
 
-    if (type == XMA_CONNECT_SENDER &&
-        conntbl[c_handle].sender != NULL)
+    if (c_handle & XMA_CONNECT_SHARED_HANDLE)
+        return xma_res_connect_free(g_xma_singleton->shm_res_cfg,
+                                    c_handle & ~XMA_CONNECT_SHARED_HANDLE,
+                                    type);
+
+    if (!is_valid_handle(c_handle))
+        return XMA_ERROR_INVALID;
+
+    auto& index = get_index();
+    std::lock_guard<std::mutex> lk(index.mutex);
+    XmaConnect *conn = &conntbl[c_handle];
+
+    if (type == XMA_CONNECT_SENDER && conn->sender != NULL)
     {
-        free(conntbl[c_handle].sender);
-        conntbl[c_handle].sender = NULL;
-        if (conntbl[c_handle].state == XMA_CONNECT_ACTIVE &&
-            conntbl[c_handle].receiver == NULL)
-            conntbl[c_handle].state = XMA_CONNECT_UNUSED;
-        else
-            conntbl[c_handle].state = XMA_CONNECT_PENDING_DELETE;
+        if (conn->state == XMA_CONNECT_PENDING_ACTIVE)
+            index.remove_pending(conn->sender, c_handle);
+        free(conn->sender);
+        conn->sender = NULL;
     }
 
-    if (type == XMA_CONNECT_RECEIVER &&
-        conntbl[c_handle].receiver != NULL)
+    if (type == XMA_CONNECT_RECEIVER && conn->receiver != NULL)
     {
-        free(conntbl[c_handle].receiver);
-        conntbl[c_handle].receiver = NULL;
-        if (conntbl[c_handle].state == XMA_CONNECT_PENDING_DELETE &&
-            conntbl[c_handle].sender == NULL)
-            conntbl[c_handle].state = XMA_CONNECT_UNUSED;
-        else
-            conntbl[c_handle].state = XMA_CONNECT_PENDING_DELETE;
+        free(conn->receiver);
+        conn->receiver = NULL;
     }
 
-   return XMA_SUCCESS;
+    // The entry is reclaimed once both sides are gone
+    if (conn->state != XMA_CONNECT_UNUSED)
+    {
+        if (conn->sender == NULL && conn->receiver == NULL)
+        {
+            conn->state = XMA_CONNECT_UNUSED;
+            index.free_list.push_back(c_handle);
+        }
+        else if (conn->state == XMA_CONNECT_ACTIVE)
+            conn->state = XMA_CONNECT_PENDING_DELETE;
+    }
+
+    return XMA_SUCCESS;
+}
+
+int32_t
+xma_connect_get_dev_addr(int32_t c_handle, uint64_t *dev_addr)
+{
+    XmaConnect *conntbl = g_xma_singleton->connections;
+
+    if (c_handle == -1)
+        return XMA_ERROR;
+
+    if (c_handle & XMA_CONNECT_SHARED_HANDLE)
+        return xma_res_connect_get_dev_addr(g_xma_singleton->shm_res_cfg,
+                                            c_handle & ~XMA_CONNECT_SHARED_HANDLE,
+                                            dev_addr);
+
+    if (!is_valid_handle(c_handle))
+        return XMA_ERROR_INVALID;
+
+    // The lock keeps the receiver from going away while it is queried
+    auto& index = get_index();
+    std::lock_guard<std::mutex> lk(index.mutex);
+    XmaEndpoint *recv = conntbl[c_handle].receiver;
+    if (!recv || !is_xma_encoder(recv->session))
+        return XMA_ERROR;
+
+    XmaEncoderSession *e_ses = to_xma_encoder(recv->session);
+    if (!e_ses->encoder_plugin->get_dev_input_paddr)
+    {
+        xma_logmsg(XMA_DEBUG_LOG, XMA_CONNECT_MOD,
+                   "encoder plugin does not support zero copy\n");
+        return XMA_ERROR;
+    }
+
+    *dev_addr = e_ses->encoder_plugin->get_dev_input_paddr(e_ses);
+    return XMA_SUCCESS;
+}
+
+int32_t
+xma_connect_set_dev_addr(int32_t c_handle, uint64_t dev_addr)
+{
+    // A local sender queries the receiver directly
+    if (!xma_connect_is_shared(c_handle))
+        return XMA_SUCCESS;
+
+    return xma_res_connect_set_dev_addr(g_xma_singleton->shm_res_cfg,
+                                        c_handle & ~XMA_CONNECT_SHARED_HANDLE,
+                                        dev_addr);
+}
+
+bool
+xma_connect_is_shared(int32_t c_handle)
+{
+    return c_handle != -1 && (c_handle & XMA_CONNECT_SHARED_HANDLE);
 }
 
 bool
@@ -157,31 +334,15 @@ is_zerocopy_enabled(int32_t dev_id)
 }
 
 bool
-is_connect_compatible(XmaEndpoint *endpt1,
-                      XmaEndpoint *endpt2)
+is_zerocopy_shared(int32_t dev_id)
 {
-    XmaHwSession *hw1 = &endpt1->session->hw_session;
-    XmaHwSession *hw2 = &endpt2->session->hw_session;
-
-    // Can't check format because of scaler plugin BUG
-    //       "endpt1->format  %d, endpt2->format  %d\n"
-    //        endpt1->format,  endpt2->format,
-    printf("hw1->dev_handle %p, hw2->dev_handle %p\n"
-           "hw1->ddr_bank   %d, hw2->ddr_bandk  %d\n"
-           "endpt1->bpp     %d, endpt2->bpp     %d\n"
-           "endpt1->width   %d, endpt2->width   %d\n"
-           "endpt1->height  %d, endpt2->height  %d\n",
-            hw1->dev_handle, hw2->dev_handle,
-            hw1->ddr_bank,   hw2->ddr_bank,
-            endpt1->bits_per_pixel, endpt2->bits_per_pixel,
-            endpt1->width,   endpt2->width,
-            endpt1->height,  endpt2->height);
-
-    // Can't check format because of scaler plugin BUG
-    //        endpt1->format         == endpt2->format         &&
-    return (hw1->dev_handle        == hw2->dev_handle        &&
-            hw1->ddr_bank          == hw2->ddr_bank          &&
-            endpt1->bits_per_pixel == endpt2->bits_per_pixel &&
-            endpt1->width          == endpt2->width          &&
-            endpt1->height         == endpt2->height);
+    int32_t i, j;
+    XmaSystemCfg *systemcfg = &g_xma_singleton->systemcfg;
+
+    for (i = 0; i < systemcfg->num_images; i++)
+        for (j = 0; j < systemcfg->imagecfg[i].num_devices; j++)
+            if (systemcfg->imagecfg[i].device_id_map[j] == dev_id)
+                return systemcfg->imagecfg[i].zerocopy_shared;
+
+    return false;
 }
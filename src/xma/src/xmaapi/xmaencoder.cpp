@@ -65,6 +65,8 @@ void xma_enc_session_statsfile_write(XmaEncoderStats *stats);
 
 void xma_enc_session_statsfile_close(XmaEncoderSession *session);
 
+static void xma_enc_session_publish_dev_addr(XmaEncoderSession *session);
+
 #define XMA_ENCODER_MOD "xmaencoder"
 
 extern XmaSingleton *g_xma_singleton;
@@ -234,6 +236,10 @@ xma_enc_session_create(XmaEncoderProperties *enc_props)
         return NULL;
     }
 
+    // A sender in another process can't query the plugin, so publish
+    // the buffer for the first frame through the connection
+    xma_enc_session_publish_dev_addr(enc_session);
+
     // Create encoder file if it does not exist and initialize all fields 
     xma_enc_session_statsfile_init(enc_session);
 
@@ -250,6 +256,11 @@ xma_enc_session_destroy(XmaEncoderSession *session)
     // Clean up the stats file, but don't delete it 
     xma_enc_session_statsfile_close(session);
 
+    // Free the receiver connection before the plugin goes away
+    // so that a sender can no longer query it
+    xma_connect_free(session->conn_recv_handle,
+                        XMA_CONNECT_RECEIVER);
+
     rc  = session->encoder_plugin->close(session);
     if (rc != 0)
         xma_logmsg(XMA_ERROR_LOG, XMA_ENCODER_MOD,
@@ -258,10 +269,6 @@ xma_enc_session_destroy(XmaEncoderSession *session)
     // Clean up the private data
     free(session->base.plugin_data);
 
-    // Free the receiver connection
-    xma_connect_free(session->conn_recv_handle,
-                        XMA_CONNECT_RECEIVER);
-
     /* free kernel/kernel-session */
     rc = xma_res_free_kernel(g_xma_singleton->shm_res_cfg,
                              session->base.kern_res);
@@ -276,6 +283,18 @@ xma_enc_session_destroy(XmaEncoderSession *session)
     return XMA_SUCCESS;
 }
 
+static void
+xma_enc_session_publish_dev_addr(XmaEncoderSession *session)
+{
+    // Only needed when the sender may live in another process
+    if (!xma_connect_is_shared(session->conn_recv_handle) ||
+        !session->encoder_plugin->get_dev_input_paddr)
+        return;
+
+    xma_connect_set_dev_addr(session->conn_recv_handle,
+        session->encoder_plugin->get_dev_input_paddr(session));
+}
+
 int32_t
 xma_enc_session_send_frame(XmaEncoderSession *session,
                            XmaFrame          *frame)
@@ -289,6 +308,7 @@ xma_enc_session_send_frame(XmaEncoderSession *session,
     clock_gettime(CLOCK_MONOTONIC, &ts);  
     timestamp = (ts.tv_sec * 1000000000) + ts.tv_nsec;
     rc = session->encoder_plugin->send_frame(session, frame);
+    xma_enc_session_publish_dev_addr(session);
     if (frame->do_not_encode == false)
     {
         frame_size = frame->frame_props.width * frame->frame_props.height; 
@@ -246,29 +246,20 @@ int32_t
 xma_filter_session_send_frame(XmaFilterSession  *session,
                               XmaFrame          *frame)
 {
+    uint64_t dev_addr;
+
     xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD, "%s()\n", __func__);
-    if (session->conn_send_handle != -1)
+    // Find the device buffer of a connected receiver, never reuse a
+    // buffer the receiver has not handed out again
+    if (xma_connect_get_dev_addr(session->conn_send_handle,
+                                 &dev_addr) == XMA_SUCCESS)
     {
-        // Get the connection entry to find the receiver
-        int32_t c_handle = session->conn_send_handle;
-        XmaConnect *conn = &g_xma_singleton->connections[c_handle];
-        XmaEndpoint *recv = conn->receiver;
-        if (recv)
-        {
-            if (is_xma_encoder(recv->session))
-            {
-                XmaEncoderSession *e_ses = to_xma_encoder(recv->session);
-                if (!e_ses->encoder_plugin->get_dev_input_paddr) {
-                    xma_logmsg(XMA_DEBUG_LOG, XMA_FILTER_MOD,
-                        "encoder plugin does not support zero copy\n");
-                    goto send;
-		}
-                session->out_dev_addr = e_ses->encoder_plugin->get_dev_input_paddr(e_ses);
-                session->zerocopy_dest = true;
-            }
-        }
+        session->out_dev_addr = dev_addr;
+        session->zerocopy_dest = true;
     }
-send:
+    else
+        session->zerocopy_dest = false;
+
     return session->filter_plugin->send_frame(session, frame);
 }
 
@@ -29,8 +29,12 @@
 #include <sched.h>
 #include <errno.h>
 #include <syslog.h>
+#include <ctype.h>
 #include <cstdlib>
+#include <algorithm>
+#include <chrono>
 #include <string>
+#include <vector>
 #include <fstream>
 #include <iostream>
 
@@ -72,6 +76,533 @@ XmaLogLevel2Str g_loglevel_tbl[] = {
 /* Prototype for the logger actor thread */
 //void* xma_logger_actor(void *data);
 
+/* Type of the argument consumed by a printf conversion */
+enum XmaLogArgType
+{
+    XMA_LOG_ARG_NONE = 0,
+    XMA_LOG_ARG_INT,
+    XMA_LOG_ARG_LONG,
+    XMA_LOG_ARG_LLONG,
+    XMA_LOG_ARG_INTMAX,
+    XMA_LOG_ARG_SIZE,
+    XMA_LOG_ARG_PTRDIFF,
+    XMA_LOG_ARG_DOUBLE,
+    XMA_LOG_ARG_PTR,
+    XMA_LOG_ARG_STR,
+    XMA_LOG_ARG_UNSUPPORTED
+};
+
+/* Longest conversion specification that is captured */
+#define XMA_LOG_MAX_SPEC 32
+
+typedef struct XmaLogSpec
+{
+    XmaLogArgType type;
+    int32_t       num_stars;  /* '*' width and precision arguments */
+    bool          star_precision;
+    int32_t       precision;  /* -1 if none */
+    const char   *end;        /* one past the conversion character */
+} XmaLogSpec;
+
+/* Message captured by xma_logmsg() for the actor to format
+ *
+ * data holds the NUL terminated name, then the NUL terminated format
+ * and then the arguments.  Scalar arguments take 8 bytes each and
+ * strings are copied with their terminating NUL.  A message that can't
+ * be captured is formatted by the caller and stored instead of the
+ * format.
+ */
+typedef struct XmaLogRecord
+{
+    uint64_t timestamp;  /* CLOCK_MONOTONIC in ns */
+    int32_t  level;
+    bool     formatted;
+    uint16_t name_len;
+    uint16_t text_len;
+    uint16_t args_len;
+    char     data[XMA_LOG_RECORD_SIZE - 24];
+} XmaLogRecord;
+
+static_assert(sizeof(XmaLogRecord) <= XMA_LOG_RECORD_SIZE, "log record too large");
+static_assert((XMA_MAX_LOGMSG_Q_ENTRIES & (XMA_MAX_LOGMSG_Q_ENTRIES - 1)) == 0,
+              "log ring size must be a power of 2");
+
+/* Single producer, single consumer ring of a logging thread */
+typedef struct XmaLogRing
+{
+    XmaLogRecord          records[XMA_MAX_LOGMSG_Q_ENTRIES];
+    std::atomic<uint32_t> head;      /* next record read by the actor */
+    std::atomic<uint32_t> tail;      /* next record written by the thread */
+    std::atomic<uint64_t> dropped;   /* rate limited or ring full */
+    std::atomic<bool>     orphaned;  /* owning thread has exited */
+    uint64_t              reported;  /* drops reported by the actor */
+    uint64_t              rate_ts;   /* last refill of tokens */
+    uint32_t              tokens;
+} XmaLogRing;
+
+/* Rings of all threads, the mutex only guards the list itself */
+typedef struct XmaLogRings
+{
+    std::mutex               mutex;
+    std::vector<XmaLogRing*> rings;
+} XmaLogRings;
+
+/* State of the actor output */
+typedef struct XmaLogOutput
+{
+    bool        use_xrt;  /* sdaccel.ini found, log through xrt */
+    std::string batch;    /* lines for file or stdout not yet written */
+} XmaLogOutput;
+
+/* Marks the ring of an exiting thread so the actor can reclaim it */
+struct XmaLogRingOwner
+{
+    XmaLogRing *ring = nullptr;
+
+    ~XmaLogRingOwner()
+    {
+        if (ring)
+            ring->orphaned = true;
+    }
+};
+
+static XmaLogRings&
+xma_log_rings()
+{
+    /* Not destroyed as threads may still log while the process exits */
+    static XmaLogRings *rings = new XmaLogRings;
+    return *rings;
+}
+
+static XmaLogRing*
+xma_log_thread_ring()
+{
+    static thread_local XmaLogRingOwner owner;
+
+    if (!owner.ring)
+    {
+        XmaLogRing *ring = new XmaLogRing();
+        XmaLogRings& all = xma_log_rings();
+
+        ring->tokens = XMA_LOG_RATE_LIMIT;
+        std::lock_guard<std::mutex> lk(all.mutex);
+        all.rings.push_back(ring);
+        owner.ring = ring;
+    }
+    return owner.ring;
+}
+
+static uint64_t
+xma_log_now(clockid_t clock)
+{
+    struct timespec ts;
+
+    clock_gettime(clock, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Token bucket limiting the messages of a thread per second */
+static bool
+xma_log_rate_ok(XmaLogRing *ring, uint64_t now)
+{
+    uint64_t elapsed = now - ring->rate_ts;
+    uint64_t refill;
+
+    if (elapsed >= 1000000000ULL)
+    {
+        ring->tokens = XMA_LOG_RATE_LIMIT;
+        ring->rate_ts = now;
+    }
+    else
+    {
+        refill = elapsed * XMA_LOG_RATE_LIMIT / 1000000000ULL;
+        if (refill)
+        {
+            ring->tokens = std::min<uint64_t>(XMA_LOG_RATE_LIMIT,
+                                              ring->tokens + refill);
+            ring->rate_ts += refill * 1000000000ULL / XMA_LOG_RATE_LIMIT;
+        }
+    }
+
+    if (!ring->tokens)
+        return false;
+    ring->tokens--;
+    return true;
+}
+
+/* Parse the conversion specification starting at the '%' in fmt */
+static void
+xma_log_parse_spec(const char *fmt, XmaLogSpec *spec)
+{
+    const char *p = fmt + 1;
+    char        mod = 0;
+    int32_t     num_mod = 0;
+
+    spec->type = XMA_LOG_ARG_UNSUPPORTED;
+    spec->num_stars = 0;
+    spec->star_precision = false;
+    spec->precision = -1;
+
+    while (*p && strchr("-+ #0'", *p))
+        p++;
+    if (*p == '*')
+    {
+        spec->num_stars++;
+        p++;
+    }
+    while (isdigit(*p))
+        p++;
+    if (*p == '.')
+    {
+        p++;
+        spec->precision = 0;
+        if (*p == '*')
+        {
+            spec->num_stars++;
+            spec->star_precision = true;
+            p++;
+        }
+        for (; isdigit(*p); p++)
+            spec->precision = std::min(spec->precision * 10 + (*p - '0'),
+                                       XMA_LOG_RECORD_SIZE);
+    }
+    while (*p && strchr("hlLqjzZt", *p))
+    {
+        mod = *p++;
+        num_mod++;
+    }
+
+    spec->end = *p ? p + 1 : p;
+    if (spec->end - fmt >= XMA_LOG_MAX_SPEC)
+        return;
+
+    switch (*p)
+    {
+    case '%':
+        if (!num_mod && !spec->num_stars)
+            spec->type = XMA_LOG_ARG_NONE;
+        break;
+    case 'c':
+        if (!num_mod)
+            spec->type = XMA_LOG_ARG_INT;
+        break;
+    case 'd': case 'i': case 'o': case 'u': case 'x': case 'X':
+        if (!num_mod || mod == 'h')
+            spec->type = XMA_LOG_ARG_INT;
+        else if (mod == 'l' && num_mod == 1)
+            spec->type = XMA_LOG_ARG_LONG;
+        else if (mod == 'l' || mod == 'q' || mod == 'L')
+            spec->type = XMA_LOG_ARG_LLONG;
+        else if (mod == 'j')
+            spec->type = XMA_LOG_ARG_INTMAX;
+        else if (mod == 'z' || mod == 'Z')
+            spec->type = XMA_LOG_ARG_SIZE;
+        else if (mod == 't')
+            spec->type = XMA_LOG_ARG_PTRDIFF;
+        break;
+    case 'e': case 'E': case 'f': case 'F':
+    case 'g': case 'G': case 'a': case 'A':
+        if (!num_mod || (mod == 'l' && num_mod == 1))
+            spec->type = XMA_LOG_ARG_DOUBLE;
+        break;
+    case 's':
+        if (!num_mod)
+            spec->type = XMA_LOG_ARG_STR;
+        break;
+    case 'p':
+        if (!num_mod)
+            spec->type = XMA_LOG_ARG_PTR;
+        break;
+    default:
+        /* %n, %m, wide characters and long double */
+        break;
+    }
+}
+
+static bool
+xma_log_put_scalar(char **args, char *end, const void *value, size_t size)
+{
+    if ((size_t)(end - *args) < sizeof(uint64_t))
+        return false;
+    memset(*args, 0, sizeof(uint64_t));
+    memcpy(*args, value, size);
+    *args += sizeof(uint64_t);
+    return true;
+}
+
+template <typename ArgType>
+static ArgType
+xma_log_get_scalar(const char **args)
+{
+    ArgType value;
+
+    memcpy(&value, *args, sizeof(value));
+    *args += sizeof(uint64_t);
+    return value;
+}
+
+/* Copy the arguments of msg into the record, false if not possible */
+static bool
+xma_log_capture(XmaLogRecord *rec, const char *msg, va_list ap)
+{
+    char       *start = rec->data + rec->name_len + rec->text_len;
+    char       *end = rec->data + sizeof(rec->data);
+    char       *args = start;
+    const char *p = msg;
+    XmaLogSpec  spec;
+
+    while ((p = strchr(p, '%')))
+    {
+        int32_t precision;
+        int32_t i;
+
+        xma_log_parse_spec(p, &spec);
+        if (spec.type == XMA_LOG_ARG_UNSUPPORTED)
+            return false;
+        p = spec.end;
+
+        precision = spec.precision;
+        for (i = 0; i < spec.num_stars; i++)
+        {
+            int star = va_arg(ap, int);
+            if (spec.star_precision && i == spec.num_stars - 1)
+                precision = star;
+            if (!xma_log_put_scalar(&args, end, &star, sizeof(star)))
+                return false;
+        }
+
+        switch (spec.type)
+        {
+        case XMA_LOG_ARG_INT:
+        {
+            int value = va_arg(ap, int);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_LONG:
+        {
+            long value = va_arg(ap, long);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_LLONG:
+        {
+            long long value = va_arg(ap, long long);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_INTMAX:
+        {
+            intmax_t value = va_arg(ap, intmax_t);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_SIZE:
+        {
+            size_t value = va_arg(ap, size_t);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_PTRDIFF:
+        {
+            ptrdiff_t value = va_arg(ap, ptrdiff_t);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_DOUBLE:
+        {
+            double value = va_arg(ap, double);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_PTR:
+        {
+            void *value = va_arg(ap, void*);
+            if (!xma_log_put_scalar(&args, end, &value, sizeof(value)))
+                return false;
+            break;
+        }
+        case XMA_LOG_ARG_STR:
+        {
+            /* String may not be terminated if a precision is given */
+            const char *value = va_arg(ap, const char*);
+            size_t      len;
+
+            if (!value)
+                value = "(null)";
+            len = precision >= 0 ? strnlen(value, precision) : strlen(value);
+            if ((size_t)(end - args) < len + 1)
+                return false;
+            memcpy(args, value, len);
+            args[len] = '\0';
+            args += len + 1;
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    rec->args_len = args - start;
+    return true;
+}
+
+template <typename ArgType>
+static int
+xma_log_snprintf(char *buf, size_t size, const char *conv,
+                 const XmaLogSpec *spec, const int *stars, ArgType value)
+{
+    switch (spec->num_stars)
+    {
+    case 0:
+        return snprintf(buf, size, conv, value);
+    case 1:
+        return snprintf(buf, size, conv, stars[0], value);
+    default:
+        return snprintf(buf, size, conv, stars[0], stars[1], value);
+    }
+}
+
+/* Format a captured message into buf, truncating it as vsnprintf does */
+static void
+xma_log_format(const XmaLogRecord *rec, char *buf, size_t size)
+{
+    const char *fmt = rec->data + rec->name_len;
+    const char *args = fmt + rec->text_len;
+    const char *p = fmt;
+    size_t      len = 0;
+    XmaLogSpec  spec;
+
+    if (rec->formatted)
+    {
+        snprintf(buf, size, "%s", fmt);
+        return;
+    }
+
+    while (*p && len < size - 1)
+    {
+        const char *pct = strchr(p, '%');
+        size_t      lit = pct ? (size_t)(pct - p) : strlen(p);
+        char        conv[XMA_LOG_MAX_SPEC];
+        int         stars[2] = {0, 0};
+        int         n = 0;
+        int32_t     i;
+
+        lit = std::min(lit, size - 1 - len);
+        memcpy(buf + len, p, lit);
+        len += lit;
+        if (!pct || len == size - 1)
+            break;
+
+        xma_log_parse_spec(pct, &spec);
+        memcpy(conv, pct, spec.end - pct);
+        conv[spec.end - pct] = '\0';
+        p = spec.end;
+        for (i = 0; i < spec.num_stars; i++)
+            stars[i] = xma_log_get_scalar<int>(&args);
+
+        switch (spec.type)
+        {
+        case XMA_LOG_ARG_NONE:
+            buf[len] = '%';
+            n = 1;
+            break;
+        case XMA_LOG_ARG_INT:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<int>(&args));
+            break;
+        case XMA_LOG_ARG_LONG:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<long>(&args));
+            break;
+        case XMA_LOG_ARG_LLONG:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<long long>(&args));
+            break;
+        case XMA_LOG_ARG_INTMAX:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<intmax_t>(&args));
+            break;
+        case XMA_LOG_ARG_SIZE:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<size_t>(&args));
+            break;
+        case XMA_LOG_ARG_PTRDIFF:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<ptrdiff_t>(&args));
+            break;
+        case XMA_LOG_ARG_DOUBLE:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<double>(&args));
+            break;
+        case XMA_LOG_ARG_PTR:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 xma_log_get_scalar<void*>(&args));
+            break;
+        case XMA_LOG_ARG_STR:
+            n = xma_log_snprintf(buf + len, size - len, conv, &spec, stars,
+                                 args);
+            args += strlen(args) + 1;
+            break;
+        default:
+            break;
+        }
+
+        if (n > 0)
+            len += std::min((size_t)n, size - 1 - len);
+    }
+    buf[len] = '\0';
+}
+
+/* Time stamp, process and component that start each log message */
+static int32_t
+xma_log_header(char *buf, size_t size, bool use_syslog, int32_t level,
+               const char *name, uint64_t realtime)
+{
+    const char *log_level = g_loglevel_tbl[level].lvl_str;
+    char        log_time[40] = {0};
+    time_t      sec = realtime / 1000000000ULL;
+    int32_t     millisec = (realtime % 1000000000ULL) / 1000000;
+    struct tm   tm_info;
+    int32_t     len;
+
+    //NOTE: Usage of program_invocation_short_name may hinder portability
+    if (use_syslog)
+    {
+        len = snprintf(buf, size, "%s %s %.39s ", program_invocation_short_name,
+                       log_level, name);
+    }
+    else
+    {
+        localtime_r(&sec, &tm_info);
+        strftime(log_time, sizeof(log_time), "%Y-%m-%d %H:%M:%S", &tm_info);
+        len = snprintf(buf, size, "%s.%03d %d %s %s %.39s ", log_time, millisec,
+                       getpid(), program_invocation_short_name, log_level,
+                       name);
+    }
+    return std::min(len, (int32_t)size - 1);
+}
+
+/* Format a message on the calling thread */
+static void
+xma_log_vformat(char *buf, size_t size, bool use_syslog, int32_t level,
+                const char *name, const char *msg, va_list ap)
+{
+    int32_t hdr_offset;
+
+    hdr_offset = xma_log_header(buf, size, use_syslog, level, name,
+                                xma_log_now(CLOCK_REALTIME));
+    vsnprintf(&buf[hdr_offset], size - hdr_offset, msg, ap);
+}
+
+
 void xma_logger_callback(XmaLoggerCallback callback, XmaLogLevelType level)
 {
     // Allocate singleton if it doesn't exist
@@ -164,24 +695,21 @@ xma_logmsg(XmaLogLevelType level, const char *name, const char *msg, ...)
     /* Handle variable arguments */
     va_list ap;
 
-    /* Create message buffer on the stack */
     char            msg_buff[XMA_MAX_LOGMSG_SIZE];
-    struct tm      *tm_info;
-    struct timeval  tv;
-    int32_t         millisec;
-    char            log_time[40] = {0};
-    char            log_name[40] = {0};
-    const char     *log_level;
-    int32_t         hdr_offset;
     bool            send2callback = false;
     bool            send2actor = false;
     char           *buffer;
+    XmaLogRing     *ring;
+    XmaLogRecord   *rec;
+    uint64_t        now;
+    uint32_t        tail;
+    size_t          len;
+    bool            captured = false;
 
     /* Get XMA logger */
     XmaLogger *logger = &g_xma_singleton->logger;
     XmaLoggerCbData *cbdata = g_xma_loggercb_singleton;
-
-    memset(msg_buff, 0, sizeof(msg_buff));
+    XmaActor *actor = logger->actor;
 
     if (cbdata)
     {
@@ -195,56 +723,220 @@ xma_logmsg(XmaLogLevelType level, const char *name, const char *msg, ...)
     if (!(send2callback || send2actor))
         return;
 
-    /* Get time */
-    gettimeofday(&tv, NULL);
-    millisec = lrint(tv.tv_usec/1000.0);
-    if (millisec >= 1000)
+    /* Set component name */
+    if (name == NULL)
+        name = "XMA-default";
+
+    /* The callback is invoked in the context of the caller */
+    if (send2callback)
     {
-        millisec -= 1000;
-        tv.tv_sec++;
+        va_start(ap, msg);
+        xma_log_vformat(msg_buff, sizeof(msg_buff), logger->use_syslog,
+                        level, name, msg, ap);
+        va_end(ap);
+        buffer = (char*) malloc(sizeof(msg_buff));
+        strcpy(buffer, msg_buff);
+        cbdata->callback(buffer);
     }
-    tm_info = localtime(&tv.tv_sec);
-    strftime(log_time, sizeof(log_time), "%Y-%m-%d %H:%M:%S", tm_info);
 
-    /* Set component name */
-    if (name == NULL)
-        strncpy(log_name, "XMA-default", sizeof(log_name));
-    else
-        strncpy(log_name, name, sizeof(log_name)-1);
+    if (!send2actor)
+        return;
 
-    log_level = g_loglevel_tbl[level].lvl_str;
+    /* Without logger thread, print right away */
+    if (!actor || actor->shutdown)
+    {
+        va_start(ap, msg);
+        xma_log_vformat(msg_buff, sizeof(msg_buff), false, level, name,
+                        msg, ap);
+        va_end(ap);
+        printf("%s", msg_buff);
+        return;
+    }
 
-    /* Format log message */
-    //NOTE: Usage of program_invocation_short_name may hinder portability
-    if(logger->use_syslog){
-        sprintf(msg_buff, "%s %s %s ", program_invocation_short_name, log_level, log_name);
+    /* Only capture the message, the actor formats it */
+    now = xma_log_now(CLOCK_MONOTONIC);
+    ring = xma_log_thread_ring();
+    if (level > XMA_ERROR_LOG && !xma_log_rate_ok(ring, now))
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-    else{
-        sprintf(msg_buff, "%s.%03d %d %s %s %s ", log_time, millisec, getpid(), program_invocation_short_name, log_level, log_name);
+
+    tail = ring->tail.load(std::memory_order_relaxed);
+    if (tail - ring->head.load(std::memory_order_acquire) ==
+        XMA_MAX_LOGMSG_Q_ENTRIES)
+    {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
     }
-    hdr_offset = strlen(msg_buff);
-    va_start(ap, msg);
-    vsnprintf(&msg_buff[hdr_offset], (XMA_MAX_LOGMSG_SIZE - hdr_offset), msg, ap);
-    va_end(ap);
 
-    /* Send message buffer to logger Actor -
-       will be copied to loggers message buffer */
-    if (send2actor)
-        xma_actor_sendmsg(logger->actor, msg_buff, sizeof(msg_buff));
+    rec = &ring->records[tail & (XMA_MAX_LOGMSG_Q_ENTRIES - 1)];
+    rec->timestamp = now;
+    rec->level = level;
+    len = strnlen(name, 39);
+    memcpy(rec->data, name, len);
+    rec->data[len] = '\0';
+    rec->name_len = len + 1;
 
-    if (send2callback)
+    len = strlen(msg) + 1;
+    if (len <= XMA_MAX_LOGMSG_SIZE)
     {
-        buffer = (char*) malloc(sizeof(msg_buff));
-        strcpy(buffer, msg_buff);
-        cbdata->callback(buffer);
+        memcpy(rec->data + rec->name_len, msg, len);
+        rec->text_len = len;
+        va_start(ap, msg);
+        captured = xma_log_capture(rec, msg, ap);
+        va_end(ap);
+    }
+    rec->formatted = !captured;
+    if (!captured)
+    {
+        va_start(ap, msg);
+        vsnprintf(rec->data + rec->name_len, XMA_MAX_LOGMSG_SIZE, msg, ap);
+        va_end(ap);
+        rec->text_len = strlen(rec->data + rec->name_len) + 1;
+        rec->args_len = 0;
+    }
+
+    ring->tail.store(tail + 1, std::memory_order_release);
+    if (actor->sleeping)
+        actor->wait_cv.notify_one();
+}
+
+/* Write out lines batched for log file or stdout */
+static void
+xma_log_flush(XmaLogger *logger, XmaLogOutput *out)
+{
+    struct stat fd_stat;
+    struct stat path_stat;
+    int32_t     rc;
+
+    if (out->batch.empty())
+        return;
+
+    if (logger->use_stdout)
+        fwrite(out->batch.data(), 1, out->batch.size(), stdout);
+
+    if (logger->fd != -1)
+    {
+        rc = write(logger->fd, out->batch.data(), out->batch.size());
+        if (rc < 0)
+        {
+            perror("XMA Logger: could not write to file: ");
+            close(logger->fd);
+            logger->fd = -1;
+        }
+    }
+    out->batch.clear();
+
+    /* Rotate the log file, unless another process sharing it already did */
+    if (logger->fd == -1 || fstat(logger->fd, &fd_stat) ||
+        fd_stat.st_size < XMA_MAX_LOGFILE_SIZE)
+        return;
+
+    if (!stat(logger->filename, &path_stat) &&
+        path_stat.st_ino == fd_stat.st_ino &&
+        path_stat.st_dev == fd_stat.st_dev)
+    {
+        std::string backup = std::string(logger->filename) + ".1";
+        rename(logger->filename, backup.c_str());
+    }
+    close(logger->fd);
+    logger->fd = open((const char*)logger->filename,
+                      O_APPEND | O_CREAT | O_WRONLY, 00666);
+    if (logger->fd == -1)
+        perror("XMA Logger: could not reopen file: ");
+}
+
+static void
+xma_log_write(XmaLogger *logger, XmaLogOutput *out, int32_t level,
+              const char *logmsg)
+{
+    if (out->use_xrt)
+    {
+        xclLogMsg(NULL, xclLogMsgLevel::INFO, "XMA", logmsg);
+        return;
     }
+
+    if (logger->use_syslog)
+    {
+        uint8_t syslog_level = LOG_DEBUG;
+        switch(level){
+            case XMA_CRITICAL_LOG: syslog_level = LOG_CRIT ; break;
+            case XMA_ERROR_LOG   : syslog_level = LOG_ERR  ; break;
+            case XMA_INFO_LOG    : syslog_level = LOG_INFO ; break;
+            case XMA_DEBUG_LOG   : syslog_level = LOG_DEBUG; break;
+        }
+        syslog(syslog_level,"%s", logmsg);
+    }
+
+    if (logger->use_stdout || logger->fd != -1)
+        out->batch.append(logmsg);
+}
+
+/* Format and write the messages of all threads, returns count written */
+static size_t
+xma_log_drain(XmaActor *actor, XmaLogger *logger, XmaLogOutput *out)
+{
+    XmaLogRings& all = xma_log_rings();
+    char         logmsg[XMA_MAX_LOGMSG_SIZE];
+    size_t       count = 0;
+    int32_t      hdr_offset;
+
+    std::lock_guard<std::mutex> lk(all.mutex);
+    for (auto itr = all.rings.begin(); itr != all.rings.end(); )
+    {
+        XmaLogRing *ring = *itr;
+        /* Read before tail so the last messages of a thread are seen */
+        bool        orphaned = ring->orphaned;
+        uint32_t    head = ring->head.load(std::memory_order_relaxed);
+        uint32_t    tail = ring->tail.load(std::memory_order_acquire);
+        uint64_t    dropped;
+
+        for (; head != tail; head++, count++)
+        {
+            XmaLogRecord *rec =
+                &ring->records[head & (XMA_MAX_LOGMSG_Q_ENTRIES - 1)];
+
+            hdr_offset = xma_log_header(logmsg, sizeof(logmsg),
+                                        logger->use_syslog, rec->level,
+                                        rec->data,
+                                        rec->timestamp + actor->realtime_offset);
+            xma_log_format(rec, &logmsg[hdr_offset],
+                           sizeof(logmsg) - hdr_offset);
+            ring->head.store(head + 1, std::memory_order_release);
+            xma_log_write(logger, out, rec->level, logmsg);
+        }
+
+        dropped = ring->dropped.load(std::memory_order_relaxed);
+        if (dropped != ring->reported)
+        {
+            hdr_offset = xma_log_header(logmsg, sizeof(logmsg),
+                                        logger->use_syslog, XMA_ERROR_LOG,
+                                        "xmalogger",
+                                        xma_log_now(CLOCK_REALTIME));
+            snprintf(&logmsg[hdr_offset], sizeof(logmsg) - hdr_offset,
+                     "dropped %llu messages of a thread\n",
+                     (unsigned long long)(dropped - ring->reported));
+            ring->reported = dropped;
+            xma_log_write(logger, out, XMA_ERROR_LOG, logmsg);
+        }
+
+        if (orphaned)
+        {
+            delete ring;
+            itr = all.rings.erase(itr);
+        }
+        else
+            ++itr;
+    }
+    xma_log_flush(logger, out);
+
+    return count;
 }
 
 //void* xma_logger_actor(void *data)
 void xma_logger_actor(XmaActor *actor)
 {
-    int32_t rc;
-    char logmsg[XMA_MAX_LOGMSG_SIZE];
     XmaLogger *logger = &g_xma_singleton->logger;
     //XmaActor  *actor = (XmaActor*)data;
 
@@ -325,52 +1017,25 @@ void xma_logger_actor(XmaActor *actor)
 
 
     //std::cout << "ERROR: found ini file: " << std::boolalpha << found_sdaccel_ini_file << std::endl;
+    XmaLogOutput out;
+    out.use_xrt = found_sdaccel_ini_file;
+
     printf("XMA Logger: Logging thread started\n");
     while (1)
     {
-        memset(logmsg, 0, sizeof(logmsg));
-        rc = xma_actor_recvmsg(actor, logmsg, sizeof(logmsg));
-        if (rc == 0)
-        {
-            if (strncmp(logmsg, "shutdown", 8) == 0)
-            {
-                printf("XMA logger: received shutdown\n");
-                break;
-            }
+        /* Messages logged before shutdown are still written */
+        bool shutdown = actor->shutdown;
 
-            if (found_sdaccel_ini_file) {
-                /* Format log message
-                sprintf(msg_buff, "%s.%03d %d %s %s ", log_time, millisec, getpid(), log_level, log_name);
-                */
-                //rc = xclLogMsg(xclDeviceHandle handle, xclLogMsgLevel level, logmsg);
-                xclLogMsg(NULL, xclLogMsgLevel::INFO, "XMA",logmsg);
-            } else {
-                if (logger->fd != -1)
-                {
-                    rc = write(logger->fd, logmsg, strlen(logmsg));
-                    if (rc < 0)
-                    {
-                        perror("XMA Logger: could not write to file: ");
-                        break;
-                    }
-                }
-                if (logger->use_syslog){
-                    uint8_t syslog_level = LOG_DEBUG;
-                    switch(logger->log_level){
-                        case XMA_CRITICAL_LOG: syslog_level = LOG_CRIT ; break;
-                        case XMA_ERROR_LOG   : syslog_level = LOG_ERR  ; break;
-                        case XMA_INFO_LOG    : syslog_level = LOG_INFO ; break;
-                        case XMA_DEBUG_LOG   : syslog_level = LOG_DEBUG; break;
-                    }
-                    syslog(syslog_level,"%s", logmsg);
-                }
-                if (logger->use_stdout)
-                    printf("%s", logmsg);
-            }
-        }
-        else
-            /* Logger has been shutdown - so return from thread */
+        if (xma_log_drain(actor, logger, &out))
+            continue;
+        if (shutdown)
             break;
+
+        /* A wakeup missed by a logging thread only delays output */
+        std::unique_lock<std::mutex> lk(actor->wait_mutex);
+        actor->sleeping = true;
+        actor->wait_cv.wait_for(lk, std::chrono::milliseconds(50));
+        actor->sleeping = false;
     }
     printf("XMA Logger: shutting down\n");
     if (logger->fd != -1)
@@ -505,40 +1170,15 @@ int32_t xma_msgq_dequeue(XmaMsgQ *msgq, void *msg, size_t size)
 */
 
 /* XmaActor APIs */
-/*
-XmaActor *xma_actor_create(XmaThreadFunc    func,
-                           size_t           msg_size,
-                           size_t           max_msg_entries)
-*/
 XmaActor *xma_actor_create()
 {
-    //std::cout << "Sarab: " << __func__ << " , " << std::dec << __LINE__ << std::endl;
-    /*
-    XmaActor *actor = (XmaActor*) malloc(sizeof(XmaActor));
-    pthread_mutex_init(&actor->lock, NULL);
-    pthread_cond_init(&actor->queued_cond, NULL);
-    pthread_cond_init(&actor->dequeued_cond, NULL);
-    actor->msg_q = xma_msgq_create(msg_size, max_msg_entries);
-    */
     XmaActor *actor =  new XmaActor();
     actor->thread = new XmaThread();
     actor->thread->is_running = false;
-    
-    /*
-    std::cout << "Sarab: " << __func__ << " , " << std::dec << __LINE__ << std::endl;
-    actor->logger_queue_mutex.reset(new std::mutex());
-    exit(0);
-
-
 
-    actor->logger_queue_mutex = std::unique_ptr<std::mutex>(new std::mutex());
-    actor->logger_queue_cv = std::unique_ptr<std::condition_variable>(new std::condition_variable());
-    actor->logger_queue_locked = std::unique_ptr<std::atomic<bool>>(new std::atomic<bool>());
-    *(actor->logger_queue_locked) = false;
-
-    std::cout << "Sarab: " << __func__ << " , " << std::dec << __LINE__ << std::endl;
-    actor->logger_queue = std::unique_ptr<std::queue<std::string>>(new std::queue<std::string>());
-    */
+    /* Records carry a monotonic time stamp, the actor converts it */
+    actor->realtime_offset = xma_log_now(CLOCK_REALTIME) -
+                             xma_log_now(CLOCK_MONOTONIC);
 
     return actor;
 }
@@ -552,140 +1192,15 @@ void xma_actor_start(XmaActor *actor)
 
 void xma_actor_destroy(XmaActor *actor)
 {
-    char *shutdown = (char*) "shutdown\0";
-
-    /* Send shutdown message to Actor */
+    /* Actor drains all threads before it exits */
     XMA_DBG_PRINTF("%s", "XMA sending shutdown message\n");
-    xma_actor_sendmsg(actor, shutdown, strlen(shutdown));
+    actor->shutdown = true;
+    actor->wait_cv.notify_one();
     if (actor->thread->thread_obj.joinable()) {
         actor->thread->thread_obj.join();
     }
     actor->thread->is_running = false;
-    //xma_thread_join(actor->thread);
-    //xma_msgq_destroy(actor->msg_q);
-    //xma_thread_destroy(actor->thread);
-    free(actor->thread);
-
-    free(actor);
-}
-
-int32_t xma_actor_sendmsg(XmaActor *actor, void *msg, size_t msg_size)
-{
-    /*
-    int32_t rc;
-    bool    was_empty;
-
-    pthread_mutex_lock(&actor->lock);
-    XMA_DBG_PRINTF("XMA actor sendmsg on entry depth=%d, front=%d, back=%d\n",
-            actor->msg_q->num_entries,
-            actor->msg_q->front,
-            actor->msg_q->back);
-    if (xma_msgq_isfull(actor->msg_q))
-    {
-        XMA_DBG_PRINTF("%s", "Waiting: msgq_isfull\n");
-        pthread_cond_wait(&actor->dequeued_cond, &actor->lock);
-        XMA_DBG_PRINTF("%s", "Waiting: msgq_isfull done\n");
-    }
-    was_empty = xma_msgq_isempty(actor->msg_q);
-    rc = xma_msgq_enqueue(actor->msg_q, msg, msg_size);
-    if (rc == 0 && was_empty)
-    {
-        XMA_DBG_PRINTF("%s", "Sending queued_cond for previously empty queue\n");
-        pthread_cond_broadcast(&actor->queued_cond);
-    }
-
-    XMA_DBG_PRINTF("XMA actor sendmsg on exit depth=%d, front=%d, back=%d\n",
-            actor->msg_q->num_entries,
-            actor->msg_q->front,
-            actor->msg_q->back);
-
-    pthread_mutex_unlock(&actor->lock);
-    */
-    // First acquire queue lock
-    bool expected = false;
-    bool desired = true;
-    while (!(*(actor->logger_queue_locked)).compare_exchange_weak(expected, desired)) {
-        expected = false;
-    }
-    //Queue lock acquired
-    bool was_empty = actor->logger_queue->empty();
-
-    actor->logger_queue->emplace(std::string((char*)msg, ((char*)msg)+msg_size));
-    if (was_empty) {
-        (*(actor->logger_queue_cv)).notify_all();
-    }
-    *(actor->logger_queue_locked) = false;
-
-    return 0;
-}
-
-int32_t xma_actor_recvmsg(XmaActor *actor, void *msg, size_t msg_size)
-{
-    /*
-    int32_t rc;
-    bool    was_full;
-
-    pthread_mutex_lock(&actor->lock);
-
-    XMA_DBG_PRINTF("XMA actor recvmsg on entry depth=%d, front=%d, back=%d\n",
-            actor->msg_q->num_entries,
-            actor->msg_q->front,
-            actor->msg_q->back);
-
-
-    if (xma_msgq_isempty(actor->msg_q))
-        pthread_cond_wait(&actor->queued_cond, &actor->lock);
-
-    was_full = xma_msgq_isfull(actor->msg_q);
-    rc = xma_msgq_dequeue(actor->msg_q, msg, msg_size);
-    if (was_full)
-    {
-        XMA_DBG_PRINTF("%s", "sending dequeued_cond\n");
-        pthread_cond_broadcast(&actor->dequeued_cond);
-    }
-
-    XMA_DBG_PRINTF("XMA actor recvmsg on exit depth=%d, front=%d, back=%d\n",
-            actor->msg_q->num_entries,
-            actor->msg_q->front,
-            actor->msg_q->back);
+    delete actor->thread;
 
-    pthread_mutex_unlock(&actor->lock);
-    */
-
-    // First acquire queue lock
-    bool lock_acquired = false;
-    bool expected = false;
-    bool desired = true;
-    while (!(*(actor->logger_queue_locked)).compare_exchange_weak(expected, desired)) {
-        expected = false;
-    }
-    //Queue lock acquired
-    lock_acquired = true;
-    if (actor->logger_queue->empty()) {
-        *(actor->logger_queue_locked) = false;
-        lock_acquired = false;
-        std::unique_lock<std::mutex> lk(*(actor->logger_queue_mutex));
-        (*(actor->logger_queue_cv)).wait(lk, [&]{return (!(actor->logger_queue->empty()));});
-    }
-    if (!lock_acquired) {
-        expected = false;
-        desired = true;
-        while (!(*(actor->logger_queue_locked)).compare_exchange_weak(expected, desired)) {
-            expected = false;
-        }
-        lock_acquired = true;
-    }
-    
-    std::string log_msg = actor->logger_queue->front();
-    uint32_t max = log_msg.size();
-    if (max > msg_size-1) {
-        max = msg_size-1;
-        XMA_DBG_PRINTF("%s", "XMA msgq dequeue: too small\n");
-    }
-    std::copy(log_msg.begin(), log_msg.begin()+max, (char*)msg);
-
-    actor->logger_queue->pop();
-    *(actor->logger_queue_locked) = false;
-
-    return 0;
+    delete actor;
 }
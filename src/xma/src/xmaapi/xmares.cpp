@@ -47,6 +47,9 @@
 
 #define XMA_RES_MOD "xmares"
 
+/* bump whenever the layout of XmaResConfig changes */
+#define XMA_SHM_DB_VERSION 2
+
 enum XmaKernType {
     xma_res_encoder = 1,
     xma_res_scaler,
@@ -126,8 +129,25 @@ typedef struct XmaShmRes {
     XmaImage images[MAX_IMAGE_CONFIGS];
 } XmaShmRes;
 
+/* zerocopy connection shared between processes; a pid of 0 is unused */
+typedef struct XmaShmConnect {
+    XmaConnectState state;
+    pid_t    sender_pid;
+    pid_t    receiver_pid;
+    int32_t  dev_id;
+    int32_t  ddr_bank;
+    int32_t  bits_per_pixel;
+    int32_t  width;
+    int32_t  height;
+    bool     dev_addr_valid; /* published and not yet taken by the sender */
+    uint64_t dev_addr;
+} XmaShmConnect;
+
 typedef struct XmaResConfig {
+    uint32_t version; /* XMA_SHM_DB_VERSION of the process creating the db */
+    uint32_t size; /* sizeof(XmaResConfig) of the process creating the db */
     XmaShmRes sys_res;
+    XmaShmConnect connections[MAX_CONNECTION_ENTRIES];
     pthread_mutex_t lock; /* protect access to shm across processes/threads */
     bool sys_res_ready; /* flag indicating system devices have been programmed */
     pid_t clients[MAX_XILINX_DEVICES * MAX_KERNEL_CONFIGS];
@@ -206,6 +226,8 @@ static void xma_free_all_kernel_chan_res(XmaDevice *dev, pid_t pid);
 
 static void xma_free_all_proc_res(XmaResConfig *xma_shm, pid_t proc_id);
 
+static void xma_connect_release(XmaShmConnect *conn);
+
 static void xma_dec_ref_shm(XmaResConfig *xma_shm);
 
 static int xma_inc_ref_shm(XmaResConfig *xma_shm, bool config_owner);
@@ -449,6 +471,133 @@ int32_t xma_res_free_dev(XmaResources shm_cfg, int32_t dev_handle)
     return ret;
 }
 
+int32_t xma_res_connect_alloc(XmaResources shm_cfg, XmaEndpoint *endpt,
+                              XmaConnectType type)
+{
+    XmaResConfig *xma_shm = (XmaResConfig *)shm_cfg;
+    pid_t proc_id = getpid();
+    int32_t ddr_bank;
+    int32_t c_idx = -1;
+    int i;
+
+    if (!shm_cfg || !endpt)
+        return -1;
+
+    /* format is not compared because of scaler plugin BUG */
+    ddr_bank = endpt->session->hw_session.ddr_bank;
+    if (xma_shm_lock(xma_shm))
+        return -1;
+    for (i = 0; i < MAX_CONNECTION_ENTRIES; i++)
+    {
+        XmaShmConnect *conn = &xma_shm->connections[i];
+
+        if (type == XMA_CONNECT_SENDER &&
+            conn->state == XMA_CONNECT_UNUSED)
+        {
+            conn->sender_pid = proc_id;
+            conn->dev_id = endpt->dev_id;
+            conn->ddr_bank = ddr_bank;
+            conn->bits_per_pixel = endpt->bits_per_pixel;
+            conn->width = endpt->width;
+            conn->height = endpt->height;
+            conn->dev_addr_valid = false;
+            conn->state = XMA_CONNECT_PENDING_ACTIVE;
+            c_idx = i;
+            break;
+        }
+
+        if (type == XMA_CONNECT_RECEIVER &&
+            conn->state == XMA_CONNECT_PENDING_ACTIVE &&
+            conn->dev_id == endpt->dev_id &&
+            conn->ddr_bank == ddr_bank &&
+            conn->bits_per_pixel == endpt->bits_per_pixel &&
+            conn->width == endpt->width &&
+            conn->height == endpt->height)
+        {
+            conn->receiver_pid = proc_id;
+            conn->state = XMA_CONNECT_ACTIVE;
+            c_idx = i;
+            break;
+        }
+    }
+    xma_shm_unlock(xma_shm);
+
+    xma_logmsg(XMA_DEBUG_LOG, XMA_RES_MOD,
+               "%s() %s connection %d\n", __func__,
+               type == XMA_CONNECT_SENDER ? "sender" : "receiver", c_idx);
+    return c_idx;
+}
+
+int32_t xma_res_connect_free(XmaResources shm_cfg, int32_t c_idx,
+                             XmaConnectType type)
+{
+    XmaResConfig *xma_shm = (XmaResConfig *)shm_cfg;
+    XmaShmConnect *conn;
+    pid_t proc_id = getpid();
+
+    if (!shm_cfg || c_idx < 0 || c_idx >= MAX_CONNECTION_ENTRIES)
+        return XMA_ERROR_INVALID;
+
+    conn = &xma_shm->connections[c_idx];
+    if (xma_shm_lock(xma_shm))
+        return XMA_ERROR;
+    if (type == XMA_CONNECT_SENDER && conn->sender_pid == proc_id)
+        conn->sender_pid = 0;
+    if (type == XMA_CONNECT_RECEIVER && conn->receiver_pid == proc_id)
+        conn->receiver_pid = 0;
+    xma_connect_release(conn);
+    xma_shm_unlock(xma_shm);
+    return XMA_SUCCESS;
+}
+
+int32_t xma_res_connect_get_dev_addr(XmaResources shm_cfg, int32_t c_idx,
+                                     uint64_t *dev_addr)
+{
+    XmaResConfig *xma_shm = (XmaResConfig *)shm_cfg;
+    XmaShmConnect *conn;
+    int32_t ret = XMA_ERROR;
+
+    if (!shm_cfg || c_idx < 0 || c_idx >= MAX_CONNECTION_ENTRIES)
+        return XMA_ERROR_INVALID;
+
+    conn = &xma_shm->connections[c_idx];
+    if (xma_shm_lock(xma_shm))
+        return XMA_ERROR;
+    /* the sender owns the buffer until the receiver publishes the next one */
+    if (conn->state == XMA_CONNECT_ACTIVE && conn->dev_addr_valid &&
+        conn->sender_pid == getpid())
+    {
+        *dev_addr = conn->dev_addr;
+        conn->dev_addr_valid = false;
+        ret = XMA_SUCCESS;
+    }
+    xma_shm_unlock(xma_shm);
+    return ret;
+}
+
+int32_t xma_res_connect_set_dev_addr(XmaResources shm_cfg, int32_t c_idx,
+                                     uint64_t dev_addr)
+{
+    XmaResConfig *xma_shm = (XmaResConfig *)shm_cfg;
+    XmaShmConnect *conn;
+    int32_t ret = XMA_ERROR;
+
+    if (!shm_cfg || c_idx < 0 || c_idx >= MAX_CONNECTION_ENTRIES)
+        return XMA_ERROR_INVALID;
+
+    conn = &xma_shm->connections[c_idx];
+    if (xma_shm_lock(xma_shm))
+        return XMA_ERROR;
+    if (conn->receiver_pid == getpid())
+    {
+        conn->dev_addr = dev_addr;
+        conn->dev_addr_valid = true;
+        ret = XMA_SUCCESS;
+    }
+    xma_shm_unlock(xma_shm);
+    return ret;
+}
+
 int32_t xma_res_dev_handle_get(XmaKernelRes kern_res)
 {
     XmaKernReq *kern_req = (XmaKernReq *)kern_res;
@@ -534,6 +683,7 @@ static XmaResConfig *xma_shm_open(char *shm_filename, XmaSystemCfg *config)
     bool shm_initalized;
     int max_wait = xma_cfg_dev_cnt_get() * 10; /* 10s per device programmed */
     XmaResConfig *shm_map;
+    struct stat shm_stat;
 
     pthread_mutexattr_t proc_shared_lock;
 
@@ -560,6 +710,8 @@ static XmaResConfig *xma_shm_open(char *shm_filename, XmaSystemCfg *config)
     pthread_mutexattr_setprotocol(&proc_shared_lock, PTHREAD_PRIO_INHERIT);
     shm_map = (XmaResConfig *)mmap(NULL, sizeof(XmaResConfig),
                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    shm_map->version = XMA_SHM_DB_VERSION;
+    shm_map->size = sizeof(XmaResConfig);
     pthread_mutex_init(&shm_map->lock, &proc_shared_lock);
     ret = xma_init_shm(shm_map, config);
     /* Permit other processes to open properly as shm is initalized */
@@ -603,11 +755,32 @@ eexist:
         return NULL;
     }
 
+    /* a db created by a different version of XMA can't be shared */
+    if (fstat(fd, &shm_stat) || shm_stat.st_size != sizeof(XmaResConfig)) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+                   "Resource database %s has an unexpected size, it may have been "
+                   "created by another version of XMA\n", shm_filename);
+        close(fd);
+        return NULL;
+    }
+
     shm_map = (XmaResConfig *)mmap(NULL, sizeof(XmaResConfig),
                PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
 
     close(fd);
 
+    if (shm_map == MAP_FAILED)
+        return NULL;
+
+    if (shm_map->version != XMA_SHM_DB_VERSION ||
+        shm_map->size != sizeof(XmaResConfig)) {
+        xma_logmsg(XMA_ERROR_LOG, XMA_RES_MOD,
+                   "Resource database %s version %u does not match XMA version %u\n",
+                   shm_filename, shm_map->version, XMA_SHM_DB_VERSION);
+        munmap((void*)shm_map, sizeof(XmaResConfig));
+        return NULL;
+    }
+
     /* verify processes held resources and update ref cnt */
     shm_initalized = false;
     for (max_retry = max_wait; !shm_initalized && max_retry; max_retry--)
@@ -689,6 +862,7 @@ static int xma_init_shm(XmaResConfig *xma_shm,
     xma_cfg_dev_ids_get(cfg_dev_ids);
 
     memset(&xma_shm->sys_res, 0, sizeof(XmaShmRes));
+    memset(xma_shm->connections, 0, sizeof(xma_shm->connections));
 
     /* init device data */
     for (i = 0, cfg_dev_idx = 0; i < dev_cnt; i++, cfg_dev_idx++) {
@@ -1692,9 +1866,36 @@ static void xma_free_all_proc_res(XmaResConfig *xma_shm, pid_t proc_id)
         xma_free_dev(xma_shm, i, proc_id);
         xma_free_all_kernel_chan_res(&xma_shm->sys_res.devices[i], proc_id);
     }
+
+    /* drop both sides of connections owned by the process */
+    for (i = 0; i < MAX_CONNECTION_ENTRIES; i++)
+    {
+        XmaShmConnect *conn = &xma_shm->connections[i];
+
+        if (conn->state == XMA_CONNECT_UNUSED)
+            continue;
+        if (conn->sender_pid == proc_id)
+            conn->sender_pid = 0;
+        if (conn->receiver_pid == proc_id)
+            conn->receiver_pid = 0;
+        xma_connect_release(conn);
+    }
     return;
 }
 
+static void xma_connect_release(XmaShmConnect *conn)
+{
+    /* entry can be reused once both sides are gone */
+    if (!conn->sender_pid && !conn->receiver_pid)
+        memset(conn, 0, sizeof(XmaShmConnect));
+    else if (conn->state == XMA_CONNECT_ACTIVE && !conn->receiver_pid) {
+        conn->dev_addr_valid = false;
+        conn->state = XMA_CONNECT_PENDING_DELETE;
+    }
+    else if (conn->state == XMA_CONNECT_ACTIVE && !conn->sender_pid)
+        conn->state = XMA_CONNECT_PENDING_DELETE;
+}
+
 static void xma_rm_client_from_kernel(XmaKernelInstance *k, pid_t client_id)
 {
     int i = xma_is_client_using_kernel(k, client_id);
@@ -337,33 +337,21 @@ xma_scaler_session_send_frame(XmaScalerSession  *session,
                               XmaFrame          *frame)
 {
     int32_t i;
+    uint64_t dev_addr;
 
     xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD, "%s()\n", __func__);
     for (i = 0; i < session->props.num_outputs; i++)
     {
-        if (session->conn_send_handles[i] != -1)
+        // Find the device buffer of a connected receiver, never reuse a
+        // buffer the receiver has not handed out again
+        if (xma_connect_get_dev_addr(session->conn_send_handles[i],
+                                     &dev_addr) == XMA_SUCCESS)
         {
-            // Get the connection entry to find the receiver
-            int32_t c_handle = session->conn_send_handles[i];
-            XmaConnect *conn = &g_xma_singleton->connections[c_handle];
-            XmaEndpoint *recv = conn->receiver;
-            if (recv)
-            {
-                if (is_xma_encoder(recv->session))
-                {
-                    XmaEncoderSession *e_ses =
-                        to_xma_encoder(recv->session);
-                    if (!e_ses->encoder_plugin->get_dev_input_paddr) {
-                        xma_logmsg(XMA_DEBUG_LOG, XMA_SCALER_MOD,
-                            "encoder plugin does not support zero copy\n");
-                        continue;
-                    }
-                    session->out_dev_addrs[i] =
-                        e_ses->encoder_plugin->get_dev_input_paddr(e_ses);
-                    session->zerocopy_dests[i] = true;
-                }
-            }
+            session->out_dev_addrs[i] = dev_addr;
+            session->zerocopy_dests[i] = true;
         }
+        else
+            session->zerocopy_dests[i] = false;
     }
 
     return session->scaler_plugin->send_frame(session, frame);
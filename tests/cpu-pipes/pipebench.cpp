@@ -0,0 +1,218 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * Throughput of the software emulation pipe builtins
+ *
+ * Writers push consecutive packet numbers, readers sum what they pop,
+ * and the sums must match.  Each mode runs the builtins the way the
+ * emulation kernels call them:
+ *
+ *   nolock   single writer and reader, cpu_write_pipe_nolock etc.
+ *   locking  cpu_write_pipe / cpu_read_pipe
+ *   reserve  cpu_reserve_write_pipe / cpu_reserve_read_pipe in batches
+ */
+
+#include "impl/cpu_pipes.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum mode { NOLOCK, LOCKING, RESERVE };
+
+static const char* modeName(mode m)
+{
+    switch (m) {
+    case NOLOCK: return "nolock";
+    case LOCKING: return "locking";
+    default: return "reserve";
+    }
+}
+
+// Packet carrying a sequence number, padded to the packet size
+static void fill(char* pkt, size_t pktSize, uint64_t value)
+{
+    std::memcpy(pkt, &value, sizeof(value));
+    for (size_t i = sizeof(value); i < pktSize; ++i)
+        pkt[i] = static_cast<char>(value);
+}
+
+static uint64_t value(const char* pkt)
+{
+    uint64_t v;
+    std::memcpy(&v, pkt, sizeof(v));
+    return v;
+}
+
+static void writer(void* pipe, mode m, size_t pktSize, unsigned batch, uint64_t first, uint64_t count)
+{
+    std::vector<char> pkt(pktSize);
+    uint64_t v = first;
+    const uint64_t end = first + count;
+    while (v < end) {
+        if (m == RESERVE) {
+            unsigned n = static_cast<unsigned>(std::min<uint64_t>(batch, end - v));
+            void* rid;
+            while (!(rid = cpu_reserve_write_pipe(pipe, n)))
+                std::this_thread::yield();
+            for (unsigned i = 0; i < n; ++i, ++v) {
+                fill(pkt.data(), pktSize, v);
+                cpu_write_pipe_reserve(pipe, rid, i, pkt.data());
+            }
+            cpu_commit_write_pipe(pipe, rid);
+            continue;
+        }
+        fill(pkt.data(), pktSize, v++);
+        if (m == NOLOCK)
+            cpu_write_pipe_nolock(pipe, pkt.data());
+        else
+            cpu_write_pipe(pipe, pkt.data());
+    }
+}
+
+static uint64_t reader(void* pipe, mode m, size_t pktSize, unsigned batch, uint64_t count)
+{
+    std::vector<char> pkt(pktSize);
+    uint64_t sum = 0;
+    uint64_t done = 0;
+    while (done < count) {
+        if (m == RESERVE) {
+            unsigned n = static_cast<unsigned>(std::min<uint64_t>(batch, count - done));
+            void* rid;
+            while (!(rid = cpu_reserve_read_pipe(pipe, n)))
+                std::this_thread::yield();
+            for (unsigned i = 0; i < n; ++i) {
+                cpu_read_pipe_reserve(pipe, rid, i, pkt.data());
+                sum += value(pkt.data());
+            }
+            cpu_commit_read_pipe(pipe, rid);
+            done += n;
+            continue;
+        }
+        if (m == NOLOCK)
+            cpu_read_pipe_nolock(pipe, pkt.data());
+        else
+            cpu_read_pipe(pipe, pkt.data());
+        sum += value(pkt.data());
+        ++done;
+    }
+    return sum;
+}
+
+static bool run(mode m, unsigned threads, size_t pktSize, size_t depth, unsigned batch, uint64_t packets)
+{
+    size_t bytes = pktSize * (depth + 8);
+    void* pipe = nullptr;
+    if (posix_memalign(&pipe, 128, sizeof(cpu_pipe_t) + bytes))
+        return false;
+    cpu_pipe_init(pipe, pktSize, bytes);
+
+    // Readers and writers each take an equal share, batches must not
+    // be split between readers
+    uint64_t share = packets / threads / batch * batch;
+    std::vector<std::thread> workers;
+    std::vector<uint64_t> sums(threads, 0);
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back(writer, pipe, m, pktSize, batch, t * share, share);
+        workers.emplace_back([&, t] { sums[t] = reader(pipe, m, pktSize, batch, share); });
+    }
+    for (auto& w : workers)
+        w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    free(pipe);
+
+    uint64_t total = share * threads;
+    uint64_t sum = 0;
+    for (auto s : sums)
+        sum += s;
+    bool ok = (sum == total * (total - 1) / 2);
+
+    std::ios_base::fmtflags f(std::cout.flags());
+    std::cout << std::left << std::setw(9) << modeName(m) << std::right << std::setw(8) << threads
+              << std::setw(8) << pktSize << std::setw(8) << batch << std::setw(12) << total
+              << std::fixed << std::setprecision(2) << std::setw(12) << total / seconds / 1e6
+              << std::setw(12) << total * pktSize / seconds / 1e9 << (ok ? "" : "  MISMATCH") << "\n";
+    std::cout.flags(f);
+    return ok;
+}
+
+static void printHelp(const char* exe)
+{
+    std::cout << "usage: " << exe << " [options]\n\n";
+    std::cout << "  -n <packets>, default 4000000\n";
+    std::cout << "  -d <pipe_depth_in_packets>, default 1024\n";
+    std::cout << "  -t <max_writer_reader_pairs>, default 4\n";
+    std::cout << "  -b <reservation_batch>, default 16\n";
+    std::cout << "  -h\n";
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t packets = 4000000;
+    size_t depth = 1024;
+    unsigned maxThreads = 4;
+    unsigned batch = 16;
+    int c;
+    while ((c = getopt(argc, argv, "n:d:t:b:h")) != -1) {
+        switch (c) {
+        case 'n':
+            packets = std::stoull(optarg);
+            break;
+        case 'd':
+            depth = std::stoul(optarg);
+            break;
+        case 't':
+            maxThreads = std::stoul(optarg);
+            break;
+        case 'b':
+            batch = std::stoul(optarg);
+            break;
+        case 'h':
+            printHelp(argv[0]);
+            return 0;
+        default:
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+    if (!batch || batch > depth || !maxThreads) {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    std::cout << std::left << std::setw(9) << "Mode" << std::right << std::setw(8) << "Pairs"
+              << std::setw(8) << "Size(B)" << std::setw(8) << "Batch" << std::setw(12) << "Packets"
+              << std::setw(12) << "Mpkt/s" << std::setw(12) << "GB/s" << "\n";
+    bool ok = true;
+    for (size_t size : {8, 64, 1024}) {
+        ok &= run(NOLOCK, 1, size, depth, 1, packets);
+        for (unsigned t = 1; t <= maxThreads; t *= 2) {
+            ok &= run(LOCKING, t, size, depth, 1, packets);
+            ok &= run(RESERVE, t, size, depth, batch, packets);
+        }
+    }
+    std::cout << (ok ? "PASSED" : "FAILED") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,775 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#ifndef KDS_BROKER_H
+#define KDS_BROKER_H
+
+/*
+ * KDS broker
+ *
+ * Shares command submission to one device among processes.  The
+ * broker owns the device handle and a POSIX shared memory segment
+ * with one slot per client process.  A client claims a slot, writes
+ * ERT command packets into the ring of its slot and waits for the
+ * broker to mark them done.  The broker dispatches submitted commands
+ * of all clients with weighted deficit round robin and keeps per
+ * client statistics.
+ *
+ * Commands are dispatched either through ERT (xclExecBuf) or, when the
+ * shim does not support xclExecBuf as in software emulation, by
+ * starting the CUs directly through their AXI-lite control register
+ * the same way as the XRT software scheduler.
+ *
+ * Only ERT_START_CU, and ERT_EXEC_WRITE when dispatching through ERT,
+ * are accepted.  These carry device addresses of buffers in the CU
+ * register map, not BO handles.  BO handles are local to the process
+ * that allocated or imported them and there is no path to import a
+ * client's BO into the broker, so commands that name BOs, such as
+ * ERT_START_COPYBO, are rejected.  The broker holds no reference on
+ * the buffers either: a client must keep its buffers allocated until
+ * wait() has returned for every command that uses them.
+ *
+ * The segment is accessible by the user running the broker only,
+ * unless the broker is given a group whose members may be clients.
+ */
+
+#include "xclhal2.h"
+#include "xclbin.h"
+#include "ert.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Not all shims implement ERT, e.g. the software emulation shim
+#pragma weak xclExecBuf
+#pragma weak xclExecWait
+#pragma weak xclOpenContext
+#pragma weak xclCloseContext
+
+namespace kds_broker {
+
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "shared memory requires lock free atomics");
+
+const uint32_t segment_magic = 0x4b445342; // "KDSB"
+const uint32_t segment_version = 1;
+const unsigned max_clients = 16;
+const unsigned ring_size = 32;
+const unsigned max_packet_words = 128;   // header + cu masks + register map
+
+enum entry_state : uint32_t {
+    ENTRY_FREE = 0,       // available to client
+    ENTRY_SUBMITTED,      // written by client, not yet seen by broker
+    ENTRY_RUNNING,        // dispatched by broker
+    ENTRY_DONE            // completed, packet state has the result
+};
+
+struct entry {
+    std::atomic<uint32_t> state;
+    uint32_t num_words;
+    uint64_t submit_ns;
+    uint64_t start_ns;
+    uint64_t done_ns;
+    uint32_t packet[max_packet_words];
+};
+
+// Written by broker only
+struct client_stats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t errors;
+    uint64_t queue_ns;     // total submit to start
+    uint64_t exec_ns;      // total start to done
+    uint64_t max_queue_ns;
+};
+
+struct client_slot {
+    std::atomic<int32_t> pid;           // 0 if slot is free
+    std::atomic<uint32_t> generation;   // incremented when claimed
+    std::atomic<uint32_t> weight;
+    client_stats stats;
+    entry ring[ring_size];
+};
+
+struct segment {
+    uint32_t magic;
+    uint32_t version;
+    std::atomic<int32_t> broker_pid;
+    std::atomic<uint32_t> doorbell;     // incremented on every submission
+    client_slot clients[max_clients];
+};
+
+inline std::string
+segment_name(unsigned deviceIndex)
+{
+    return "/xrt_kds_broker." + std::to_string(deviceIndex);
+}
+
+inline uint64_t
+now_ns()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Shared (not private) futex ops since waiters and wakers are in
+// different processes
+inline void
+futex_wait(std::atomic<uint32_t>& word, uint32_t value, long timeoutUs)
+{
+    struct timespec ts = { timeoutUs / 1000000, (timeoutUs % 1000000) * 1000L };
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &ts, nullptr, 0);
+}
+
+inline void
+futex_wake(std::atomic<uint32_t>& word)
+{
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+inline bool
+process_alive(int32_t pid)
+{
+    return pid > 0 && (kill(pid, 0) == 0 || errno != ESRCH);
+}
+
+/*
+ * client
+ *
+ * Claims a slot in the broker's segment for the lifetime of the
+ * object.  Not thread safe, use one client per thread.
+ */
+class client {
+    int mFd = -1;
+    segment* mSegment = nullptr;
+    client_slot* mSlot = nullptr;
+    unsigned mHead = 0;
+
+public:
+    client(unsigned deviceIndex, unsigned weight = 1) {
+        mFd = shm_open(segment_name(deviceIndex).c_str(), O_RDWR, 0);
+        if (mFd < 0 && errno == EACCES)
+            throw std::runtime_error("No permission to use KDS broker for device " + std::to_string(deviceIndex));
+        if (mFd < 0)
+            throw std::runtime_error("No KDS broker for device " + std::to_string(deviceIndex));
+        void* addr = mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE, MAP_SHARED, mFd, 0);
+        if (addr == MAP_FAILED) {
+            close(mFd);
+            throw std::runtime_error(std::string("Failed to map KDS broker segment: ") + strerror(errno));
+        }
+        mSegment = static_cast<segment*>(addr);
+        if (mSegment->magic != segment_magic || mSegment->version != segment_version
+            || !process_alive(mSegment->broker_pid)) {
+            release();
+            throw std::runtime_error("KDS broker for device " + std::to_string(deviceIndex) + " is not running");
+        }
+
+        int32_t self = getpid();
+        for (auto& slot : mSegment->clients) {
+            int32_t expected = 0;
+            if (slot.pid.compare_exchange_strong(expected, self)) {
+                slot.weight = std::max(weight, 1u);
+                ++slot.generation;
+                mSlot = &slot;
+                break;
+            }
+        }
+        if (!mSlot) {
+            release();
+            throw std::runtime_error("KDS broker has no free client slot");
+        }
+    }
+
+    ~client() {
+        if (mSlot) {
+            // Outstanding commands may reference buffers owned by caller
+            for (unsigned i = 0; i < ring_size; ++i) {
+                auto state = mSlot->ring[i].state.load();
+                try {
+                    if (state == ENTRY_SUBMITTED || state == ENTRY_RUNNING)
+                        wait(i);
+                }
+                catch (const std::exception&) {
+                    // broker exited, nothing is running
+                }
+                mSlot->ring[i].state = ENTRY_FREE;
+            }
+            mSlot->pid = 0;
+        }
+        release();
+    }
+
+    client(const client&) = delete;
+    client& operator=(const client&) = delete;
+
+    unsigned index() const {
+        return mSlot - mSegment->clients;
+    }
+
+    const client_stats& stats() const {
+        return mSlot->stats;
+    }
+
+    /*
+     * submit()
+     *
+     * Copy an ERT packet into the ring.  Returns a ticket to wait on,
+     * or -1 if the ring is full and the command must be retried after
+     * waiting on an outstanding ticket.
+     */
+    int submit(const uint32_t* aPacket, size_t aWords) {
+        if (aWords > max_packet_words)
+            throw std::runtime_error("ERT packet too large for KDS broker");
+        auto& e = mSlot->ring[mHead];
+        if (e.state != ENTRY_FREE)
+            return -1;
+        std::memcpy(e.packet, aPacket, aWords * sizeof(uint32_t));
+        e.num_words = aWords;
+        e.submit_ns = now_ns();
+        e.state = ENTRY_SUBMITTED;
+        int ticket = mHead;
+        mHead = (mHead + 1) % ring_size;
+
+        ++mSegment->doorbell;
+        futex_wake(mSegment->doorbell);
+        return ticket;
+    }
+
+    /*
+     * wait()
+     *
+     * Block until the command of ticket is done and release the ring
+     * entry.  Copies the completed packet to aPacket if not null.
+     * Returns the ert_cmd_state of the completed packet.
+     */
+    ert_cmd_state wait(int aTicket, uint32_t* aPacket = nullptr) {
+        auto& e = mSlot->ring[aTicket];
+        for (uint32_t state = e.state; state != ENTRY_DONE; state = e.state) {
+            if (state == ENTRY_FREE)
+                throw std::runtime_error("No command for ticket " + std::to_string(aTicket));
+            if (!process_alive(mSegment->broker_pid))
+                throw std::runtime_error("KDS broker exited");
+            futex_wait(e.state, state, 100000);
+        }
+        auto packet = reinterpret_cast<const ert_packet*>(e.packet);
+        auto result = static_cast<ert_cmd_state>(packet->state);
+        if (aPacket)
+            std::memcpy(aPacket, e.packet, std::min<uint32_t>(e.num_words, max_packet_words) * sizeof(uint32_t));
+        e.state = ENTRY_FREE;
+        return result;
+    }
+
+private:
+    void release() {
+        if (mSegment)
+            munmap(mSegment, sizeof(segment));
+        if (mFd >= 0)
+            close(mFd);
+        mSegment = nullptr;
+        mFd = -1;
+    }
+};
+
+/*
+ * broker
+ *
+ * Owns the shared segment of a device and dispatches commands of all
+ * clients on the device handle.  The handle must have the xclbin
+ * loaded, and CU contexts are opened by the broker.
+ */
+class broker {
+    static const uint32_t AP_START = 0x1;
+    static const uint32_t AP_DONE = 0x2;
+    static const uint32_t AP_IDLE = 0x4;
+    static const uint32_t AP_CONTINUE = 0x10;
+    static const unsigned num_exec_bos = 64;
+    static const long cu_poll_us = 20;
+
+    struct exec_bo {
+        unsigned m_bo;
+        ert_packet* m_data;
+    };
+
+    // Command dispatched to ERT or started on a CU
+    struct running {
+        unsigned m_client;
+        unsigned m_entry;
+        int m_exec;           // index of exec BO, or -1
+        int m_cu;             // index of CU, or -1
+        uint32_t m_words;     // validated size of packet
+    };
+
+    // Broker private state per client slot
+    struct client_state {
+        int32_t m_pid = 0;
+        uint32_t m_generation = 0;
+        unsigned m_tail = 0;
+        unsigned m_running = 0;
+        long m_deficit = 0;
+        bool m_dead = false;
+        client_stats m_stats = {};
+    };
+
+    xclDeviceHandle mHandle;
+    std::string mName;
+    segment* mSegment = nullptr;
+    bool mErt;
+    bool mSwEmu;
+    uuid_t mXclbinId;
+    std::vector<std::pair<uint64_t, unsigned>> mCus;   // base address, ip_layout index
+    std::vector<bool> mCuBusy;
+    std::vector<exec_bo> mExecBos;
+    std::vector<int> mFreeExecBos;
+    std::vector<running> mRunning;
+    client_state mClients[max_clients];
+    unsigned mNext = 0;
+    uint64_t mLastReap = 0;
+    std::ostream& mLog;
+
+public:
+    /*
+     * @aTop: xclbin loaded on aHandle, used to find the CUs
+     * @aUseErt: dispatch through xclExecBuf, ignored if the shim
+     *   does not support it
+     * @aGroup: group allowed to connect as clients, by default only
+     *   the user running the broker
+     */
+    broker(xclDeviceHandle aHandle, unsigned aDeviceIndex, const axlf* aTop, bool aUseErt = true,
+           std::ostream& aLog = std::cout, gid_t aGroup = static_cast<gid_t>(-1))
+        : mHandle(aHandle), mName(segment_name(aDeviceIndex)),
+          mErt(aUseErt && xclExecBuf && xclExecWait), mLog(aLog) {
+        auto mode = std::getenv("XCL_EMULATION_MODE");
+        mSwEmu = mode && std::strcmp(mode, "sw_emu") == 0;
+        std::memcpy(mXclbinId, aTop->m_header.uuid, sizeof(uuid_t));
+        auto layout = xclbin::get_axlf_section(aTop, IP_LAYOUT);
+        if (layout) {
+            auto ips = reinterpret_cast<const ip_layout*>(reinterpret_cast<const char*>(aTop) + layout->m_sectionOffset);
+            for (int i = 0; i < ips->m_count; ++i)
+                if (ips->m_ip_data[i].m_type == IP_KERNEL)
+                    mCus.emplace_back(ips->m_ip_data[i].m_base_address, i);
+        }
+        // CU index in cu_mask is the index of the CU sorted by address
+        std::sort(mCus.begin(), mCus.end());
+        mCuBusy.resize(mCus.size(), false);
+
+        if (xclOpenContext) {
+            for (auto& cu : mCus)
+                if (xclOpenContext(mHandle, mXclbinId, cu.second, true))
+                    throw std::runtime_error("Failed to open context on CU " + std::to_string(cu.second));
+        }
+
+        if (mErt) {
+            for (unsigned i = 0; i < num_exec_bos; ++i) {
+                unsigned bo = xclAllocBO(mHandle, 4096, xclBOKind(0), (1 << 31));
+                if (bo == 0xffffffff)
+                    throw std::runtime_error("Failed to allocate exec buffer");
+                auto data = static_cast<ert_packet*>(xclMapBO(mHandle, bo, true));
+                mExecBos.push_back({bo, data});
+                mFreeExecBos.push_back(i);
+            }
+            configure();
+        }
+
+        // A segment left by a broker that did not exit cleanly is recreated
+        shm_unlink(mName.c_str());
+        int fd = shm_open(mName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0)
+            throw std::runtime_error("Failed to create " + mName + ": " + strerror(errno));
+        if (aGroup != static_cast<gid_t>(-1) && (fchown(fd, -1, aGroup) || fchmod(fd, 0660))) {
+            close(fd);
+            shm_unlink(mName.c_str());
+            throw std::runtime_error("Failed to share " + mName + " with group: " + strerror(errno));
+        }
+        if (ftruncate(fd, sizeof(segment))) {
+            close(fd);
+            shm_unlink(mName.c_str());
+            throw std::runtime_error("Failed to size " + mName + ": " + strerror(errno));
+        }
+        void* addr = mmap(nullptr, sizeof(segment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (addr == MAP_FAILED) {
+            shm_unlink(mName.c_str());
+            throw std::runtime_error("Failed to map " + mName + ": " + strerror(errno));
+        }
+        mSegment = static_cast<segment*>(addr);
+        mSegment->magic = segment_magic;
+        mSegment->version = segment_version;
+        mSegment->broker_pid = getpid();
+    }
+
+    ~broker() {
+        for (auto& ebo : mExecBos) {
+            munmap(ebo.m_data, 4096);
+            xclFreeBO(mHandle, ebo.m_bo);
+        }
+        if (xclCloseContext) {
+            for (auto& cu : mCus)
+                xclCloseContext(mHandle, mXclbinId, cu.second);
+        }
+        mSegment->broker_pid = 0;
+        munmap(mSegment, sizeof(segment));
+        shm_unlink(mName.c_str());
+    }
+
+    broker(const broker&) = delete;
+    broker& operator=(const broker&) = delete;
+
+    bool usesErt() const {
+        return mErt;
+    }
+
+    /*
+     * run()
+     *
+     * Dispatch and complete commands until aStop is set and no
+     * commands are running.  aStats is polled for a request to print
+     * statistics and cleared when done.
+     */
+    void run(const std::atomic<bool>& aStop, std::atomic<bool>* aStats = nullptr) {
+        while (!aStop || !mRunning.empty()) {
+            uint32_t doorbell = mSegment->doorbell;
+            reap();
+            if (!aStop)
+                dispatch();
+            if (aStats && *aStats) {
+                printStats(mLog);
+                *aStats = false;
+            }
+
+            if (!mRunning.empty()) {
+                wait();
+                complete();
+            }
+            else if (doorbell == mSegment->doorbell) {
+                futex_wait(mSegment->doorbell, doorbell, 100000);
+            }
+        }
+    }
+
+    void printStats(std::ostream& aOut) const {
+        std::ios_base::fmtflags f(aOut.flags());
+        aOut << "KDS broker " << mName << (mErt ? " (ert)" : " (cu)") << "\n";
+        aOut << std::left << std::setw(6) << "Slot" << std::setw(8) << "PID" << std::right
+             << std::setw(8) << "Weight" << std::setw(12) << "Submitted" << std::setw(12) << "Completed"
+             << std::setw(8) << "Errors" << std::setw(14) << "AvgQueue(us)" << std::setw(14) << "MaxQueue(us)"
+             << std::setw(14) << "AvgExec(us)" << "\n";
+        for (unsigned i = 0; i < max_clients; ++i) {
+            const client_state& c = mClients[i];
+            if (!c.m_pid)
+                continue;
+            printClient(aOut, i, c);
+        }
+        aOut.flags(f);
+    }
+
+private:
+    // Clients are not allowed to configure the scheduler, the broker
+    // configures it once for the CUs of the xclbin
+    void configure() {
+        if (mCus.empty())
+            return;
+        auto ecmd = reinterpret_cast<ert_configure_cmd*>(mExecBos[0].m_data);
+        std::memset(ecmd, 0, 4096);
+        ecmd->state = ERT_CMD_STATE_NEW;
+        ecmd->opcode = ERT_CONFIGURE;
+        ecmd->slot_size = 4096;
+        ecmd->num_cus = mCus.size();
+        ecmd->cu_shift = 16;
+        ecmd->cu_base_addr = mCus[0].first;
+        ecmd->ert = 1;
+        ecmd->cu_dma = 1;
+        ecmd->cu_isr = 1;
+        for (size_t i = 0; i < mCus.size(); ++i)
+            ecmd->data[i] = mCus[i].first;
+        ecmd->count = 5 + ecmd->num_cus;
+
+        if (xclExecBuf(mHandle, mExecBos[0].m_bo))
+            throw std::runtime_error("Failed to configure scheduler");
+        while (ecmd->state < ERT_CMD_STATE_COMPLETED)
+            xclExecWait(mHandle, 1000);
+        if (ecmd->state != ERT_CMD_STATE_COMPLETED)
+            throw std::runtime_error("Failed to configure scheduler");
+    }
+
+    void printClient(std::ostream& aOut, unsigned aIndex, const client_state& aClient) const {
+        const client_stats& s = aClient.m_stats;
+        double done = s.completed ? s.completed : 1;
+        aOut << std::left << std::setw(6) << aIndex << std::setw(8) << aClient.m_pid << std::right
+             << std::setw(8) << mSegment->clients[aIndex].weight << std::setw(12) << s.submitted
+             << std::setw(12) << s.completed << std::setw(8) << s.errors << std::fixed << std::setprecision(1)
+             << std::setw(14) << s.queue_ns / done / 1000 << std::setw(14) << s.max_queue_ns / 1000.0
+             << std::setw(14) << s.exec_ns / done / 1000 << "\n";
+    }
+
+    // Track claimed and released slots, retire slots of clients that
+    // exited without releasing
+    void reap() {
+        uint64_t now = now_ns();
+        bool check = now - mLastReap > 100000000;   // 100ms
+        if (check)
+            mLastReap = now;
+
+        for (unsigned i = 0; i < max_clients; ++i) {
+            client_slot& slot = mSegment->clients[i];
+            client_state& c = mClients[i];
+            uint32_t generation = slot.generation;
+            int32_t pid = slot.pid;
+            if (c.m_pid && (generation != c.m_generation || pid != c.m_pid) && !c.m_running) {
+                mLog << "KDS broker client " << c.m_pid << " detached\n";
+                printClient(mLog, i, c);
+                c = client_state();
+            }
+            if (!c.m_pid && pid && !c.m_running) {
+                c.m_pid = pid;
+                c.m_generation = generation;
+                slot.stats = c.m_stats;
+            }
+            if (check && c.m_pid && !c.m_dead && !process_alive(c.m_pid)) {
+                mLog << "KDS broker client " << c.m_pid << " exited\n";
+                c.m_dead = true;
+            }
+            if (c.m_dead && !c.m_running) {
+                printClient(mLog, i, c);
+                for (auto& e : slot.ring)
+                    e.state = ENTRY_FREE;
+                c = client_state();
+                int32_t expected = pid;
+                slot.pid.compare_exchange_strong(expected, 0);
+            }
+        }
+    }
+
+    bool pending(unsigned aClient) const {
+        const client_state& c = mClients[aClient];
+        return c.m_pid && !c.m_dead
+            && mSegment->clients[aClient].ring[c.m_tail].state == ENTRY_SUBMITTED;
+    }
+
+    bool capacity() const {
+        if (mErt)
+            return !mFreeExecBos.empty();
+        return std::find(mCuBusy.begin(), mCuBusy.end(), false) != mCuBusy.end();
+    }
+
+    // Weighted deficit round robin.  A client with pending commands
+    // earns its weight in commands per round, the round starts after
+    // the client that was served last.
+    void dispatch() {
+        bool progress = true;
+        while (progress && capacity()) {
+            progress = false;
+            for (unsigned n = 0; n < max_clients && capacity(); ++n) {
+                unsigned idx = (mNext + n) % max_clients;
+                client_state& c = mClients[idx];
+                if (!pending(idx)) {
+                    c.m_deficit = 0;
+                    continue;
+                }
+                c.m_deficit += mSegment->clients[idx].weight;
+                while (c.m_deficit > 0 && pending(idx) && capacity()) {
+                    if (!launch(idx))
+                        break;
+                    --c.m_deficit;
+                    progress = true;
+                }
+                if (!capacity())
+                    mNext = (idx + 1) % max_clients;
+            }
+        }
+    }
+
+    // Complete an entry without running it
+    void fail(unsigned aClient, entry& aEntry, ert_cmd_state aState) {
+        client_state& c = mClients[aClient];
+        reinterpret_cast<ert_packet*>(aEntry.packet)->state = aState;
+        aEntry.start_ns = aEntry.done_ns = now_ns();
+        ++c.m_stats.submitted;
+        ++c.m_stats.errors;
+        c.m_tail = (c.m_tail + 1) % ring_size;
+        mSegment->clients[aClient].stats = c.m_stats;
+        aEntry.state = ENTRY_DONE;
+        futex_wake(aEntry.state);
+    }
+
+    // Opcodes clients may submit, see top of file
+    bool allowed(const ert_start_kernel_cmd* aCmd, uint32_t aWords) const {
+        if (aCmd->opcode != ERT_START_CU && (aCmd->opcode != ERT_EXEC_WRITE || !mErt))
+            return false;
+        unsigned masks = 1 + aCmd->extra_cu_masks;
+        if (aWords < 1 + masks)
+            return false;
+        // Only CUs of the xclbin, and at least one
+        const uint32_t* mask = &aCmd->cu_mask;
+        bool any = false;
+        for (unsigned i = 0; i < masks; ++i) {
+            uint32_t valid = ~0u;
+            if (mCus.size() <= i * 32)
+                valid = 0;
+            else if (mCus.size() < (i + 1) * 32)
+                valid = (1u << (mCus.size() - i * 32)) - 1;
+            if (mask[i] & ~valid)
+                return false;
+            any = any || mask[i];
+        }
+        return any;
+    }
+
+    // Start next command of client, returns false if the command
+    // cannot be started now
+    bool launch(unsigned aClient) {
+        client_state& c = mClients[aClient];
+        entry& e = mSegment->clients[aClient].ring[c.m_tail];
+
+        // The client can write the entry at any time, validate and
+        // dispatch a private copy of the packet
+        uint32_t words = e.num_words;
+        if (words < 1 || words > max_packet_words) {
+            fail(aClient, e, ERT_CMD_STATE_ERROR);
+            return true;
+        }
+        uint32_t packet[max_packet_words];
+        std::memcpy(packet, e.packet, words * sizeof(uint32_t));
+        auto cmd = reinterpret_cast<ert_start_kernel_cmd*>(packet);
+        if (words != cmd->count + 1u || !allowed(cmd, words)) {
+            fail(aClient, e, ERT_CMD_STATE_ERROR);
+            return true;
+        }
+
+        running r = {aClient, c.m_tail, -1, -1, words};
+        if (mErt) {
+            r.m_exec = mFreeExecBos.back();
+            auto ebo = mExecBos[r.m_exec].m_data;
+            std::memcpy(ebo, packet, words * sizeof(uint32_t));
+            ebo->state = ERT_CMD_STATE_NEW;
+            if (xclExecBuf(mHandle, mExecBos[r.m_exec].m_bo)) {
+                fail(aClient, e, ERT_CMD_STATE_ERROR);
+                return true;
+            }
+            mFreeExecBos.pop_back();
+        }
+        else {
+            unsigned masks = 1 + cmd->extra_cu_masks;
+            const uint32_t* mask = &cmd->cu_mask;
+            for (unsigned cu = 0; cu < mCus.size() && cu < masks * 32; ++cu) {
+                if (!mCuBusy[cu] && (mask[cu / 32] & (1u << (cu % 32)))) {
+                    r.m_cu = cu;
+                    break;
+                }
+            }
+            if (r.m_cu < 0)
+                return false;
+
+            // Register map follows the masks, written with AP_START low
+            // first, same as the XRT software scheduler
+            uint32_t* regmap = &cmd->cu_mask + masks;
+            size_t size = (cmd->count - masks) * sizeof(uint32_t);
+            regmap[0] = 0;
+            xclWrite(mHandle, XCL_ADDR_KERNEL_CTRL, mCus[r.m_cu].first, regmap, size);
+            regmap[0] = AP_START;
+            xclWrite(mHandle, XCL_ADDR_KERNEL_CTRL, mCus[r.m_cu].first, regmap, size);
+            mCuBusy[r.m_cu] = true;
+        }
+
+        e.start_ns = now_ns();
+        e.state = ENTRY_RUNNING;
+        c.m_tail = (c.m_tail + 1) % ring_size;
+        ++c.m_running;
+        ++c.m_stats.submitted;
+        mRunning.push_back(r);
+        return true;
+    }
+
+    // CUs started directly have no interrupt and are polled, sleep
+    // between polls unless a client submits more work
+    void wait() {
+        if (mErt)
+            xclExecWait(mHandle, 1);
+        else
+            futex_wait(mSegment->doorbell, mSegment->doorbell, cu_poll_us);
+    }
+
+    void complete() {
+        for (size_t i = 0; i < mRunning.size();) {
+            running& r = mRunning[i];
+            entry& e = mSegment->clients[r.m_client].ring[r.m_entry];
+            auto packet = reinterpret_cast<ert_packet*>(e.packet);
+            uint32_t state = ERT_CMD_STATE_COMPLETED;
+            if (mErt) {
+                auto ebo = mExecBos[r.m_exec].m_data;
+                if (ebo->state < ERT_CMD_STATE_COMPLETED) {
+                    ++i;
+                    continue;
+                }
+                std::memcpy(e.packet, ebo, r.m_words * sizeof(uint32_t));
+                state = ebo->state;
+                mFreeExecBos.push_back(r.m_exec);
+            }
+            else {
+                // AP_IDLE check in sw emulation, same as software scheduler
+                uint32_t ctrl = 0;
+                xclRead(mHandle, XCL_ADDR_KERNEL_CTRL, mCus[r.m_cu].first, &ctrl, 4);
+                if (!(ctrl & (mSwEmu ? (AP_DONE | AP_IDLE) : AP_DONE))) {
+                    ++i;
+                    continue;
+                }
+                uint32_t cont = AP_CONTINUE;
+                xclWrite(mHandle, XCL_ADDR_KERNEL_CTRL, mCus[r.m_cu].first, &cont, 4);
+                mCuBusy[r.m_cu] = false;
+            }
+
+            packet->state = state;
+            e.done_ns = now_ns();
+            client_state& c = mClients[r.m_client];
+            uint64_t queued = e.start_ns - e.submit_ns;
+            c.m_stats.queue_ns += queued;
+            c.m_stats.max_queue_ns = std::max(c.m_stats.max_queue_ns, queued);
+            c.m_stats.exec_ns += e.done_ns - e.start_ns;
+            if (state == ERT_CMD_STATE_COMPLETED)
+                ++c.m_stats.completed;
+            else
+                ++c.m_stats.errors;
+            --c.m_running;
+            mSegment->clients[r.m_client].stats = c.m_stats;
+
+            e.state = ENTRY_DONE;
+            futex_wake(e.state);
+
+            r = mRunning.back();
+            mRunning.pop_back();
+        }
+    }
+};
+
+} // kds_broker
+
+#endif /* KDS_BROKER_H */
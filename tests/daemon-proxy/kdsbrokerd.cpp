@@ -0,0 +1,196 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*
+ * KDS broker daemon
+ *
+ * Loads an xclbin and shares command submission to the device among
+ * client processes, see kds_broker.h.  Like mproxyd one child process
+ * is forked per device unless a device is specified.
+ *
+ * SIGUSR1 prints per client statistics, SIGINT and SIGTERM stop the
+ * broker after running commands complete.
+ */
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <getopt.h>
+#include <grp.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "kds_broker.h"
+
+static std::atomic<bool> g_stop(false);
+static std::atomic<bool> g_stats(false);
+
+static void on_signal(int sig)
+{
+    if (sig == SIGUSR1)
+        g_stats = true;
+    else
+        g_stop = true;
+}
+
+static void printHelp(const char* exe)
+{
+    std::cout << "usage: " << exe << " [options] -k <bitstream>\n\n";
+    std::cout << "  -k <bitstream>\n";
+    std::cout << "  -d <device_index>, default all devices\n";
+    std::cout << "  -l <hal_logfile>\n";
+    std::cout << "  -g <group>, group allowed to submit commands, default broker user only\n";
+    std::cout << "  --no-ert, start CUs directly instead of through xclExecBuf\n";
+    std::cout << "  -h\n";
+}
+
+static int runBroker(unsigned index, const std::vector<char>& xclbin, const std::string& halLog, bool ert, gid_t group)
+{
+    xclDeviceHandle handle = xclOpen(index, halLog.size() ? halLog.c_str() : nullptr, XCL_INFO);
+    if (!handle) {
+        std::cout << "ERROR: Failed to open device " << index << "\n";
+        return 1;
+    }
+
+    int ret = 0;
+    try {
+        if (xclLockDevice(handle))
+            throw std::runtime_error("Cannot lock device");
+        if (xclLoadXclBin(handle, reinterpret_cast<const xclBin*>(xclbin.data())))
+            throw std::runtime_error("Bitstream download failed");
+
+        kds_broker::broker b(handle, index, reinterpret_cast<const axlf*>(xclbin.data()), ert, std::cout, group);
+        std::cout << "KDS broker for device " << index << " started, pid " << getpid()
+                  << (b.usesErt() ? " (ert)" : " (cu)") << "\n";
+        b.run(g_stop, &g_stats);
+        b.printStats(std::cout);
+    }
+    catch (const std::exception& ex) {
+        std::cout << "ERROR: device " << index << ": " << ex.what() << "\n";
+        ret = 1;
+    }
+    xclClose(handle);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    static struct option long_options[] = {
+        {"bitstream", required_argument, 0, 'k'},
+        {"device", required_argument, 0, 'd'},
+        {"hal_logfile", required_argument, 0, 'l'},
+        {"group", required_argument, 0, 'g'},
+        {"no-ert", no_argument, 0, 'n'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    std::string bitstream;
+    std::string halLog;
+    int device = -1;
+    bool ert = true;
+    gid_t group = static_cast<gid_t>(-1);
+    int c;
+    while ((c = getopt_long(argc, argv, "k:d:l:g:h", long_options, nullptr)) != -1) {
+        switch (c) {
+        case 'k':
+            bitstream = optarg;
+            break;
+        case 'd':
+            device = std::atoi(optarg);
+            break;
+        case 'l':
+            halLog = optarg;
+            break;
+        case 'g': {
+            struct group* grp = getgrnam(optarg);
+            if (!grp) {
+                std::cout << "ERROR: Unknown group " << optarg << "\n";
+                return 1;
+            }
+            group = grp->gr_gid;
+            break;
+        }
+        case 'n':
+            ert = false;
+            break;
+        case 'h':
+            printHelp(argv[0]);
+            return 0;
+        default:
+            printHelp(argv[0]);
+            return 1;
+        }
+    }
+
+    if (bitstream.empty()) {
+        printHelp(argv[0]);
+        return 1;
+    }
+
+    std::ifstream stream(bitstream, std::ios::binary);
+    std::vector<char> xclbin((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    if (xclbin.size() < sizeof(axlf) || std::strncmp(xclbin.data(), "xclbin2", 8)) {
+        std::cout << "ERROR: Invalid bitstream " << bitstream << "\n";
+        return 1;
+    }
+
+    struct sigaction sa;
+    std::memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, nullptr);
+    sigaction(SIGTERM, &sa, nullptr);
+    sigaction(SIGUSR1, &sa, nullptr);
+
+    if (device >= 0)
+        return runBroker(device, xclbin, halLog, ert, group);
+
+    const unsigned numDevs = xclProbe();
+    std::vector<pid_t> children;
+    for (unsigned i = 0; i < numDevs; i++) {
+        pid_t pid = fork();
+        if (pid < 0) {
+            std::cout << "Failed to create child process: " << errno << std::endl;
+            break;
+        }
+        if (pid == 0)
+            return runBroker(i, xclbin, halLog, ert, group);
+        std::cout << "New child process: " << pid << std::endl;
+        children.push_back(pid);
+    }
+
+    // Forward stop and statistics requests to the brokers
+    int ret = 0;
+    for (size_t running = children.size(); running;) {
+        int status = 0;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid > 0) {
+            --running;
+            if (!WIFEXITED(status) || WEXITSTATUS(status))
+                ret = 1;
+            continue;
+        }
+        if (errno != EINTR)
+            break;
+        for (auto child : children)
+            kill(child, g_stop ? SIGTERM : SIGUSR1);
+        g_stats = false;
+    }
+    return ret;
+}
@@ -0,0 +1,100 @@
+import sys
+import time
+sys.path.append('../') # utils_binding.py
+from xrt_binding import *
+from utils_binding import *
+
+# Compares the per call ctypes path of moving data through mapped BOs with
+# the zero-copy buffer views and batched syncs of xclMapBOBuffer/xclSyncBOs
+
+NUM_BOS = 8
+COUNT = 64 * 1024
+ITERATIONS = 20
+
+
+def report(name, elapsed, nbytes):
+    print("%-24s %8.3f ms  %8.1f MB/s" % (name, elapsed * 1000, nbytes / elapsed / 1e6))
+
+
+def benchCopy(opt, boHandles, size):
+    bos = [xclMapBO(opt.handle, bo, True, 'int', COUNT) for bo in boHandles]
+    data = [i for i in range(COUNT)]
+    start = time.time()
+    for _ in range(ITERATIONS):
+        for bo, boHandle in zip(bos, boHandles):
+            arr = (ctypes.c_int * COUNT)(*data)
+            ctypes.memmove(bo, arr, size)
+            if xclSyncBO(opt.handle, boHandle, xclBOSyncDirection.XCL_BO_SYNC_BO_TO_DEVICE, size, 0):
+                return -1
+        for bo, boHandle in zip(bos, boHandles):
+            if xclSyncBO(opt.handle, boHandle, xclBOSyncDirection.XCL_BO_SYNC_BO_FROM_DEVICE, size, 0):
+                return -1
+            result = bo.contents[:]
+    return time.time() - start
+
+
+def benchZeroCopy(opt, boHandles, size):
+    bufs = [xclMapBOBuffer(opt.handle, bo, True, size) for bo in boHandles]
+    try:
+        import numpy
+        views = [numpy.frombuffer(buf, dtype=numpy.int32) for buf in bufs]
+        data = numpy.arange(COUNT, dtype=numpy.int32)
+    except ImportError:
+        views = [memoryview(buf).cast('B').cast('i') for buf in bufs]
+        data = memoryview(bytearray((ctypes.c_int * COUNT)(*range(COUNT)))).cast('i')
+    syncs = [(bo, size, 0) for bo in boHandles]
+    start = time.time()
+    for _ in range(ITERATIONS):
+        for view in views:
+            view[:] = data
+        if xclSyncBOs(opt.handle, syncs, xclBOSyncDirection.XCL_BO_SYNC_BO_TO_DEVICE):
+            return -1
+        if xclSyncBOs(opt.handle, syncs, xclBOSyncDirection.XCL_BO_SYNC_BO_FROM_DEVICE):
+            return -1
+        for view in views:
+            result = view[:]
+    elapsed = time.time() - start
+    del views
+    for bo, buf in zip(boHandles, bufs):
+        xclUnmapBOBuffer(opt.handle, bo, buf)
+    return elapsed
+
+
+def main(args):
+    opt = Options()
+    Options.getOptions(opt, args)
+    try:
+        if initXRT(opt):
+            return 1
+        if opt.first_mem < 0:
+            return 1
+
+        size = ctypes.sizeof(ctypes.c_int) * COUNT
+        boHandles = [xclAllocBO(opt.handle, size, xclBOKind.XCL_BO_DEVICE_RAM, opt.first_mem)
+                     for _ in range(NUM_BOS)]
+        nbytes = 2 * size * NUM_BOS * ITERATIONS
+
+        elapsed = benchCopy(opt, boHandles, size)
+        if elapsed < 0:
+            return 1
+        report("per call copy", elapsed, nbytes)
+
+        elapsed = benchZeroCopy(opt, boHandles, size)
+        if elapsed < 0:
+            return 1
+        report("zero-copy batched", elapsed, nbytes)
+
+        for bo in boHandles:
+            xclFreeBO(opt.handle, bo)
+
+    except Exception as exp:
+        print("Exception: ")
+        print(exp)  # prints the err
+        print("FAILED TEST")
+        sys.exit()
+
+    print("PASSED TEST")
+
+
+if __name__ == "__main__":
+    main(sys.argv)
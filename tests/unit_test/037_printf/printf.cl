@@ -0,0 +1,33 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+//------------------------------------------------------------------------------
+//
+// kernel:  printf_heavy
+//
+// Purpose: Every work item prints a few lines using a handful of format
+//          strings, so the runtime decodes many records per buffer
+//
+// input:   int scale, echoed back in the printed values
+//
+
+__kernel void __attribute__ ((reqd_work_group_size(16, 1, 1)))
+    printf_heavy(int scale) {
+  int glbId = get_global_id(0);
+  printf("PRINTF_TEST id=%d value=%d\n", glbId, glbId * scale);
+  printf("PRINTF_TEST id=%d half=%f\n", glbId, (float)glbId / 2.0f);
+  printf("PRINTF_TEST id=%d hex=%x\n", glbId, glbId * scale);
+}
@@ -0,0 +1,230 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// This is the host code for the printf example.  It runs a printf heavy
+// kernel several times and checks after each clWaitForEvents that all
+// printf output of the kernel is visible, without relying on clFinish.
+// Kernel printf output goes to a temporary file so it can be counted.
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <CL/opencl.h>
+
+////////////////////////////////////////////////////////////////////////////////
+
+#define GLOBAL (256)
+#define LOCAL (16)
+#define LINES_PER_ITEM (3)
+#define ITERATIONS (8)
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int
+load_file_to_memory(const char *filename, char **result)
+{
+  int size = 0;
+  FILE *f = fopen(filename, "rb");
+  if (f == NULL)
+  {
+    *result = NULL;
+    return -1; // -1 means file opening fail
+  }
+  fseek(f, 0, SEEK_END);
+  size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  *result = (char *)malloc(size+1);
+  if (size != fread(*result, sizeof(char), size, f))
+  {
+    free(*result);
+    fclose(f);
+    return -2; // -2 means file reading fail
+  }
+  fclose(f);
+  (*result)[size] = 0;
+  return size;
+}
+
+// Count the kernel printf lines written to file so far
+static int
+count_lines(const char *filename)
+{
+  char line[256];
+  int count = 0;
+  FILE *f = fopen(filename, "r");
+  if (f == NULL)
+    return -1;
+  while (fgets(line, sizeof(line), f))
+    if (strncmp(line, "PRINTF_TEST ", 12) == 0)
+      ++count;
+  fclose(f);
+  return count;
+}
+
+static double
+now_ms()
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+int main(int argc, char** argv)
+{
+  int err;
+  cl_platform_id platform_id;
+  cl_device_id device_id = NULL;
+  cl_context context;
+  cl_command_queue commands;
+  cl_program program;
+  cl_kernel kernel;
+
+  if (argc != 2) {
+    printf("%s <inputfile>\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  err = clGetPlatformIDs(1,&platform_id,NULL);
+  if (err != CL_SUCCESS) {
+    printf("Error: Failed to find an OpenCL platform!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  int fpga = 0;
+#if defined (FPGA_DEVICE)
+  fpga = 1;
+#endif
+  err = clGetDeviceIDs(platform_id, fpga ? CL_DEVICE_TYPE_ACCELERATOR : CL_DEVICE_TYPE_CPU,
+                       1, &device_id, NULL);
+  if (err != CL_SUCCESS) {
+    printf("Error: Failed to create a device group!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  context = clCreateContext(0, 1, &device_id, NULL, NULL, &err);
+  if (!context) {
+    printf("Error: Failed to create a compute context!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  commands = clCreateCommandQueue(context, device_id, 0, &err);
+  if (!commands) {
+    printf("Error: Failed to create a command commands!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  unsigned char *kernelbinary;
+  char *xclbin = argv[1];
+  printf("loading %s\n", xclbin);
+  int n_i = load_file_to_memory(xclbin, (char **) &kernelbinary);
+  if (n_i < 0) {
+    printf("failed to load kernel from xclbin: %s\n", xclbin);
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+  size_t n = n_i;
+  int status;
+  program = clCreateProgramWithBinary(context, 1, &device_id, &n,
+                                      (const unsigned char **) &kernelbinary, &status, &err);
+  free(kernelbinary);
+  if ((!program) || (err!=CL_SUCCESS)) {
+    printf("Error: Failed to create compute program from binary %d!\n", err);
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  err = clBuildProgram(program, 0, NULL, NULL, NULL, NULL);
+  if (err != CL_SUCCESS) {
+    printf("Error: Failed to build program executable!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  kernel = clCreateKernel(program, "printf_heavy", &err);
+  if (!kernel || err != CL_SUCCESS) {
+    printf("Error: Failed to create compute kernel!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  // Send stdout, and with it the kernel printf output, to a file
+  char outfile[] = "/tmp/037_printf_XXXXXX";
+  int fd = mkstemp(outfile);
+  int saved_stdout = dup(STDOUT_FILENO);
+  if (fd < 0 || saved_stdout < 0) {
+    printf("Error: Failed to create printf output file!\n");
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+  fflush(stdout);
+  dup2(fd, STDOUT_FILENO);
+  close(fd);
+
+  int failed = 0;
+  size_t global = GLOBAL;
+  size_t local = LOCAL;
+  double start = now_ms();
+  for (int iter = 0; iter < ITERATIONS && !failed; ++iter) {
+    int scale = iter + 1;
+    cl_event kevent;
+    clSetKernelArg(kernel, 0, sizeof(int), &scale);
+    err = clEnqueueNDRangeKernel(commands, kernel, 1, NULL, &global, &local, 0, NULL, &kevent);
+    if (err != CL_SUCCESS) {
+      failed = 1;
+      break;
+    }
+
+    // All printf output of the kernel must be visible once the host
+    // has observed its completion
+    clWaitForEvents(1, &kevent);
+    clReleaseEvent(kevent);
+    fflush(stdout);
+    int expected = (iter + 1) * GLOBAL * LINES_PER_ITEM;
+    int lines = count_lines(outfile);
+    if (lines != expected) {
+      fprintf(stderr, "Error: iteration %d has %d printf lines, expected %d\n", iter, lines, expected);
+      failed = 1;
+    }
+  }
+  double elapsed = now_ms() - start;
+
+  fflush(stdout);
+  dup2(saved_stdout, STDOUT_FILENO);
+  close(saved_stdout);
+  unlink(outfile);
+
+  clReleaseKernel(kernel);
+  clReleaseProgram(program);
+  clReleaseCommandQueue(commands);
+  clReleaseContext(context);
+
+  if (failed) {
+    printf("Test failed\n");
+    return EXIT_FAILURE;
+  }
+
+  printf("%d kernels, %d printf lines in %.3f ms\n",
+         ITERATIONS, ITERATIONS * GLOBAL * LINES_PER_ITEM, elapsed);
+  printf("Test passed\n");
+  return EXIT_SUCCESS;
+}
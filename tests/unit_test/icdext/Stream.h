@@ -22,54 +22,87 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
 
 namespace cl {
 
     class Stream {
         Device device_;
         cl_stream stream_;
+    public:
         static decltype(&clCreateStream) openStm_;
         static decltype(&clReleaseStream) closeStm_;
         static decltype(&clReadStream) readStm_;
         static decltype(&clWriteStream) writeStm_;
-    public:
+        static decltype(&clReadStreams) readStms_;
+        static decltype(&clWriteStreams) writeStms_;
+        static decltype(&clCreateStreamBuffer) createBuf_;
+        static decltype(&clMapStreamBuffer) mapBuf_;
+        static decltype(&clReleaseStreamBuffer) releaseBuf_;
+        static decltype(&clPollStreams) pollStms_;
+
+        template <typename FunctionType>
+        static void lookup(cl::Platform platform, const char* name, FunctionType& func) {
+            void *bar = clGetExtensionFunctionAddressForPlatform(platform(), name);
+            func = (FunctionType)bar;
+            std::cout << name << "(0x" << bar << ")\n";
+        }
+
         static void init(cl::Platform platform) {
-            void *bar = clGetExtensionFunctionAddressForPlatform(platform(), "clCreateStream");
-            openStm_ = (decltype(&clCreateStream))bar;
-            std::cout << "clCreateStream(0x" << bar << ")\n";
-            bar = clGetExtensionFunctionAddressForPlatform(platform(), "clReleaseStream");
-            closeStm_ = (decltype(&clReleaseStream))bar;
-            std::cout << "clReleaseStream(0x" << bar << ")\n";
-            bar = clGetExtensionFunctionAddressForPlatform(platform(), "clReadStream");
-            readStm_ = (decltype(&clReadStream))bar;
-            std::cout << "clReadStream(0x" << bar << ")\n";
-            bar = clGetExtensionFunctionAddressForPlatform(platform(), "clWriteStream");
-            writeStm_ = (decltype(&clWriteStream))bar;
-            std::cout << "clWriteStream(0x" << bar << ")\n";
+            lookup(platform, "clCreateStream", openStm_);
+            lookup(platform, "clReleaseStream", closeStm_);
+            lookup(platform, "clReadStream", readStm_);
+            lookup(platform, "clWriteStream", writeStm_);
+            lookup(platform, "clReadStreams", readStms_);
+            lookup(platform, "clWriteStreams", writeStms_);
+            lookup(platform, "clCreateStreamBuffer", createBuf_);
+            lookup(platform, "clMapStreamBuffer", mapBuf_);
+            lookup(platform, "clReleaseStreamBuffer", releaseBuf_);
+            lookup(platform, "clPollStreams", pollStms_);
         }
+
         Stream(Device device, cl_stream_flags flags,
 	       cl_stream_attributes attr,
 	       cl_mem_ext_ptr_t* ext) : device_(device) {
             int res = 0;
-            openStm_(device_(), flags, attr, ext, &res);
+            stream_ = openStm_(device_(), flags, attr, ext, &res);
         }
 
         ~Stream() {
             closeStm_(stream_);
         }
 
-        int read(void* buf, size_t offset, size_t size,
-                 cl_stream_xfer_req* attr) {
+        int read(void* buf, size_t size, cl_stream_xfer_req* attr) {
+            int res = 0;
+            return readStm_(stream_, buf, size, attr, &res);
+        }
+
+        int write(const void* buf, size_t size, cl_stream_xfer_req* attr) {
+            int res = 0;
+            return writeStm_(stream_, buf, size, attr, &res);
+        }
+
+        // Post all requests in one call, returns number posted
+        int read(const std::vector<void*>& bufs, const std::vector<size_t>& sizes,
+                 std::vector<cl_stream_xfer_req>& attrs) {
+            int res = 0;
+            return readStms_(stream_, bufs.size(), bufs.data(), sizes.data(), attrs.data(), &res);
+        }
+
+        int write(const std::vector<const void*>& bufs, const std::vector<size_t>& sizes,
+                  std::vector<cl_stream_xfer_req>& attrs) {
             int res = 0;
-            readStm_(device_(), stream_, buf, offset, size, attr, &res);
-            return res;
+            return writeStms_(stream_, bufs.size(), bufs.data(), sizes.data(), attrs.data(), &res);
         }
 
-        int write(void* buf, size_t offset, size_t size,
-                  cl_stream_xfer_req* attr) {
+        // Reap at least min completions of non-blocking requests on all
+        // streams of the device, returns number reaped
+        static int poll(Device device, std::vector<cl_streams_poll_req_completions>& comps,
+                        int min, int timeout) {
+            int actual = 0;
             int res = 0;
-            writeStm_(device_(), stream_, buf, offset, size, attr, &res);
-            return res;
+            pollStms_(device(), comps.data(), min, comps.size(), &actual, timeout, &res);
+            return actual;
         }
     };
 }
@@ -16,11 +16,19 @@
 
 #include <CL/cl2.hpp>
 #include <CL/cl_ext_xilinx.h>
+#include <cstring>
+#include <fstream>
 #include <iostream>
+#include <iterator>
+#include <vector>
 
 #include "Stream.h"
 
-//g++ -g -I $XILINX_XRT/include main.cpp -lOpenCL; ./a.out
+//g++ -g -I $XILINX_XRT/include main.cpp -lOpenCL; ./a.out [loopback.xclbin]
+//
+// With an xclbin whose kernel 'loopback' copies its input stream
+// argument 0 to its output stream argument 1, packets are looped back
+// through pooled stream buffers with the batched stream APIs.
 
 #define OCL_CHECK(error,call)                                       \
     call;                                                           \
@@ -34,6 +42,103 @@ decltype(&clCreateStream) cl::Stream::openStm_ = nullptr;
 decltype(&clReleaseStream) cl::Stream::closeStm_ = nullptr;
 decltype(&clReadStream) cl::Stream::readStm_ = nullptr;
 decltype(&clWriteStream) cl::Stream::writeStm_ = nullptr;
+decltype(&clReadStreams) cl::Stream::readStms_ = nullptr;
+decltype(&clWriteStreams) cl::Stream::writeStms_ = nullptr;
+decltype(&clCreateStreamBuffer) cl::Stream::createBuf_ = nullptr;
+decltype(&clMapStreamBuffer) cl::Stream::mapBuf_ = nullptr;
+decltype(&clReleaseStreamBuffer) cl::Stream::releaseBuf_ = nullptr;
+decltype(&clPollStreams) cl::Stream::pollStms_ = nullptr;
+
+static const size_t PACKETS = 64;
+static const size_t PACKET_SIZE = 4096;
+
+static int loopback(cl::Platform platform, const char* xclbin)
+{
+    cl_int err;
+    std::vector<cl::Device> devices;
+    OCL_CHECK(err, err = platform.getDevices(CL_DEVICE_TYPE_ACCELERATOR, &devices));
+    cl::Device device = devices[0];
+    cl::Context context(device);
+
+    std::ifstream stream(xclbin, std::ios::binary);
+    std::vector<unsigned char> binary((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+    cl::Program::Binaries bins{binary};
+    OCL_CHECK(err, cl::Program program(context, {device}, bins, nullptr, &err));
+    OCL_CHECK(err, cl::Kernel kernel(program, "loopback", &err));
+
+    cl_mem_ext_ptr_t ext;
+    std::memset(&ext, 0, sizeof(ext));
+    ext.param = kernel();
+    ext.flags = 0;
+    cl::Stream write_stream(device, CL_STREAM_WRITE_ONLY, CL_STREAM, &ext);
+    ext.flags = 1;
+    cl::Stream read_stream(device, CL_STREAM_READ_ONLY, CL_STREAM, &ext);
+
+    cl::CommandQueue queue(context, device);
+    OCL_CHECK(err, err = queue.enqueueTask(kernel));
+
+    // Two rounds so that the second round reuses the released buffers
+    for (int round = 0; round < 2; ++round) {
+        std::vector<cl_stream_mem> mems;
+        std::vector<const void*> wbufs;
+        std::vector<void*> rbufs;
+        for (size_t i = 0; i < PACKETS; ++i) {
+            cl_stream_mem wmem = cl::Stream::createBuf_(device(), PACKET_SIZE, &err);
+            cl_stream_mem rmem = cl::Stream::createBuf_(device(), PACKET_SIZE, &err);
+            if (!wmem || !rmem) {
+                std::cout << "Error: Failed to create stream buffers" << std::endl;
+                return EXIT_FAILURE;
+            }
+            auto wbuf = static_cast<unsigned*>(cl::Stream::mapBuf_(wmem, &err));
+            auto rbuf = static_cast<unsigned*>(cl::Stream::mapBuf_(rmem, &err));
+            for (size_t j = 0; j < PACKET_SIZE / sizeof(unsigned); ++j) {
+                wbuf[j] = round * PACKETS + i + j;
+                rbuf[j] = 0;
+            }
+            mems.push_back(wmem);
+            mems.push_back(rmem);
+            wbufs.push_back(wbuf);
+            rbufs.push_back(rbuf);
+        }
+
+        std::vector<size_t> sizes(PACKETS, PACKET_SIZE);
+        std::vector<cl_stream_xfer_req> rreqs(PACKETS), wreqs(PACKETS);
+        for (size_t i = 0; i < PACKETS; ++i) {
+            std::memset(&rreqs[i], 0, sizeof(cl_stream_xfer_req));
+            std::memset(&wreqs[i], 0, sizeof(cl_stream_xfer_req));
+            rreqs[i].flags = CL_STREAM_EOT | CL_STREAM_NONBLOCKING;
+            rreqs[i].priv_data = rbufs[i];
+            wreqs[i].flags = CL_STREAM_EOT | CL_STREAM_NONBLOCKING;
+            wreqs[i].priv_data = const_cast<void*>(wbufs[i]);
+        }
+        if (read_stream.read(rbufs, sizes, rreqs) != (int)PACKETS
+            || write_stream.write(wbufs, sizes, wreqs) != (int)PACKETS) {
+            std::cout << "Error: Failed to post stream requests" << std::endl;
+            return EXIT_FAILURE;
+        }
+
+        std::vector<cl_streams_poll_req_completions> comps(PACKETS * 2);
+        for (size_t reaped = 0; reaped < PACKETS * 2;) {
+            int num = cl::Stream::poll(device, comps, 1, 1000);
+            if (num <= 0) {
+                std::cout << "Error: Timeout polling stream completions" << std::endl;
+                return EXIT_FAILURE;
+            }
+            reaped += num;
+        }
+
+        for (size_t i = 0; i < PACKETS; ++i) {
+            if (std::memcmp(wbufs[i], rbufs[i], PACKET_SIZE)) {
+                std::cout << "Error: Packet " << i << " mismatch in round " << round << std::endl;
+                return EXIT_FAILURE;
+            }
+        }
+        for (auto mem : mems)
+            cl::Stream::releaseBuf_(mem);
+    }
+    std::cout << "Looped back " << 2 * PACKETS << " packets" << std::endl;
+    return 0;
+}
 
 int main(int argc, char *argv[])
 {
@@ -57,5 +162,7 @@ int main(int argc, char *argv[])
     }
 
     cl::Stream::init(platform);
+    if (argc > 1)
+        return loopback(platform, argv[1]);
     return 0;
 }
@@ -0,0 +1,23 @@
+/**
+ * Copyright (C) 2016-2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+// Copyright 2019 Xilinx, Inc. All rights reserved.
+
+__attribute__ ((reqd_work_group_size(128, 1, 1)))
+kernel void dummy(global int * restrict s)
+{
+    s[get_global_id(0)] = get_global_id(0);
+}
@@ -0,0 +1,170 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <getopt.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// host_src includes
+#include "xclhal2.h"
+#include "xclbin.h"
+
+// lowlevel common include
+#include "utils.h"
+
+// shared with xbutil dmatest --bench
+#include "dmabench.h"
+
+/**
+ * Runs the DMA bandwidth and latency sweep of 'xbutil dmatest --bench'
+ * on every memory bank of the xclbin.  Unlike xbutil this does not
+ * need sysfs so it also runs on the emulation shims.
+ */
+
+const static struct option long_options[] = {
+{"bitstream",       required_argument, 0, 'k'},
+{"hal_logfile",     required_argument, 0, 'l'},
+{"device",          required_argument, 0, 'd'},
+{"max_size",        required_argument, 0, 'm'},
+{"threads",         required_argument, 0, 't'},
+{"json",            required_argument, 0, 'j'},
+{"help",            no_argument,       0, 'h'},
+{0, 0, 0, 0}
+};
+
+static void printHelp()
+{
+    std::cout << "usage: %s [options] -k <bitstream>\n\n";
+    std::cout << "  -k <bitstream>\n";
+    std::cout << "  -l <hal_logfile>\n";
+    std::cout << "  -d <device_index>\n";
+    std::cout << "  -m <max_transfer_size_bytes>\n";
+    std::cout << "  -t <max_threads>\n";
+    std::cout << "  -j <json_output_file>\n";
+    std::cout << "  -h\n\n";
+    std::cout << "* Bitstream is required\n";
+    std::cout << "* HAL logfile is optional but useful for capturing messages from HAL driver\n";
+}
+
+static std::vector<xcldev::DMABenchmark::bank> getBanks(const std::string& bitstreamFile)
+{
+    std::ifstream stream(bitstreamFile);
+    stream.seekg(0, stream.end);
+    int size = stream.tellg();
+    stream.seekg(0, stream.beg);
+    std::vector<char> header(size);
+    stream.read(header.data(), size);
+
+    const axlf* top = (const axlf*)header.data();
+    auto topo = xclbin::get_axlf_section(top, MEM_TOPOLOGY);
+    if (!topo)
+        throw std::runtime_error("No memory topology in bitstream");
+    const mem_topology* topology = (const mem_topology*)(header.data() + topo->m_sectionOffset);
+
+    std::vector<xcldev::DMABenchmark::bank> banks;
+    for (int i = 0; i < topology->m_count; ++i) {
+        const mem_data& mem = topology->m_mem_data[i];
+        if (mem.m_used && mem.m_type != MEM_STREAMING)
+            banks.emplace_back(i, (const char*)mem.m_tag, mem.m_size * 1024);
+    }
+    return banks;
+}
+
+int main(int argc, char** argv)
+{
+    std::string bitstreamFile;
+    std::string halLogfile;
+    std::string jsonFile;
+    unsigned index = 0;
+    xcldev::DMABenchmark::options options;
+    int option_index = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, "k:l:d:m:t:j:h", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+        case 'k':
+            bitstreamFile = optarg;
+            break;
+        case 'l':
+            halLogfile = optarg;
+            break;
+        case 'd':
+            index = std::atoi(optarg);
+            break;
+        case 'm':
+            options.m_max_size = std::stoull(optarg, 0, 0);
+            break;
+        case 't':
+            options.m_max_threads = std::atoi(optarg);
+            break;
+        case 'j':
+            jsonFile = optarg;
+            break;
+        case 'h':
+            printHelp();
+            return 0;
+        default:
+            printHelp();
+            return -1;
+        }
+    }
+
+    if (bitstreamFile.size() == 0) {
+        std::cout << "FAILED TEST\n";
+        std::cout << "No bitstream specified\n";
+        return -1;
+    }
+
+    try
+    {
+        xclDeviceHandle handle;
+        uint64_t cu_base_addr = 0;
+        int first_mem = -1;
+        uuid_t xclbinId;
+
+        if (initXRT(bitstreamFile.c_str(), index, halLogfile.c_str(), handle, 0, cu_base_addr, first_mem, xclbinId))
+            return 1;
+
+        auto banks = getBanks(bitstreamFile);
+        xcldev::DMABenchmark bench(handle, banks, options);
+        if (bench.run(std::cout)) {
+            std::cout << "FAILED TEST\n";
+            std::cout << "No DMA transfer could be measured\n";
+            return 1;
+        }
+
+        if (jsonFile.size()) {
+            std::ofstream ostr(jsonFile);
+            bench.writeJson(ostr, bitstreamFile);
+            std::cout << "Results saved in " << jsonFile << "\n";
+        }
+        xclClose(handle);
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Exception: " << e.what() << "\n";
+        std::cout << "FAILED TEST\n";
+        return 1;
+    }
+
+    std::cout << "PASSED TEST\n";
+    return 0;
+}
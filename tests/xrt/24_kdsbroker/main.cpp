@@ -0,0 +1,286 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <getopt.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// host_src includes
+#include "xclhal2.h"
+#include "xclbin.h"
+
+// lowlevel common include
+#include "utils.h"
+
+// shared with kdsbrokerd
+#include "kds_broker.h"
+
+#include "xaddone_hw_64.h"
+
+/**
+ * Runs addone jobs from several client processes through one KDS
+ * broker.  The broker runs in a thread of this process, which owns the
+ * device and the buffers, and the clients are forked processes that
+ * only submit and wait for commands.  This also works in software
+ * emulation where device memory is private to the process that
+ * opened the device.
+ *
+ * The first client has weight 2, the others weight 1.
+ */
+
+static const size_t ELEMENTS = 16;
+static const size_t ARRAY_SIZE = 8;
+static const size_t DATA_SIZE = ELEMENTS * ARRAY_SIZE * sizeof(unsigned long);
+
+const static struct option long_options[] = {
+{"bitstream",       required_argument, 0, 'k'},
+{"hal_logfile",     required_argument, 0, 'l'},
+{"device",          required_argument, 0, 'd'},
+{"clients",         required_argument, 0, 'c'},
+{"jobs",            required_argument, 0, 'j'},
+{"no-ert",          no_argument,       0, 'n'},
+{"help",            no_argument,       0, 'h'},
+{0, 0, 0, 0}
+};
+
+static void printHelp()
+{
+    std::cout << "usage: %s [options] -k <bitstream>\n\n";
+    std::cout << "  -k <bitstream>\n";
+    std::cout << "  -l <hal_logfile>\n";
+    std::cout << "  -d <device_index>\n";
+    std::cout << "  -c <number_of_client_processes>\n";
+    std::cout << "  -j <jobs_per_client>\n";
+    std::cout << "  --no-ert, start CUs directly instead of through xclExecBuf\n";
+    std::cout << "  -h\n\n";
+    std::cout << "* Bitstream is required\n";
+    std::cout << "* HAL logfile is optional but useful for capturing messages from HAL driver\n";
+}
+
+struct job_buffers {
+    unsigned a;
+    unsigned b;
+    unsigned long* adata;
+    unsigned long* bdata;
+    uint64_t a_addr;
+    uint64_t b_addr;
+};
+
+static int runClient(unsigned index, unsigned weight, const job_buffers& bufs, size_t jobs)
+{
+    try {
+        kds_broker::client c(index, weight);
+
+        const size_t regmap_size = XADDONE_CONTROL_ADDR_ELEMENTS_DATA/4 + 1;
+        std::vector<uint32_t> packet(1 + 1 + regmap_size, 0);
+        auto ecmd = reinterpret_cast<ert_start_kernel_cmd*>(packet.data());
+        ecmd->state = ERT_CMD_STATE_NEW;
+        ecmd->opcode = ERT_START_CU;
+        ecmd->count = 1 + regmap_size;
+        ecmd->cu_mask = 0x3;
+        ecmd->data[XADDONE_CONTROL_ADDR_A_DATA/4] = bufs.a_addr;
+        ecmd->data[XADDONE_CONTROL_ADDR_A_DATA/4 + 1] = (bufs.a_addr >> 32) & 0xFFFFFFFF;
+        ecmd->data[XADDONE_CONTROL_ADDR_B_DATA/4] = bufs.b_addr;
+        ecmd->data[XADDONE_CONTROL_ADDR_B_DATA/4 + 1] = (bufs.b_addr >> 32) & 0xFFFFFFFF;
+        ecmd->data[XADDONE_CONTROL_ADDR_ELEMENTS_DATA/4] = ELEMENTS;
+
+        // Keep the ring full, wait for the oldest command when it is not
+        std::vector<int> tickets;
+        size_t head = 0;
+        for (size_t i = 0; i < jobs; ++i) {
+            int ticket;
+            while ((ticket = c.submit(packet.data(), packet.size())) < 0) {
+                if (c.wait(tickets[head++]) != ERT_CMD_STATE_COMPLETED)
+                    return 1;
+            }
+            tickets.push_back(ticket);
+        }
+        for (; head < tickets.size(); ++head) {
+            if (c.wait(tickets[head]) != ERT_CMD_STATE_COMPLETED)
+                return 1;
+        }
+        return 0;
+    }
+    catch (std::exception const& e) {
+        std::cout << "Client " << getpid() << " exception: " << e.what() << "\n";
+        return 1;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string bitstreamFile;
+    std::string halLogfile;
+    unsigned index = 0;
+    unsigned clients = 3;
+    size_t jobs = 256;
+    bool ert = true;
+    int option_index = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, "k:l:d:c:j:h", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+        case 'k':
+            bitstreamFile = optarg;
+            break;
+        case 'l':
+            halLogfile = optarg;
+            break;
+        case 'd':
+            index = std::atoi(optarg);
+            break;
+        case 'c':
+            clients = std::atoi(optarg);
+            break;
+        case 'j':
+            jobs = std::atoi(optarg);
+            break;
+        case 'n':
+            ert = false;
+            break;
+        case 'h':
+            printHelp();
+            return 0;
+        default:
+            printHelp();
+            return -1;
+        }
+    }
+
+    if (bitstreamFile.size() == 0) {
+        std::cout << "FAILED TEST\n";
+        std::cout << "No bitstream specified\n";
+        return -1;
+    }
+
+    if (clients == 0 || clients > kds_broker::max_clients) {
+        std::cout << "FAILED TEST\n";
+        std::cout << "Number of clients must be between 1 and " << kds_broker::max_clients << "\n";
+        return -1;
+    }
+
+    try
+    {
+        xclDeviceHandle handle;
+        uint64_t cu_base_addr = 0;
+        int first_mem = -1;
+        uuid_t xclbinId;
+
+        if (initXRT(bitstreamFile.c_str(), index, halLogfile.c_str(), handle, 0, cu_base_addr, first_mem, xclbinId))
+            return 1;
+
+        if (first_mem < 0)
+            return 1;
+
+        std::ifstream stream(bitstreamFile);
+        std::vector<char> xclbin((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+        std::vector<job_buffers> bufs(clients);
+        for (unsigned i = 0; i < clients; ++i) {
+            job_buffers& jb = bufs[i];
+            jb.a = xclAllocBO(handle, DATA_SIZE, XCL_BO_DEVICE_RAM, first_mem);
+            jb.b = xclAllocBO(handle, DATA_SIZE, XCL_BO_DEVICE_RAM, first_mem);
+            if (jb.a == 0xffffffff || jb.b == 0xffffffff)
+                throw std::runtime_error("Failed to allocate buffers");
+            jb.adata = (unsigned long*)xclMapBO(handle, jb.a, true);
+            jb.bdata = (unsigned long*)xclMapBO(handle, jb.b, true);
+            for (size_t j = 0; j < ELEMENTS * ARRAY_SIZE; ++j) {
+                jb.adata[j] = (i << 16) + j;
+                jb.bdata[j] = 0;
+            }
+            if (xclSyncBO(handle, jb.a, XCL_BO_SYNC_BO_TO_DEVICE, DATA_SIZE, 0)
+                || xclSyncBO(handle, jb.b, XCL_BO_SYNC_BO_TO_DEVICE, DATA_SIZE, 0))
+                throw std::runtime_error("Failed to sync buffers");
+            xclBOProperties p;
+            xclGetBOProperties(handle, jb.a, &p);
+            jb.a_addr = p.paddr;
+            xclGetBOProperties(handle, jb.b, &p);
+            jb.b_addr = p.paddr;
+        }
+
+        kds_broker::broker broker(handle, index, reinterpret_cast<const axlf*>(xclbin.data()), ert);
+        std::cout << "KDS broker started" << (broker.usesErt() ? " (ert)" : " (cu)") << "\n";
+
+        // Fork before the broker thread starts, children must not return
+        // from main or they would destroy the broker
+        std::vector<pid_t> pids;
+        for (unsigned i = 0; i < clients; ++i) {
+            pid_t pid = fork();
+            if (pid < 0)
+                throw std::runtime_error("Failed to create client process");
+            if (pid == 0) {
+                std::cout.flush();
+                _exit(runClient(index, i ? 1 : 2, bufs[i], jobs));
+            }
+            pids.push_back(pid);
+        }
+
+        std::atomic<bool> stop(false);
+        std::thread dispatcher([&] { broker.run(stop); });
+
+        int failed = 0;
+        for (auto pid : pids) {
+            int status = 0;
+            if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status))
+                ++failed;
+        }
+        stop = true;
+        dispatcher.join();
+        broker.printStats(std::cout);
+
+        for (unsigned i = 0; i < clients; ++i) {
+            job_buffers& jb = bufs[i];
+            if (xclSyncBO(handle, jb.b, XCL_BO_SYNC_BO_FROM_DEVICE, DATA_SIZE, 0))
+                throw std::runtime_error("Failed to sync output buffer");
+            for (size_t j = 0; j < ELEMENTS * ARRAY_SIZE; ++j) {
+                unsigned long expected = (j % ARRAY_SIZE) ? jb.adata[j] : jb.adata[j] + 1;
+                if (jb.bdata[j] != expected) {
+                    std::cout << "Client " << i << " mismatch at " << j << ": " << jb.bdata[j]
+                              << " expected " << expected << "\n";
+                    ++failed;
+                    break;
+                }
+            }
+            munmap(jb.adata, DATA_SIZE);
+            munmap(jb.bdata, DATA_SIZE);
+            xclFreeBO(handle, jb.a);
+            xclFreeBO(handle, jb.b);
+        }
+
+        if (failed) {
+            std::cout << "FAILED TEST\n";
+            return 1;
+        }
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Exception: " << e.what() << "\n";
+        std::cout << "FAILED TEST\n";
+        return 1;
+    }
+
+    std::cout << "PASSED TEST\n";
+    return 0;
+}
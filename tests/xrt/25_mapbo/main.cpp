@@ -0,0 +1,192 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <getopt.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+
+// host_src includes
+#include "xclhal2.h"
+#include "xclbin.h"
+
+// lowlevel common include
+#include "utils.h"
+
+static const int DATA_SIZE = 4096;
+
+/**
+ * Exercises the per BO mapping cache of shims that export xclUnmapBO
+ * (zynq).  Repeated xclMapBO calls of a BO must return the same
+ * address, a read-write mapping must satisfy read-only requests, and
+ * releasing the last reference must unmap so that the next xclMapBO
+ * returns a fresh, usable mapping.  Shims without xclUnmapBO skip the
+ * test.
+ */
+
+typedef int (* unmapBOFuncType)(xclDeviceHandle handle, unsigned int boHandle, void *addr);
+
+const static struct option long_options[] = {
+{"bitstream",       required_argument, 0, 'k'},
+{"hal_logfile",     required_argument, 0, 'l'},
+{"cu_index",        required_argument, 0, 'c'},
+{"device",          required_argument, 0, 'd'},
+{"verbose",         no_argument,       0, 'v'},
+{"help",            no_argument,       0, 'h'},
+{0, 0, 0, 0}
+};
+
+static void printHelp()
+{
+    std::cout << "usage: %s [options] -k <bitstream>\n\n";
+    std::cout << "  -k <bitstream>\n";
+    std::cout << "  -l <hal_logfile>\n";
+    std::cout << "  -d <device_index>\n";
+    std::cout << "  -c <cu_index>\n";
+    std::cout << "  -v\n";
+    std::cout << "  -h\n\n";
+    std::cout << "* Bitstream is required\n";
+    std::cout << "* HAL logfile is optional but useful for capturing messages from HAL driver\n";
+}
+
+static void check(bool cond, const std::string& msg)
+{
+    if (!cond)
+        throw std::runtime_error(msg);
+}
+
+static void runTest(xclDeviceHandle handle, unmapBOFuncType unmapBO, int first_mem)
+{
+    unsigned boHandle = xclAllocBO(handle, DATA_SIZE, XCL_BO_DEVICE_RAM, first_mem);
+    check(boHandle != 0xffffffff, "Cannot allocate BO");
+
+    // Cached: same address for repeated and read-only maps
+    char *rw1 = (char *)xclMapBO(handle, boHandle, true);
+    char *rw2 = (char *)xclMapBO(handle, boHandle, true);
+    char *ro1 = (char *)xclMapBO(handle, boHandle, false);
+    check(rw1 && rw1 != MAP_FAILED, "Cannot map BO");
+    check(rw1 == rw2, "Repeated read-write map returned a new address");
+    check(rw1 == ro1, "Read-only map did not reuse read-write mapping");
+
+    std::memset(rw1, 0xa5, DATA_SIZE);
+    check(ro1[DATA_SIZE - 1] == (char)0xa5, "Mappings do not alias");
+
+    // Three references, the fourth release must fail
+    check(!unmapBO(handle, boHandle, rw1), "Release of first reference failed");
+    check(!unmapBO(handle, boHandle, rw2), "Release of second reference failed");
+    check(!unmapBO(handle, boHandle, ro1), "Release of last reference failed");
+    check(unmapBO(handle, boHandle, rw1) != 0, "Release of unmapped BO succeeded");
+
+    // After the last release the next map must be a usable mapping
+    char *rw3 = (char *)xclMapBO(handle, boHandle, true);
+    check(rw3 && rw3 != MAP_FAILED, "Cannot map BO after release");
+    std::memset(rw3, 0x5a, DATA_SIZE);
+    check(!xclSyncBO(handle, boHandle, XCL_BO_SYNC_BO_TO_DEVICE, DATA_SIZE, 0), "Sync to device failed");
+    std::memset(rw3, 0, DATA_SIZE);
+    check(!xclSyncBO(handle, boHandle, XCL_BO_SYNC_BO_FROM_DEVICE, DATA_SIZE, 0), "Sync from device failed");
+    for (int i = 0; i < DATA_SIZE; ++i)
+        check(rw3[i] == 0x5a, "Value read back does not match value written");
+    check(!unmapBO(handle, boHandle, rw3), "Release of remapped BO failed");
+
+    // A read-only mapping does not satisfy read-write requests
+    char *ro2 = (char *)xclMapBO(handle, boHandle, false);
+    char *rw4 = (char *)xclMapBO(handle, boHandle, true);
+    char *ro3 = (char *)xclMapBO(handle, boHandle, false);
+    check(ro2 != rw4, "Read-write map reused read-only mapping");
+    check(ro3 == rw4, "Read-only map did not prefer read-write mapping");
+    check(!unmapBO(handle, boHandle, ro2), "Release of read-only mapping failed");
+    check(!unmapBO(handle, boHandle, rw4), "Release of read-write mapping failed");
+    check(!unmapBO(handle, boHandle, ro3), "Release of read-write mapping failed");
+
+    xclFreeBO(handle, boHandle);
+}
+
+int main(int argc, char** argv)
+{
+    std::string bitstreamFile;
+    std::string halLogfile;
+    int option_index = 0;
+    unsigned index = 0;
+    unsigned cu_index = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, "k:l:c:d:vh", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+        case 'k':
+            bitstreamFile = optarg;
+            break;
+        case 'l':
+            halLogfile = optarg;
+            break;
+        case 'd':
+            index = std::atoi(optarg);
+            break;
+        case 'c':
+            cu_index = std::atoi(optarg);
+            break;
+        case 'v':
+            break;
+        case 'h':
+            printHelp();
+            return 0;
+        default:
+            printHelp();
+            return -1;
+        }
+    }
+
+    if (bitstreamFile.size() == 0) {
+        std::cout << "FAILED TEST\n";
+        std::cout << "No bitstream specified\n";
+        return -1;
+    }
+
+    auto unmapBO = (unmapBOFuncType)dlsym(RTLD_DEFAULT, "xclUnmapBO");
+    if (!unmapBO) {
+        std::cout << "xclUnmapBO not supported by this shim, skipping\n";
+        std::cout << "PASSED TEST\n";
+        return 0;
+    }
+
+    try
+    {
+        xclDeviceHandle handle;
+        uint64_t cu_base_addr = 0;
+        int first_mem = -1;
+        uuid_t xclbinId;
+
+        if (initXRT(bitstreamFile.c_str(), index, halLogfile.c_str(), handle, cu_index, cu_base_addr, first_mem, xclbinId))
+            return 1;
+
+        if (first_mem < 0)
+            return 1;
+
+        runTest(handle, unmapBO, first_mem);
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Exception: " << e.what() << "\n";
+        std::cout << "FAILED TEST\n";
+        return 1;
+    }
+
+    std::cout << "PASSED TEST\n";
+    return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * Copyright (C) 2019 Xilinx, Inc
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License"). You may
+ * not use this file except in compliance with the License. A copy of the
+ * License is located at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied. See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ */
+
+#include <getopt.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <cstring>
+
+// host_src includes
+#include "xclhal2.h"
+#include "xclbin.h"
+
+// lowlevel common include
+#include "utils.h"
+
+static const int DATA_SIZE = 4096;
+
+/**
+ * Exports a P2P BO, imports it on the same device, and checks that
+ * data written through either BO is read back through the other.  In
+ * software emulation the imported BO shares the device memory of the
+ * exported BO, see CpuemShim::xclImportBO.  Also checks that a plain
+ * BO reads back what was written when xclSyncBO has nothing to copy
+ * (software emulation with shared device memory).
+ */
+
+const static struct option long_options[] = {
+{"bitstream",       required_argument, 0, 'k'},
+{"hal_logfile",     required_argument, 0, 'l'},
+{"cu_index",        required_argument, 0, 'c'},
+{"device",          required_argument, 0, 'd'},
+{"verbose",         no_argument,       0, 'v'},
+{"help",            no_argument,       0, 'h'},
+{0, 0, 0, 0}
+};
+
+static void printHelp()
+{
+    std::cout << "usage: %s [options] -k <bitstream>\n\n";
+    std::cout << "  -k <bitstream>\n";
+    std::cout << "  -l <hal_logfile>\n";
+    std::cout << "  -d <device_index>\n";
+    std::cout << "  -c <cu_index>\n";
+    std::cout << "  -v\n";
+    std::cout << "  -h\n\n";
+    std::cout << "* Bitstream is required\n";
+    std::cout << "* HAL logfile is optional but useful for capturing messages from HAL driver\n";
+}
+
+static void check(bool cond, const std::string& msg)
+{
+    if (!cond)
+        throw std::runtime_error(msg);
+}
+
+static char* mapBO(xclDeviceHandle handle, unsigned boHandle)
+{
+    char *ptr = (char *)xclMapBO(handle, boHandle, true);
+    check(ptr && ptr != MAP_FAILED, "Cannot map BO");
+    return ptr;
+}
+
+// Write @value through @src, read it back through @dst
+static void transfer(xclDeviceHandle handle, unsigned src, char* srcPtr, unsigned dst, char* dstPtr,
+                     char value, const std::string& what)
+{
+    std::memset(srcPtr, value, DATA_SIZE);
+    check(!xclSyncBO(handle, src, XCL_BO_SYNC_BO_TO_DEVICE, DATA_SIZE, 0), what + ": sync to device failed");
+    if (dstPtr != srcPtr)
+        std::memset(dstPtr, 0, DATA_SIZE);
+    check(!xclSyncBO(handle, dst, XCL_BO_SYNC_BO_FROM_DEVICE, DATA_SIZE, 0), what + ": sync from device failed");
+    for (int i = 0; i < DATA_SIZE; ++i)
+        check(dstPtr[i] == value, what + ": value read back does not match value written");
+}
+
+static void runTest(xclDeviceHandle handle, int first_mem)
+{
+    // Plain BO, sync is a no-op when device memory is shared
+    unsigned boHandle = xclAllocBO(handle, DATA_SIZE, XCL_BO_DEVICE_RAM, first_mem);
+    check(boHandle != 0xffffffff, "Cannot allocate BO");
+    char *bo = mapBO(handle, boHandle);
+    transfer(handle, boHandle, bo, boHandle, bo, 0x3c, "Plain BO");
+
+    // Exported and imported BO
+    unsigned expHandle = xclAllocBO(handle, DATA_SIZE, XCL_BO_DEVICE_RAM, first_mem | XCL_BO_FLAGS_P2P);
+    check(expHandle != 0xffffffff, "Cannot allocate P2P BO");
+    char *exp = mapBO(handle, expHandle);
+    int fd = xclExportBO(handle, expHandle);
+    check(fd >= 0, "Cannot export BO");
+    unsigned impHandle = xclImportBO(handle, fd, 0);
+    check(impHandle != 0xffffffff, "Cannot import BO");
+    char *imp = mapBO(handle, impHandle);
+
+    transfer(handle, expHandle, exp, impHandle, imp, 0x5a, "Exported to imported BO");
+    transfer(handle, impHandle, imp, expHandle, exp, (char)0xa5, "Imported to exported BO");
+
+    munmap(imp, DATA_SIZE);
+    xclFreeBO(handle, impHandle);
+    munmap(exp, DATA_SIZE);
+    xclFreeBO(handle, expHandle);
+    close(fd);
+    munmap(bo, DATA_SIZE);
+    xclFreeBO(handle, boHandle);
+}
+
+int main(int argc, char** argv)
+{
+    std::string bitstreamFile;
+    std::string halLogfile;
+    int option_index = 0;
+    unsigned index = 0;
+    unsigned cu_index = 0;
+    int c;
+    while ((c = getopt_long(argc, argv, "k:l:c:d:vh", long_options, &option_index)) != -1)
+    {
+        switch (c)
+        {
+        case 'k':
+            bitstreamFile = optarg;
+            break;
+        case 'l':
+            halLogfile = optarg;
+            break;
+        case 'd':
+            index = std::atoi(optarg);
+            break;
+        case 'c':
+            cu_index = std::atoi(optarg);
+            break;
+        case 'v':
+            break;
+        case 'h':
+            printHelp();
+            return 0;
+        default:
+            printHelp();
+            return -1;
+        }
+    }
+
+    if (bitstreamFile.size() == 0) {
+        std::cout << "FAILED TEST\n";
+        std::cout << "No bitstream specified\n";
+        return -1;
+    }
+
+    try
+    {
+        xclDeviceHandle handle;
+        uint64_t cu_base_addr = 0;
+        int first_mem = -1;
+        uuid_t xclbinId;
+
+        if (initXRT(bitstreamFile.c_str(), index, halLogfile.c_str(), handle, cu_index, cu_base_addr, first_mem, xclbinId))
+            return 1;
+
+        if (first_mem < 0)
+            return 1;
+
+        runTest(handle, first_mem);
+    }
+    catch (std::exception const& e)
+    {
+        std::cout << "Exception: " << e.what() << "\n";
+        std::cout << "FAILED TEST\n";
+        return 1;
+    }
+
+    std::cout << "PASSED TEST\n";
+    return 0;
+}